@@ -0,0 +1,588 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ensemble.h"
+#include "frame_exporter.h"
+#include "gas_container.h"
+#include "profiler.h"
+#include "state_hash.h"
+#include "trajectory.h"
+
+using glm::vec2;
+using idealgas::Boundary;
+using idealgas::CollisionDetection;
+using idealgas::CsvEnsembleSink;
+using idealgas::EnsembleOptions;
+using idealgas::EnsembleRunner;
+using idealgas::EnsembleSink;
+using idealgas::FindFirstDivergentFrame;
+using idealgas::FrameExporter;
+using idealgas::FrameExportOptions;
+using idealgas::FrameFormat;
+using idealgas::GasContainer;
+using idealgas::Narrowphase;
+using idealgas::Observables;
+using idealgas::ParticleStore;
+using idealgas::Placement;
+using idealgas::Profiler;
+using idealgas::SpeciesRegistry;
+using idealgas::SpeedDistribution;
+using idealgas::Stepper;
+using idealgas::TrajectoryOptions;
+using idealgas::TrajectoryWriter;
+using idealgas::WorldResult;
+using idealgas::WorldSpec;
+
+namespace {
+
+/** Same particle density as the Cinder app: 30 particles in 700 x 1200 **/
+const float kDefaultAreaPerParticle = 700.0f * 1200.0f / 30.0f;
+
+struct Options {
+  size_t particle_count = 1000;
+  size_t frame_count = 1000;
+  int seed = 225;
+  size_t thread_count = 1;
+  float width = 0;   // 0 = derived from the particle count
+  float height = 0;  // 0 = derived from the particle count
+  bool brute_force = false;
+  bool event_driven = false;
+  bool adaptive = false;
+  bool deterministic = false;
+  bool periodic_x = false;
+  bool periodic_y = false;
+  float dt = 1;
+  Narrowphase::Kernel narrowphase_kernel = Narrowphase::GetBestKernel();
+  Placement placement = Placement::kUniform;
+  std::string load_path;  // empty = generate particles from the seed
+  std::string save_path;  // empty = don't save the final state
+  std::string trajectory_path;  // empty = don't write a trajectory
+  TrajectoryOptions trajectory;
+  std::string export_prefix;  // empty = don't export frames
+  FrameExportOptions frame_export;
+  std::string profile_path;  // empty = don't profile
+  size_t ensemble_count = 0;  // 0 = run a single container
+  std::string ensemble_csv_path;  // empty = don't write world results
+  std::string hash_log_path;  // empty = don't write state hashes
+  std::string hash_compare_path;  // empty = don't compare state hashes
+};
+
+void PrintUsage(const char* program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "Runs the gas simulation without a display and reports timings.\n\n"
+      "  --particles N   number of particles (default 1000)\n"
+      "  --frames N      number of frames to simulate (default 1000)\n"
+      "  --seed N        random seed (default 225)\n"
+      "  --threads N     threads to step with, 0 = all cores (default 1)\n"
+      "  --width W       container width (default keeps the app's density)\n"
+      "  --height H      container height (default keeps the app's density)\n"
+      "  --brute-force   use O(N^2) collision detection\n"
+      "  --event-driven  jump between exact collision times\n"
+      "  --adaptive      substep fast frames and sweep fast particles\n"
+      "  --deterministic give bit-identical results for any --threads\n"
+      "  --periodic AXES x, y or xy: wrap particles around those axes\n"
+      "                  instead of bouncing them off walls\n"
+      "  --dt T          time simulated per frame (default 1)\n"
+      "  --narrowphase K scalar, sse2 or avx2 (default: best supported)\n"
+      "  --placement P   uniform, lattice or sequential (default uniform)\n"
+      "  --load FILE     start from a snapshot instead of random particles\n"
+      "  --save FILE     save a snapshot of the final state\n"
+      "  --trajectory FILE\n"
+      "                  write every frame's particles to FILE\n"
+      "  --trajectory-stride N\n"
+      "                  only write every Nth frame (default 1)\n"
+      "  --trajectory-species ID\n"
+      "                  only write particles of species ID, repeatable\n"
+      "  --export PREFIX write rendered frames to PREFIX_<frame>.png\n"
+      "  --export-stride N\n"
+      "                  only export every Nth frame (default 1)\n"
+      "  --export-format F\n"
+      "                  png, or raw to append RGBA pixels to PREFIX.rgba\n"
+      "  --export-width W, --export-height H\n"
+      "                  frame size in pixels (default 1024 x 1024)\n"
+      "  --profile FILE  time each phase of a frame, write a Chrome trace to\n"
+      "                  FILE and print a summary. Needs a build configured\n"
+      "                  with -DIDEALGAS_PROFILING=ON\n"
+      "  --ensemble N    run N containers with consecutive seeds from --seed\n"
+      "                  on --threads threads and print their combined\n"
+      "                  speeds\n"
+      "  --ensemble-csv FILE\n"
+      "                  write each container's observables to FILE\n"
+      "  --hash-log FILE write a hash of the state after every frame to FILE\n"
+      "  --hash-compare FILE\n"
+      "                  report the first frame whose state hash differs from\n"
+      "                  the ones in FILE, written by --hash-log\n"
+      "  --help          show this message\n",
+      program);
+}
+
+Narrowphase::Kernel ParseKernel(const std::string& name) {
+  const Narrowphase::Kernel kernels[] = {Narrowphase::Kernel::kScalar,
+                                         Narrowphase::Kernel::kSse2,
+                                         Narrowphase::Kernel::kAvx2};
+  for (Narrowphase::Kernel kernel : kernels) {
+    if (name != Narrowphase::GetKernelName(kernel)) {
+      continue;
+    } else if (!Narrowphase::IsSupported(kernel)) {
+      throw std::invalid_argument(name + " is not supported on this CPU");
+    }
+    return kernel;
+  }
+  throw std::invalid_argument("Unknown narrowphase kernel " + name);
+}
+
+Placement ParsePlacement(const std::string& name) {
+  if (name == "uniform") {
+    return Placement::kUniform;
+  } else if (name == "lattice") {
+    return Placement::kJitteredLattice;
+  } else if (name == "sequential") {
+    return Placement::kRandomSequential;
+  }
+  throw std::invalid_argument("Unknown placement " + name);
+}
+
+FrameFormat ParseFrameFormat(const std::string& name) {
+  if (name == "png") {
+    return FrameFormat::kPng;
+  } else if (name == "raw") {
+    return FrameFormat::kRaw;
+  }
+  throw std::invalid_argument("Unknown frame format " + name);
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help") {
+      PrintUsage(argv[0]);
+      std::exit(0);
+    } else if (arg == "--brute-force") {
+      options.brute_force = true;
+      continue;
+    } else if (arg == "--event-driven") {
+      options.event_driven = true;
+      continue;
+    } else if (arg == "--adaptive") {
+      options.adaptive = true;
+      continue;
+    } else if (arg == "--deterministic") {
+      options.deterministic = true;
+      continue;
+    }
+
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value for " + arg);
+    }
+    std::string value = argv[++i];
+    if (arg == "--particles") {
+      options.particle_count = std::stoul(value);
+    } else if (arg == "--frames") {
+      options.frame_count = std::stoul(value);
+    } else if (arg == "--seed") {
+      options.seed = std::stoi(value);
+    } else if (arg == "--threads") {
+      options.thread_count = std::stoul(value);
+    } else if (arg == "--dt") {
+      options.dt = std::stof(value);
+    } else if (arg == "--width") {
+      options.width = std::stof(value);
+    } else if (arg == "--height") {
+      options.height = std::stof(value);
+    } else if (arg == "--load") {
+      options.load_path = value;
+    } else if (arg == "--save") {
+      options.save_path = value;
+    } else if (arg == "--periodic") {
+      if (value != "x" && value != "y" && value != "xy") {
+        throw std::invalid_argument("Unknown periodic axes " + value);
+      }
+      options.periodic_x = value.find('x') != std::string::npos;
+      options.periodic_y = value.find('y') != std::string::npos;
+    } else if (arg == "--narrowphase") {
+      options.narrowphase_kernel = ParseKernel(value);
+    } else if (arg == "--placement") {
+      options.placement = ParsePlacement(value);
+    } else if (arg == "--trajectory") {
+      options.trajectory_path = value;
+    } else if (arg == "--trajectory-stride") {
+      options.trajectory.stride = std::stoul(value);
+    } else if (arg == "--trajectory-species") {
+      options.trajectory.species_ids.push_back(
+          static_cast<uint8_t>(std::stoul(value)));
+    } else if (arg == "--export") {
+      options.export_prefix = value;
+    } else if (arg == "--export-stride") {
+      options.frame_export.stride = std::stoul(value);
+    } else if (arg == "--export-format") {
+      options.frame_export.format = ParseFrameFormat(value);
+    } else if (arg == "--export-width") {
+      options.frame_export.width = std::stoul(value);
+    } else if (arg == "--export-height") {
+      options.frame_export.height = std::stoul(value);
+    } else if (arg == "--profile") {
+      if (!Profiler::IsCompiledIn()) {
+        throw std::invalid_argument(
+            "--profile needs a build with -DIDEALGAS_PROFILING=ON");
+      }
+      options.profile_path = value;
+    } else if (arg == "--ensemble") {
+      options.ensemble_count = std::stoul(value);
+    } else if (arg == "--ensemble-csv") {
+      options.ensemble_csv_path = value;
+    } else if (arg == "--hash-log") {
+      options.hash_log_path = value;
+    } else if (arg == "--hash-compare") {
+      options.hash_compare_path = value;
+    } else {
+      throw std::invalid_argument("Unknown option " + arg);
+    }
+  }
+
+  // default to a square container with the same density as the app
+  float side = std::sqrt(static_cast<float>(options.particle_count) *
+                         kDefaultAreaPerParticle);
+  if (options.width <= 0) {
+    options.width = side;
+  }
+  if (options.height <= 0) {
+    options.height = side;
+  }
+  return options;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void PrintStatistics(const GasContainer& container) {
+  const ParticleStore& particles = container.GetParticleStore();
+  const SpeciesRegistry& species = container.GetSpecies();
+
+  double kinetic_energy = 0;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    float speed = particles.GetSpeed(i);
+    kinetic_energy += 0.5 * particles.GetMass(i) * speed * speed;
+  }
+  std::printf("total kinetic energy: %.3f\n", kinetic_energy);
+
+  std::printf("%-12s %10s %12s %12s\n", "species", "particles", "mean speed",
+              "max speed");
+  for (size_t id = 0; id < species.Size(); id++) {
+    const std::vector<float>& speeds =
+        container.GetSpeciesSpeeds(static_cast<uint8_t>(id));
+    double speed_sum = 0;
+    float max_speed = 0;
+    for (float speed : speeds) {
+      speed_sum += speed;
+      max_speed = std::max(max_speed, speed);
+    }
+    double mean_speed = speeds.empty() ? 0 : speed_sum / speeds.size();
+    std::printf("%-12s %10zu %12.4f %12.4f\n",
+                species.Get(static_cast<uint8_t>(id)).name.c_str(),
+                speeds.size(), mean_speed, max_speed);
+  }
+
+  Observables observables = container.GetObservables();
+  std::printf("last %zu frames: pressure %.6g, temperature %.4f, collision "
+              "frequency %.6g, mean free path %.4f\n",
+              observables.frame_count, observables.pressure,
+              observables.temperature, observables.collision_frequency,
+              observables.mean_free_path);
+}
+
+void WriteStateHashes(const std::string& path,
+                      const std::vector<uint64_t>& hashes) {
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    throw std::runtime_error("Can't create " + path);
+  }
+  for (uint64_t hash : hashes) {
+    std::fprintf(file, "%016llx\n", static_cast<unsigned long long>(hash));
+  }
+  std::fclose(file);
+}
+
+std::vector<uint64_t> ReadStateHashes(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    throw std::runtime_error("Can't open " + path);
+  }
+  std::vector<uint64_t> hashes;
+  unsigned long long hash;
+  while (std::fscanf(file, "%llx", &hash) == 1) {
+    hashes.push_back(hash);
+  }
+  std::fclose(file);
+  return hashes;
+}
+
+/**
+ * Prints the first frame whose state hash differs from the ones in the
+ * file at path
+ */
+void CompareStateHashes(const std::string& path,
+                        const std::vector<uint64_t>& hashes) {
+  std::vector<uint64_t> expected = ReadStateHashes(path);
+  size_t frame = FindFirstDivergentFrame(hashes, expected);
+  if (frame < std::min(hashes.size(), expected.size())) {
+    std::printf("state first differs from %s after frame %zu\n", path.c_str(),
+                frame + 1);
+  } else if (hashes.size() != expected.size()) {
+    std::printf("state matches the %zu frames %s and this run share\n",
+                frame, path.c_str());
+  } else {
+    std::printf("state matches %s on all %zu frames\n", path.c_str(), frame);
+  }
+}
+
+/**
+ * Reports the ensemble worlds that failed and passes every result on to an
+ * optional CSV file
+ */
+class CliEnsembleSink : public EnsembleSink {
+ public:
+  /** @param csv_path    file to write the results to, empty for none **/
+  explicit CliEnsembleSink(const std::string& csv_path) {
+    if (!csv_path.empty()) {
+      csv_sink_.reset(new CsvEnsembleSink(csv_path));
+    }
+  }
+
+  void AddResult(const WorldResult& result) override {
+    if (!result.error.empty()) {
+      std::fprintf(stderr, "container %zu: %s\n", result.world_index,
+                   result.error.c_str());
+      failure_count_++;
+    }
+    if (csv_sink_) {
+      csv_sink_->AddResult(result);
+    }
+  }
+
+  size_t GetFailureCount() const {
+    return failure_count_;
+  }
+
+ private:
+  std::unique_ptr<CsvEnsembleSink> csv_sink_;
+  size_t failure_count_ = 0;
+};
+
+/**
+ * Runs options.ensemble_count containers with consecutive seeds and prints
+ * their combined speeds
+ *
+ * @return    exit code of the program
+ */
+int RunEnsemble(const Options& options) {
+  std::vector<WorldSpec> worlds(options.ensemble_count);
+  for (size_t i = 0; i < worlds.size(); i++) {
+    WorldSpec& spec = worlds[i];
+    spec.particle_count = options.particle_count;
+    spec.container_dimension = vec2(options.width, options.height);
+    spec.seed = options.seed + static_cast<int>(i);
+    spec.placement = options.placement;
+    if (options.event_driven) {
+      spec.stepper = Stepper::kEventDriven;
+    } else if (options.adaptive) {
+      spec.stepper = Stepper::kAdaptive;
+    }
+    spec.frame_count = options.frame_count;
+    spec.dt = options.dt;
+  }
+
+  EnsembleOptions ensemble_options;
+  ensemble_options.thread_count = options.thread_count;
+  EnsembleRunner runner(ensemble_options);
+  CliEnsembleSink sink(options.ensemble_csv_path);
+
+  auto run_start = std::chrono::steady_clock::now();
+  runner.Run(worlds, sink);
+  double run_seconds = SecondsSince(run_start);
+
+  std::printf("containers: %zu of %zu particles, frames: %zu, container: "
+              "%.1f x %.1f\n",
+              worlds.size(), options.particle_count, options.frame_count,
+              options.width, options.height);
+  std::printf("threads: %zu, tasks: %zu\n", runner.GetThreadCount(),
+              runner.GetTaskCount());
+  std::printf("run: %.3f s (%.1f containers/s)\n", run_seconds,
+              run_seconds > 0 ? worlds.size() / run_seconds : 0);
+  std::printf("%-12s %12s %12s %10s %10s %10s\n", "species", "samples",
+              "mean speed", "p50", "p90", "p99");
+  for (const auto& entry : runner.GetSpeedDistributions()) {
+    const SpeedDistribution& distribution = entry.second;
+    std::printf("%-12s %12llu %12.4f %10.4f %10.4f %10.4f\n",
+                entry.first.c_str(),
+                static_cast<unsigned long long>(distribution.GetSampleCount()),
+                distribution.GetMean(), distribution.GetQuantile(0.5),
+                distribution.GetQuantile(0.9), distribution.GetQuantile(0.99));
+  }
+  if (!options.ensemble_csv_path.empty()) {
+    std::printf("wrote results to %s\n", options.ensemble_csv_path.c_str());
+  }
+  return sink.GetFailureCount() == 0 ? 0 : 1;
+}
+
+/**
+ * Sets up the container, runs it and prints the results
+ *
+ * @return    exit code of the program
+ */
+int Run(const Options& options) {
+  auto setup_start = std::chrono::steady_clock::now();
+  GasContainer container =
+      options.load_path.empty()
+          ? GasContainer(options.particle_count, vec2(0, 0),
+                         vec2(options.width, options.height), options.seed,
+                         options.placement)
+          : GasContainer::LoadSnapshot(options.load_path);
+  container.SetCollisionDetection(options.brute_force
+                                      ? CollisionDetection::kBruteForce
+                                      : CollisionDetection::kSpatialGrid);
+  if (options.periodic_x) {
+    container.SetBoundary(0, Boundary::kPeriodic);
+  }
+  if (options.periodic_y) {
+    container.SetBoundary(1, Boundary::kPeriodic);
+  }
+  if (options.event_driven) {
+    container.SetStepper(Stepper::kEventDriven);
+  } else if (options.adaptive) {
+    container.SetStepper(Stepper::kAdaptive);
+  }
+  container.SetThreadCount(options.thread_count);
+  container.SetNarrowphaseKernel(options.narrowphase_kernel);
+  container.SetDeterministic(options.deterministic);
+  container.SetStateHashing(!options.hash_log_path.empty() ||
+                            !options.hash_compare_path.empty());
+  double setup_seconds = SecondsSince(setup_start);
+
+  std::printf("particles: %zu, frames: %zu, container: %.1f x %.1f\n",
+              container.GetParticleCount(), options.frame_count,
+              container.GetWidth(), container.GetHeight());
+
+  std::unique_ptr<TrajectoryWriter> trajectory;
+  if (!options.trajectory_path.empty()) {
+    trajectory.reset(new TrajectoryWriter(options.trajectory_path, container,
+                                          options.trajectory));
+  }
+
+  std::unique_ptr<FrameExporter> frame_exporter;
+  if (!options.export_prefix.empty()) {
+    FrameExportOptions frame_export = options.frame_export;
+    frame_export.thread_count = container.GetThreadCount();
+    frame_exporter.reset(
+        new FrameExporter(options.export_prefix, container, frame_export));
+  }
+
+  if (!options.profile_path.empty()) {
+    if (!Profiler::SetHardwareCountersEnabled(true)) {
+      std::printf("hardware counters unavailable, profiling times only\n");
+    }
+    Profiler::SetEnabled(true);
+  }
+
+  auto run_start = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < options.frame_count; frame++) {
+    container.AdvanceOneFrame(options.dt);
+    if (trajectory) {
+      trajectory->AddFrame(container);
+    }
+    if (frame_exporter) {
+      frame_exporter->AddFrame(container);
+    }
+  }
+  double run_seconds = SecondsSince(run_start);
+  Profiler::SetEnabled(false);
+
+  double particle_steps = static_cast<double>(container.GetParticleCount()) *
+                          static_cast<double>(options.frame_count);
+  std::printf("threads: %zu, narrowphase: %s\n", container.GetThreadCount(),
+              Narrowphase::GetKernelName(container.GetNarrowphaseKernel()));
+  std::printf("setup: %.3f ms\n", setup_seconds * 1e3);
+  std::printf("run: %.3f s (%.1f frames/s, %.3f ms/frame, %.2f "
+              "ns/particle-step)\n",
+              run_seconds,
+              options.frame_count > 0 ? options.frame_count / run_seconds : 0,
+              options.frame_count > 0
+                  ? run_seconds * 1e3 / options.frame_count
+                  : 0,
+              particle_steps > 0 ? run_seconds * 1e9 / particle_steps : 0);
+  PrintStatistics(container);
+
+  if (!options.hash_log_path.empty()) {
+    WriteStateHashes(options.hash_log_path, container.GetStateHashes());
+    std::printf("wrote state hashes to %s\n", options.hash_log_path.c_str());
+  }
+  if (!options.hash_compare_path.empty()) {
+    CompareStateHashes(options.hash_compare_path, container.GetStateHashes());
+  }
+
+  if (!options.profile_path.empty()) {
+    Profiler::PrintSummary(stdout);
+    Profiler::WriteChromeTrace(options.profile_path);
+    std::printf("wrote trace to %s\n", options.profile_path.c_str());
+  }
+
+  if (trajectory) {
+    auto close_start = std::chrono::steady_clock::now();
+    trajectory->Close();
+    std::printf("wrote %zu frames to %s, waited %.3f ms to finish, %zu "
+                "stalls\n",
+                trajectory->GetQueuedFrameCount(),
+                options.trajectory_path.c_str(),
+                SecondsSince(close_start) * 1e3, trajectory->GetStallCount());
+  }
+
+  if (frame_exporter) {
+    auto close_start = std::chrono::steady_clock::now();
+    frame_exporter->Close();
+    std::printf("exported %zu frames to %s, waited %.3f ms to finish, %zu "
+                "stalls\n",
+                frame_exporter->GetQueuedFrameCount(),
+                options.export_prefix.c_str(),
+                SecondsSince(close_start) * 1e3,
+                frame_exporter->GetStallCount());
+  }
+
+  if (!options.save_path.empty()) {
+    auto save_start = std::chrono::steady_clock::now();
+    container.SaveSnapshot(options.save_path);
+    std::printf("saved %s in %.3f ms\n", options.save_path.c_str(),
+                SecondsSince(save_start) * 1e3);
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  try {
+    options = ParseOptions(argc, argv);
+  } catch (const std::exception& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  try {
+    return options.ensemble_count > 0 ? RunEnsemble(options) : Run(options);
+  } catch (const std::exception& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+}
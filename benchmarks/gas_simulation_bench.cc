@@ -0,0 +1,566 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gas_container.h"
+#include "histogram.h"
+#include "narrowphase.h"
+#include "particle.h"
+#include "speed_distribution.h"
+#include "thread_pool.h"
+
+using glm::vec2;
+using idealgas::Color;
+using idealgas::GasContainer;
+using idealgas::Histogram;
+using idealgas::Narrowphase;
+using idealgas::Particle;
+using idealgas::ParticleArrays;
+using idealgas::ParticleStore;
+using idealgas::SpeedDistribution;
+using idealgas::Stepper;
+using idealgas::ThreadPool;
+
+namespace {
+
+/** Same particle density as the Cinder app: 30 particles in 700 x 1200 **/
+const float kAppAreaPerParticle = 700.0f * 1200.0f / 30.0f;
+
+/** Four times the app's density, where collisions dominate **/
+const float kDenseAreaPerParticle = kAppAreaPerParticle / 4;
+
+/** Time units each iteration of the stepper benchmarks simulates **/
+const float kStepperBenchmarkTime = 10;
+
+struct Options {
+  size_t min_particles = 100;
+  size_t max_particles = 1000000;
+  double min_seconds = 0.2;  // minimum measured time per benchmark
+  std::string filter;
+  std::string output_path;
+  std::string baseline_path;
+  double tolerance = 0.15;  // allowed slowdown before reporting a regression
+};
+
+struct Result {
+  std::string name;
+  size_t iterations;
+  double seconds;
+
+  /** Particle-steps, values or pairs processed per iteration **/
+  double items_per_iteration;
+
+  double GetNanosecondsPerIteration() const {
+    return seconds * 1e9 / iterations;
+  }
+  double GetNanosecondsPerItem() const {
+    return GetNanosecondsPerIteration() / items_per_iteration;
+  }
+};
+
+void PrintUsage(const char* program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "Benchmarks the simulation and optionally compares with a baseline.\n\n"
+      "  --filter TEXT        only run benchmarks whose name contains TEXT\n"
+      "  --min-particles N    smallest particle count (default 100)\n"
+      "  --max-particles N    largest particle count (default 1000000)\n"
+      "  --min-time S         seconds to measure each benchmark (default "
+      "0.2)\n"
+      "  --output FILE        write the results to FILE as JSON\n"
+      "  --baseline FILE      compare with results written by --output\n"
+      "  --tolerance F        allowed slowdown vs the baseline (default "
+      "0.15)\n"
+      "  --help               show this message\n",
+      program);
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help") {
+      PrintUsage(argv[0]);
+      std::exit(0);
+    }
+
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value for " + arg);
+    }
+    std::string value = argv[++i];
+    if (arg == "--filter") {
+      options.filter = value;
+    } else if (arg == "--min-particles") {
+      options.min_particles = std::stoul(value);
+    } else if (arg == "--max-particles") {
+      options.max_particles = std::stoul(value);
+    } else if (arg == "--min-time") {
+      options.min_seconds = std::stod(value);
+    } else if (arg == "--output") {
+      options.output_path = value;
+    } else if (arg == "--baseline") {
+      options.baseline_path = value;
+    } else if (arg == "--tolerance") {
+      options.tolerance = std::stod(value);
+    } else {
+      throw std::invalid_argument("Unknown option " + arg);
+    }
+  }
+  return options;
+}
+
+/**
+ * Runs benchmarks and collects their results
+ */
+class Runner {
+ public:
+  /** Runs the measured code iteration_count times **/
+  typedef std::function<void(size_t iteration_count)> Body;
+
+  explicit Runner(const Options& options) : options_(options) {
+  }
+
+  bool IsSelected(const std::string& name) const {
+    return name.find(options_.filter) != std::string::npos;
+  }
+
+  /**
+   * Runs body with more and more iterations until it takes at least the
+   * minimum time, then records the last run
+   *
+   * @param name                name of the benchmark
+   * @param items_per_iteration items processed by one iteration
+   * @param body                code to measure
+   */
+  void Run(const std::string& name, double items_per_iteration,
+           const Body& body) {
+    if (!IsSelected(name)) {
+      return;
+    }
+
+    size_t iterations = 1;
+    double seconds = 0;
+    while (true) {
+      auto start = std::chrono::steady_clock::now();
+      body(iterations);
+      seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+      if (seconds >= options_.min_seconds) {
+        break;
+      }
+
+      // aim a bit past the minimum time, growing at most 10x at a time
+      double scale = seconds > 0 ? 1.2 * options_.min_seconds / seconds : 10;
+      iterations = static_cast<size_t>(
+          std::ceil(iterations * std::min(std::max(scale, 1.5), 10.0)));
+    }
+
+    Result result = {name, iterations, seconds, items_per_iteration};
+    results_.push_back(result);
+    std::printf("%-58s %12.2f ns/item %10zu iterations\n", name.c_str(),
+                result.GetNanosecondsPerItem(), iterations);
+    std::fflush(stdout);
+  }
+
+  const std::vector<Result>& GetResults() const {
+    return results_;
+  }
+
+ private:
+  Options options_;
+  std::vector<Result> results_;
+};
+
+std::vector<size_t> GetParticleCounts(const Options& options) {
+  std::vector<size_t> counts;
+  for (size_t count = 100; count <= options.max_particles; count *= 10) {
+    if (count >= options.min_particles) {
+      counts.push_back(count);
+    }
+  }
+  return counts;
+}
+
+/** Powers of two up to the hardware thread count, and the count itself **/
+std::vector<size_t> GetThreadCounts() {
+  std::vector<size_t> counts;
+  size_t hardware_count = ThreadPool::GetHardwareThreadCount();
+  for (size_t count = 1; count < hardware_count; count *= 2) {
+    counts.push_back(count);
+  }
+  counts.push_back(hardware_count);
+  return counts;
+}
+
+vec2 GetContainerSize(size_t particle_count, float area_per_particle) {
+  float side = std::sqrt(static_cast<float>(particle_count) *
+                         area_per_particle);
+  return vec2(side, side);
+}
+
+void BenchmarkAdvanceOneFrame(Runner& runner, const Options& options) {
+  const char* density_names[] = {"app", "dense"};
+  const float densities[] = {kAppAreaPerParticle, kDenseAreaPerParticle};
+
+  for (size_t particle_count : GetParticleCounts(options)) {
+    for (size_t density = 0; density < 2; density++) {
+      for (size_t thread_count : GetThreadCounts()) {
+        std::ostringstream name;
+        name << "AdvanceOneFrame/n:" << particle_count
+             << "/density:" << density_names[density]
+             << "/threads:" << thread_count;
+        if (!runner.IsSelected(name.str())) {
+          continue;
+        }
+
+        GasContainer container(
+            particle_count, vec2(0, 0),
+            GetContainerSize(particle_count, densities[density]), 225);
+        container.SetThreadCount(thread_count);
+        container.AdvanceOneFrame();  // warm up the scratch buffers
+        runner.Run(name.str(), static_cast<double>(particle_count),
+                   [&container](size_t iteration_count) {
+                     for (size_t i = 0; i < iteration_count; i++) {
+                       container.AdvanceOneFrame();
+                     }
+                   });
+      }
+    }
+  }
+}
+
+/**
+ * Cost of simulating the same amount of time with each stepper: the fixed
+ * time step takes one frame per time unit, the others one long frame
+ */
+void BenchmarkSteppers(Runner& runner, const Options& options) {
+  const char* stepper_names[] = {"fixed", "adaptive", "event-driven"};
+  const Stepper steppers[] = {Stepper::kFixedTimeStep, Stepper::kAdaptive,
+                              Stepper::kEventDriven};
+
+  for (size_t particle_count : GetParticleCounts(options)) {
+    for (size_t s = 0; s < 3; s++) {
+      std::ostringstream name;
+      name << "SimulatedTime/n:" << particle_count
+           << "/stepper:" << stepper_names[s];
+      if (!runner.IsSelected(name.str())) {
+        continue;
+      }
+
+      GasContainer container(
+          particle_count, vec2(0, 0),
+          GetContainerSize(particle_count, kAppAreaPerParticle), 225);
+      container.SetStepper(steppers[s]);
+      size_t frame_count = 1;
+      float dt = kStepperBenchmarkTime;
+      if (steppers[s] == Stepper::kFixedTimeStep) {
+        frame_count = static_cast<size_t>(kStepperBenchmarkTime);
+        dt = 1;
+      }
+      container.AdvanceOneFrame(dt);  // warm up the scratch buffers
+      runner.Run(name.str(),
+                 static_cast<double>(particle_count) * kStepperBenchmarkTime,
+                 [&container, frame_count, dt](size_t iteration_count) {
+                   for (size_t i = 0; i < iteration_count * frame_count;
+                        i++) {
+                     container.AdvanceOneFrame(dt);
+                   }
+                 });
+    }
+  }
+}
+
+void BenchmarkInitialization(Runner& runner, const Options& options) {
+  for (size_t particle_count : GetParticleCounts(options)) {
+    std::ostringstream name;
+    name << "GasContainer/n:" << particle_count;
+    vec2 size = GetContainerSize(particle_count, kAppAreaPerParticle);
+    runner.Run(name.str(), static_cast<double>(particle_count),
+               [particle_count, size](size_t iteration_count) {
+                 for (size_t i = 0; i < iteration_count; i++) {
+                   GasContainer container(particle_count, vec2(0, 0), size,
+                                          225);
+                 }
+               });
+  }
+}
+
+void BenchmarkHistogram(Runner& runner, const Options& options) {
+  const int kBinCount = 10;
+  size_t value_count = options.max_particles;
+  std::vector<float> speeds(value_count);
+  srand(225);
+  for (float& speed : speeds) {
+    speed = 10.0f * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+  }
+
+  Histogram histogram(vec2(0, 0), vec2(400, 400), Color("blue"),
+                      Color("white"), "Speed", "Frequency");
+  std::ostringstream name;
+  name << "Histogram::UpdateData/n:" << value_count << "/threads:1";
+  runner.Run(name.str(), static_cast<double>(value_count),
+             [&](size_t iteration_count) {
+               for (size_t i = 0; i < iteration_count; i++) {
+                 histogram.UpdateData(speeds, kBinCount);
+               }
+             });
+
+  // keeps adding to the same distribution, like a long running simulation
+  SpeedDistribution distribution;
+  std::ostringstream distribution_name;
+  distribution_name << "SpeedDistribution::AddFrame/n:" << value_count;
+  runner.Run(distribution_name.str(), static_cast<double>(value_count),
+             [&](size_t iteration_count) {
+               for (size_t i = 0; i < iteration_count; i++) {
+                 distribution.AddFrame(speeds);
+               }
+             });
+
+  for (size_t thread_count : GetThreadCounts()) {
+    if (thread_count == 1) {
+      continue;
+    }
+    ThreadPool thread_pool(thread_count);
+    std::ostringstream parallel_name;
+    parallel_name << "Histogram::UpdateData/n:" << value_count
+                  << "/threads:" << thread_count;
+    runner.Run(parallel_name.str(), static_cast<double>(value_count),
+               [&](size_t iteration_count) {
+                 for (size_t i = 0; i < iteration_count; i++) {
+                   histogram.UpdateData(speeds.data(),
+                                        speeds.data() + speeds.size(),
+                                        kBinCount, thread_pool);
+                 }
+               });
+  }
+}
+
+void BenchmarkCollisionKernels(Runner& runner) {
+  // a crowded box, so about half of the pairs are touching
+  const size_t kParticleCount = 1024;
+  srand(225);
+  std::vector<Particle> particles;
+  ParticleStore store;
+  for (size_t i = 0; i < kParticleCount; i++) {
+    vec2 position(100.0f * rand() / RAND_MAX, 100.0f * rand() / RAND_MAX);
+    vec2 velocity(14.0f * rand() / RAND_MAX - 7, 14.0f * rand() / RAND_MAX - 7);
+    particles.push_back(Particle(position, velocity, Color("red"), 20, 5));
+    store.Add(position, velocity, 20, 5, 0);
+  }
+  double pair_count = static_cast<double>(kParticleCount) *
+                      static_cast<double>(kParticleCount - 1) / 2;
+
+  // results go into a volatile so the tests aren't optimized away
+  volatile size_t contact_count = 0;
+  runner.Run("Particle::IsTouching+IsApproaching", pair_count,
+             [&](size_t iteration_count) {
+               size_t contacts = 0;
+               for (size_t iteration = 0; iteration < iteration_count;
+                    iteration++) {
+                 for (size_t i = 0; i < kParticleCount; i++) {
+                   for (size_t j = i + 1; j < kParticleCount; j++) {
+                     contacts += particles[i].IsTouching(particles[j]) &&
+                                 particles[i].IsApproaching(particles[j]);
+                   }
+                 }
+               }
+               contact_count = contacts;
+             });
+
+  runner.Run("Particle::UpdateVelocitiesForParticleCollision",
+             static_cast<double>(kParticleCount - 1),
+             [&](size_t iteration_count) {
+               for (size_t iteration = 0; iteration < iteration_count;
+                    iteration++) {
+                 for (size_t i = 0; i + 1 < kParticleCount; i++) {
+                   particles[i].UpdateVelocitiesForParticleCollision(
+                       particles[i + 1]);
+                 }
+               }
+             });
+
+  const Narrowphase::Kernel kernels[] = {Narrowphase::Kernel::kScalar,
+                                         Narrowphase::Kernel::kSse2,
+                                         Narrowphase::Kernel::kAvx2};
+  ParticleArrays arrays(store);
+  for (Narrowphase::Kernel kernel : kernels) {
+    if (!Narrowphase::IsSupported(kernel)) {
+      continue;
+    }
+    Narrowphase narrowphase(kernel);
+    runner.Run(std::string("Narrowphase::FindContacts/") +
+                   Narrowphase::GetKernelName(kernel),
+               pair_count, [&](size_t iteration_count) {
+                 size_t contacts = 0;
+                 for (size_t iteration = 0; iteration < iteration_count;
+                      iteration++) {
+                   for (size_t i = 0; i < kParticleCount; i++) {
+                     for (size_t block = i + 1; block < kParticleCount;
+                          block += Narrowphase::kBlockSize) {
+                       size_t count = std::min(Narrowphase::kBlockSize,
+                                               kParticleCount - block);
+                       uint32_t mask =
+                           narrowphase.FindContacts(arrays, i, block, count);
+                       for (; mask != 0; mask &= mask - 1) {
+                         contacts++;
+                       }
+                     }
+                   }
+                 }
+                 contact_count = contacts;
+               });
+  }
+}
+
+std::string EscapeJson(const std::string& text) {
+  std::string escaped;
+  for (char character : text) {
+    if (character == '"' || character == '\\') {
+      escaped += '\\';
+    }
+    escaped += character;
+  }
+  return escaped;
+}
+
+/**
+ * Writes one benchmark per line, which is also what ReadBaseline expects
+ */
+void WriteResults(const std::string& path, const std::vector<Result>& results) {
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error("Can't write " + path);
+  }
+
+  file << "{\n  \"context\": {\"hardware_threads\": "
+       << ThreadPool::GetHardwareThreadCount() << ", \"narrowphase\": \""
+       << Narrowphase::GetKernelName(Narrowphase::GetBestKernel())
+       << "\"},\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& result = results[i];
+    char numbers[160];
+    std::snprintf(numbers, sizeof(numbers),
+                  "\"iterations\": %zu, \"ns_per_iteration\": %.3f, "
+                  "\"ns_per_item\": %.4f",
+                  result.iterations, result.GetNanosecondsPerIteration(),
+                  result.GetNanosecondsPerItem());
+    file << "    {\"name\": \"" << EscapeJson(result.name) << "\", "
+         << numbers << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+}
+
+/**
+ * Reads the name and ns_per_item of each benchmark in a file written by
+ * WriteResults
+ */
+std::vector<std::pair<std::string, double>> ReadBaseline(
+    const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Can't read " + path);
+  }
+
+  const std::string kNameKey = "\"name\": \"";
+  const std::string kTimeKey = "\"ns_per_item\": ";
+  std::vector<std::pair<std::string, double>> baseline;
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t name_start = line.find(kNameKey);
+    size_t time_start = line.find(kTimeKey);
+    if (name_start == std::string::npos || time_start == std::string::npos) {
+      continue;
+    }
+    name_start += kNameKey.size();
+    size_t name_end = line.find('"', name_start);
+    baseline.push_back(std::make_pair(
+        line.substr(name_start, name_end - name_start),
+        std::strtod(line.c_str() + time_start + kTimeKey.size(), nullptr)));
+  }
+  return baseline;
+}
+
+/**
+ * Prints how each result compares with the baseline
+ *
+ * @return    number of results slower than the baseline by more than the
+ *            tolerance
+ */
+size_t CompareWithBaseline(const std::vector<Result>& results,
+                           const Options& options) {
+  std::vector<std::pair<std::string, double>> baseline =
+      ReadBaseline(options.baseline_path);
+  size_t regression_count = 0;
+
+  std::printf("\n%-58s %12s %12s %8s\n", "benchmark", "baseline", "current",
+              "change");
+  for (const Result& result : results) {
+    auto match = std::find_if(
+        baseline.begin(), baseline.end(),
+        [&result](const std::pair<std::string, double>& entry) {
+          return entry.first == result.name;
+        });
+    double current = result.GetNanosecondsPerItem();
+    if (match == baseline.end() || match->second <= 0) {
+      std::printf("%-58s %12s %12.2f %8s\n", result.name.c_str(), "-",
+                  current, "new");
+      continue;
+    }
+
+    double change = current / match->second - 1;
+    bool is_regression = change > options.tolerance;
+    regression_count += is_regression;
+    std::printf("%-58s %12.2f %12.2f %+7.1f%%%s\n", result.name.c_str(),
+                match->second, current, change * 100,
+                is_regression ? "  REGRESSION" : "");
+  }
+  return regression_count;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  try {
+    options = ParseOptions(argc, argv);
+  } catch (const std::exception& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  Runner runner(options);
+  BenchmarkCollisionKernels(runner);
+  BenchmarkHistogram(runner, options);
+  BenchmarkInitialization(runner, options);
+  BenchmarkAdvanceOneFrame(runner, options);
+  BenchmarkSteppers(runner, options);
+
+  try {
+    if (!options.output_path.empty()) {
+      WriteResults(options.output_path, runner.GetResults());
+    }
+    if (!options.baseline_path.empty()) {
+      size_t regression_count =
+          CompareWithBaseline(runner.GetResults(), options);
+      if (regression_count > 0) {
+        std::printf("\n%zu benchmarks regressed by more than %.0f%%\n",
+                    regression_count, options.tolerance * 100);
+        return 1;
+      }
+    }
+  } catch (const std::exception& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  return 0;
+}
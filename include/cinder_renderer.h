@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cinder/gl/gl.h"
+#include "color.h"
+#include "gas_container.h"
+#include "histogram.h"
+
+namespace idealgas {
+
+/**
+ * Render layer that draws the simulation objects with Cinder's OpenGL API.
+ * The simulation core (gas-core) doesn't depend on Cinder; only the Cinder
+ * app links this.
+ */
+
+/**
+ * Converts a core Color to the equivalent Cinder color
+ *
+ * @param color   color to convert
+ * @return        the same color as a ci::Color
+ */
+ci::Color ToCinderColor(const Color& color);
+
+/**
+ * Draws the container walls and the current positions of the particles
+ *
+ * @param container   container to draw
+ */
+void DrawGasContainer(const GasContainer& container);
+
+/**
+ * Draws the walls and particles of a container from its parts, for
+ * callers that keep a copy of the particles
+ *
+ * @param particles       particles to draw
+ * @param species         species of the particles, for their colors
+ * @param top_left        top left corner of the walls
+ * @param bottom_right    bottom right corner of the walls
+ */
+void DrawParticles(const ParticleStore& particles,
+                   const SpeciesRegistry& species, const glm::vec2& top_left,
+                   const glm::vec2& bottom_right);
+
+/**
+ * Draws the bars, axis and labels of a histogram
+ *
+ * @param histogram   histogram to draw
+ */
+void DrawHistogram(const Histogram& histogram);
+
+}  // namespace idealgas
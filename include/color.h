@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+namespace idealgas {
+
+/**
+ * RGB color with components in [0, 1]. Lets the simulation core describe
+ * how species and histograms should look without depending on Cinder; the
+ * render layer converts it to a ci::Color when drawing.
+ */
+struct Color {
+  float r;
+  float g;
+  float b;
+
+  /** Black **/
+  Color();
+  Color(float red, float green, float blue);
+
+  /**
+   * Looks up one of the named SVG colors "black", "white", "red", "green",
+   * "blue", "yellow", "cyan", "magenta", "orange", "purple" or "gray". Named
+   * colors match the values Cinder uses for the same names.
+   *
+   * @param name    the color name, lower case
+   * @throws std::invalid_argument if the name is not one of the above
+   */
+  Color(const char* name);
+  Color(const std::string& name);
+
+  bool operator==(const Color& other) const;
+  bool operator!=(const Color& other) const;
+};
+
+}  // namespace idealgas
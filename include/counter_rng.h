@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace idealgas {
+
+/**
+ * Counter-based random number generator (Philox4x32-10). Every call maps
+ * (seed, stream, index, counter) to four random 32-bit words without any
+ * state, so numbers can be generated for any particle from any thread in any
+ * order and still come out the same. Different streams give independent
+ * sequences for the same index.
+ */
+class CounterRng {
+ public:
+  /** Four random 32-bit words **/
+  typedef std::array<uint32_t, 4> Block;
+
+  CounterRng() = default;
+
+  /**
+   * @param seed    key of the generator
+   */
+  explicit CounterRng(uint64_t seed);
+
+  /**
+   * Generates the block of random words at a position
+   *
+   * @param stream  sequence to draw from, e.g. one per stochastic feature
+   * @param index   position in the sequence, e.g. the particle index
+   * @param counter further position for more than one block per index
+   * @return        four random words
+   */
+  Block Generate(uint32_t stream, uint64_t index, uint32_t counter = 0) const;
+
+  uint64_t GetSeed() const;
+
+  /**
+   * Maps a random word to a float in [0, 1) using its top 24 bits, so every
+   * value is exactly representable
+   */
+  static float ToUnitFloat(uint32_t bits);
+
+ private:
+  uint64_t seed_ = 0;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gas_container.h"
+#include "particle_store.h"
+#include "species_registry.h"
+#include "transport.h"
+
+namespace idealgas {
+
+/**
+ * Parameters of a container to start a DomainCoordinator from without
+ * building it, the same as those of the GasContainer constructors with
+ * Placement::kUniform
+ */
+struct DomainSetup {
+  size_t particle_count = 0;
+  glm::vec2 top_left_position = glm::vec2(0, 0);
+  glm::vec2 container_dimension = glm::vec2(0, 0);
+  int seed = 0;
+
+  /** Species of the particles, the GasContainer defaults if empty **/
+  SpeciesRegistry species;
+};
+
+/**
+ * Runs a GasContainer split across processes. Rank 0 coordinates and every
+ * other rank is a worker that owns one vertical slab of the container: the
+ * particles whose x falls in it. The first and last slabs extend past the
+ * walls, so particles that overshoot a wall keep their owner.
+ *
+ * Started from a DomainSetup, each worker generates only the particles of
+ * its own slab, and rank 0 never holds any particles: it sends commands and
+ * nothing else, so memory and work per frame on every rank grow with the
+ * particles of a slab rather than of the whole container.
+ *
+ * Every frame the workers swap halos (the particles within two radii of a
+ * slab boundary) with their neighbors and find the colliding pairs that
+ * touch a particle they own. They choose the pairs to resolve the way the
+ * fixed time step does, in order of the particle ids with each particle in
+ * at most one pair. A pair across a slab boundary is found by the owners of
+ * both particles, and whether it is resolved depends on the earlier pairs of
+ * either particle, so the two owners trade what they know of their own
+ * particle until both can tell. The workers then resolve the pairs, bounce
+ * off the walls, move their particles and hand the ones that crossed into
+ * another slab to its owner.
+ *
+ * The floating point operations are the ones a single process makes, so the
+ * particles match a GasContainer with the fixed time step bit for bit.
+ */
+class DomainCoordinator {
+ public:
+  /**
+   * Has every worker, ranks 1 up to the rank count of transport, generate
+   * the particles of its slab
+   *
+   * @param setup       container to start from
+   * @param transport   transport of rank 0
+   * @throws std::invalid_argument if transport isn't rank 0 of at least two
+   *         ranks, or if the slabs are narrower than the halos
+   */
+  DomainCoordinator(const DomainSetup& setup, Transport& transport);
+
+  /**
+   * Sends the particles of container to the workers. Rank 0 has to hold the
+   * whole container for this, so it is meant for states that were built or
+   * loaded in one process already. The container itself isn't changed.
+   *
+   * @param container   state to start from
+   * @param transport   transport of rank 0
+   * @throws std::invalid_argument if transport isn't rank 0 of at least two
+   *         ranks, if the slabs are narrower than the halos, or if container
+   *         has a periodic axis
+   */
+  DomainCoordinator(const GasContainer& container, Transport& transport);
+
+  /** Stops the workers if Stop wasn't called **/
+  ~DomainCoordinator();
+
+  DomainCoordinator(const DomainCoordinator&) = delete;
+  DomainCoordinator& operator=(const DomainCoordinator&) = delete;
+
+  /**
+   * Has the workers advance every particle like GasContainer::AdvanceOneFrame
+   * with the fixed time step. Only sends the command, the workers take it
+   * from there.
+   *
+   * @param dt  amount of time to simulate
+   * @throws std::invalid_argument if dt isn't positive
+   */
+  void AdvanceOneFrame(float dt = 1);
+
+  /**
+   * Called with the particles of one worker at a time, and the index each
+   * has in the container the run started from
+   */
+  typedef std::function<void(const std::vector<uint64_t>& ids,
+                             const ParticleStore& particles)>
+      SlabVisitor;
+
+  /**
+   * Streams the particles of the workers to visit, one slab at a time, so
+   * rank 0 never holds more than one slab
+   *
+   * @throws std::runtime_error if a worker sends an unknown particle
+   */
+  void GatherParticles(const SlabVisitor& visit);
+
+  /**
+   * Collects every particle from the workers into one store, which takes
+   * memory for the whole container on rank 0
+   *
+   * @return    the particles, in the order of the container they started
+   *            from
+   * @throws std::runtime_error if the workers don't hold every particle once
+   */
+  ParticleStore GatherParticles();
+
+  /** Makes every RunDomainWorker return. No other call may follow. **/
+  void Stop();
+
+  /** Number of frames advanced since construction **/
+  uint64_t GetFrameCount() const;
+
+ private:
+  Transport& transport_;
+  size_t particle_count_;
+  uint64_t frame_count_ = 0;
+  bool is_stopped_ = false;
+
+  /** Kept to avoid reallocating every frame **/
+  std::vector<uint8_t> message_;
+
+  size_t GetWorkerCount() const;
+
+  /**
+   * Checks transport and the slab width, and finds the boundaries between
+   * the slabs of a container
+   *
+   * @throws std::invalid_argument if the setup can't be split
+   */
+  std::vector<float> FindSlabBoundaries(const glm::vec2& top_left,
+                                        float width, float halo_width) const;
+};
+
+/**
+ * Runs the worker of the calling rank, which must not be 0, until the
+ * coordinator calls Stop
+ *
+ * @param transport   transport of this rank
+ * @throws std::runtime_error if the transport fails
+ */
+void RunDomainWorker(Transport& transport);
+
+}  // namespace idealgas
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gas_container.h"
+#include "observables.h"
+#include "species_registry.h"
+#include "speed_distribution.h"
+#include "work_stealing_pool.h"
+
+namespace idealgas {
+
+/**
+ * One container of an ensemble and how long to run it
+ */
+struct WorldSpec {
+  size_t particle_count = 100;
+
+  /** <width, height> of the container, whose top left corner is (0, 0) **/
+  glm::vec2 container_dimension = glm::vec2(1000, 1000);
+  int seed = 0;
+
+  /** Species to generate, the default blue, red and green ones if empty **/
+  SpeciesRegistry species;
+  Placement placement = Placement::kUniform;
+  Stepper stepper = Stepper::kFixedTimeStep;
+  size_t frame_count = 1000;
+  float dt = 1;
+};
+
+/**
+ * Outcome of one world of an ensemble
+ */
+struct WorldResult {
+  /** Index of the world in the specs given to EnsembleRunner::Run **/
+  size_t world_index = 0;
+  int seed = 0;
+  size_t particle_count = 0;
+  uint64_t frame_count = 0;
+
+  /** Observables averaged over the last frames of the world **/
+  Observables observables;
+
+  /** Wall clock time the world took to set up and run **/
+  double seconds = 0;
+
+  /** Why the world couldn't be run, empty if it ran **/
+  std::string error;
+};
+
+/**
+ * Receives the result of each world of an ensemble as soon as it finishes,
+ * in whatever order the worlds finish
+ */
+class EnsembleSink {
+ public:
+  virtual ~EnsembleSink() = default;
+
+  /**
+   * Called once per world, from the thread that ran it. Calls never
+   * overlap, so sinks need no locking of their own.
+   */
+  virtual void AddResult(const WorldResult& result) = 0;
+};
+
+/**
+ * Sink that writes one line of comma separated values per world, flushed
+ * as it arrives so a long ensemble can be followed while it runs
+ */
+class CsvEnsembleSink : public EnsembleSink {
+ public:
+  /**
+   * Creates the file and writes the header line
+   *
+   * @param path    file to write
+   * @throws std::runtime_error if the file can't be created
+   */
+  explicit CsvEnsembleSink(const std::string& path);
+
+  void AddResult(const WorldResult& result) override;
+
+ private:
+  std::ofstream file_;
+};
+
+/**
+ * Settings of an EnsembleRunner
+ */
+struct EnsembleOptions {
+  /** Threads the worlds run on, 0 to use one per hardware thread **/
+  size_t thread_count = 0;
+
+  /**
+   * Worlds with fewer particle frames than this are packed together into
+   * one task, so tiny worlds don't each pay for being scheduled
+   */
+  uint64_t min_task_particle_frames = 1 << 18;
+
+  /** Speeds are added to the distributions every this many frames **/
+  size_t speed_sample_stride = 10;
+
+  float max_speed = SpeedDistribution::kDefaultMaxSpeed;
+  size_t bin_count = SpeedDistribution::kDefaultBinCount;
+};
+
+/**
+ * Runs many independent containers at once. Each world runs on one thread
+ * of a WorkStealingPool, so the threads stay busy however uneven the
+ * worlds are; the largest worlds are started first. Worlds too small to be
+ * worth a task of their own are packed into tasks with other small worlds.
+ *
+ * The speeds of every world are sampled into one SpeedDistribution per
+ * species name. Each world samples into its own distributions, which are
+ * added up in world order at the end, so the totals don't depend on the
+ * thread count.
+ */
+class EnsembleRunner {
+ public:
+  explicit EnsembleRunner(const EnsembleOptions& options = EnsembleOptions());
+
+  /**
+   * Runs every world and hands its result to sink. A world that can't be
+   * set up, e.g. because its particles don't fit, gets a result with an
+   * error instead of stopping the others.
+   *
+   * @param worlds  the worlds to run
+   * @param sink    receives the result of each world
+   */
+  void Run(const std::vector<WorldSpec>& worlds, EnsembleSink& sink);
+
+  /**
+   * Speeds of every world of the last Run, by species name
+   */
+  const std::map<std::string, SpeedDistribution>& GetSpeedDistributions()
+      const;
+
+  /** Number of tasks the worlds of the last Run were packed into **/
+  size_t GetTaskCount() const;
+  size_t GetThreadCount() const;
+
+ private:
+  EnsembleOptions options_;
+  WorkStealingPool pool_;
+  std::map<std::string, SpeedDistribution> speed_distributions_;
+  size_t task_count_ = 0;
+
+  /** Serializes the calls to the sink **/
+  std::mutex sink_mutex_;
+
+  /**
+   * Runs one world
+   *
+   * @param spec            the world
+   * @param distributions   set to the world's speed distribution of each
+   *                        species id
+   * @param species         set to the world's species
+   * @return                the result, with an error if the world failed
+   */
+  WorldResult RunWorld(const WorldSpec& spec,
+                       std::vector<SpeedDistribution>& distributions,
+                       SpeciesRegistry& species) const;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "observables.h"
+#include "particle_store.h"
+#include "species_registry.h"
+
+namespace idealgas {
+
+/**
+ * Event-driven hard-sphere stepper. Instead of moving every particle by a
+ * fixed step and testing for overlaps, it computes the exact time of the next
+ * particle-particle and particle-wall collisions, keeps them in a priority
+ * queue and jumps straight from one event to the next. Fast particles can't
+ * tunnel through each other, and in a dilute gas a frame costs time
+ * proportional to the number of collisions instead of the number of
+ * particles.
+ *
+ * Candidate partners are limited to the neighboring cells of a cell list
+ * whose cells are at least one diameter wide. Particles change cells through
+ * cell-crossing events, so the cell list is always exact. Events are
+ * invalidated lazily: each particle counts the events it took part in, and an
+ * event is skipped if a count changed since it was predicted.
+ *
+ * Particles are only moved to the current time when they take part in an
+ * event, and all of them are brought up to date at the end of Advance.
+ */
+class EventDrivenStepper {
+ public:
+  /**
+   * Builds the cell list and predicts the first events of every particle.
+   * Must be called again whenever particles are added or moved by anything
+   * other than this stepper.
+   *
+   * @param particles       particles to simulate
+   * @param top_left        top left corner of the container
+   * @param bottom_right    bottom right corner of the container
+   */
+  void Initialize(const ParticleStore& particles, const glm::vec2& top_left,
+                  const glm::vec2& bottom_right);
+
+  /**
+   * Processes every event in the next duration time units, then moves every
+   * particle to the end of that interval
+   *
+   * @param particles   the particles passed to Initialize
+   * @param species     species of the particles, for the mass fractions
+   * @param duration    amount of time to simulate, 1 is one fixed step
+   * @param sums        if not null, the wall impulse and the particle
+   *                    collisions of the events are added to it
+   */
+  void Advance(ParticleStore& particles, const SpeciesRegistry& species,
+               double duration, ObservableSums* sums = nullptr);
+
+  /** Simulated time since Initialize **/
+  double GetTime() const;
+  size_t GetParticleCollisionCount() const;
+  size_t GetWallCollisionCount() const;
+
+ private:
+  enum class EventType : uint8_t { kParticle, kWall, kCellCrossing };
+
+  struct Event {
+    double time;
+    EventType type;
+    size_t first;
+
+    /**
+     * kParticle: index of the other particle. kWall: 0 for a vertical wall,
+     * 1 for a horizontal wall. kCellCrossing: index of the new cell.
+     */
+    size_t second;
+
+    /** event_counts_ of the particles when the event was predicted **/
+    uint64_t first_count;
+    uint64_t second_count;
+
+    /** Orders by time, then by the other fields to break ties the same way
+     * on every run **/
+    bool operator>(const Event& other) const;
+  };
+
+  /** Upper bound on the number of cells per particle, as in SpatialGrid **/
+  const size_t kMaxCellsPerParticle = 4;
+
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+  double time_ = 0;
+  size_t particle_collision_count_ = 0;
+  size_t wall_collision_count_ = 0;
+
+  /** Time each particle's position in the store corresponds to **/
+  std::vector<double> particle_times_;
+
+  /** Number of events each particle has taken part in **/
+  std::vector<uint64_t> event_counts_;
+
+  glm::vec2 top_left_;
+  glm::vec2 bottom_right_;
+  float cell_size_ = 1;
+  size_t column_count_ = 1;
+  size_t row_count_ = 1;
+  std::vector<std::vector<size_t>> cell_particles_;
+  std::vector<size_t> particle_cells_;
+
+  size_t GetCellIndex(const glm::vec2& position) const;
+  void RemoveFromCell(size_t particle_index);
+
+  /**
+   * Position of a particle at time, which must not be before the time its
+   * position in the store was last updated
+   */
+  glm::dvec2 GetPositionAt(const ParticleStore& particles, size_t index,
+                           double time) const;
+
+  /** Moves a particle in the store to time **/
+  void MoveToTime(ParticleStore& particles, size_t index, double time);
+
+  /** Pushes the next collision, wall and cell-crossing events of a particle **/
+  void PredictEvents(const ParticleStore& particles, size_t index);
+
+  /**
+   * @return    time from now until the two particles collide, or a negative
+   *            number if they never do. 0 if they overlap and approach.
+   */
+  double GetTimeToCollision(const ParticleStore& particles, size_t index_one,
+                            size_t index_two) const;
+
+  void PredictWallEvent(const ParticleStore& particles, size_t index,
+                        const glm::dvec2& position);
+  void PredictCellCrossing(const ParticleStore& particles, size_t index,
+                           const glm::dvec2& position);
+  bool IsValid(const Event& event) const;
+};
+
+}  // namespace idealgas
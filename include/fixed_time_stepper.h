@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "particle_store.h"
+#include "species_registry.h"
+
+namespace idealgas {
+
+/**
+ * The fixed time step of GasContainer for a BasicParticleStore of any
+ * dimension and precision, so 3D boxes and double precision runs step with
+ * the same collision response, wall handling and integration as the 2D
+ * float container. Collisions use inverse masses unless SetSpecies gives
+ * the container's mass fractions, which makes a 2D float store step exactly
+ * like a GasContainer with brute force collision detection.
+ *
+ * Each frame follows the same phases as GasContainer::AdvanceOneFrame: every
+ * touching and approaching pair is found, pairs are resolved in increasing
+ * index order with each particle colliding at most once, the particles that
+ * didn't collide bounce off the walls, and every particle moves. Pairs are
+ * found by testing every pair on one thread, since the spatial grid and the
+ * SIMD narrowphase only handle the 2D float store.
+ */
+template <int Dimension, typename Scalar>
+class BasicFixedTimeStepper {
+ public:
+  typedef BasicParticleStore<Dimension, Scalar> Store;
+  typedef typename Store::Vector Vector;
+
+  /**
+   * @param top_left        corner of the container with the lowest
+   *                        coordinates
+   * @param bottom_right    corner of the container with the highest
+   *                        coordinates
+   */
+  BasicFixedTimeStepper(const Vector& top_left, const Vector& bottom_right);
+
+  /**
+   * Advances every particle by one frame of dt time units
+   *
+   * @param particles   particles to move
+   * @param dt          amount of time to simulate
+   */
+  void AdvanceOneFrame(Store& particles, Scalar dt = 1);
+
+  /**
+   * Resolves collisions with the precomputed mass fractions of the species
+   * instead of the particles' inverse masses. The fractions are floats, so
+   * double precision runs should keep the inverse masses.
+   *
+   * @param species     registry the species ids of the particles refer to
+   */
+  void SetSpecies(const SpeciesRegistry& species);
+
+  /** Pairs resolved in the last frame, in the order they were resolved **/
+  const std::vector<std::pair<size_t, size_t>>& GetResolvedPairs() const;
+
+ private:
+  Vector top_left_;
+  Vector bottom_right_;
+
+  /** Empty unless SetSpecies was called, indexed [one][two] **/
+  std::vector<Scalar> mass_fractions_;
+  size_t species_count_;
+
+  /** Kept to avoid reallocating every frame **/
+  std::vector<std::pair<size_t, size_t>> resolved_pairs_;
+  std::vector<uint8_t> has_collided_;
+
+  /** Updates the velocities of a touching and approaching pair **/
+  void ResolveCollision(Store& particles, size_t index_one,
+                        size_t index_two) const;
+};
+
+// the members are defined in fixed_time_stepper.cc for these only
+extern template class BasicFixedTimeStepper<2, float>;
+extern template class BasicFixedTimeStepper<3, float>;
+extern template class BasicFixedTimeStepper<2, double>;
+extern template class BasicFixedTimeStepper<3, double>;
+
+}  // namespace idealgas
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gas_container.h"
+#include "histogram.h"
+#include "software_renderer.h"
+
+namespace idealgas {
+
+/**
+ * File format of exported frames
+ */
+enum class FrameFormat {
+  /** One PNG file per frame **/
+  kPng,
+  /**
+   * Every frame appended to one file of raw 8-bit RGBA pixels, which video
+   * encoders can read directly (e.g. ffmpeg -f rawvideo -pix_fmt rgba)
+   */
+  kRaw
+};
+
+/**
+ * Settings of a FrameExporter
+ */
+struct FrameExportOptions {
+  /** Size of the frames in pixels **/
+  size_t width = 1024;
+  size_t height = 1024;
+
+  /** Only frames whose frame count is a multiple of stride are exported **/
+  size_t stride = 1;
+
+  FrameFormat format = FrameFormat::kPng;
+
+  /** Threads the rasterizer uses, besides the export thread itself **/
+  size_t thread_count = 1;
+
+  /**
+   * Frames that can wait to be drawn before AddFrame has to wait for the
+   * export thread
+   */
+  size_t buffer_count = 2;
+
+  /** Whether to draw a speed histogram per species left of the container **/
+  bool draw_histograms = true;
+  int histogram_bin_count = 10;
+};
+
+/**
+ * Draws frames of a GasContainer with the SoftwareRenderer and writes them
+ * to image files, on a background thread so drawing overlaps the
+ * simulation. AddFrame only copies the particles and speeds into a free
+ * buffer from a small pool.
+ *
+ * The layout follows the Cinder app: a column of speed histograms, one per
+ * species, on the left, and the container scaled to fit on the right.
+ */
+class FrameExporter {
+ public:
+  /**
+   * Lays out the frames and starts the export thread
+   *
+   * @param path_prefix PNG frames are written to
+   *                    <path_prefix>_<frame count, 6 digits>.png and raw
+   *                    frames are appended to <path_prefix>.rgba
+   * @param container   container the frames will come from
+   * @param options     what to export and how
+   * @throws std::invalid_argument if the size, stride or buffer count is 0
+   * @throws std::runtime_error if the raw file can't be opened
+   */
+  FrameExporter(const std::string& path_prefix, const GasContainer& container,
+                const FrameExportOptions& options = FrameExportOptions());
+
+  /**
+   * Closes the exporter, see Close. Errors are ignored; call Close to see
+   * them.
+   */
+  ~FrameExporter();
+
+  FrameExporter(const FrameExporter&) = delete;
+  FrameExporter& operator=(const FrameExporter&) = delete;
+
+  /**
+   * Queues the container's current frame for export if its frame count is
+   * a multiple of the stride. Only waits if every buffer is still queued.
+   *
+   * @param container   the container passed to the constructor
+   */
+  void AddFrame(const GasContainer& container);
+
+  /**
+   * Exports every queued frame and stops the export thread. Does nothing if
+   * the exporter is already closed.
+   *
+   * @throws std::runtime_error if writing a frame failed
+   */
+  void Close();
+
+  /**
+   * @param frame_number    frame count of the frame
+   * @return                path the frame is written to
+   */
+  std::string GetFramePath(uint64_t frame_number) const;
+
+  /** Number of frames passed to the export thread so far **/
+  size_t GetQueuedFrameCount() const;
+
+  /** Number of times AddFrame had to wait for a free buffer **/
+  size_t GetStallCount() const;
+
+ private:
+  /** State of the container needed to draw one frame **/
+  struct CapturedFrame {
+    uint64_t frame_number = 0;
+    ParticleStore particles;
+    std::vector<std::vector<float>> species_speeds;
+  };
+
+  std::string path_prefix_;
+  FrameExportOptions options_;
+  SpeciesRegistry species_;
+  glm::vec2 top_left_;
+  glm::vec2 bottom_right_;
+
+  /** Maps the container into its part of the frame **/
+  Viewport container_viewport_;
+
+  std::vector<std::unique_ptr<CapturedFrame>> frames_;
+  std::vector<CapturedFrame*> free_frames_;
+  std::deque<CapturedFrame*> queued_frames_;
+  mutable std::mutex mutex_;
+  std::condition_variable frame_freed_;
+  std::condition_variable frame_queued_;
+  bool is_closing_ = false;
+  bool is_closed_ = false;
+  size_t queued_frame_count_ = 0;
+  size_t stall_count_ = 0;
+
+  /** Only used by the export thread until it is joined **/
+  SoftwareRenderer renderer_;
+  Framebuffer framebuffer_;
+  std::vector<Histogram> histograms_;
+  std::ofstream raw_file_;
+  bool has_failed_ = false;
+
+  std::thread export_thread_;
+
+  void LayOutHistograms(const GasContainer& container);
+  void ExportLoop();
+  void DrawFrame(const CapturedFrame& frame);
+  void WriteFrame(uint64_t frame_number);
+};
+
+}  // namespace idealgas
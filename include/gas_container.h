@@ -1,14 +1,62 @@
 #pragma once
 
-#include "cinder/gl/gl.h"
-#include "histogram.h"
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "counter_rng.h"
+#include "event_driven_stepper.h"
+#include "narrowphase.h"
+#include "observables.h"
 #include "particle.h"
+#include "particle_placement.h"
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "species_registry.h"
+#include "thread_pool.h"
 
 namespace idealgas {
 
+/**
+ * Strategy used to find the pairs of particles that collide in a frame
+ */
+enum class CollisionDetection {
+  /** Tests every pair of particles. O(N^2), kept as the reference **/
+  kBruteForce,
+  /** Only tests particles in neighboring cells of a SpatialGrid **/
+  kSpatialGrid
+};
+
+/**
+ * How particles are moved from one frame to the next
+ */
+enum class Stepper {
+  /**
+   * Moves every particle by its velocity and resolves the collisions found
+   * at the start of the frame
+   **/
+  kFixedTimeStep,
+  /** Jumps between exact collision times, see EventDrivenStepper **/
+  kEventDriven,
+  /**
+   * Splits the frame into substeps short enough that no particle moves more
+   * than a fraction of the smallest radius, up to a limit. Particles that
+   * still move further than that in a substep are swept against their
+   * neighbors and the walls, so they can't tunnel through them.
+   */
+  kAdaptive
+};
+
 /**
  * The container in which all of the gas particles are contained. This class
  * stores all of the particles and updates them on each frame of the simulation.
+ *
+ * The container is 2D and single precision. 3D boxes and double precision
+ * runs use BasicParticleStore and BasicFixedTimeStepper directly, which have
+ * the same collision response, wall handling and integration but none of the
+ * container's other features.
  */
 class GasContainer {
  public:
@@ -18,15 +66,39 @@ class GasContainer {
   const std::string kGreenParticleType = "GREEN";
 
   /**
-   * Initialize GasContainer with parameters. Randomly generates particles.
+   * Initialize GasContainer with parameters. Randomly generates particles of
+   * the blue, red and green species.
    * @param particle_count      Number of particles
    * @param top_left_position   Coordinates (x, y) of the top left corner of the
    *                            container
    * @param container_dimension 2d vector as <width, height> of the container
    * @param seed                seed for generating random numbers
+   * @param placement           how the positions of the particles are chosen
+   * @throws std::runtime_error if the particles don't fit without overlaps
+   *         with the placement
    */
   GasContainer(size_t particle_count, glm::vec2 top_left_position,
-               glm::vec2 container_dimension, int seed);
+               glm::vec2 container_dimension, int seed,
+               Placement placement = Placement::kUniform);
+
+  /**
+   * Initialize GasContainer with parameters. Randomly generates particles,
+   * with the species taking turns in registration order.
+   * @param particle_count      Number of particles
+   * @param top_left_position   Coordinates (x, y) of the top left corner of the
+   *                            container
+   * @param container_dimension 2d vector as <width, height> of the container
+   * @param seed                seed for generating random numbers
+   * @param species             species to generate particles of
+   * @param placement           how the positions of the particles are chosen
+   * @throws std::invalid_argument if species is empty and particle_count > 0
+   * @throws std::runtime_error if the particles don't fit without overlaps
+   *         with the placement
+   */
+  GasContainer(size_t particle_count, glm::vec2 top_left_position,
+               glm::vec2 container_dimension, int seed,
+               const SpeciesRegistry& species,
+               Placement placement = Placement::kUniform);
 
   /**
    * Initialize GasContainer with parameters. Initialize with passed in
@@ -37,65 +109,316 @@ class GasContainer {
    * @param container_dimension 2d vector as <width, height> of the container
    * @param seed                seed for generating random numbers
    * @param particles           vector of particles to be used in gas container
+   * @throws std::invalid_argument if two particles share a type name but not
+   *         the same mass and radius
    */
   GasContainer(size_t particle_count, glm::vec2 top_left_position,
                glm::vec2 container_dimension, int seed,
                std::vector<Particle>& particles);
-  /**
-   * Displays the container walls and the current positions of the particles.
-   */
-  void Display() const;
-
   /**
    * Updates the positions and velocities of all particles (based on the rules
    * described in the assignment documentation).
+   *
+   * The frame is split into phases: all colliding pairs are found first, then
+   * resolved in increasing index order (a particle collides at most once per
+   * frame), then the particles that did not collide bounce off the walls, and
+   * finally every particle moves. Both collision detection strategies find
+   * the same pairs, so they produce identical results.
+   *
+   * Each phase runs on the container's threads. Pairs are merged in sorted
+   * order and every other phase only writes per-particle state, so the
+   * result does not depend on the thread count.
    */
   void AdvanceOneFrame();
 
+  /**
+   * Same as AdvanceOneFrame, but the frame covers dt time units instead of
+   * one. The fixed time step moves particles by velocity * dt and only
+   * detects collisions at the start of the frame, so large steps let fast
+   * particles pass through each other; use kAdaptive or kEventDriven for
+   * those.
+   *
+   * @param dt  amount of time to simulate
+   * @throws std::invalid_argument if dt isn't positive
+   */
+  void AdvanceOneFrame(float dt);
+
+  /**
+   * Writes the full state of the container to a binary snapshot: bounds,
+   * species, particles, seed and frame count. Settings such as the thread
+   * count, stepper, collision detection and boundaries are not saved.
+   *
+   * @param path    file to write
+   * @throws std::runtime_error if the file can't be written
+   */
+  void SaveSnapshot(const std::string& path) const;
+
+  /**
+   * Restores a container saved with SaveSnapshot. The file is memory-mapped
+   * and the particle arrays are copied out in bulk, so even very large
+   * states load in about the time it takes to copy them.
+   *
+   * @param path    file to read
+   * @return        the restored container, with default settings
+   * @throws std::runtime_error if the file isn't a valid snapshot
+   */
+  static GasContainer LoadSnapshot(const std::string& path);
+
+  /**
+   * Sets how many threads AdvanceOneFrame uses. Defaults to 1.
+   *
+   * @param thread_count    number of threads, 0 to use one per hardware
+   *                        thread
+   */
+  void SetThreadCount(size_t thread_count);
+  size_t GetThreadCount() const;
+
+  /**
+   * Turns deterministic mode on or off. Off by default. Pairs are always
+   * resolved in sorted order, so the particles never depend on the thread
+   * count, but the observable sums are gathered per thread, and adding the
+   * same values in other groups can round differently. In deterministic
+   * mode the passes that gather them are split into kDeterministicChunkCount
+   * chunks whatever the thread count, and the chunks are added in order, so
+   * GetObservables is bit-identical for any thread count as well.
+   *
+   * @param is_deterministic    whether to use the fixed chunks
+   */
+  void SetDeterministic(bool is_deterministic);
+  bool IsDeterministic() const;
+
+  /**
+   * Starts or stops recording a hash of the particles after every frame,
+   * see GetStateHashes. Starting clears the hashes recorded before.
+   *
+   * @param is_enabled  whether to hash every frame
+   */
+  void SetStateHashing(bool is_enabled);
+
+  /**
+   * Hashes recorded since state hashing was started, one per frame. Each is
+   * the HashParticleState of its frame combined with the hashes of the
+   * frames before and of the state hashing started at, so two runs can be
+   * compared by their last hashes and the frame they diverged at found with
+   * FindFirstDivergentFrame.
+   */
+  const std::vector<uint64_t>& GetStateHashes() const;
+
+  /**
+   * Selects how colliding particles are found. Defaults to kSpatialGrid.
+   *
+   * @param collision_detection the strategy to use from the next frame on
+   */
+  void SetCollisionDetection(CollisionDetection collision_detection);
+  CollisionDetection GetCollisionDetection() const;
+
+  /**
+   * Selects the kernel that tests candidate pairs of particles. Defaults to
+   * the widest one the CPU supports. Every kernel gives the same results.
+   *
+   * @param kernel  the kernel to use from the next frame on
+   * @throws std::invalid_argument if the CPU doesn't support the kernel
+   */
+  void SetNarrowphaseKernel(Narrowphase::Kernel kernel);
+  Narrowphase::Kernel GetNarrowphaseKernel() const;
+
+  /**
+   * Selects how particles are moved. Defaults to kFixedTimeStep. With
+   * kEventDriven a frame covers the same amount of time as one fixed step,
+   * but collisions happen at their exact times, so particles never overlap
+   * or tunnel through each other. The event-driven stepper runs on one
+   * thread and ignores the collision detection strategy. kAdaptive costs a
+   * little more per substep than a fixed step but stays accurate for frames
+   * of any length.
+   *
+   * @param stepper the stepper to use from the next frame on
+   * @throws std::invalid_argument if stepper is kEventDriven and an axis is
+   *         periodic
+   */
+  void SetStepper(Stepper stepper);
+  Stepper GetStepper() const;
+
+  /**
+   * Selects what happens at the two faces of the container along an axis.
+   * Both axes have walls by default. On a periodic axis, particles leaving
+   * through one face come back in through the other and particles collide
+   * across the faces, with offsets taken by the minimum image convention, so
+   * a small container behaves like a piece of a much larger gas. The pressure
+   * of GetObservables only counts the axes with walls, and is 0 when both
+   * are periodic.
+   *
+   * @param axis        0 for x, 1 for y
+   * @param boundary    the boundary to use from the next frame on
+   * @throws std::invalid_argument if axis isn't 0 or 1, or if boundary is
+   *         kPeriodic and the stepper is kEventDriven, which only supports
+   *         walls
+   */
+  void SetBoundary(size_t axis, Boundary boundary);
+
+  /**
+   * @param axis    0 for x, 1 for y
+   * @throws std::invalid_argument if axis isn't 0 or 1
+   */
+  Boundary GetBoundary(size_t axis) const;
+
+  /** Number of substeps the last frame was split into, 1 unless kAdaptive **/
+  size_t GetSubstepCount() const;
+
+  /**
+   * Returns pressure, temperature, collision rates and mean free path
+   * averaged over the most recent frames. Their sums are gathered by the
+   * passes every frame already makes over the particles and pairs, so the
+   * only extra work is adding up the window on each call.
+   *
+   * @return    the averages, zeroed before the first frame
+   */
+  Observables GetObservables() const;
+
+  /**
+   * Sets how many of the most recent frames GetObservables averages over.
+   * Defaults to ObservablesWindow::kDefaultFrameCount. The frames recorded
+   * so far are forgotten.
+   *
+   * @param frame_count     number of frames
+   * @throws std::invalid_argument if frame_count is 0
+   */
+  void SetObservablesWindow(size_t frame_count);
+
   /**
    * Returns a map of the particle speeds. With each key being the particle
    * type name, and the value being a vector of speeds of each particle with
-   * that type name
+   * that type name. The map is built on every call; use GetSpeciesSpeeds
+   * once per frame instead.
    *
    * @return    particle speeds map
    */
-  const std::map<std::string, std::vector<float>>& GetParticleSpeeds() const;
+  std::map<std::string, std::vector<float>> GetParticleSpeeds() const;
+
+  /**
+   * Returns the speeds of the particles of one species, recorded during the
+   * last frame
+   *
+   * @param species_id  id of the species in GetSpecies()
+   * @return            speed of each particle of the species
+   */
+  const std::vector<float>& GetSpeciesSpeeds(uint8_t species_id) const;
+
+  const SpeciesRegistry& GetSpecies() const;
 
   float GetWidth() const;
   float GetHeight() const;
   size_t GetParticleCount() const;
+
+  /** Number of frames advanced since the container was created **/
+  uint64_t GetFrameCount() const;
+  int GetSeed() const;
   const glm::vec2& GetTopLeftPosition() const;
   const glm::vec2& GetBottomRightPosition() const;
+
+  /**
+   * Returns the particles as Particle objects. The particles are stored as a
+   * ParticleStore, so this copies them out on the first call after a frame
+   * and reuses the copy until the next frame. Prefer GetParticleStore in
+   * loops over many particles.
+   *
+   * @return    a snapshot of the particles in the container
+   */
   const std::vector<Particle>& GetParticles() const;
 
+  const ParticleStore& GetParticleStore() const;
+
+  /**
+   * Generates the particles at indices [begin, end) of a container with the
+   * bounds, seed and species of this one and Placement::kUniform, the same
+   * ones its constructors make. Each particle only depends on those and its
+   * index, so a process can generate just the particles in its part of a
+   * container that is too large to build whole.
+   *
+   * @param begin       index of the first particle
+   * @param end         one past the index of the last particle
+   * @param particles   resized to end - begin, particle i is put at i - begin
+   * @throws std::invalid_argument if the container has no species and
+   *         begin < end
+   */
+  void GenerateParticles(size_t begin, size_t end,
+                         ParticleStore& particles) const;
+
  private:
   const float kMaxVelocityComponent = 7;
   const float kMinVelocityComponent = -kMaxVelocityComponent;
 
-  const ci::ColorT<float> kBlueParticleColor = "blue";
+  const Color kBlueParticleColor = "blue";
   const float kBlueParticleMass = 5;
   const float kBlueParticleRadius = 20;
 
-  const ci::ColorT<float> kRedParticleColor = "red";
+  const Color kRedParticleColor = "red";
   const float kRedParticleMass = 7;
   const float kRedParticleRadius = 25;
 
-  const ci::ColorT<float> kGreenParticleColor = "green";
+  const Color kGreenParticleColor = "green";
   const float kGreenParticleMass = 10;
   const float kGreenParticleRadius = 30;
 
+  /**
+   * Largest distance, in radii of the smallest particle, that kAdaptive lets
+   * a particle move in one substep before sweeping it. Two particles moving
+   * at most this far can't pass through each other between substeps.
+   */
+  const float kMaxSubstepTravel = 0.5f;
+
+  /**
+   * Share of the particles whose speed kAdaptive bounds with the substep
+   * length; the rest are swept
+   */
+  const float kSubstepSpeedQuantile = 0.99f;
+
+  /** Most substeps kAdaptive splits a frame into **/
+  const size_t kMaxSubstepCount = 32;
+
   /** A margin from inside the container that particles should not spawn in **/
   const float kMargin = 50;
 
+  /** Chunks per thread when finding collisions by testing every pair **/
+  const size_t kBruteForceChunksPerThread = 8;
+
+  /**
+   * Chunks the passes that gather observables are split into in
+   * deterministic mode, enough to keep a many-core machine busy
+   */
+  const size_t kDeterministicChunkCount = 64;
+
+  /**
+   * Streams of rng_, one per use of random numbers so that adding a new one
+   * doesn't change the numbers the others get
+   */
+  const uint32_t kParticleInitializationStream = 0;
+  const uint32_t kParticlePlacementStream = 1;
+
+  /**
+   * Particle count from which the particles are generated on every hardware
+   * thread. Each particle only depends on its index, so the result is the
+   * same either way.
+   */
+  const size_t kParallelInitializationMinParticles = 1 << 16;
+
   float width_;
   float height_;
   size_t particle_count_;
+  int seed_;
+  uint64_t frame_count_ = 0;
+
+  /** Random numbers keyed by seed_ **/
+  CounterRng rng_;
 
   /** Collection of particles inside the container **/
-  std::vector<Particle> particles_;
+  ParticleStore particles_;
+
+  /** Species of the particles. Indexed by the ids in particles_ **/
+  SpeciesRegistry species_;
 
-  /** The box representing the container **/
-  ci::RectT<float> container_box_;
+  /** Snapshot returned by GetParticles, rebuilt lazily after each frame **/
+  mutable std::vector<Particle> particles_snapshot_;
+  mutable bool is_snapshot_stale_ = true;
 
   /** Location of the Top-Left corner of the box relative to the canvas**/
   glm::vec2 top_left_position_;
@@ -103,52 +426,243 @@ class GasContainer {
   /** Location of the Bottom-right corner of the box relative to the canvas**/
   glm::vec2 bottom_right_position;
 
+  /** Boundary of each axis, see SetBoundary **/
+  Boundary boundaries_[2] = {Boundary::kWall, Boundary::kWall};
+
+  /**
+   * Speeds of each particle, grouped by species.
+   * Index = species id, Value = speeds of the particles of that species
+   */
+  std::vector<std::vector<float>> species_speeds_;
+
+  CollisionDetection collision_detection_ = CollisionDetection::kSpatialGrid;
+
+  /** Tests the candidate pairs of either collision detection strategy **/
+  Narrowphase narrowphase_;
+
+  /** Broadphase used when collision_detection_ is kSpatialGrid **/
+  SpatialGrid spatial_grid_;
+
+  /** Colliding pairs of the current frame, kept to avoid reallocating **/
+  std::vector<SpatialGrid::IndexPair> colliding_pairs_;
+
+  /**
+   * Subset of colliding_pairs_ that is resolved this frame. No particle is in
+   * more than one of these pairs, so they can be resolved in parallel.
+   */
+  std::vector<SpatialGrid::IndexPair> resolved_pairs_;
+
+  /**
+   * Colliding pair with the time into the substep the particles touch,
+   * used by kAdaptive. Ordered by time, then by the pair.
+   */
+  typedef std::pair<float, SpatialGrid::IndexPair> TimedPair;
+
+  /** Speeds of every particle, partially sorted to pick the substep **/
+  std::vector<float> substep_speeds_;
+
+  /** Particles kAdaptive sweeps in the current substep **/
+  std::vector<size_t> fast_particles_;
+
+  /** Particles each chunk of the swept search tests a fast particle with **/
+  std::vector<std::vector<size_t>> chunk_candidates_;
+
+  /** Swept collisions found by each chunk, and all of them merged **/
+  std::vector<std::vector<TimedPair>> chunk_timed_pairs_;
+  std::vector<TimedPair> timed_pairs_;
+  std::vector<TimedPair> resolved_timed_pairs_;
+
+  size_t substep_count_ = 1;
+
+  /** Whether each particle already collided with another in this frame **/
+  std::vector<uint8_t> has_collided_;
+
+  Stepper stepper_ = Stepper::kFixedTimeStep;
+
+  /** Used when stepper_ is kEventDriven **/
+  EventDrivenStepper event_driven_stepper_;
+
+  /**
+   * Whether event_driven_stepper_ has to be initialized again because the
+   * particles were changed by something else
+   */
+  bool is_event_driven_stepper_stale_ = true;
+
+  /** Threads used to run the phases of a frame **/
+  std::unique_ptr<ThreadPool> thread_pool_ =
+      std::unique_ptr<ThreadPool>(new ThreadPool(1));
+
+  /** Colliding pairs found by each chunk of the detection phase **/
+  std::vector<std::vector<SpatialGrid::IndexPair>> chunk_pairs_;
+
+  /**
+   * Per chunk, per species counts of the particles, turned into the offsets
+   * each chunk writes its speeds at. Indexed [chunk * species count + id]
+   */
+  std::vector<size_t> chunk_species_offsets_;
+
+  /**
+   * Observable sums of the current frame, one per chunk of the container's
+   * threads so that the passes don't share them. Added up into
+   * observables_window_ once at the end of the frame.
+   */
+  std::vector<ObservableSums> chunk_observables_;
+  ObservableSums frame_observables_;
+  ObservablesWindow observables_window_;
+
+  bool is_deterministic_ = false;
+
+  /** Combined hash of the frames since state hashing started **/
+  bool is_state_hashing_ = false;
+  uint64_t state_hash_ = 0;
+  std::vector<uint64_t> state_hashes_;
+
+  /** Used by LoadSnapshot, which sets every field **/
+  GasContainer() = default;
+
+  void InitializeDefaultSpecies();
+
   /**
-   * Map of speeds of each particle. Key = particle type name
-   * Value = a vector of particle speeds for the corresponding particle type
+   * Generates particle_count_ random particles, then moves them apart with
+   * PlaceWithoutOverlaps unless placement is kUniform
    */
-  std::map<std::string, std::vector<float>> particle_speeds_;
+  void InitializeParticlesCollection(Placement placement);
+  void InitializeSpeciesSpeeds();
+  void UpdateSpeciesSpeeds();
+
+  /**
+   * Records the speed of every particle in species_speeds_, and adds the
+   * kinetic energy and distance of the coming dt time units to the first
+   * chunk's observables
+   */
+  void RecordSpeeds(float dt);
+
+  /**
+   * Chunks the passes that gather observables are split into: one per
+   * thread, or kDeterministicChunkCount in deterministic mode
+   */
+  size_t GetObservableChunkCount() const;
+
+  /** Zeroes the chunk observables, one per GetObservableChunkCount **/
+  void BeginFrameObservables();
 
-  void InitializeParticlesCollection();
-  void InitializeParticleSpeedsMap();
-  void UpdateParticlesSpeedMap();
-  void ClearParticleSpeedsMapVectors();
-  void DrawContainer() const;
-  void DrawParticles() const;
-  Particle GenerateRandomParticle(int particle_number);
-  void SetRandomPosition(glm::vec2& position);
-  void SetRandomVelocity(glm::vec2& velocity);
+  /** Adds up the chunk observables of a frame of dt time units **/
+  void EndFrameObservables(float dt);
+
+  /**
+   * Sets the particle at index of particles to the random particle at
+   * particle_number. Only depends on the seed and particle_number, and
+   * different particles can be generated from different threads.
+   */
+  void GenerateRandomParticle(size_t particle_number, ParticleStore& particles,
+                              size_t index) const;
+
+  /**
+   * Adds a particle to particles_, registering its type name as a new
+   * species if it hasn't been seen before
+   *
+   * @param particle    particle to copy into the container
+   */
+  void AddParticle(const Particle& particle);
+  void SetRandomPosition(const CounterRng::Block& random,
+                         glm::vec2& position) const;
+  void SetRandomVelocity(const CounterRng::Block& random,
+                         glm::vec2& velocity) const;
 
   /**
    * Generates a random float between lower_bound (inclusive) and
    * upper_bound (exclusive). i.e, range = [lower_bound, upper_bound)
    *
+   * @param random_bits random word from rng_
    * @param lower_bound minimum value for random number (inclusive)
    * @param upper_bound maximum value for random number (exclusive)
    * @return            a random float
    */
-  float GenerateRandomFloat(float lower_bound, float upper_bound);
+  float GenerateRandomFloat(uint32_t random_bits, float lower_bound,
+                            float upper_bound) const;
 
   /**
-   * Gets the index of the particle that is currently colliding with the
-   * particle at particle_index
-   *
-   * @param particle_index  the index (from particles_) of the particle that you
-   *                        wish to check if other particles are collding with
-   * @return                index of the colliding particle.
-   *                        returns -1 if the particle is not colliding with
-   *                        any particle
+   * Fills colliding_pairs_ with every pair of particles that are touching and
+   * approaching each other, using the selected collision detection strategy.
+   * Pairs are sorted by the first index then by the second index.
    */
-  int GetCollidingParticleIndex(size_t particle_index) const;
+  void FindCollidingPairs();
 
   /**
-   * Checks if the particle is colliding with a particle and calls the
-   * particles update velocity for wall collision function for its respective
-   * wall collision
+   * Reference strategy for FindCollidingPairs that tests every pair. Only
+   * finds the pairs whose first particle is in [begin, end), so the work can
+   * be split across threads.
    *
-   * @param particle    particle to check if it is colliding with wall
+   * @param begin   first index of the first particle of the pairs
+   * @param end     one past the last index of the first particle
+   * @param pairs   output vector of colliding pairs, sorted
+   */
+  void FindCollidingPairsBruteForce(
+      size_t begin, size_t end,
+      std::vector<SpatialGrid::IndexPair>& pairs) const;
+
+  /**
+   * Updates the velocities of the colliding pairs in order. A pair is skipped
+   * if either particle already collided earlier in the frame. Marks the
+   * particles that collided in has_collided_.
+   */
+  void ResolveParticleCollisions();
+
+  /**
+   * Bounces the particles that did not collide off the walls, records the
+   * speed of every particle in species_speeds_ and moves every particle by
+   * its velocity times dt
+   */
+  void HandleWallsAndMove(float dt);
+
+  /**
+   * Corners of the walls for ParticleStore::HandleIfWallCollision and
+   * ParticleStore::ReflectOffWalls. Periodic axes get walls at infinity,
+   * which no particle reaches.
+   */
+  void GetWallBounds(glm::vec2& top_left, glm::vec2& bottom_right) const;
+
+  /** Length of each periodic axis, 0 for each axis with walls **/
+  glm::vec2 GetPeriods() const;
+
+  /**
+   * Wraps the particles at indices [begin, end) back into the container
+   * along the periodic axes
+   */
+  void WrapPeriodicAxes(size_t begin, size_t end);
+
+  /**
+   * Advances the particles dt time units with event_driven_stepper_ and
+   * records their speeds
+   */
+  void AdvanceEventDriven(float dt);
+
+  /**
+   * Advances the particles dt time units in as many substeps as the fastest
+   * particle needs, and records their speeds
+   */
+  void AdvanceAdaptive(float dt);
+
+  /**
+   * One substep of kAdaptive: finds the touching pairs and sweeps the fast
+   * particles, resolves the pairs in the order they touch, then bounces off
+   * the walls and moves every particle
+   */
+  void AdvanceSubstep(float dt);
+
+  /**
+   * Fills fast_particles_ with the particles that move further than
+   * kMaxSubstepTravel allows in dt, then fills timed_pairs_ with the pairs
+   * from colliding_pairs_ plus every pair with a fast particle that touches
+   * within dt, sorted and without duplicates
+   */
+  void FindSweptCollisions(float dt);
+
+  /**
+   * Resolves the pairs of timed_pairs_ in order, each particle at most once,
+   * at the time the particles touch
    */
-  void HandleIfWallCollision(Particle& particle);
+  void ResolveTimedCollisions();
 };
 
 }  // namespace idealgas
@@ -1,12 +1,20 @@
-#include "cinder/gl/gl.h"
-
 #ifndef IDEAL_GAS_HISTOGRAM_H
 #define IDEAL_GAS_HISTOGRAM_H
 
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "color.h"
+#include "speed_distribution.h"
+#include "thread_pool.h"
+
 namespace idealgas {
 
 /**
- * Histogram to be displayed in the Gas Container.
+ * Histogram to be displayed in the Gas Container. Holds the bins and the
+ * layout of the histogram; drawing it is done by the render layer (see
+ * cinder_renderer.h).
  */
 class Histogram {
  public:
@@ -22,7 +30,7 @@ class Histogram {
    * @param y_axis_label        string to be displayed for the y axis label
    */
   Histogram(const glm::vec2& position, const glm::vec2& dimension,
-            const ci::Color& bar_color, const ci::Color& axis_label_color,
+            const Color& bar_color, const Color& axis_label_color,
             std::string x_axis_label, std::string y_axis_label);
 
   /**
@@ -30,47 +38,116 @@ class Histogram {
    * frequencies based off the data provided and calculates the width that
    * each bar should be depending on the value of num_bins
    *
+   * Each value is binned directly, so an update is O(N) with no sorting.
+   * Without a fixed range (see SetRange), the bins evenly split the range
+   * from the smallest to the largest value of the data. The data is read in
+   * place, and once a first update has sized the bins, later updates with
+   * the same num_bins don't allocate.
+   *
    * @param data        vector of data that you wish to find frequencies of
    * @param num_bins    number of bars/bins to be used to group data into to
    * find frequencies of data values that lie within each interval, which is
    * found using the number of bins and the range of the data
    */
-  void UpdateData(std::vector<float> data, int num_bins);
+  void UpdateData(const std::vector<float>& data, int num_bins);
+
+  /**
+   * Same as UpdateData, for the values in [begin, end)
+   *
+   * @param begin       pointer to the first value
+   * @param end         pointer one past the last value
+   * @param num_bins    number of bars/bins
+   */
+  void UpdateData(const float* begin, const float* end, int num_bins);
 
   /**
-   * Draw histogram to cinder canvas
+   * Same as UpdateData, splitting the values across the threads of
+   * thread_pool. Each chunk counts into its own bins, which are then summed,
+   * so the result is the same as the single threaded version.
+   *
+   * @param begin       pointer to the first value
+   * @param end         pointer one past the last value
+   * @param num_bins    number of bars/bins
+   * @param thread_pool threads to count on
    */
-  void Draw();
+  void UpdateData(const float* begin, const float* end, int num_bins,
+                  ThreadPool& thread_pool);
+
+  /**
+   * Shows the time averaged histogram of distribution instead of a single
+   * frame: one bin per bin of distribution, holding its average count per
+   * frame (see SpeedDistribution::GetAverageBinCounts). The averages keep
+   * their fractions, so a bin that is hit in only some frames still shows
+   * with few particles. The range is left as it is.
+   *
+   * @param distribution    speeds gathered over many frames
+   */
+  void UpdateData(const SpeedDistribution& distribution);
+
+  /**
+   * Fixes the range the bins cover, so the bin edges stay the same from one
+   * update to the next. Values below min are counted in the first bin. When a
+   * value is above max, the range is widened by doubling its width until the
+   * value fits; it never shrinks again.
+   *
+   * @param min     lower edge of the first bin
+   * @param max     upper edge of the last bin, greater than min
+   * @throws std::invalid_argument if max <= min
+   */
+  void SetRange(float min, float max);
+
+  /**
+   * Goes back to fitting the bins to the range of each update's data
+   */
+  void ClearRange();
+
+  bool HasFixedRange() const;
+  float GetRangeMin() const;
+  float GetRangeMax() const;
 
   const glm::vec2& GetPosition() const;
-  const ci::Color& GetBarColor() const;
-  const ci::Color& GetAxisLabelColor() const;
+  const Color& GetBarColor() const;
+  const Color& GetAxisLabelColor() const;
   const glm::vec2 GetDimensions() const;
-  std::string GetXLabel() const;
-  std::string GetYLabel() const;
+  const std::string& GetXLabel() const;
+  const std::string& GetYLabel() const;
   float GetBarWidth() const;
-  const std::vector<int>& GetBins() const;
+  const std::vector<float>& GetBins() const;
 
  private:
-  const float kXLabelMargin = 10;
-  const float kYLabelMargin = 85;
   glm::vec2 position_;
   float width_;
   float height_;
-  ci::Color bar_color_;
-  ci::Color axis_label_color_;
+  Color bar_color_;
+  Color axis_label_color_;
   std::string x_axis_label_;  // x-axis label
   std::string y_axis_label_;  // y-axis label
   float bar_width_;           // width of each bar in the graph
 
   /**
-   * vector of frequencies for each bar/bin
+   * vector of frequencies for each bar/bin. Whole counts for a single
+   * frame, averages per frame for a SpeedDistribution
    */
-  std::vector<int> bins_;
+  std::vector<float> bins_;
 
-  void DrawLabels();
-  void DrawAxis();
-  void DrawBars();
+  bool has_fixed_range_ = false;
+  float range_min_ = 0;
+  float range_max_ = 0;
+
+  /**
+   * Per chunk scratch space for updates, kept to avoid reallocating.
+   * chunk_bins_ is indexed [chunk * num_bins + bin]
+   */
+  std::vector<float> chunk_minimums_;
+  std::vector<float> chunk_maximums_;
+  std::vector<int> chunk_bins_;
+
+  /**
+   * Bins the values in [begin, end) split into chunk_count chunks, on
+   * thread_pool if it isn't null
+   */
+  void UpdateBins(const float* begin, const float* end, int num_bins,
+                  size_t chunk_count, ThreadPool* thread_pool);
 };
 }  // namespace idealgas
 
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Pointers to the arrays of a structure-of-arrays particle layout, such as a
+ * ParticleStore or a copy of one sorted into another order
+ */
+struct ParticleArrays {
+  const float* positions_x = nullptr;
+  const float* positions_y = nullptr;
+  const float* velocities_x = nullptr;
+  const float* velocities_y = nullptr;
+  const float* radii = nullptr;
+
+  /**
+   * Lengths of the axes with periodic boundaries, where offsets are taken
+   * with GetMinimumImage. 0 for an axis with walls.
+   */
+  float period_x = 0;
+  float period_y = 0;
+
+  ParticleArrays() = default;
+  explicit ParticleArrays(const ParticleStore& particles);
+};
+
+/**
+ * Narrowphase collision test: checks one particle against a block of
+ * candidates that are contiguous in memory, with the same squared distance
+ * and dot product tests as ParticleStore::IsTouching and
+ * ParticleStore::IsApproaching, or their minimum image versions when the
+ * arrays have periodic axes. The SIMD kernels compute exactly the same
+ * floating point operations as the scalar one, so every kernel gives the
+ * same answer.
+ */
+class Narrowphase {
+ public:
+  /** Most candidates tested by one call, one bit of the result each **/
+  static const size_t kBlockSize = 32;
+
+  enum class Kernel {
+    /** Plain C++, available everywhere **/
+    kScalar,
+    /** 4 candidates at a time, x86 only **/
+    kSse2,
+    /** 8 candidates at a time, x86 CPUs with AVX2 only **/
+    kAvx2
+  };
+
+  /**
+   * Uses the widest kernel the CPU supports
+   */
+  Narrowphase();
+
+  /**
+   * @param kernel  kernel to use
+   * @throws std::invalid_argument if the CPU doesn't support the kernel
+   */
+  explicit Narrowphase(Kernel kernel);
+
+  /**
+   * Tests the particle at index against the candidates at
+   * [begin, begin + count)
+   *
+   * @param particles   arrays holding both the particle and the candidates
+   * @param index       index of the particle to test
+   * @param begin       index of the first candidate
+   * @param count       number of candidates, at most kBlockSize
+   * @return            bit i is set if candidate begin + i is touching and
+   *                    approaching the particle
+   */
+  uint32_t FindContacts(const ParticleArrays& particles, size_t index,
+                        size_t begin, size_t count) const;
+
+  Kernel GetKernel() const;
+
+  static bool IsSupported(Kernel kernel);
+  static Kernel GetBestKernel();
+  static const char* GetKernelName(Kernel kernel);
+
+ private:
+  typedef uint32_t (*KernelFunction)(const ParticleArrays& particles,
+                                     size_t index, size_t begin,
+                                     size_t count);
+
+  Kernel kernel_;
+  KernelFunction find_contacts_;
+
+  /** Same kernel, with the offsets wrapped across the periodic axes **/
+  KernelFunction find_periodic_contacts_;
+};
+
+}  // namespace idealgas
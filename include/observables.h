@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Totals a stepper accumulates while advancing. Each field is a plain sum, so
+ * the sums of several threads or frames combine by adding them up.
+ */
+struct ObservableSums {
+  /** Simulated time the sums cover **/
+  double time = 0;
+
+  /**
+   * Momentum the particles pushed into the walls. Negative contributions come
+   * from the fixed time step reflecting particles that were already leaving.
+   */
+  double wall_impulse = 0;
+
+  /** Total kinetic energy integrated over time: sum of E * dt **/
+  double energy_time = 0;
+
+  /** Distance traveled by all of the particles together **/
+  double distance = 0;
+
+  size_t species_count = 0;
+
+  /**
+   * Particle collisions between species a and b with a <= b, at
+   * [a * species count + b]
+   */
+  std::vector<uint64_t> pair_collision_counts;
+
+  /** Zeroes every sum and sizes the pair counts for the species count **/
+  void Clear(size_t species);
+
+  /** Counts one collision between particles of the two species **/
+  void AddCollision(uint8_t species_one, uint8_t species_two);
+
+  /** Adds the sums of other, which must have as many species **/
+  void Add(const ObservableSums& other);
+};
+
+/**
+ * Thermodynamic observables averaged over the frames of an ObservablesWindow.
+ * Units follow the simulation: 2D pressure is force per unit length of wall
+ * and temperature is in energy units (k = 1).
+ */
+struct Observables {
+  /** Frames and simulated time the averages cover **/
+  size_t frame_count = 0;
+  double time = 0;
+
+  /** Momentum transferred to the walls per unit time and wall length **/
+  double pressure = 0;
+
+  /** Time averaged total kinetic energy **/
+  double kinetic_energy = 0;
+
+  /** Mean kinetic energy per particle, which is kT for a 2D gas **/
+  double temperature = 0;
+
+  /** Particle collisions per particle per unit time **/
+  double collision_frequency = 0;
+
+  /** Mean distance a particle travels between two particle collisions **/
+  double mean_free_path = 0;
+
+  /**
+   * Collisions per unit time between particles of species a and b, at both
+   * [a * species count + b] and [b * species count + a]
+   */
+  std::vector<double> pair_collision_rates;
+};
+
+/**
+ * Sums of the last few frames, kept in a ring so adding a frame neither
+ * allocates nor touches the older frames. The averages are only computed
+ * when asked for.
+ */
+class ObservablesWindow {
+ public:
+  /** Frames averaged unless told otherwise, one second at 60 fps **/
+  static const size_t kDefaultFrameCount = 60;
+
+  /**
+   * @param frame_count     most recent frames to average over
+   * @throws std::invalid_argument if frame_count is 0
+   */
+  explicit ObservablesWindow(size_t frame_count = kDefaultFrameCount);
+
+  /**
+   * Changes how many frames are averaged, forgetting the frames added so far
+   *
+   * @throws std::invalid_argument if frame_count is 0
+   */
+  void SetFrameCount(size_t frame_count);
+  size_t GetFrameCount() const;
+
+  /** Adds the sums of a frame, dropping the oldest one if the ring is full **/
+  void Add(const ObservableSums& frame);
+
+  /** Forgets every frame **/
+  void Clear();
+
+  /**
+   * Averages the frames in the window
+   *
+   * @param particle_count  number of particles in the container
+   * @param wall_length     total length of the walls, the 2D "area" the
+   *                        impulse is spread over
+   * @return                the averages, all 0 if no time has passed
+   */
+  Observables GetAverages(size_t particle_count, double wall_length) const;
+
+ private:
+  std::vector<ObservableSums> frames_;
+
+  /** Slot the next frame is written to, and number of slots in use **/
+  size_t next_frame_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace idealgas
@@ -2,13 +2,46 @@
 // Created by amaan on 3/16/2021.
 //
 
-#include "cinder/gl/gl.h"
-
 #ifndef IDEAL_GAS_PARTICLE_H
 #define IDEAL_GAS_PARTICLE_H
 
+#include <glm/glm.hpp>
+#include <string>
+
+#include "color.h"
+
 namespace idealgas {
 
+/**
+ * New velocity of particle one after an elastic collision with particle two,
+ * in any number of dimensions and either precision. The vector math works on
+ * glm vectors of a fixed length, so it unrolls at compile time.
+ *
+ * @param position_one    position of particle one
+ * @param velocity_one    velocity of particle one
+ * @param mass_one        mass of particle one
+ * @param position_two    position of particle two
+ * @param velocity_two    velocity of particle two
+ * @param mass_two        mass of particle two
+ * @return                velocity of particle one after the collision
+ */
+template <int Dimension, typename Scalar>
+glm::vec<Dimension, Scalar> ComputeCollisionVelocity(
+    const glm::vec<Dimension, Scalar>& position_one,
+    const glm::vec<Dimension, Scalar>& velocity_one, Scalar mass_one,
+    const glm::vec<Dimension, Scalar>& position_two,
+    const glm::vec<Dimension, Scalar>& velocity_two, Scalar mass_two) {
+  // difference between the velocities & distance between particle 1 & 2
+  glm::vec<Dimension, Scalar> velocity_difference = velocity_one - velocity_two;
+  glm::vec<Dimension, Scalar> distance = position_one - position_two;
+
+  // the fraction in the equation that multiplies the distance vector
+  Scalar mass_fraction = 2 * mass_two / (mass_one + mass_two);
+  Scalar multiplier = mass_fraction * (glm::dot(velocity_difference, distance) /
+                                       glm::dot(distance, distance));
+  return velocity_one - multiplier * distance;
+}
+
 /**
  * Represents a Particle with information about the
  * Particle's state such as Position, Velocity, etc,
@@ -26,20 +59,20 @@ class Particle {
    * @param type_name   the name of the particle type. Anything you wish to name
    *                    the particle type as
    */
-  Particle(glm::vec2 position, glm::vec2 velocity, ci::Color particle_color,
+  Particle(glm::vec2 position, glm::vec2 velocity, Color particle_color,
            float radius, float mass, std::string type_name = "");
 
   /**
    * Particles moves one time step by using velocity
    */
   void Move();
-  ci::Color GetColor() const;
+  Color GetColor() const;
   const glm::vec2& GetPosition() const;
   const glm::vec2& GetVelocity() const;
   float GetSpeed() const;
   float GetRadius() const;
   float GetMass() const;
-  std::string GetTypeName() const;
+  const std::string& GetTypeName() const;
 
   /**
    * Checks if the 2 particles are touching each other.
@@ -86,7 +119,7 @@ class Particle {
  private:
   glm::vec2 position_;
   glm::vec2 velocity_;
-  ci::Color color_;
+  Color color_;
   float radius_;
   float mass_;
   std::string type_name_;
@@ -100,8 +133,8 @@ class Particle {
    *                    that you wish to find the new velocity for
    * @param particle2   the second particle in the collision
    */
-  glm::vec2 Particle::ComputeVelocityForParticleCollision(Particle& particle1,
-                                                          Particle& particle2);
+  glm::vec2 ComputeVelocityForParticleCollision(Particle& particle1,
+                                                Particle& particle2);
 };
 }  // namespace idealgas
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "counter_rng.h"
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * How the positions of randomly generated particles are chosen
+ */
+enum class Placement {
+  /** Independent uniform positions. Particles can overlap **/
+  kUniform,
+  /**
+   * One particle per cell of a square lattice sized for the largest radius,
+   * on randomly chosen cells and jittered inside them
+   */
+  kJitteredLattice,
+  /**
+   * Random sequential addition: from the largest particle to the smallest,
+   * each particle tries random positions until one doesn't overlap the
+   * particles placed before it
+   */
+  kRandomSequential
+};
+
+/**
+ * Densest packing fraction, the share of the area covered by particles,
+ * kRandomSequential is attempted at. Random sequential addition of equal
+ * disks jams at about 0.547, and gets very slow well before that.
+ */
+const float kMaxRandomSequentialPackingFraction = 0.5f;
+
+/**
+ * Moves every particle to a position where it lies completely inside the
+ * bounds and doesn't overlap any other particle. Both placements run in
+ * time linear in the particle count and only depend on the radii, the
+ * bounds and the random numbers.
+ *
+ * @param placement       kJitteredLattice or kRandomSequential
+ * @param top_left        top left corner of the bounds
+ * @param bottom_right    bottom right corner of the bounds
+ * @param rng             random numbers to place with
+ * @param stream          stream of rng to use
+ * @param particles       particles to move, their radii are kept
+ * @throws std::invalid_argument if placement is kUniform
+ * @throws std::runtime_error if the particles don't fit with the placement
+ */
+void PlaceWithoutOverlaps(Placement placement, const glm::vec2& top_left,
+                          const glm::vec2& bottom_right, const CounterRng& rng,
+                          uint32_t stream, ParticleStore& particles);
+
+}  // namespace idealgas
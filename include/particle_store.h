@@ -0,0 +1,268 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace idealgas {
+
+/** What happens to particles at the two faces of the container on an axis **/
+enum class Boundary {
+  /** Particles bounce off the faces **/
+  kWall,
+  /**
+   * Particles leaving through one face come back in through the opposite
+   * one, and particles near opposite faces can collide across them
+   */
+  kPeriodic
+};
+
+/**
+ * Shortest offset along a periodic axis between two points that are offset
+ * apart, the minimum image convention. Swapping the points negates the
+ * result exactly.
+ *
+ * @param offset  difference of the two coordinates, within one period
+ * @param period  length of the axis, 0 for an axis with walls, which leaves
+ *                offset as it is
+ */
+template <typename Scalar>
+inline Scalar GetMinimumImage(Scalar offset, Scalar period) {
+  Scalar half_period = period / 2;
+  if (offset > half_period) {
+    return offset - period;
+  } else if (offset < -half_period) {
+    return offset + period;
+  }
+  return offset;
+}
+
+/**
+ * Structure-of-arrays storage for the particles of a GasContainer. Each field
+ * of the particles is kept in its own contiguous array so that the per-frame
+ * sweeps (integration, wall handling, collision tests) only stream the bytes
+ * they actually use. Colors and type names are not stored per particle; they
+ * are looked up from the species id.
+ *
+ * The store is templated on the number of dimensions and the scalar type.
+ * Every loop over the axes has Dimension iterations known at compile time,
+ * so it is unrolled, and the 2D float store used by GasContainer (see
+ * ParticleStore) compiles to the same code as one written for two axes. It
+ * is compiled for 2 and 3 dimensions of float and double, and every variant
+ * can be stepped by a BasicFixedTimeStepper. GasContainer, with its spatial
+ * grid, SIMD narrowphase and other steppers, only runs the 2D float store.
+ * The walls of the container are the faces of the box from top_left, its
+ * corner with the lowest coordinates, to bottom_right, its corner with the
+ * highest.
+ */
+template <int Dimension, typename Scalar>
+class BasicParticleStore {
+ public:
+  typedef glm::vec<Dimension, Scalar> Vector;
+
+  /**
+   * Appends a particle to the store
+   *
+   * @param position    position of the particle
+   * @param velocity    velocity of the particle
+   * @param radius      radius of the particle
+   * @param mass        mass of the particle, must be greater than 0
+   * @param species_id  id of the particle's species
+   * @return            index of the new particle
+   */
+  size_t Add(const Vector& position, const Vector& velocity, Scalar radius,
+             Scalar mass, uint8_t species_id);
+
+  /**
+   * Replaces every particle with copies of the given arrays, which each hold
+   * particle_count values
+   *
+   * @param positions   Dimension arrays, one per axis
+   * @param velocities  Dimension arrays, one per axis
+   */
+  void Assign(size_t particle_count, const Scalar* const* positions,
+              const Scalar* const* velocities, const Scalar* radii,
+              const Scalar* inverse_masses, const uint8_t* species_ids);
+
+  /**
+   * Sets every field of the particle at index. Different indices can be set
+   * from different threads.
+   *
+   * @param index       index of the particle, less than Size()
+   * @param position    position of the particle
+   * @param velocity    velocity of the particle
+   * @param radius      radius of the particle
+   * @param mass        mass of the particle, must be greater than 0
+   * @param species_id  id of the particle's species
+   */
+  void Set(size_t index, const Vector& position, const Vector& velocity,
+           Scalar radius, Scalar mass, uint8_t species_id);
+
+  void Clear();
+  void Reserve(size_t particle_count);
+
+  /**
+   * Adds or removes particles at the end so there are particle_count. Added
+   * particles are zeroed and must be filled in with Set.
+   */
+  void Resize(size_t particle_count);
+  size_t Size() const;
+  bool IsEmpty() const;
+
+  /**
+   * Moves every particle one time step by using its velocity
+   */
+  void Integrate();
+
+  /**
+   * Moves the particles at indices [begin, end) one time step. Disjoint
+   * ranges can be integrated from different threads.
+   */
+  void Integrate(size_t begin, size_t end);
+
+  /**
+   * Moves the particles at indices [begin, end) by their velocity times dt
+   */
+  void Integrate(size_t begin, size_t end, Scalar dt);
+
+  /**
+   * Checks if the particles at index_one and index_two are touching, by
+   * comparing squared distances
+   */
+  bool IsTouching(size_t index_one, size_t index_two) const;
+
+  /**
+   * Checks if the particles at index_one and index_two get closer to each
+   * other after one more time step, with a single dot product test
+   */
+  bool IsApproaching(size_t index_one, size_t index_two) const;
+
+  /**
+   * Updates the velocities of two colliding particles. Equivalent to
+   * Particle::UpdateVelocitiesForParticleCollision but written in terms of
+   * inverse masses so the two new velocities share one dot product.
+   */
+  void UpdateVelocitiesForParticleCollision(size_t index_one,
+                                            size_t index_two);
+
+  /**
+   * Updates the velocities of two colliding particles using precomputed mass
+   * fractions, see SpeciesRegistry::GetMassFraction
+   *
+   * @param index_one           index of the first particle
+   * @param index_two           index of the second particle
+   * @param mass_fraction_one   2 * m2 / (m1 + m2)
+   * @param mass_fraction_two   2 * m1 / (m1 + m2)
+   */
+  void UpdateVelocitiesForParticleCollision(size_t index_one, size_t index_two,
+                                            Scalar mass_fraction_one,
+                                            Scalar mass_fraction_two);
+
+  /**
+   * Same as above, for particles that can touch across periodic axes
+   *
+   * @param periods   length of each periodic axis, 0 for each axis with walls
+   */
+  void UpdateVelocitiesForParticleCollision(size_t index_one, size_t index_two,
+                                            Scalar mass_fraction_one,
+                                            Scalar mass_fraction_two,
+                                            const Vector& periods);
+
+  /**
+   * Reflects the velocity of the particle at index if it is touching one of
+   * the walls of the container. Walls across lower axes take priority, e.g.
+   * in 2D the vertical walls over the horizontal walls when the particle is
+   * touching both.
+   *
+   * @param index           index of the particle
+   * @param top_left        top left corner of the container
+   * @param bottom_right    bottom right corner of the container
+   * @return                momentum pushed into the wall, 2 * m * |v| along
+   *                        its normal, or 0 if there was no collision.
+   *                        Negative if the particle was already moving away
+   *                        from the wall.
+   */
+  Scalar HandleIfWallCollision(size_t index, const Vector& top_left,
+                               const Vector& bottom_right);
+
+  /**
+   * Reflects each velocity component that would carry the particle at index
+   * into a wall within the next dt time units. The position is shifted so
+   * that Integrating over dt afterwards leaves the particle where it would
+   * be had it bounced off the wall at the moment it reached it, so fast
+   * particles can't pass through the walls.
+   *
+   * @param index           index of the particle
+   * @param top_left        top left corner of the container
+   * @param bottom_right    bottom right corner of the container
+   * @param dt              length of the coming step
+   * @return                momentum pushed into the walls
+   */
+  Scalar ReflectOffWalls(size_t index, const Vector& top_left,
+                         const Vector& bottom_right, Scalar dt);
+
+  /**
+   * Negates one component of the velocity of the particle at index
+   *
+   * @param index   index of the particle
+   * @param axis    axis of the component, 0 for x, 1 for y and so on
+   * @return        momentum a wall along the axis takes, 2 * m * |v|
+   */
+  Scalar ReflectVelocity(size_t index, size_t axis);
+
+  /**
+   * Moves each of the particles at indices [begin, end) that left [low, high)
+   * along axis back in from the other side, by a whole number of periods
+   *
+   * @param axis    a periodic axis
+   * @param low     lowest coordinate on the axis
+   * @param high    highest coordinate on the axis, greater than low
+   */
+  void WrapPositions(size_t begin, size_t end, size_t axis, Scalar low,
+                     Scalar high);
+
+  void SetPosition(size_t index, const Vector& position);
+
+  Vector GetPosition(size_t index) const;
+  Vector GetVelocity(size_t index) const;
+  Scalar GetSpeed(size_t index) const;
+  Scalar GetRadius(size_t index) const;
+  Scalar GetMass(size_t index) const;
+  uint8_t GetSpeciesId(size_t index) const;
+  Scalar GetMaxRadius() const;
+
+  /** Smallest radius of any particle, 0 if there are none **/
+  Scalar GetMinRadius() const;
+
+  /** Raw arrays, for sweeps over every particle **/
+  const Scalar* GetPositions(size_t axis) const;
+  const Scalar* GetVelocities(size_t axis) const;
+  const Scalar* GetPositionsX() const;
+  const Scalar* GetPositionsY() const;
+  const Scalar* GetVelocitiesX() const;
+  const Scalar* GetVelocitiesY() const;
+  const Scalar* GetRadii() const;
+  const Scalar* GetInverseMasses() const;
+  const uint8_t* GetSpeciesIds() const;
+
+ private:
+  /** One array per axis **/
+  std::array<std::vector<Scalar>, Dimension> positions_;
+  std::array<std::vector<Scalar>, Dimension> velocities_;
+  std::vector<Scalar> radii_;
+  std::vector<Scalar> inverse_masses_;
+  std::vector<uint8_t> species_ids_;
+};
+
+/** Particles of a GasContainer **/
+typedef BasicParticleStore<2, float> ParticleStore;
+
+// the members are defined in particle_store.cc for these only
+extern template class BasicParticleStore<2, float>;
+extern template class BasicParticleStore<3, float>;
+extern template class BasicParticleStore<2, double>;
+extern template class BasicParticleStore<3, double>;
+
+}  // namespace idealgas
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "software_renderer.h"
+
+namespace idealgas {
+
+/**
+ * Encodes a framebuffer as an 8-bit RGBA PNG. Each row is filtered with the
+ * PNG Sub filter, which turns runs of equal pixels into runs of zeros, and
+ * compressed with run-length matches and the fixed deflate codes. Frames of
+ * the simulation are mostly background, so this gets most of the size
+ * reduction of a full deflate encoder without depending on zlib.
+ *
+ * @param framebuffer     image to encode
+ * @return                bytes of the PNG file
+ */
+std::vector<uint8_t> EncodePng(const Framebuffer& framebuffer);
+
+/**
+ * Writes a framebuffer to a PNG file, see EncodePng
+ *
+ * @param path            file to write
+ * @param framebuffer     image to write
+ * @throws std::runtime_error if the file can't be written
+ */
+void WritePng(const std::string& path, const Framebuffer& framebuffer);
+
+}  // namespace idealgas
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Wraps the rest of the enclosing scope in a ProfileScope named name, which
+ * must be a string literal. Expands to nothing unless IDEALGAS_PROFILING is
+ * defined (configure with -DIDEALGAS_PROFILING=ON), so the hot paths pay
+ * nothing for it in normal builds.
+ */
+#if defined(IDEALGAS_PROFILING)
+#define IDEALGAS_PROFILE_CONCAT_INNER(a, b) a##b
+#define IDEALGAS_PROFILE_CONCAT(a, b) IDEALGAS_PROFILE_CONCAT_INNER(a, b)
+#define IDEALGAS_PROFILE_SCOPE(name)                                 \
+  ::idealgas::ProfileScope IDEALGAS_PROFILE_CONCAT(profile_scope_, \
+                                                   __LINE__)(name)
+#else
+#define IDEALGAS_PROFILE_SCOPE(name) \
+  do {                               \
+  } while (false)
+#endif
+
+namespace idealgas {
+
+/**
+ * Totals of every scope recorded with one name
+ */
+struct PhaseSummary {
+  std::string name;
+  uint64_t call_count = 0;
+  uint64_t total_nanoseconds = 0;
+  uint64_t min_nanoseconds = 0;
+  uint64_t max_nanoseconds = 0;
+
+  /** Hardware counters, 0 unless they were enabled and available **/
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+};
+
+/**
+ * Collects the scopes recorded by IDEALGAS_PROFILE_SCOPE. Each thread records
+ * into its own buffer, so recording never waits for other threads, and the
+ * buffers outlive their threads so the work of finished threads still shows
+ * up. Recording is off until SetEnabled(true).
+ *
+ * With hardware counters enabled, each scope also reads the cycles,
+ * instructions and cache misses of its thread through perf_event_open. Each
+ * read is a system call, so only enable them for phases that take well over
+ * a microsecond.
+ */
+class Profiler {
+ public:
+  /** Most scopes kept per thread for the trace; the summary counts all **/
+  static const size_t kMaxEventsPerThread = 1 << 20;
+
+  /** Whether the scopes were compiled in, see IDEALGAS_PROFILE_SCOPE **/
+  static bool IsCompiledIn();
+
+  /** Starts or stops recording **/
+  static void SetEnabled(bool is_enabled);
+  static bool IsEnabled();
+
+  /**
+   * Starts or stops reading hardware counters in every scope. Threads that
+   * can't open them (not on Linux, or not allowed by perf_event_paranoid)
+   * only record times.
+   *
+   * @param is_enabled  whether to read the counters
+   * @return            whether the calling thread could open the counters
+   */
+  static bool SetHardwareCountersEnabled(bool is_enabled);
+
+  /** Drops every scope recorded so far **/
+  static void Clear();
+
+  /**
+   * @return    totals per scope name over every thread, longest total first
+   */
+  static std::vector<PhaseSummary> GetSummary();
+
+  /**
+   * Prints GetSummary as a table, with the instructions per cycle and the
+   * cache misses per call when the counters were read
+   */
+  static void PrintSummary(std::FILE* file);
+
+  /**
+   * Writes the recorded scopes as Chrome trace event JSON, which
+   * chrome://tracing and ui.perfetto.dev can open. Each thread is a track.
+   *
+   * @param path    file to write
+   * @throws std::runtime_error if the file can't be written
+   */
+  static void WriteChromeTrace(const std::string& path);
+};
+
+/**
+ * Records the time between its construction and destruction with the
+ * Profiler. Use IDEALGAS_PROFILE_SCOPE rather than creating one directly, so
+ * the scope disappears from builds without profiling.
+ */
+class ProfileScope {
+ public:
+  /**
+   * @param name    name of the phase, must outlive the Profiler's use of it,
+   *                e.g. a string literal
+   */
+  explicit ProfileScope(const char* name);
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  const char* name_;
+  bool is_recording_ = false;
+  bool has_counters_ = false;
+  uint64_t start_nanoseconds_ = 0;
+  uint64_t start_counters_[3] = {};
+};
+
+}  // namespace idealgas
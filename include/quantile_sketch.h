@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * KLL quantile sketch (Karnin, Lang and Liberty) of a stream of floats.
+ * Estimates any quantile of the values added so far while keeping only a
+ * few times size of them, however many were added.
+ *
+ * Values are kept in levels, where a value at level h stands for 2^h of the
+ * added values. When a level fills up it is sorted and every other value is
+ * moved one level up, with a coin flip deciding whether the odd or the even
+ * ones go. The top level gets room for size values, and each level below gets
+ * 2/3 of the room of the one above it, but never less than 8. A quantile is
+ * then off by about 1.7 / size in rank.
+ *
+ * Adding a value takes amortized constant time for a fixed size. The coin
+ * flips come from a fixed seed, so the same values added in the same order
+ * give the same sketch. Sketches of the same size can be merged, e.g. the
+ * sketches of each thread or of each run of an ensemble.
+ */
+class QuantileSketch {
+ public:
+  static const size_t kDefaultSize = 200;
+
+  /**
+   * @param size    room of the top levels, larger is more accurate
+   * @throws std::invalid_argument if size is less than 8
+   */
+  explicit QuantileSketch(size_t size = kDefaultSize);
+
+  void Add(float value);
+
+  /**
+   * Adds the values of other, as if they had been added to this sketch
+   *
+   * @throws std::invalid_argument if other has a different size
+   */
+  void Add(const QuantileSketch& other);
+
+  /**
+   * Estimates the value below which the given fraction of the added values
+   * lie. The fractions 0 and 1 give the exact smallest and largest values.
+   *
+   * @param fraction    fraction of the values, in [0, 1]
+   * @return            the estimate, 0 if no values were added
+   * @throws std::invalid_argument if fraction is outside [0, 1]
+   */
+  float GetQuantile(double fraction) const;
+
+  /** Number of values added **/
+  uint64_t GetCount() const;
+
+  /** Number of values the sketch holds on to, its memory use **/
+  size_t GetRetainedCount() const;
+  size_t GetSize() const;
+  float GetMin() const;
+  float GetMax() const;
+
+ private:
+  size_t size_;
+
+  /**
+   * Values of each level, the ones at level h weigh 2^h. Every level but
+   * the first is kept sorted.
+   */
+  std::vector<std::vector<float>> levels_;
+  size_t retained_count_ = 0;
+
+  /** Values each level can hold before it is compacted **/
+  std::vector<size_t> capacities_;
+
+  /** Sum of the capacities of the levels **/
+  size_t max_retained_count_ = 0;
+  uint64_t count_ = 0;
+  float min_ = 0;
+  float max_ = 0;
+  uint64_t random_state_;
+
+  /** Values on their way up a level, kept to avoid reallocating **/
+  std::vector<float> merge_buffer_;
+
+  void AddLevel();
+
+  /**
+   * Compacts full levels, lowest first, until the sketch holds fewer than
+   * max_retained_count_ values
+   */
+  void Compress();
+
+  /** Moves every other value of level, in sorted order, up a level **/
+  void CompactLevel(size_t level);
+
+  /** Adds the values in [begin, end), sorted unless level is 0, to level **/
+  void MergeIntoLevel(size_t level, const float* begin, const float* end);
+  bool FlipCoin();
+};
+
+}  // namespace idealgas
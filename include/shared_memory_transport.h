@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+
+#include "transport.h"
+
+namespace idealgas {
+
+/**
+ * Transport between processes on one machine through a POSIX shared memory
+ * segment. The segment holds a mailbox for every ordered pair of ranks: a
+ * ring buffer guarded by a process-shared mutex. Messages larger than a
+ * mailbox are streamed through it, so the sender waits for the receiver.
+ *
+ * One process creates the segment with Create before the others open it,
+ * and removes its name with Unlink once every rank has opened it.
+ */
+class SharedMemoryTransport : public Transport {
+ public:
+  /** Bytes each mailbox buffers before Send waits for the receiver **/
+  static const size_t kDefaultMailboxCapacity = 1 << 20;
+
+  /**
+   * Creates and initializes the segment
+   *
+   * @param name                name of the segment, e.g. "/idealgas-run"
+   * @param rank_count          number of ranks that will open it
+   * @param mailbox_capacity    bytes buffered per ordered pair of ranks
+   * @throws std::runtime_error if the segment can't be created, e.g. it
+   *         already exists or shared memory isn't supported
+   */
+  static void Create(const std::string& name, size_t rank_count,
+                     size_t mailbox_capacity = kDefaultMailboxCapacity);
+
+  /**
+   * Removes the segment's name. Processes that opened it keep using it.
+   */
+  static void Unlink(const std::string& name);
+
+  /**
+   * Opens a segment made with Create
+   *
+   * @param name    name given to Create
+   * @param rank    rank of this process
+   * @throws std::runtime_error if the segment can't be opened
+   * @throws std::invalid_argument if rank is out of range
+   */
+  SharedMemoryTransport(const std::string& name, size_t rank);
+  ~SharedMemoryTransport() override;
+
+  SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+  SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+  size_t GetRank() const override;
+  size_t GetRankCount() const override;
+  void Send(size_t destination, const std::vector<uint8_t>& message) override;
+  void Receive(size_t source, std::vector<uint8_t>& message) override;
+
+ private:
+  size_t rank_;
+  size_t rank_count_ = 0;
+  size_t mailbox_capacity_ = 0;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+
+  /** Mailbox messages from source to destination go through **/
+  void* GetMailbox(size_t source, size_t destination) const;
+  void CheckRank(size_t rank) const;
+};
+
+}  // namespace idealgas
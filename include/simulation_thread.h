@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gas_container.h"
+#include "triple_buffer.h"
+
+namespace idealgas {
+
+/**
+ * State of the container published for drawing
+ */
+struct SimulationSnapshot {
+  uint64_t frame_count = 0;
+  ParticleStore particles;
+
+  /** Speeds of the particles of each species, indexed by species id **/
+  std::vector<std::vector<float>> species_speeds;
+};
+
+/**
+ * Settings of a SimulationThread
+ */
+struct SimulationThreadOptions {
+  /** Steps to run per second, 0 = as fast as possible **/
+  double steps_per_second = 0;
+
+  /**
+   * How many steps behind schedule the thread may fall before it drops the
+   * missed steps instead of running them back to back
+   */
+  size_t max_catch_up_steps = 4;
+
+  /**
+   * Shortest time between two snapshots, in seconds, so copying the
+   * particles doesn't slow down a simulation running thousands of steps per
+   * second. 0 publishes every step.
+   */
+  double min_publish_interval = 1.0 / 240;
+};
+
+/**
+ * Runs a GasContainer on its own thread, so the simulation rate doesn't
+ * depend on the display's frame rate and a slow step doesn't stall drawing.
+ * Snapshots are published through a TripleBuffer, so the drawing thread
+ * reads the latest one without waiting for the simulation.
+ *
+ * The container must not be used by other threads until Stop returns.
+ */
+class SimulationThread {
+ public:
+  /**
+   * Publishes the container's current state and starts stepping it
+   *
+   * @param container   container to run
+   * @param options     how fast to run and publish
+   */
+  explicit SimulationThread(
+      GasContainer container,
+      const SimulationThreadOptions& options = SimulationThreadOptions());
+
+  /**
+   * Stops the thread, see Stop
+   */
+  ~SimulationThread();
+
+  SimulationThread(const SimulationThread&) = delete;
+  SimulationThread& operator=(const SimulationThread&) = delete;
+
+  /**
+   * Stops stepping after the current step and joins the thread. Does nothing
+   * if the thread is already stopped.
+   */
+  void Stop();
+
+  /**
+   * Changes the rate the thread runs at, see SimulationThreadOptions
+   *
+   * @param steps_per_second    steps per second, 0 = as fast as possible
+   */
+  void SetStepsPerSecond(double steps_per_second);
+
+  /**
+   * Makes the latest published snapshot the one GetSnapshot returns. Only
+   * one thread may read snapshots.
+   *
+   * @return    whether there was a newer snapshot
+   */
+  bool AcquireSnapshot();
+
+  /** Snapshot of the last AcquireSnapshot call **/
+  const SimulationSnapshot& GetSnapshot() const;
+
+  /** Number of steps run so far **/
+  uint64_t GetStepCount() const;
+
+  /** Number of steps skipped because the thread fell behind schedule **/
+  uint64_t GetDroppedStepCount() const;
+
+  /** These don't change while running, so any thread may use them **/
+  const SpeciesRegistry& GetSpecies() const;
+  const glm::vec2& GetTopLeftPosition() const;
+  const glm::vec2& GetBottomRightPosition() const;
+
+  /**
+   * @return    the container, only safe to use once the thread is stopped
+   */
+  const GasContainer& GetContainer() const;
+
+ private:
+  GasContainer container_;
+  SimulationThreadOptions options_;
+  SpeciesRegistry species_;
+  glm::vec2 top_left_;
+  glm::vec2 bottom_right_;
+
+  TripleBuffer<SimulationSnapshot> snapshots_;
+
+  std::atomic<double> steps_per_second_;
+  std::atomic<uint64_t> step_count_{0};
+  std::atomic<uint64_t> dropped_step_count_{0};
+
+  /** Wakes the thread from waiting for its next step when stopping **/
+  std::mutex mutex_;
+  std::condition_variable stop_requested_;
+  bool is_stopping_ = false;
+
+  std::thread thread_;
+
+  void StepLoop();
+  void PublishSnapshot();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "particle_store.h"
+#include "species_registry.h"
+
+namespace idealgas {
+
+/**
+ * Container state stored in a snapshot besides the species and particles
+ */
+struct SnapshotHeader {
+  glm::vec2 top_left_position;
+  glm::vec2 container_dimension;
+  int64_t seed = 0;
+  uint64_t frame_count = 0;
+};
+
+/**
+ * Current version of the snapshot format. Files with another version are
+ * rejected.
+ */
+const uint32_t kSnapshotVersion = 1;
+
+/**
+ * Writes a binary snapshot. The file starts with a fixed size header and
+ * the species table, followed by one array per particle field, each aligned
+ * to 64 bytes, in the machine's byte order.
+ *
+ * @param path        file to write
+ * @param header      container state to store
+ * @param species     species of the particles
+ * @param particles   particles to store
+ * @throws std::runtime_error if the file can't be written
+ */
+void WriteSnapshot(const std::string& path, const SnapshotHeader& header,
+                   const SpeciesRegistry& species,
+                   const ParticleStore& particles);
+
+/**
+ * Reads a snapshot written by WriteSnapshot. The file is memory-mapped and
+ * the particle arrays are copied straight out of the mapping, so nothing is
+ * parsed per particle.
+ *
+ * @param path        file to read
+ * @param header      set to the stored container state
+ * @param species     emptied, then filled with the stored species
+ * @param particles   emptied, then filled with the stored particles
+ * @throws std::runtime_error if the file can't be read, isn't a snapshot,
+ *         has another version or byte order, or is truncated
+ */
+void ReadSnapshot(const std::string& path, SnapshotHeader& header,
+                  SpeciesRegistry& species, ParticleStore& particles);
+
+}  // namespace idealgas
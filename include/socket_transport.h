@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+
+#include "transport.h"
+
+namespace idealgas {
+
+/**
+ * Transport over TCP, for ranks on different machines. Every pair of ranks
+ * has its own connection: each rank listens on its own address, accepts the
+ * higher ranks and connects to the lower ones. Messages are sent as a size
+ * followed by the bytes.
+ */
+class SocketTransport : public Transport {
+ public:
+  /** Seconds to wait for every other rank to connect **/
+  static constexpr double kDefaultConnectTimeout = 30;
+
+  /**
+   * Listens on addresses[rank] and connects to every other rank. Returns
+   * once every connection is made.
+   *
+   * @param addresses           "host:port" of every rank, in rank order
+   * @param rank                rank of this process
+   * @param connect_timeout     seconds to keep retrying for ranks that
+   *                            aren't listening yet
+   * @throws std::invalid_argument if an address or the rank is invalid
+   * @throws std::runtime_error if a connection can't be made in time
+   */
+  SocketTransport(const std::vector<std::string>& addresses, size_t rank,
+                  double connect_timeout = kDefaultConnectTimeout);
+  ~SocketTransport() override;
+
+  SocketTransport(const SocketTransport&) = delete;
+  SocketTransport& operator=(const SocketTransport&) = delete;
+
+  size_t GetRank() const override;
+  size_t GetRankCount() const override;
+  void Send(size_t destination, const std::vector<uint8_t>& message) override;
+  void Receive(size_t source, std::vector<uint8_t>& message) override;
+
+ private:
+  size_t rank_;
+
+  /** Connection to each rank, -1 for this rank **/
+  std::vector<int> sockets_;
+
+  int GetSocket(size_t rank) const;
+  void CloseSockets();
+};
+
+}  // namespace idealgas
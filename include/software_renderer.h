@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "color.h"
+#include "gas_container.h"
+#include "histogram.h"
+#include "thread_pool.h"
+
+namespace idealgas {
+
+/**
+ * In-memory RGBA image with 8 bits per channel, stored row by row from the
+ * top
+ */
+class Framebuffer {
+ public:
+  /**
+   * Creates a black, opaque image
+   *
+   * @param width   width in pixels
+   * @param height  height in pixels
+   */
+  Framebuffer(size_t width, size_t height);
+
+  void Clear(const Color& color);
+
+  /** Returns the 4 bytes of the pixel at column x and row y **/
+  const uint8_t* GetPixel(size_t x, size_t y) const;
+
+  size_t GetWidth() const;
+  size_t GetHeight() const;
+  const uint8_t* GetPixels() const;
+  uint8_t* GetPixels();
+
+ private:
+  size_t width_;
+  size_t height_;
+  std::vector<uint8_t> pixels_;
+};
+
+/**
+ * Maps positions to pixels: pixel = (position - origin) * scale. The default
+ * draws positions as pixels, like the Cinder app's window.
+ */
+struct Viewport {
+  glm::vec2 origin = glm::vec2(0, 0);
+  float scale = 1;
+};
+
+/**
+ * Render layer that draws the simulation objects into a Framebuffer on the
+ * CPU, for machines without a GPU or display. Draws the same shapes as
+ * cinder_renderer.h, except the histogram labels, which would need a font.
+ *
+ * Particles are binned into square tiles of the framebuffer, and the tiles
+ * are rasterized in parallel. Each tile draws its particles in index order,
+ * so the image doesn't depend on the thread count.
+ */
+class SoftwareRenderer {
+ public:
+  /** Width and height of a tile in pixels **/
+  static const size_t kTileSize = 64;
+
+  /**
+   * @param thread_count    threads to rasterize tiles on
+   */
+  explicit SoftwareRenderer(size_t thread_count = 1);
+
+  SoftwareRenderer(const SoftwareRenderer&) = delete;
+  SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+  void SetViewport(const Viewport& viewport);
+  const Viewport& GetViewport() const;
+
+  /**
+   * Draws the container walls and the current positions of the particles
+   *
+   * @param container   container to draw
+   * @param framebuffer image to draw into
+   */
+  void DrawGasContainer(const GasContainer& container,
+                        Framebuffer& framebuffer);
+
+  /**
+   * Draws the walls and particles of a container from its parts, for
+   * callers that keep a copy of the particles
+   *
+   * @param particles       particles to draw
+   * @param species         species of the particles, for their colors
+   * @param top_left        top left corner of the walls
+   * @param bottom_right    bottom right corner of the walls
+   * @param framebuffer     image to draw into
+   */
+  void DrawParticles(const ParticleStore& particles,
+                     const SpeciesRegistry& species,
+                     const glm::vec2& top_left, const glm::vec2& bottom_right,
+                     Framebuffer& framebuffer);
+
+  /**
+   * Draws the bars and axis of a histogram
+   *
+   * @param histogram   histogram to draw
+   * @param framebuffer image to draw into
+   */
+  void DrawHistogram(const Histogram& histogram, Framebuffer& framebuffer);
+
+ private:
+  Viewport viewport_;
+  ThreadPool thread_pool_;
+
+  /**
+   * Particles overlapping each tile, as a counting sort: the particles of
+   * tile t are tile_particles_[tile_offsets_[t], tile_offsets_[t + 1])
+   */
+  std::vector<size_t> tile_offsets_;
+  std::vector<size_t> tile_cursors_;
+  std::vector<uint32_t> tile_particles_;
+
+  /** Packed RGBA of each species, indexed by species id **/
+  std::vector<uint32_t> species_colors_;
+
+  glm::vec2 ToPixel(const glm::vec2& position) const;
+
+  /** Fills the pixels of [left, right) x [top, bottom), clipped **/
+  void FillRect(float left, float top, float right, float bottom,
+                const Color& color, Framebuffer& framebuffer) const;
+  void StrokeRect(const glm::vec2& top_left, const glm::vec2& bottom_right,
+                  const Color& color, Framebuffer& framebuffer) const;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "narrowphase.h"
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Uniform grid (cell list) used as the broadphase for particle collisions.
+ * Particles are binned into square cells that are at least as wide as the
+ * largest particle diameter, so two particles can only be touching if they
+ * are in the same cell or in adjacent cells. The grid is rebuilt every frame.
+ *
+ * Rebuild copies the particles into cell order, so the candidates of a
+ * particle are two contiguous runs: the rest of its own cell plus the cell to
+ * its right, and the three cells below. Both runs are handed to the
+ * Narrowphase in blocks.
+ *
+ * On a periodic axis the cells tile the container exactly, and the cells on
+ * opposite edges are neighbors, so the forward neighbors of an edge cell
+ * wrap around to the other side as extra runs.
+ */
+class SpatialGrid {
+ public:
+  /** Indices of two colliding particles, with first < second **/
+  typedef std::pair<size_t, size_t> IndexPair;
+
+  /**
+   * Bins every particle into a cell of a grid covering the container.
+   * Particles outside of the container are binned into the nearest edge cell,
+   * so particles should be wrapped into the container on periodic axes first.
+   *
+   * @param particles       particles to bin
+   * @param top_left        top left corner of the container
+   * @param bottom_right    bottom right corner of the container
+   */
+  void Rebuild(const ParticleStore& particles, const glm::vec2& top_left,
+               const glm::vec2& bottom_right);
+
+  /**
+   * Finds every pair of particles that are touching and approaching each
+   * other. Only particles in the same or adjacent cells are tested, and each
+   * pair of cells is visited once, so each pair is reported exactly once.
+   *
+   * @param particles   the same particles the grid was last rebuilt with
+   * @param pairs       output vector of colliding pairs, sorted by the first
+   *                    index then by the second index
+   */
+  void FindCollidingPairs(const ParticleStore& particles,
+                          std::vector<IndexPair>& pairs) const;
+
+  /**
+   * Appends the colliding pairs found from the cells in rows
+   * [first_row, end_row), without sorting them. Rows only read the row below
+   * them, so disjoint row ranges can be searched from different threads.
+   *
+   * @param particles   the same particles the grid was last rebuilt with
+   * @param first_row   first row to search
+   * @param end_row     one past the last row to search
+   * @param pairs       vector to append the colliding pairs to
+   */
+  void FindCollidingPairsInRows(const ParticleStore& particles,
+                                size_t first_row, size_t end_row,
+                                std::vector<IndexPair>& pairs) const;
+
+  /**
+   * Appends the indices of the particles binned into the cells that overlap
+   * the box [low, high]. Particles outside of the container count as being
+   * in the nearest edge cell, like in Rebuild.
+   *
+   * @param low     corner of the box with the smallest coordinates
+   * @param high    corner of the box with the largest coordinates
+   * @param indices vector to append the indices to
+   */
+  void FindParticlesInBox(const glm::vec2& low, const glm::vec2& high,
+                          std::vector<size_t>& indices) const;
+
+  /**
+   * Sets the boundaries of the container, applied from the next Rebuild.
+   * Both axes have walls by default.
+   */
+  void SetBoundaries(Boundary x_boundary, Boundary y_boundary);
+
+  /**
+   * Sets the kernel used to test candidate pairs. Defaults to the widest one
+   * the CPU supports.
+   */
+  void SetNarrowphase(const Narrowphase& narrowphase);
+
+  float GetCellSize() const;
+  size_t GetColumnCount() const;
+  size_t GetRowCount() const;
+
+ private:
+  /**
+   * Upper bound on the number of cells per particle. Keeps the grid small
+   * when the particles are tiny compared to the container.
+   */
+  const size_t kMaxCellsPerParticle = 4;
+
+  float cell_size_ = 0;
+
+  /**
+   * Sides of the cells, cell_size_ on an axis with walls and stretched so
+   * the cells tile the container on a periodic axis
+   */
+  glm::vec2 cell_sides_;
+  Boundary x_boundary_ = Boundary::kWall;
+  Boundary y_boundary_ = Boundary::kWall;
+  size_t column_count_ = 0;
+  size_t row_count_ = 0;
+  glm::vec2 origin_;
+
+  /**
+   * Particles of cell c are cell_particles_[cell_starts_[c]] up to (but not
+   * including) cell_particles_[cell_starts_[c + 1]], in increasing order
+   */
+  std::vector<size_t> cell_starts_;
+  std::vector<size_t> cell_particles_;
+
+  /** Cell index of each particle **/
+  std::vector<size_t> particle_cells_;
+
+  /** Scratch space for the counting sort, kept to avoid reallocating **/
+  std::vector<size_t> next_slots_;
+
+  /** Copies of the particle fields in the order of cell_particles_ **/
+  std::vector<float> sorted_positions_x_;
+  std::vector<float> sorted_positions_y_;
+  std::vector<float> sorted_velocities_x_;
+  std::vector<float> sorted_velocities_y_;
+  std::vector<float> sorted_radii_;
+  ParticleArrays sorted_particles_;
+
+  Narrowphase narrowphase_;
+
+  size_t GetCellIndex(const glm::vec2& position) const;
+
+  /**
+   * Number of cells along an axis of the given length, at least cell_size_
+   * wide
+   */
+  size_t GetCellCount(float length, Boundary boundary) const;
+
+  /**
+   * Finds the cells along axis that overlap [low, high]
+   *
+   * @param first   first of the cells, the ones after it may wrap around to
+   *                0 on a periodic axis
+   * @param count   number of cells
+   */
+  void GetCellRange(float low, float high, size_t axis, size_t& first,
+                    size_t& count) const;
+
+  /**
+   * Tests the particle in slot of cell_particles_ against the particles in
+   * slots [begin, end) and appends the colliding pairs
+   */
+  void CollectPairs(size_t slot, size_t begin, size_t end,
+                    std::vector<IndexPair>& pairs) const;
+};
+
+}  // namespace idealgas
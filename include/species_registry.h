@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "color.h"
+
+namespace idealgas {
+
+/**
+ * Properties shared by every particle of one species (particle type)
+ */
+struct Species {
+  std::string name;
+  Color color;
+  float mass;
+  float radius;
+};
+
+/**
+ * Table of the species in a GasContainer. Each species gets a dense id in
+ * registration order, so per-species data can be kept in vectors indexed by
+ * id instead of maps keyed by type name. Collision constants for every pair
+ * of species are precomputed when a species is registered.
+ */
+class SpeciesRegistry {
+ public:
+  /** Ids are stored per particle, so they are kept to one byte **/
+  static const size_t kMaxSpeciesCount = 256;
+
+  /**
+   * Registers a species. Registering a name again with the same mass and
+   * radius returns the existing id.
+   *
+   * @param name    the particle type name
+   * @param color   color used to draw the species
+   * @param mass    mass of each particle, must be greater than 0
+   * @param radius  radius of each particle, must be greater than 0
+   * @return        id of the species
+   * @throws std::invalid_argument if the mass or radius is not positive, or
+   *         if the name is already registered with a different mass or radius
+   * @throws std::length_error if kMaxSpeciesCount species are registered
+   */
+  uint8_t Register(const std::string& name, const Color& color,
+                   float mass, float radius);
+
+  /**
+   * @param name    the particle type name
+   * @return        true if a species with the name is registered
+   */
+  bool Contains(const std::string& name) const;
+
+  /**
+   * @param name    the particle type name
+   * @return        id of the species with the name
+   * @throws std::out_of_range if no species has the name
+   */
+  uint8_t GetId(const std::string& name) const;
+
+  const Species& Get(uint8_t id) const;
+  size_t Size() const;
+  bool IsEmpty() const;
+
+  /**
+   * Returns 2 * m2 / (m1 + m2), the mass term of the new velocity of a
+   * particle of species_one after colliding with a particle of species_two
+   */
+  float GetMassFraction(uint8_t species_one, uint8_t species_two) const;
+
+  /**
+   * Returns the distance at which particles of the two species touch
+   */
+  float GetRadiusSum(uint8_t species_one, uint8_t species_two) const;
+
+ private:
+  std::vector<Species> species_;
+
+  /** size() x size() tables in row-major order, indexed [one][two] **/
+  std::vector<float> mass_fractions_;
+  std::vector<float> radius_sums_;
+
+  void RebuildPairTables();
+};
+
+}  // namespace idealgas
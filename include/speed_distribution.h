@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "quantile_sketch.h"
+
+namespace idealgas {
+
+/**
+ * Speeds gathered over many frames, in fixed bins for their time averaged
+ * histogram and in a QuantileSketch for their percentiles. Adding a speed
+ * takes constant time and the memory use doesn't grow with the number of
+ * speeds, so a distribution can run for the whole life of a simulation.
+ * Distributions with the same bins add up into one, e.g. those of the
+ * threads or of the worlds of an ensemble.
+ */
+class SpeedDistribution {
+ public:
+  static constexpr float kDefaultMaxSpeed = 20;
+  static const size_t kDefaultBinCount = 40;
+
+  /**
+   * @param max_speed   upper edge of the last bin. Faster speeds are counted
+   *                    in the last bin.
+   * @param bin_count   number of bins splitting [0, max_speed)
+   * @throws std::invalid_argument if max_speed isn't positive or bin_count
+   *         is 0
+   */
+  explicit SpeedDistribution(float max_speed = kDefaultMaxSpeed,
+                             size_t bin_count = kDefaultBinCount);
+
+  void Add(float speed);
+
+  /**
+   * Adds the speeds of one frame, see GetAverageBinCounts
+   *
+   * @param speeds  the speeds, e.g. from GasContainer::GetSpeciesSpeeds
+   */
+  void AddFrame(const std::vector<float>& speeds);
+
+  /**
+   * Adds the samples and frames of other
+   *
+   * @throws std::invalid_argument if other has different bins
+   */
+  void Add(const SpeedDistribution& other);
+
+  uint64_t GetSampleCount() const;
+
+  /** Number of frames added with AddFrame **/
+  uint64_t GetFrameCount() const;
+
+  /** Mean of the samples, 0 if there are none **/
+  double GetMean() const;
+
+  /**
+   * Estimates a percentile of the samples, see QuantileSketch::GetQuantile
+   *
+   * @param fraction    fraction of the samples below the speed, in [0, 1]
+   * @return            the speed, 0 if there are no samples
+   */
+  float GetQuantile(double fraction) const;
+  const std::vector<uint64_t>& GetBinCounts() const;
+
+  /**
+   * Counts of each bin per frame, the time averaged histogram of the frames
+   * added with AddFrame. Empty bins if no frames were added.
+   */
+  std::vector<double> GetAverageBinCounts() const;
+  const QuantileSketch& GetSketch() const;
+  float GetMaxSpeed() const;
+  float GetBinWidth() const;
+
+ private:
+  float max_speed_;
+  std::vector<uint64_t> bin_counts_;
+  uint64_t sample_count_ = 0;
+  uint64_t frame_count_ = 0;
+  double speed_sum_ = 0;
+  QuantileSketch sketch_;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "particle_store.h"
+
+namespace idealgas {
+
+/**
+ * Hashes the positions, velocities and species of every particle, bit for
+ * bit, so two states hash the same only if they are identical (up to hash
+ * collisions). One multiply per value, cheap enough to run every frame.
+ *
+ * @param particles   the particles to hash
+ * @return            64-bit hash of the state
+ */
+uint64_t HashParticleState(const ParticleStore& particles);
+
+/**
+ * Folds the hash of a frame's state into the hash of the frames before it,
+ * so the result depends on every frame and their order
+ *
+ * @param previous_hash   combined hash of the frames before
+ * @param state_hash      HashParticleState of the frame
+ * @return                combined hash up to and including the frame
+ */
+uint64_t CombineStateHashes(uint64_t previous_hash, uint64_t state_hash);
+
+/**
+ * Finds the first frame two runs disagree on, from their hashes of each
+ * frame, e.g. GasContainer::GetStateHashes
+ *
+ * @return    index of the first differing hash, or the length of the
+ *            shorter log if they agree on all of it
+ */
+size_t FindFirstDivergentFrame(const std::vector<uint64_t>& one,
+                               const std::vector<uint64_t>& two);
+
+}  // namespace idealgas
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Fixed set of worker threads used to split the phases of a frame across
+ * cores. Work is always split into the same contiguous chunks for a given
+ * chunk count, so callers can make results independent of the thread count
+ * by only depending on chunk boundaries through order-preserving merges.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Body of a parallel loop: processes indices [begin, end) of chunk
+   * chunk_index. Only refers to the function it is made from instead of
+   * copying it, so passing a lambda never allocates; the function has to
+   * outlive the RangeFunction, which a lambda passed straight to ParallelFor
+   * does.
+   */
+  class RangeFunction {
+   public:
+    template <typename Function>
+    RangeFunction(const Function& function)  // NOLINT(runtime/explicit)
+        : function_(&function), call_(&Call<Function>) {}
+
+    void operator()(size_t begin, size_t end, size_t chunk_index) const {
+      call_(function_, begin, end, chunk_index);
+    }
+
+   private:
+    const void* function_;
+    void (*call_)(const void* function, size_t begin, size_t end,
+                  size_t chunk_index);
+
+    template <typename Function>
+    static void Call(const void* function, size_t begin, size_t end,
+                     size_t chunk_index) {
+      (*static_cast<const Function*>(function))(begin, end, chunk_index);
+    }
+  };
+
+  /**
+   * Starts the worker threads. The calling thread also does work, so
+   * thread_count - 1 threads are started.
+   *
+   * @param thread_count    number of threads to run loops on, at least 1
+   */
+  explicit ThreadPool(size_t thread_count);
+
+  /**
+   * Stops and joins the worker threads
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Splits [0, count) into chunk_count contiguous chunks of nearly equal size
+   * and calls body once per chunk, spread over the threads. Returns once
+   * every chunk is done.
+   *
+   * @param count       number of indices to process
+   * @param chunk_count number of chunks to split the indices into
+   * @param body        function called for each chunk
+   */
+  void ParallelFor(size_t count, size_t chunk_count, const RangeFunction& body);
+
+  /**
+   * Same as ParallelFor with one chunk per thread
+   */
+  void ParallelFor(size_t count, const RangeFunction& body);
+
+  size_t GetThreadCount() const;
+
+  /**
+   * @return    number of hardware threads, or 1 if it is unknown
+   */
+  static size_t GetHardwareThreadCount();
+
+ private:
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+
+  /** Loop currently being run, only valid while busy_workers_ > 0 **/
+  const RangeFunction* body_ = nullptr;
+  size_t count_ = 0;
+  size_t chunk_count_ = 0;
+  size_t next_chunk_ = 0;
+  size_t busy_workers_ = 0;
+
+  /** Incremented for every loop so workers can tell a new loop started **/
+  size_t generation_ = 0;
+  bool is_stopping_ = false;
+
+  void WorkerLoop();
+
+  /**
+   * Claims and runs chunks of the current loop until none are left
+   */
+  void RunChunks(std::unique_lock<std::mutex>& lock);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gas_container.h"
+
+namespace idealgas {
+
+/**
+ * Settings of a TrajectoryWriter
+ */
+struct TrajectoryOptions {
+  /** Only frames whose frame count is a multiple of stride are written **/
+  size_t stride = 1;
+
+  /** Ids of the species to write, empty to write every particle **/
+  std::vector<uint8_t> species_ids;
+
+  /**
+   * Velocity components are quantized in [-velocity_limit, velocity_limit],
+   * faster components are clamped
+   */
+  float velocity_limit = 32;
+
+  /**
+   * Frames per compressed chunk. Each chunk starts from absolute values, so
+   * a reader can start at any chunk.
+   */
+  size_t frames_per_chunk = 32;
+
+  /**
+   * Frames that can wait to be written before AddFrame has to wait for the
+   * disk
+   */
+  size_t buffer_count = 4;
+};
+
+/**
+ * Writes the positions and velocities of the particles of a GasContainer to
+ * a trajectory file on a background thread.
+ *
+ * AddFrame only quantizes the particles into a free buffer from a small
+ * pool and hands it to the I/O thread, which does the encoding and writing.
+ * Positions are quantized to 16 bits relative to the container bounds and
+ * velocities to 16 bits relative to the velocity limit. Each value is stored
+ * as the zigzag varint of its difference from the previous frame, which
+ * takes one or two bytes for the small per-frame changes of a gas instead of
+ * four for a float, and runs of unchanged values, mostly velocities between
+ * collisions, take two bytes per run.
+ */
+class TrajectoryWriter {
+ public:
+  /**
+   * Opens the file, writes the header and starts the I/O thread. The
+   * particles to write are picked from the container's current particles.
+   *
+   * @param path        file to write
+   * @param container   container the frames will come from
+   * @param options     what to write and how
+   * @throws std::invalid_argument if the stride, chunk size, buffer count or
+   *         velocity limit is not positive
+   * @throws std::runtime_error if the file can't be opened
+   */
+  TrajectoryWriter(const std::string& path, const GasContainer& container,
+                   const TrajectoryOptions& options = TrajectoryOptions());
+
+  /**
+   * Closes the writer, see Close. Errors are ignored; call Close to see them.
+   */
+  ~TrajectoryWriter();
+
+  TrajectoryWriter(const TrajectoryWriter&) = delete;
+  TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+  /**
+   * Queues the container's current frame for writing if its frame count is
+   * a multiple of the stride. Only waits if every buffer is still queued.
+   *
+   * @param container   the container passed to the constructor
+   */
+  void AddFrame(const GasContainer& container);
+
+  /**
+   * Writes every queued frame, stops the I/O thread and closes the file.
+   * Does nothing if the writer is already closed.
+   *
+   * @throws std::runtime_error if writing failed
+   */
+  void Close();
+
+  /** Number of frames passed to the I/O thread so far **/
+  size_t GetQueuedFrameCount() const;
+
+  /** Number of times AddFrame had to wait for a free buffer **/
+  size_t GetStallCount() const;
+
+ private:
+  /** One quantized frame **/
+  struct FrameBuffer {
+    uint64_t frame_number = 0;
+    std::vector<uint16_t> positions_x;
+    std::vector<uint16_t> positions_y;
+    std::vector<int16_t> velocities_x;
+    std::vector<int16_t> velocities_y;
+  };
+
+  std::string path_;
+  TrajectoryOptions options_;
+  glm::vec2 top_left_;
+  glm::vec2 dimension_;
+  /** Size of the container's ParticleStore, which every frame must keep **/
+  size_t container_particle_count_;
+
+  /** Indices into the container's ParticleStore of the written particles **/
+  std::vector<size_t> particle_indices_;
+
+  std::vector<std::unique_ptr<FrameBuffer>> buffers_;
+  std::vector<FrameBuffer*> free_buffers_;
+  std::deque<FrameBuffer*> queued_buffers_;
+  mutable std::mutex mutex_;
+  std::condition_variable buffer_freed_;
+  std::condition_variable frame_queued_;
+  bool is_closing_ = false;
+  bool is_closed_ = false;
+  size_t queued_frame_count_ = 0;
+  size_t stall_count_ = 0;
+
+  /** Only used by the I/O thread until it is joined **/
+  std::ofstream file_;
+  bool has_failed_ = false;
+  std::vector<int32_t> previous_values_;
+  uint64_t previous_frame_number_ = 0;
+  std::vector<uint8_t> chunk_;
+  uint32_t chunk_frame_count_ = 0;
+
+  std::thread io_thread_;
+
+  void WriteHeader(const GasContainer& container);
+  void IoLoop();
+
+  /** Delta encodes a frame into chunk_ **/
+  void EncodeFrame(const FrameBuffer& buffer);
+  void FlushChunk();
+};
+
+/**
+ * One frame read from a trajectory file
+ */
+struct TrajectoryFrame {
+  uint64_t frame_number = 0;
+  std::vector<glm::vec2> positions;
+  std::vector<glm::vec2> velocities;
+};
+
+/**
+ * Reads the frames of a file written by TrajectoryWriter, in order
+ */
+class TrajectoryReader {
+ public:
+  /**
+   * Opens the file and reads its header
+   *
+   * @param path    file to read
+   * @throws std::runtime_error if the file can't be read or isn't a
+   *         trajectory
+   */
+  explicit TrajectoryReader(const std::string& path);
+
+  /**
+   * Reads the next frame
+   *
+   * @param frame   set to the next frame
+   * @return        false if there are no more frames
+   * @throws std::runtime_error if the file is corrupt
+   */
+  bool ReadFrame(TrajectoryFrame& frame);
+
+  /** Index of each written particle in the container **/
+  const std::vector<uint64_t>& GetParticleIndices() const;
+  const std::vector<uint8_t>& GetSpeciesIds() const;
+  const std::vector<std::string>& GetSpeciesNames() const;
+  size_t GetStride() const;
+
+ private:
+  std::ifstream file_;
+  glm::vec2 top_left_;
+  glm::vec2 dimension_;
+  float velocity_limit_ = 0;
+  size_t stride_ = 1;
+
+  /** Most frames a chunk may hold, which bounds the size of a chunk **/
+  uint32_t frames_per_chunk_ = 0;
+  std::vector<uint64_t> particle_indices_;
+  std::vector<uint8_t> species_ids_;
+  std::vector<std::string> species_names_;
+
+  /** Current chunk and the read position in it **/
+  std::vector<uint8_t> chunk_;
+  size_t chunk_position_ = 0;
+  uint32_t chunk_frames_left_ = 0;
+  std::vector<int32_t> previous_values_;
+  uint64_t previous_frame_number_ = 0;
+};
+
+}  // namespace idealgas
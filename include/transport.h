@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Point to point messaging between the processes (ranks) of a distributed
+ * run. Messages between two ranks arrive in the order they were sent.
+ *
+ * Send may block until the destination receives, so ranks that send to each
+ * other must agree on who goes first; Exchange does that for any set of
+ * partners.
+ */
+class Transport {
+ public:
+  virtual ~Transport() = default;
+
+  /** Rank of this process, in [0, GetRankCount()) **/
+  virtual size_t GetRank() const = 0;
+  virtual size_t GetRankCount() const = 0;
+
+  /**
+   * Sends a message to another rank
+   *
+   * @throws std::runtime_error if the message can't be sent
+   */
+  virtual void Send(size_t destination,
+                    const std::vector<uint8_t>& message) = 0;
+
+  /**
+   * Waits for the next message from another rank
+   *
+   * @param source  rank to receive from
+   * @param message replaced with the message
+   * @throws std::runtime_error if the connection failed
+   */
+  virtual void Receive(size_t source, std::vector<uint8_t>& message) = 0;
+
+  /**
+   * Sends outgoing[i] to partners[i] and receives incoming[i] from it, for
+   * every partner. The pairs are visited in the same global order on every
+   * rank (the lower rank of a pair sends first), so ranks calling Exchange
+   * with each other never wait on each other in a cycle.
+   *
+   * @param partners    ranks to exchange with, in increasing order
+   * @param outgoing    message for each partner
+   * @param incoming    resized to the number of partners and filled with
+   *                    their messages
+   */
+  void Exchange(const std::vector<size_t>& partners,
+                const std::vector<std::vector<uint8_t>>& outgoing,
+                std::vector<std::vector<uint8_t>>& incoming);
+};
+
+/**
+ * Appends plain values to a message. Values are copied as they are in
+ * memory, so every rank must run on machines of the same byte order.
+ */
+class MessageWriter {
+ public:
+  /** Clears message and writes to it **/
+  explicit MessageWriter(std::vector<uint8_t>& message) : message_(message) {
+    message_.clear();
+  }
+
+  template <typename T>
+  void Write(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only plain values can be written");
+    WriteBytes(&value, sizeof(T));
+  }
+
+  /** Writes the number of values, then the values **/
+  template <typename T>
+  void WriteArray(const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only plain values can be written");
+    Write<uint64_t>(values.size());
+    WriteBytes(values.data(), values.size() * sizeof(T));
+  }
+
+ private:
+  std::vector<uint8_t>& message_;
+
+  void WriteBytes(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    message_.insert(message_.end(), bytes, bytes + size);
+  }
+};
+
+/**
+ * Reads back the values of a MessageWriter, in the same order
+ */
+class MessageReader {
+ public:
+  explicit MessageReader(const std::vector<uint8_t>& message)
+      : message_(message) {
+  }
+
+  /** @throws std::runtime_error if the message is too short **/
+  template <typename T>
+  T Read() {
+    T value;
+    ReadBytes(&value, sizeof(T));
+    return value;
+  }
+
+  /** @throws std::runtime_error if the message is too short **/
+  template <typename T>
+  void ReadArray(std::vector<T>& values) {
+    uint64_t count = Read<uint64_t>();
+    if (count > (message_.size() - offset_) / sizeof(T)) {
+      throw std::runtime_error("Message is truncated");
+    }
+    values.resize(count);
+    ReadBytes(values.data(), count * sizeof(T));
+  }
+
+  bool IsAtEnd() const {
+    return offset_ == message_.size();
+  }
+
+ private:
+  const std::vector<uint8_t>& message_;
+  size_t offset_ = 0;
+
+  void ReadBytes(void* data, size_t size) {
+    if (size > message_.size() - offset_) {
+      throw std::runtime_error("Message is truncated");
+    }
+    if (size > 0) {
+      std::memcpy(data, message_.data() + offset_, size);
+    }
+    offset_ += size;
+  }
+};
+
+}  // namespace idealgas
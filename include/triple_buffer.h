@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace idealgas {
+
+/**
+ * Hands values from one writer thread to one reader thread without locks.
+ * There are three slots: the writer fills the back slot, the reader reads
+ * the front slot, and the middle slot holds the latest published value.
+ * Publishing and acquiring swap a slot with the middle one atomically, so
+ * neither side ever waits for the other and the reader always gets the
+ * newest value. Values the reader never acquired are overwritten.
+ *
+ * Slots are reused, so T should keep its allocations when assigned to
+ * (e.g. vectors) to avoid allocating on every publish.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  /**
+   * Slot the writer fills before calling Publish. Only the writer may use
+   * it.
+   */
+  T& GetBack() {
+    return slots_[back_];
+  }
+
+  /**
+   * Makes the back slot the latest value, and gives the writer the previous
+   * middle slot to fill next. The new back slot holds an older value.
+   */
+  void Publish() {
+    uint8_t published = static_cast<uint8_t>(back_ | kIsFreshBit);
+    back_ = middle_.exchange(published, std::memory_order_acq_rel) &
+            kIndexMask;
+  }
+
+  /**
+   * Moves the latest published value to the front slot if there is one the
+   * reader hasn't acquired yet. Only the reader may call it.
+   *
+   * @return    whether the front slot changed
+   */
+  bool Acquire() {
+    if ((middle_.load(std::memory_order_relaxed) & kIsFreshBit) == 0) {
+      return false;
+    }
+    front_ =
+        middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  /**
+   * Value of the last Acquire, or a default constructed T before the first
+   * one. Only the reader may use it.
+   */
+  const T& GetFront() const {
+    return slots_[front_];
+  }
+
+ private:
+  static const uint8_t kIndexMask = 3;
+
+  /** Set in middle_ when it holds a value the reader hasn't acquired **/
+  static const uint8_t kIsFreshBit = 4;
+
+  T slots_[3] = {};
+  uint8_t back_ = 0;
+  std::atomic<uint8_t> middle_{1};
+  uint8_t front_ = 2;
+};
+
+template <typename T>
+const uint8_t TripleBuffer<T>::kIndexMask;
+
+template <typename T>
+const uint8_t TripleBuffer<T>::kIsFreshBit;
+
+}  // namespace idealgas
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Fixed set of worker threads for independent tasks of uneven length. Each
+ * thread has its own queue of tasks; a thread that runs out takes tasks
+ * from the back of another thread's queue, so a few long tasks don't leave
+ * the other threads idle. Unlike ThreadPool, which task runs on which
+ * thread depends on timing.
+ */
+class WorkStealingPool {
+ public:
+  /** Body of a task: runs task number task on thread number thread **/
+  typedef std::function<void(size_t task, size_t thread)> TaskFunction;
+
+  /**
+   * Starts the worker threads. The calling thread also runs tasks, so
+   * thread_count - 1 threads are started.
+   *
+   * @param thread_count    number of threads to run tasks on, at least 1
+   */
+  explicit WorkStealingPool(size_t thread_count);
+
+  /**
+   * Stops and joins the worker threads
+   */
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /**
+   * Runs body for every task in [0, task_count) and returns once all are
+   * done. Tasks are dealt out to the threads in turn, and each thread runs
+   * its own tasks in increasing order, so the first tasks start first: put
+   * the longest ones first. body must not throw.
+   *
+   * @param task_count  number of tasks
+   * @param body        function called once per task
+   */
+  void Run(size_t task_count, const TaskFunction& body);
+
+  size_t GetThreadCount() const;
+
+  /** Number of tasks the last Run took from another thread's queue **/
+  size_t GetStealCount() const;
+
+ private:
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+  };
+
+  std::vector<std::thread> workers_;
+
+  /** Queue of each thread, the calling thread of Run being thread 0 **/
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+
+  /** Body of the current Run, only valid while busy_workers_ > 0 **/
+  const TaskFunction* body_ = nullptr;
+  size_t busy_workers_ = 0;
+
+  /** Incremented for every Run so workers can tell a new one started **/
+  size_t generation_ = 0;
+  bool is_stopping_ = false;
+
+  std::atomic<size_t> steal_count_;
+
+  void WorkerLoop(size_t thread);
+
+  /** Runs tasks of the current Run until every queue is empty **/
+  void RunTasks(size_t thread, const TaskFunction& body);
+
+  /**
+   * Takes the next task of thread's own queue, or else the last task of
+   * another queue
+   *
+   * @return    whether a task was found
+   */
+  bool TakeTask(size_t thread, size_t& task);
+};
+
+}  // namespace idealgas
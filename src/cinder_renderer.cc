@@ -0,0 +1,111 @@
+#include "cinder_renderer.h"
+
+#include <algorithm>
+
+namespace idealgas {
+
+using glm::vec2;
+
+namespace {
+
+const float kHistogramXLabelMargin = 10;
+const float kHistogramYLabelMargin = 85;
+const float kHistogramFontSize = 20;
+
+void DrawHistogramAxis(const Histogram& histogram) {
+  const vec2& position = histogram.GetPosition();
+  vec2 dimension = histogram.GetDimensions();
+
+  ci::gl::color(ToCinderColor(histogram.GetAxisLabelColor()));
+  // draw y axis
+  ci::gl::drawLine(vec2(position[0], position[1]),
+                   vec2(position[0], position[1] + dimension[1]));
+
+  // draw x axis
+  float bottom_y = position[1] + dimension[1];
+  ci::gl::drawLine(vec2(position[0], bottom_y),
+                   vec2(position[0] + dimension[0], bottom_y));
+}
+
+void DrawHistogramLabels(const Histogram& histogram) {
+  const vec2& position = histogram.GetPosition();
+  vec2 dimension = histogram.GetDimensions();
+  ci::Color label_color = ToCinderColor(histogram.GetAxisLabelColor());
+
+  ci::gl::color(label_color);
+  vec2 x_label_position =
+      vec2(position[0] + (dimension[0] / 2),
+           position[1] + dimension[1] + kHistogramXLabelMargin);
+  ci::gl::drawStringCentered(histogram.GetXLabel(), x_label_position,
+                             label_color,
+                             ci::Font("Arial", kHistogramFontSize));
+
+  vec2 y_label_position = vec2(position[0] - kHistogramYLabelMargin,
+                               position[1] + (dimension[1] / 2));
+  ci::gl::drawString(histogram.GetYLabel(), y_label_position, label_color,
+                     ci::Font("Arial", kHistogramFontSize));
+}
+
+void DrawHistogramBars(const Histogram& histogram) {
+  const std::vector<float>& bins = histogram.GetBins();
+  if (bins.empty()) {
+    return;
+  }
+
+  // find max frequency to find how much each y axis data point should go up by
+  float max_freq = 0;
+  for (const auto& frequency : bins) {
+    max_freq = std::max(frequency, max_freq);
+  }
+  if (max_freq == 0) {
+    return;
+  }
+
+  const vec2& position = histogram.GetPosition();
+  float height = histogram.GetDimensions()[1];
+  float bar_width = histogram.GetBarWidth();
+
+  float y_step = height / max_freq;  // number of pixels per one frequency value
+  float bottom_y = position[1] + height;  // bottom y coord of the bar
+  float left_x = position[0];  // increments by bar width for each iteration
+
+  ci::gl::color(ToCinderColor(histogram.GetBarColor()));
+  for (const auto& value : bins) {
+    float top_y = bottom_y - (y_step * value);
+    ci::gl::drawSolidRect(
+        ci::Rectf(vec2(left_x, top_y), vec2(left_x + bar_width, bottom_y)));
+    left_x += bar_width;
+  }
+}
+
+}  // namespace
+
+ci::Color ToCinderColor(const Color& color) {
+  return ci::Color(color.r, color.g, color.b);
+}
+
+void DrawGasContainer(const GasContainer& container) {
+  DrawParticles(container.GetParticleStore(), container.GetSpecies(),
+                container.GetTopLeftPosition(),
+                container.GetBottomRightPosition());
+}
+
+void DrawParticles(const ParticleStore& particles,
+                   const SpeciesRegistry& species, const vec2& top_left,
+                   const vec2& bottom_right) {
+  ci::gl::color(ci::Color("white"));
+  ci::gl::drawStrokedRect(ci::Rectf(top_left, bottom_right));
+
+  for (size_t i = 0; i < particles.Size(); i++) {
+    ci::gl::color(ToCinderColor(species.Get(particles.GetSpeciesId(i)).color));
+    ci::gl::drawSolidCircle(particles.GetPosition(i), particles.GetRadius(i));
+  }
+}
+
+void DrawHistogram(const Histogram& histogram) {
+  DrawHistogramBars(histogram);
+  DrawHistogramAxis(histogram);
+  DrawHistogramLabels(histogram);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,54 @@
+#include "color.h"
+
+#include <stdexcept>
+
+namespace idealgas {
+
+using std::string;
+
+namespace {
+
+struct NamedColor {
+  const char* name;
+  unsigned int rgb;  // 0xRRGGBB
+};
+
+// values from the SVG 1.1 color keywords, same as ci::Color(const char*)
+const NamedColor kNamedColors[] = {
+    {"black", 0x000000},  {"white", 0xffffff},   {"red", 0xff0000},
+    {"green", 0x008000},  {"blue", 0x0000ff},    {"yellow", 0xffff00},
+    {"cyan", 0x00ffff},   {"magenta", 0xff00ff}, {"orange", 0xffa500},
+    {"purple", 0x800080}, {"gray", 0x808080}};
+
+}  // namespace
+
+Color::Color() : r(0), g(0), b(0) {
+}
+
+Color::Color(float red, float green, float blue) : r(red), g(green), b(blue) {
+}
+
+Color::Color(const char* name) : Color(string(name)) {
+}
+
+Color::Color(const string& name) {
+  for (const auto& named_color : kNamedColors) {
+    if (name == named_color.name) {
+      r = static_cast<float>((named_color.rgb >> 16) & 0xff) / 255;
+      g = static_cast<float>((named_color.rgb >> 8) & 0xff) / 255;
+      b = static_cast<float>(named_color.rgb & 0xff) / 255;
+      return;
+    }
+  }
+  throw std::invalid_argument("Unknown color name " + name);
+}
+
+bool Color::operator==(const Color& other) const {
+  return r == other.r && g == other.g && b == other.b;
+}
+
+bool Color::operator!=(const Color& other) const {
+  return !(*this == other);
+}
+
+}  // namespace idealgas
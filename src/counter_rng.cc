@@ -0,0 +1,49 @@
+#include "counter_rng.h"
+
+namespace idealgas {
+
+namespace {
+
+const uint32_t kMultiplierZero = 0xD2511F53;
+const uint32_t kMultiplierOne = 0xCD9E8D57;
+
+/** Added to the key halves after every round **/
+const uint32_t kWeylZero = 0x9E3779B9;
+const uint32_t kWeylOne = 0xBB67AE85;
+
+const int kRoundCount = 10;
+
+}  // namespace
+
+CounterRng::CounterRng(uint64_t seed) : seed_(seed) {
+}
+
+CounterRng::Block CounterRng::Generate(uint32_t stream, uint64_t index,
+                                       uint32_t counter) const {
+  Block block = {{counter, stream, static_cast<uint32_t>(index),
+                  static_cast<uint32_t>(index >> 32)}};
+  uint32_t key_zero = static_cast<uint32_t>(seed_);
+  uint32_t key_one = static_cast<uint32_t>(seed_ >> 32);
+
+  for (int round = 0; round < kRoundCount; round++) {
+    uint64_t product_zero = static_cast<uint64_t>(kMultiplierZero) * block[0];
+    uint64_t product_one = static_cast<uint64_t>(kMultiplierOne) * block[2];
+    block = {{static_cast<uint32_t>(product_one >> 32) ^ block[1] ^ key_zero,
+              static_cast<uint32_t>(product_one),
+              static_cast<uint32_t>(product_zero >> 32) ^ block[3] ^ key_one,
+              static_cast<uint32_t>(product_zero)}};
+    key_zero += kWeylZero;
+    key_one += kWeylOne;
+  }
+  return block;
+}
+
+uint64_t CounterRng::GetSeed() const {
+  return seed_;
+}
+
+float CounterRng::ToUnitFloat(uint32_t bits) {
+  return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+}  // namespace idealgas
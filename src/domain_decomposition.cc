@@ -0,0 +1,833 @@
+#include "domain_decomposition.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "profiler.h"
+#include "spatial_grid.h"
+
+namespace idealgas {
+
+namespace {
+
+/**
+ * Factor the halo is widened by past two radii, so rounding in the distance
+ * tests can't leave out a particle that touches the slab
+ */
+const float kHaloSlack = 1.01f;
+
+enum class Command : uint8_t { kAdvance, kGather, kStop };
+
+/**
+ * Particles sent between ranks, as parallel arrays with the index each
+ * particle has in the container the run started from
+ */
+struct ParticleRecords {
+  std::vector<uint64_t> ids;
+  std::vector<float> positions_x;
+  std::vector<float> positions_y;
+  std::vector<float> velocities_x;
+  std::vector<float> velocities_y;
+  std::vector<float> radii;
+  std::vector<float> inverse_masses;
+  std::vector<uint8_t> species_ids;
+
+  size_t Size() const {
+    return ids.size();
+  }
+
+  void Clear() {
+    ids.clear();
+    positions_x.clear();
+    positions_y.clear();
+    velocities_x.clear();
+    velocities_y.clear();
+    radii.clear();
+    inverse_masses.clear();
+    species_ids.clear();
+  }
+
+  void Append(const ParticleStore& particles, size_t index, uint64_t id) {
+    ids.push_back(id);
+    positions_x.push_back(particles.GetPositionsX()[index]);
+    positions_y.push_back(particles.GetPositionsY()[index]);
+    velocities_x.push_back(particles.GetVelocitiesX()[index]);
+    velocities_y.push_back(particles.GetVelocitiesY()[index]);
+    radii.push_back(particles.GetRadii()[index]);
+    inverse_masses.push_back(particles.GetInverseMasses()[index]);
+    species_ids.push_back(particles.GetSpeciesIds()[index]);
+  }
+
+  void Append(const ParticleRecords& other, size_t index) {
+    ids.push_back(other.ids[index]);
+    positions_x.push_back(other.positions_x[index]);
+    positions_y.push_back(other.positions_y[index]);
+    velocities_x.push_back(other.velocities_x[index]);
+    velocities_y.push_back(other.velocities_y[index]);
+    radii.push_back(other.radii[index]);
+    inverse_masses.push_back(other.inverse_masses[index]);
+    species_ids.push_back(other.species_ids[index]);
+  }
+
+  void AppendAll(const ParticleRecords& other) {
+    for (size_t i = 0; i < other.Size(); i++) {
+      Append(other, i);
+    }
+  }
+
+  void Write(MessageWriter& writer) const {
+    writer.WriteArray(ids);
+    writer.WriteArray(positions_x);
+    writer.WriteArray(positions_y);
+    writer.WriteArray(velocities_x);
+    writer.WriteArray(velocities_y);
+    writer.WriteArray(radii);
+    writer.WriteArray(inverse_masses);
+    writer.WriteArray(species_ids);
+  }
+
+  /** @throws std::runtime_error if the arrays differ in length **/
+  void Read(MessageReader& reader) {
+    reader.ReadArray(ids);
+    reader.ReadArray(positions_x);
+    reader.ReadArray(positions_y);
+    reader.ReadArray(velocities_x);
+    reader.ReadArray(velocities_y);
+    reader.ReadArray(radii);
+    reader.ReadArray(inverse_masses);
+    reader.ReadArray(species_ids);
+    size_t size = ids.size();
+    if (positions_x.size() != size || positions_y.size() != size ||
+        velocities_x.size() != size || velocities_y.size() != size ||
+        radii.size() != size || inverse_masses.size() != size ||
+        species_ids.size() != size) {
+      throw std::runtime_error("Particle arrays differ in length");
+    }
+  }
+
+  /** Replaces the particles of store with these, bit for bit **/
+  void AssignTo(ParticleStore& store) const {
+    const float* positions[] = {positions_x.data(), positions_y.data()};
+    const float* velocities[] = {velocities_x.data(), velocities_y.data()};
+    store.Assign(Size(), positions, velocities, radii.data(),
+                 inverse_masses.data(), species_ids.data());
+  }
+};
+
+/**
+ * Finds the slab a particle at x belongs to
+ *
+ * @param boundaries  x of the boundary between each pair of adjacent slabs,
+ *                    increasing
+ * @return            index of the slab
+ */
+size_t FindSlab(const std::vector<float>& boundaries, float x) {
+  return static_cast<size_t>(
+      std::upper_bound(boundaries.begin(), boundaries.end(), x) -
+      boundaries.begin());
+}
+
+/** Where a worker gets the particles of its slab **/
+enum class SlabSource : uint8_t { kRecords, kGenerate };
+
+/** Particles a worker generates at a time when it builds its slab **/
+const size_t kGenerationBatchSize = 4096;
+
+enum class PairState : uint8_t { kUndecided, kSelected, kRejected };
+
+/**
+ * What a worker knows of a particle before one of its pairs: whether an
+ * earlier pair of the particle was resolved (taken), none will be (free),
+ * or that isn't decided yet
+ */
+enum class Side : uint8_t { kUnknown, kFree, kTaken };
+
+/**
+ * Writes the part of the setup message every worker gets: the container,
+ * the slabs and the species
+ */
+void WriteSetup(MessageWriter& writer, const glm::vec2& top_left,
+                const glm::vec2& bottom_right, float halo_width,
+                const std::vector<float>& boundaries,
+                const SpeciesRegistry& species) {
+  writer.Write(top_left.x);
+  writer.Write(top_left.y);
+  writer.Write(bottom_right.x);
+  writer.Write(bottom_right.y);
+  writer.Write(halo_width);
+  writer.WriteArray(boundaries);
+  writer.Write<uint64_t>(species.Size());
+  for (size_t id = 0; id < species.Size(); id++) {
+    const Species& one = species.Get(static_cast<uint8_t>(id));
+    writer.WriteArray(std::vector<char>(one.name.begin(), one.name.end()));
+    writer.Write(one.color);
+    writer.Write(one.mass);
+    writer.Write(one.radius);
+  }
+}
+
+/**
+ * State of one worker rank: the particles of its slab, and, during a frame,
+ * the ghosts of its neighbors
+ */
+class DomainWorker {
+ public:
+  /**
+   * Receives the slab from the coordinator, and either its particles or
+   * what to generate them from
+   */
+  explicit DomainWorker(Transport& transport);
+
+  /** Handles commands until the coordinator stops the run **/
+  void Run();
+
+ private:
+  Transport& transport_;
+  size_t slab_;
+  glm::vec2 top_left_;
+  glm::vec2 bottom_right_;
+  float halo_width_;
+  std::vector<float> boundaries_;
+  SpeciesRegistry species_;
+
+  /** Particles whose x is in the slab **/
+  ParticleRecords owned_;
+
+  /** Owned particles followed by the ghosts, as a ParticleStore **/
+  ParticleRecords local_;
+  ParticleStore particles_;
+  SpatialGrid spatial_grid_;
+
+  /** End of the ghosts of each neighbor in local_ **/
+  std::vector<size_t> ghost_ends_;
+
+  /**
+   * Colliding pairs with an owned particle, as indices into particles_
+   * ordered by the ids of the particles, and what is known of each
+   */
+  std::vector<SpatialGrid::IndexPair> pairs_;
+  std::vector<PairState> pair_states_;
+  std::vector<Side> owned_sides_;
+  std::vector<Side> ghost_sides_;
+
+  /** Pairs with a ghost of each neighbor, in order **/
+  std::vector<std::vector<size_t>> boundary_pairs_;
+
+  /** Side of each owned particle before the pair a pass is at **/
+  std::vector<Side> particle_sides_;
+  std::vector<uint8_t> has_collided_;
+
+  /** Ranks exchanged with, each in increasing order **/
+  std::vector<size_t> neighbors_;
+  std::vector<size_t> other_workers_;
+
+  /** Kept to avoid reallocating every frame **/
+  std::vector<SpatialGrid::IndexPair> grid_pairs_;
+  std::vector<size_t> active_neighbors_;
+  std::vector<size_t> active_ranks_;
+  std::vector<Side> sides_;
+  std::vector<uint8_t> message_;
+  std::vector<ParticleRecords> outgoing_records_;
+  std::vector<std::vector<uint8_t>> outgoing_;
+  std::vector<std::vector<uint8_t>> incoming_;
+  ParticleRecords incoming_records_;
+  ParticleRecords kept_;
+
+  /**
+   * Generates the particles of the container in batches and keeps the ones
+   * in the slab, so the whole container is never held at once
+   */
+  void GenerateSlab(size_t particle_count, const glm::vec2& dimension,
+                    int seed);
+
+  void Advance(float dt);
+
+  /** Fills local_ and particles_ with the owned particles and the ghosts **/
+  void ExchangeHalos();
+
+  /** Finds the colliding pairs with an owned particle **/
+  void FindCollidingPairs();
+
+  /**
+   * Chooses the pairs to resolve like GasContainer: in order, skipping the
+   * pairs of particles that collided already. The owner of a ghost knows
+   * its earlier pairs, so the pairs across a boundary are settled with the
+   * neighbor, round by round.
+   *
+   * @throws std::runtime_error if a neighbor found other pairs across the
+   *         boundary
+   */
+  void SelectCollidingPairs();
+
+  /**
+   * Makes one pass over the pairs in order, deciding the ones whose sides
+   * are known
+   *
+   * @return    true if every pair is decided
+   */
+  bool DecidePairs();
+
+  /** Resolves the pairs SelectCollidingPairs chose **/
+  void ResolveParticleCollisions();
+
+  /** Bounces the owned particles off the walls and moves them **/
+  void HandleWallsAndMove(float dt);
+
+  /** Hands the particles that left the slab to their new owners **/
+  void Migrate();
+
+  void SendParticles();
+};
+
+DomainWorker::DomainWorker(Transport& transport)
+    : transport_(transport), slab_(transport.GetRank() - 1) {
+  transport_.Receive(0, message_);
+  MessageReader reader(message_);
+  top_left_.x = reader.Read<float>();
+  top_left_.y = reader.Read<float>();
+  bottom_right_.x = reader.Read<float>();
+  bottom_right_.y = reader.Read<float>();
+  halo_width_ = reader.Read<float>();
+  reader.ReadArray(boundaries_);
+  if (boundaries_.size() + 2 != transport_.GetRankCount()) {
+    throw std::runtime_error("Invalid domain setup message");
+  }
+  uint64_t species_count = reader.Read<uint64_t>();
+  std::vector<char> name;
+  for (uint64_t id = 0; id < species_count; id++) {
+    reader.ReadArray(name);
+    Color color = reader.Read<Color>();
+    float mass = reader.Read<float>();
+    float radius = reader.Read<float>();
+    species_.Register(std::string(name.begin(), name.end()), color, mass,
+                      radius);
+  }
+
+  SlabSource source = reader.Read<SlabSource>();
+  if (source == SlabSource::kRecords) {
+    owned_.Read(reader);
+  } else if (source == SlabSource::kGenerate) {
+    uint64_t particle_count = reader.Read<uint64_t>();
+    glm::vec2 dimension;
+    dimension.x = reader.Read<float>();
+    dimension.y = reader.Read<float>();
+    int32_t seed = reader.Read<int32_t>();
+    GenerateSlab(particle_count, dimension, seed);
+  } else {
+    throw std::runtime_error("Invalid domain setup message");
+  }
+
+  size_t rank = transport_.GetRank();
+  if (rank > 1) {
+    neighbors_.push_back(rank - 1);
+  }
+  if (rank + 1 < transport_.GetRankCount()) {
+    neighbors_.push_back(rank + 1);
+  }
+  for (size_t other = 1; other < transport_.GetRankCount(); other++) {
+    if (other != rank) {
+      other_workers_.push_back(other);
+    }
+  }
+}
+
+void DomainWorker::GenerateSlab(size_t particle_count,
+                                const glm::vec2& dimension, int seed) {
+  IDEALGAS_PROFILE_SCOPE("slab generation");
+  GasContainer generator(0, top_left_, dimension, seed, species_);
+  ParticleStore batch;
+  for (size_t begin = 0; begin < particle_count;
+       begin += kGenerationBatchSize) {
+    size_t end = std::min(particle_count, begin + kGenerationBatchSize);
+    generator.GenerateParticles(begin, end, batch);
+    for (size_t i = 0; i < batch.Size(); i++) {
+      if (FindSlab(boundaries_, batch.GetPositionsX()[i]) == slab_) {
+        owned_.Append(batch, i, begin + i);
+      }
+    }
+  }
+}
+
+void DomainWorker::Run() {
+  while (true) {
+    transport_.Receive(0, message_);
+    MessageReader reader(message_);
+    Command command = reader.Read<Command>();
+    if (command == Command::kAdvance) {
+      Advance(reader.Read<float>());
+    } else if (command == Command::kGather) {
+      SendParticles();
+    } else if (command == Command::kStop) {
+      return;
+    } else {
+      throw std::runtime_error("Unknown domain command");
+    }
+  }
+}
+
+void DomainWorker::Advance(float dt) {
+  ExchangeHalos();
+  FindCollidingPairs();
+  SelectCollidingPairs();
+  ResolveParticleCollisions();
+  HandleWallsAndMove(dt);
+  Migrate();
+}
+
+void DomainWorker::ExchangeHalos() {
+  IDEALGAS_PROFILE_SCOPE("halo exchange");
+  outgoing_records_.resize(neighbors_.size());
+  outgoing_.resize(neighbors_.size());
+  for (size_t n = 0; n < neighbors_.size(); n++) {
+    ParticleRecords& records = outgoing_records_[n];
+    records.Clear();
+    bool is_left = neighbors_[n] < transport_.GetRank();
+    for (size_t i = 0; i < owned_.Size(); i++) {
+      float x = owned_.positions_x[i];
+      if (is_left ? x < boundaries_[slab_ - 1] + halo_width_
+                  : x >= boundaries_[slab_] - halo_width_) {
+        records.Append(owned_, i);
+      }
+    }
+    MessageWriter writer(outgoing_[n]);
+    records.Write(writer);
+  }
+  transport_.Exchange(neighbors_, outgoing_, incoming_);
+
+  local_ = owned_;
+  ghost_ends_.clear();
+  for (const std::vector<uint8_t>& message : incoming_) {
+    MessageReader reader(message);
+    incoming_records_.Read(reader);
+    local_.AppendAll(incoming_records_);
+    ghost_ends_.push_back(local_.Size());
+  }
+  local_.AssignTo(particles_);
+}
+
+void DomainWorker::FindCollidingPairs() {
+  IDEALGAS_PROFILE_SCOPE("domain collision search");
+  // the grid only needs to cover the slab and its halos
+  glm::vec2 low = top_left_;
+  glm::vec2 high = bottom_right_;
+  if (slab_ > 0) {
+    low.x = std::max(low.x, boundaries_[slab_ - 1] - halo_width_);
+  }
+  if (slab_ < boundaries_.size()) {
+    high.x = std::min(high.x, boundaries_[slab_] + halo_width_);
+  }
+  spatial_grid_.Rebuild(particles_, low, high);
+  spatial_grid_.FindCollidingPairs(particles_, grid_pairs_);
+
+  // pairs of two ghosts belong to their owners
+  size_t owned_count = owned_.Size();
+  pairs_.clear();
+  for (SpatialGrid::IndexPair pair : grid_pairs_) {
+    if (pair.first >= owned_count) {
+      continue;
+    }
+    if (local_.ids[pair.first] > local_.ids[pair.second]) {
+      std::swap(pair.first, pair.second);
+    }
+    pairs_.push_back(pair);
+  }
+  const std::vector<uint64_t>& ids = local_.ids;
+  std::sort(pairs_.begin(), pairs_.end(),
+            [&ids](const SpatialGrid::IndexPair& one,
+                   const SpatialGrid::IndexPair& two) {
+              if (ids[one.first] != ids[two.first]) {
+                return ids[one.first] < ids[two.first];
+              }
+              return ids[one.second] < ids[two.second];
+            });
+
+  boundary_pairs_.resize(neighbors_.size());
+  for (std::vector<size_t>& pair_indices : boundary_pairs_) {
+    pair_indices.clear();
+  }
+  for (size_t p = 0; p < pairs_.size(); p++) {
+    size_t ghost = std::max(pairs_[p].first, pairs_[p].second);
+    if (ghost < owned_count) {
+      continue;
+    }
+    size_t n = 0;
+    while (ghost >= ghost_ends_[n]) {
+      n++;
+    }
+    boundary_pairs_[n].push_back(p);
+  }
+}
+
+void DomainWorker::SelectCollidingPairs() {
+  IDEALGAS_PROFILE_SCOPE("domain pair selection");
+  pair_states_.assign(pairs_.size(), PairState::kUndecided);
+  owned_sides_.assign(pairs_.size(), Side::kUnknown);
+  ghost_sides_.assign(pairs_.size(), Side::kUnknown);
+  bool is_done = DecidePairs();
+
+  // once either side of a boundary has decided every pair, the sides it
+  // sent are final and the other side can decide the rest alone, so both
+  // stop exchanging after that round
+  active_neighbors_.clear();
+  for (size_t n = 0; n < neighbors_.size(); n++) {
+    active_neighbors_.push_back(n);
+  }
+  while (!active_neighbors_.empty()) {
+    active_ranks_.clear();
+    outgoing_.resize(active_neighbors_.size());
+    for (size_t a = 0; a < active_neighbors_.size(); a++) {
+      size_t n = active_neighbors_[a];
+      active_ranks_.push_back(neighbors_[n]);
+      sides_.clear();
+      for (size_t p : boundary_pairs_[n]) {
+        sides_.push_back(owned_sides_[p]);
+      }
+      MessageWriter writer(outgoing_[a]);
+      writer.Write<uint8_t>(is_done);
+      writer.WriteArray(sides_);
+    }
+    transport_.Exchange(active_ranks_, outgoing_, incoming_);
+
+    size_t kept_count = 0;
+    for (size_t a = 0; a < active_neighbors_.size(); a++) {
+      size_t n = active_neighbors_[a];
+      MessageReader reader(incoming_[a]);
+      bool is_neighbor_done = reader.Read<uint8_t>() != 0;
+      reader.ReadArray(sides_);
+      if (sides_.size() != boundary_pairs_[n].size()) {
+        throw std::runtime_error(
+            "Neighbors found different pairs across their boundary");
+      }
+      for (size_t i = 0; i < sides_.size(); i++) {
+        ghost_sides_[boundary_pairs_[n][i]] = sides_[i];
+      }
+      if (!is_done && !is_neighbor_done) {
+        active_neighbors_[kept_count++] = n;
+      }
+    }
+    active_neighbors_.resize(kept_count);
+    is_done = DecidePairs();
+  }
+  if (!is_done) {
+    throw std::runtime_error("Colliding pairs were left undecided");
+  }
+}
+
+bool DomainWorker::DecidePairs() {
+  size_t owned_count = owned_.Size();
+  particle_sides_.assign(owned_count, Side::kFree);
+  bool is_done = true;
+  for (size_t p = 0; p < pairs_.size(); p++) {
+    size_t first = pairs_[p].first;
+    size_t second = pairs_[p].second;
+    Side first_side =
+        first < owned_count ? particle_sides_[first] : ghost_sides_[p];
+    Side second_side =
+        second < owned_count ? particle_sides_[second] : ghost_sides_[p];
+    owned_sides_[p] = first < owned_count ? first_side : second_side;
+
+    PairState& state = pair_states_[p];
+    if (state == PairState::kUndecided) {
+      if (first_side == Side::kTaken || second_side == Side::kTaken) {
+        state = PairState::kRejected;
+      } else if (first_side == Side::kFree && second_side == Side::kFree) {
+        state = PairState::kSelected;
+      } else {
+        is_done = false;
+      }
+    }
+
+    for (size_t index : {first, second}) {
+      if (index >= owned_count) {
+        continue;
+      }
+      Side& side = particle_sides_[index];
+      if (state == PairState::kSelected) {
+        side = Side::kTaken;
+      } else if (state == PairState::kUndecided && side == Side::kFree) {
+        side = Side::kUnknown;
+      }
+    }
+  }
+  return is_done;
+}
+
+void DomainWorker::ResolveParticleCollisions() {
+  // a pair across a boundary is resolved by the owners of both particles
+  has_collided_.assign(particles_.Size(), 0);
+  for (size_t p = 0; p < pairs_.size(); p++) {
+    if (pair_states_[p] != PairState::kSelected) {
+      continue;
+    }
+    size_t first = pairs_[p].first;
+    size_t second = pairs_[p].second;
+    uint8_t species_one = particles_.GetSpeciesId(first);
+    uint8_t species_two = particles_.GetSpeciesId(second);
+    particles_.UpdateVelocitiesForParticleCollision(
+        first, second, species_.GetMassFraction(species_one, species_two),
+        species_.GetMassFraction(species_two, species_one));
+    has_collided_[first] = 1;
+    has_collided_[second] = 1;
+  }
+}
+
+void DomainWorker::HandleWallsAndMove(float dt) {
+  size_t owned_count = owned_.Size();
+  for (size_t i = 0; i < owned_count; i++) {
+    if (!has_collided_[i]) {
+      particles_.HandleIfWallCollision(i, top_left_, bottom_right_);
+    }
+  }
+  particles_.Integrate(0, owned_count, dt);
+
+  // the owned particles come first in particles_
+  std::copy(particles_.GetPositionsX(),
+            particles_.GetPositionsX() + owned_count,
+            owned_.positions_x.begin());
+  std::copy(particles_.GetPositionsY(),
+            particles_.GetPositionsY() + owned_count,
+            owned_.positions_y.begin());
+  std::copy(particles_.GetVelocitiesX(),
+            particles_.GetVelocitiesX() + owned_count,
+            owned_.velocities_x.begin());
+  std::copy(particles_.GetVelocitiesY(),
+            particles_.GetVelocitiesY() + owned_count,
+            owned_.velocities_y.begin());
+}
+
+void DomainWorker::Migrate() {
+  IDEALGAS_PROFILE_SCOPE("migration");
+  // a particle can cross more than one slab in a long frame, so every
+  // worker is a partner
+  outgoing_records_.resize(other_workers_.size());
+  for (ParticleRecords& records : outgoing_records_) {
+    records.Clear();
+  }
+  kept_.Clear();
+  for (size_t i = 0; i < owned_.Size(); i++) {
+    size_t slab = FindSlab(boundaries_, owned_.positions_x[i]);
+    if (slab == slab_) {
+      kept_.Append(owned_, i);
+    } else {
+      // other_workers_ skips this worker's rank, slab_ + 1
+      size_t partner = slab < slab_ ? slab : slab - 1;
+      outgoing_records_[partner].Append(owned_, i);
+    }
+  }
+
+  outgoing_.resize(other_workers_.size());
+  for (size_t n = 0; n < other_workers_.size(); n++) {
+    MessageWriter writer(outgoing_[n]);
+    outgoing_records_[n].Write(writer);
+  }
+  transport_.Exchange(other_workers_, outgoing_, incoming_);
+
+  for (const std::vector<uint8_t>& message : incoming_) {
+    MessageReader reader(message);
+    incoming_records_.Read(reader);
+    kept_.AppendAll(incoming_records_);
+  }
+  std::swap(owned_, kept_);
+}
+
+void DomainWorker::SendParticles() {
+  MessageWriter writer(message_);
+  owned_.Write(writer);
+  transport_.Send(0, message_);
+}
+
+}  // namespace
+
+DomainCoordinator::DomainCoordinator(const DomainSetup& setup,
+                                     Transport& transport)
+    : transport_(transport), particle_count_(setup.particle_count) {
+  SpeciesRegistry species = setup.species;
+  if (species.IsEmpty()) {
+    species = GasContainer(0, setup.top_left_position,
+                           setup.container_dimension, setup.seed)
+                  .GetSpecies();
+  }
+  float max_radius = 0;
+  for (size_t id = 0; id < species.Size(); id++) {
+    max_radius =
+        std::max(max_radius, species.Get(static_cast<uint8_t>(id)).radius);
+  }
+  float halo_width = 2 * max_radius * kHaloSlack;
+  std::vector<float> boundaries = FindSlabBoundaries(
+      setup.top_left_position, setup.container_dimension.x, halo_width);
+
+  // same corner as GasContainer computes
+  const glm::vec2& top_left = setup.top_left_position;
+  glm::vec2 bottom_right(top_left.x + setup.container_dimension.x,
+                         top_left.y + setup.container_dimension.y);
+  MessageWriter writer(message_);
+  WriteSetup(writer, top_left, bottom_right, halo_width, boundaries,
+             species);
+  writer.Write(SlabSource::kGenerate);
+  writer.Write<uint64_t>(setup.particle_count);
+  writer.Write(setup.container_dimension.x);
+  writer.Write(setup.container_dimension.y);
+  writer.Write<int32_t>(setup.seed);
+  for (size_t worker = 0; worker < GetWorkerCount(); worker++) {
+    transport_.Send(worker + 1, message_);
+  }
+}
+
+DomainCoordinator::DomainCoordinator(const GasContainer& container,
+                                     Transport& transport)
+    : transport_(transport),
+      particle_count_(container.GetParticleStore().Size()) {
+  const ParticleStore& particles = container.GetParticleStore();
+  float halo_width = 2 * particles.GetMaxRadius() * kHaloSlack;
+  std::vector<float> boundaries = FindSlabBoundaries(
+      container.GetTopLeftPosition(), container.GetWidth(), halo_width);
+  if (container.GetBoundary(0) != Boundary::kWall ||
+      container.GetBoundary(1) != Boundary::kWall) {
+    throw std::invalid_argument("Domains only support containers with walls");
+  }
+
+  std::vector<ParticleRecords> records(GetWorkerCount());
+  for (size_t i = 0; i < particles.Size(); i++) {
+    records[FindSlab(boundaries, particles.GetPositionsX()[i])].Append(
+        particles, i, i);
+  }
+
+  for (size_t worker = 0; worker < GetWorkerCount(); worker++) {
+    MessageWriter writer(message_);
+    WriteSetup(writer, container.GetTopLeftPosition(),
+               container.GetBottomRightPosition(), halo_width, boundaries,
+               container.GetSpecies());
+    writer.Write(SlabSource::kRecords);
+    records[worker].Write(writer);
+    transport_.Send(worker + 1, message_);
+  }
+}
+
+DomainCoordinator::~DomainCoordinator() {
+  if (!is_stopped_) {
+    try {
+      Stop();
+    } catch (const std::exception&) {
+      // the workers are gone already
+    }
+  }
+}
+
+void DomainCoordinator::AdvanceOneFrame(float dt) {
+  if (!(dt > 0)) {
+    throw std::invalid_argument("The time step must be positive");
+  }
+  MessageWriter writer(message_);
+  writer.Write(Command::kAdvance);
+  writer.Write(dt);
+  for (size_t worker = 0; worker < GetWorkerCount(); worker++) {
+    transport_.Send(worker + 1, message_);
+  }
+  frame_count_++;
+}
+
+void DomainCoordinator::GatherParticles(const SlabVisitor& visit) {
+  ParticleRecords records;
+  ParticleStore particles;
+  // one worker at a time, so at most one slab is in flight to rank 0
+  for (size_t worker = 0; worker < GetWorkerCount(); worker++) {
+    {
+      MessageWriter writer(message_);
+      writer.Write(Command::kGather);
+    }
+    transport_.Send(worker + 1, message_);
+    transport_.Receive(worker + 1, message_);
+    MessageReader reader(message_);
+    records.Read(reader);
+    for (uint64_t id : records.ids) {
+      if (id >= particle_count_) {
+        throw std::runtime_error("Gathered an unknown particle");
+      }
+    }
+    records.AssignTo(particles);
+    visit(records.ids, particles);
+  }
+}
+
+ParticleStore DomainCoordinator::GatherParticles() {
+  ParticleRecords gathered;
+  gathered.ids.resize(particle_count_);
+  gathered.positions_x.resize(particle_count_);
+  gathered.positions_y.resize(particle_count_);
+  gathered.velocities_x.resize(particle_count_);
+  gathered.velocities_y.resize(particle_count_);
+  gathered.radii.resize(particle_count_);
+  gathered.inverse_masses.resize(particle_count_);
+  gathered.species_ids.resize(particle_count_);
+  size_t gathered_count = 0;
+  GatherParticles([&](const std::vector<uint64_t>& ids,
+                      const ParticleStore& particles) {
+    for (size_t i = 0; i < ids.size(); i++) {
+      uint64_t id = ids[i];
+      gathered.ids[id] = id;
+      gathered.positions_x[id] = particles.GetPositionsX()[i];
+      gathered.positions_y[id] = particles.GetPositionsY()[i];
+      gathered.velocities_x[id] = particles.GetVelocitiesX()[i];
+      gathered.velocities_y[id] = particles.GetVelocitiesY()[i];
+      gathered.radii[id] = particles.GetRadii()[i];
+      gathered.inverse_masses[id] = particles.GetInverseMasses()[i];
+      gathered.species_ids[id] = particles.GetSpeciesIds()[i];
+    }
+    gathered_count += ids.size();
+  });
+  if (gathered_count != particle_count_) {
+    throw std::runtime_error("Workers hold the wrong number of particles");
+  }
+
+  ParticleStore particles;
+  gathered.AssignTo(particles);
+  return particles;
+}
+
+void DomainCoordinator::Stop() {
+  is_stopped_ = true;
+  MessageWriter writer(message_);
+  writer.Write(Command::kStop);
+  for (size_t worker = 0; worker < GetWorkerCount(); worker++) {
+    transport_.Send(worker + 1, message_);
+  }
+}
+
+uint64_t DomainCoordinator::GetFrameCount() const {
+  return frame_count_;
+}
+
+size_t DomainCoordinator::GetWorkerCount() const {
+  return transport_.GetRankCount() - 1;
+}
+
+std::vector<float> DomainCoordinator::FindSlabBoundaries(
+    const glm::vec2& top_left, float width, float halo_width) const {
+  if (transport_.GetRank() != 0 || transport_.GetRankCount() < 2) {
+    throw std::invalid_argument(
+        "The coordinator must be rank 0 of at least two ranks");
+  }
+  size_t worker_count = GetWorkerCount();
+  if (width / static_cast<float>(worker_count) < halo_width) {
+    throw std::invalid_argument("Slabs are narrower than the halos");
+  }
+
+  // slabs split the width evenly; the first and last reach past the walls
+  std::vector<float> boundaries;
+  for (size_t slab = 1; slab < worker_count; slab++) {
+    boundaries.push_back(top_left.x + width * static_cast<float>(slab) /
+                                          static_cast<float>(worker_count));
+  }
+  return boundaries;
+}
+
+void RunDomainWorker(Transport& transport) {
+  if (transport.GetRank() == 0) {
+    throw std::invalid_argument("Rank 0 is the coordinator");
+  }
+  DomainWorker worker(transport);
+  worker.Run();
+}
+
+}  // namespace idealgas
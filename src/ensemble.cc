@@ -0,0 +1,196 @@
+#include "ensemble.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <numeric>
+#include <stdexcept>
+
+#include "thread_pool.h"
+
+namespace idealgas {
+
+namespace {
+
+/** Rough cost of a world: one unit per particle per frame **/
+uint64_t GetParticleFrames(const WorldSpec& spec) {
+  return static_cast<uint64_t>(spec.particle_count) * spec.frame_count;
+}
+
+/** Quotes a CSV field, doubling any quotes in it **/
+std::string QuoteCsv(const std::string& field) {
+  std::string quoted = "\"";
+  for (char c : field) {
+    quoted += c;
+    if (c == '"') {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+}  // namespace
+
+CsvEnsembleSink::CsvEnsembleSink(const std::string& path)
+    : file_(path, std::ios::trunc) {
+  if (!file_) {
+    throw std::runtime_error("Can't create " + path);
+  }
+  file_ << "world,seed,particles,frames,seconds,pressure,kinetic_energy,"
+           "temperature,collision_frequency,mean_free_path,error\n";
+  file_.flush();
+}
+
+void CsvEnsembleSink::AddResult(const WorldResult& result) {
+  const Observables& observables = result.observables;
+  file_ << result.world_index << ',' << result.seed << ','
+        << result.particle_count << ',' << result.frame_count << ','
+        << result.seconds << ',' << observables.pressure << ','
+        << observables.kinetic_energy << ',' << observables.temperature
+        << ',' << observables.collision_frequency << ','
+        << observables.mean_free_path << ',' << QuoteCsv(result.error)
+        << '\n';
+  file_.flush();
+}
+
+EnsembleRunner::EnsembleRunner(const EnsembleOptions& options)
+    : options_(options),
+      pool_(options.thread_count == 0 ? ThreadPool::GetHardwareThreadCount()
+                                      : options.thread_count) {
+  if (options.speed_sample_stride == 0) {
+    throw std::invalid_argument("The speed sample stride must be positive");
+  }
+  // checks the bins before any world runs
+  SpeedDistribution(options.max_speed, options.bin_count);
+}
+
+void EnsembleRunner::Run(const std::vector<WorldSpec>& worlds,
+                         EnsembleSink& sink) {
+  // largest first, so a long world doesn't start after the others are done
+  std::vector<size_t> order(worlds.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&worlds](size_t one, size_t two) {
+                     return GetParticleFrames(worlds[one]) >
+                            GetParticleFrames(worlds[two]);
+                   });
+
+  std::vector<std::vector<size_t>> tasks;
+  std::vector<size_t> pack;
+  uint64_t pack_particle_frames = 0;
+  for (size_t world : order) {
+    uint64_t particle_frames = GetParticleFrames(worlds[world]);
+    if (particle_frames >= options_.min_task_particle_frames) {
+      tasks.push_back(std::vector<size_t>(1, world));
+      continue;
+    }
+    pack.push_back(world);
+    pack_particle_frames += particle_frames;
+    if (pack_particle_frames >= options_.min_task_particle_frames) {
+      tasks.push_back(pack);
+      pack.clear();
+      pack_particle_frames = 0;
+    }
+  }
+  if (!pack.empty()) {
+    tasks.push_back(pack);
+  }
+  task_count_ = tasks.size();
+
+  std::vector<std::vector<SpeedDistribution>> world_distributions(
+      worlds.size());
+  std::vector<SpeciesRegistry> world_species(worlds.size());
+  std::exception_ptr sink_error;
+  pool_.Run(tasks.size(), [&](size_t task, size_t) {
+    for (size_t world : tasks[task]) {
+      WorldResult result = RunWorld(worlds[world], world_distributions[world],
+                                    world_species[world]);
+      result.world_index = world;
+
+      std::lock_guard<std::mutex> lock(sink_mutex_);
+      if (sink_error) {
+        continue;
+      }
+      try {
+        sink.AddResult(result);
+      } catch (...) {
+        sink_error = std::current_exception();
+      }
+    }
+  });
+  if (sink_error) {
+    std::rethrow_exception(sink_error);
+  }
+
+  speed_distributions_.clear();
+  SpeedDistribution empty(options_.max_speed, options_.bin_count);
+  for (size_t world = 0; world < worlds.size(); world++) {
+    const std::vector<SpeedDistribution>& distributions =
+        world_distributions[world];
+    for (size_t id = 0; id < distributions.size(); id++) {
+      const std::string& name =
+          world_species[world].Get(static_cast<uint8_t>(id)).name;
+      speed_distributions_.insert(std::make_pair(name, empty))
+          .first->second.Add(distributions[id]);
+    }
+  }
+}
+
+const std::map<std::string, SpeedDistribution>&
+EnsembleRunner::GetSpeedDistributions() const {
+  return speed_distributions_;
+}
+
+size_t EnsembleRunner::GetTaskCount() const {
+  return task_count_;
+}
+
+size_t EnsembleRunner::GetThreadCount() const {
+  return pool_.GetThreadCount();
+}
+
+WorldResult EnsembleRunner::RunWorld(
+    const WorldSpec& spec, std::vector<SpeedDistribution>& distributions,
+    SpeciesRegistry& species) const {
+  WorldResult result;
+  result.seed = spec.seed;
+  result.particle_count = spec.particle_count;
+  auto start = std::chrono::steady_clock::now();
+  try {
+    GasContainer container =
+        spec.species.IsEmpty()
+            ? GasContainer(spec.particle_count, glm::vec2(0, 0),
+                           spec.container_dimension, spec.seed,
+                           spec.placement)
+            : GasContainer(spec.particle_count, glm::vec2(0, 0),
+                           spec.container_dimension, spec.seed, spec.species,
+                           spec.placement);
+    container.SetStepper(spec.stepper);
+    species = container.GetSpecies();
+    distributions.assign(
+        species.Size(),
+        SpeedDistribution(options_.max_speed, options_.bin_count));
+
+    for (size_t frame = 0; frame < spec.frame_count; frame++) {
+      container.AdvanceOneFrame(spec.dt);
+      if (container.GetFrameCount() % options_.speed_sample_stride != 0) {
+        continue;
+      }
+      for (size_t id = 0; id < species.Size(); id++) {
+        distributions[id].AddFrame(
+            container.GetSpeciesSpeeds(static_cast<uint8_t>(id)));
+      }
+    }
+    result.frame_count = container.GetFrameCount();
+    result.observables = container.GetObservables();
+  } catch (const std::exception& error) {
+    result.error = error.what();
+    distributions.clear();
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,313 @@
+#include "event_driven_stepper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace idealgas {
+
+using glm::dvec2;
+using glm::vec2;
+
+bool EventDrivenStepper::Event::operator>(const Event& other) const {
+  if (time != other.time) {
+    return time > other.time;
+  } else if (type != other.type) {
+    return type > other.type;
+  } else if (first != other.first) {
+    return first > other.first;
+  }
+  return second > other.second;
+}
+
+void EventDrivenStepper::Initialize(const ParticleStore& particles,
+                                    const vec2& top_left,
+                                    const vec2& bottom_right) {
+  events_ = std::priority_queue<Event, std::vector<Event>,
+                                std::greater<Event>>();
+  time_ = 0;
+  particle_collision_count_ = 0;
+  wall_collision_count_ = 0;
+  particle_times_.assign(particles.Size(), 0);
+  event_counts_.assign(particles.Size(), 0);
+  top_left_ = top_left;
+  bottom_right_ = bottom_right;
+
+  // same sizing as SpatialGrid: at least one diameter, at most a few cells
+  // per particle
+  float width = bottom_right[0] - top_left[0];
+  float height = bottom_right[1] - top_left[1];
+  size_t max_cells =
+      std::max<size_t>(1, kMaxCellsPerParticle * particles.Size());
+  cell_size_ = std::max(2 * particles.GetMaxRadius(),
+                        std::sqrt(width * height / max_cells));
+  if (cell_size_ <= 0) {
+    cell_size_ = 1;
+  }
+  column_count_ = std::max<size_t>(
+      1, static_cast<size_t>(std::ceil(width / cell_size_)));
+  row_count_ = std::max<size_t>(
+      1, static_cast<size_t>(std::ceil(height / cell_size_)));
+
+  cell_particles_.assign(column_count_ * row_count_, std::vector<size_t>());
+  particle_cells_.resize(particles.Size());
+  for (size_t i = 0; i < particles.Size(); i++) {
+    particle_cells_[i] = GetCellIndex(particles.GetPosition(i));
+    cell_particles_[particle_cells_[i]].push_back(i);
+  }
+
+  for (size_t i = 0; i < particles.Size(); i++) {
+    PredictEvents(particles, i);
+  }
+}
+
+void EventDrivenStepper::Advance(ParticleStore& particles,
+                                 const SpeciesRegistry& species,
+                                 double duration, ObservableSums* sums) {
+  double end_time = time_ + duration;
+
+  while (!events_.empty() && events_.top().time <= end_time) {
+    Event event = events_.top();
+    events_.pop();
+    if (!IsValid(event)) {
+      continue;
+    }
+    time_ = event.time;
+
+    size_t first = event.first;
+    if (event.type == EventType::kParticle) {
+      size_t second = event.second;
+      MoveToTime(particles, first, time_);
+      MoveToTime(particles, second, time_);
+      uint8_t species_one = particles.GetSpeciesId(first);
+      uint8_t species_two = particles.GetSpeciesId(second);
+      particles.UpdateVelocitiesForParticleCollision(
+          first, second, species.GetMassFraction(species_one, species_two),
+          species.GetMassFraction(species_two, species_one));
+      particle_collision_count_++;
+      if (sums != nullptr) {
+        sums->AddCollision(species_one, species_two);
+      }
+      event_counts_[first]++;
+      event_counts_[second]++;
+      PredictEvents(particles, first);
+      PredictEvents(particles, second);
+    } else if (event.type == EventType::kWall) {
+      MoveToTime(particles, first, time_);
+      float impulse = particles.ReflectVelocity(first, event.second);
+      if (sums != nullptr) {
+        sums->wall_impulse += impulse;
+      }
+      wall_collision_count_++;
+      event_counts_[first]++;
+      PredictEvents(particles, first);
+    } else {
+      // the trajectory doesn't change, but the particle has new neighbors
+      RemoveFromCell(first);
+      particle_cells_[first] = event.second;
+      cell_particles_[event.second].push_back(first);
+      event_counts_[first]++;
+      PredictEvents(particles, first);
+    }
+  }
+
+  time_ = end_time;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    MoveToTime(particles, i, time_);
+  }
+}
+
+double EventDrivenStepper::GetTime() const {
+  return time_;
+}
+
+size_t EventDrivenStepper::GetParticleCollisionCount() const {
+  return particle_collision_count_;
+}
+
+size_t EventDrivenStepper::GetWallCollisionCount() const {
+  return wall_collision_count_;
+}
+
+size_t EventDrivenStepper::GetCellIndex(const vec2& position) const {
+  // positions outside of the container are clamped into the edge cells
+  float column = std::floor((position[0] - top_left_[0]) / cell_size_);
+  float row = std::floor((position[1] - top_left_[1]) / cell_size_);
+  column = std::min(std::max(column, 0.0f),
+                    static_cast<float>(column_count_ - 1));
+  row = std::min(std::max(row, 0.0f), static_cast<float>(row_count_ - 1));
+  return static_cast<size_t>(row) * column_count_ +
+         static_cast<size_t>(column);
+}
+
+void EventDrivenStepper::RemoveFromCell(size_t particle_index) {
+  std::vector<size_t>& cell = cell_particles_[particle_cells_[particle_index]];
+  cell.erase(std::find(cell.begin(), cell.end(), particle_index));
+}
+
+dvec2 EventDrivenStepper::GetPositionAt(const ParticleStore& particles,
+                                        size_t index, double time) const {
+  double elapsed = time - particle_times_[index];
+  return dvec2(particles.GetPosition(index)) +
+         dvec2(particles.GetVelocity(index)) * elapsed;
+}
+
+void EventDrivenStepper::MoveToTime(ParticleStore& particles, size_t index,
+                                    double time) {
+  if (particle_times_[index] != time) {
+    particles.SetPosition(index, vec2(GetPositionAt(particles, index, time)));
+    particle_times_[index] = time;
+  }
+}
+
+void EventDrivenStepper::PredictEvents(const ParticleStore& particles,
+                                       size_t index) {
+  size_t cell = particle_cells_[index];
+  size_t column = cell % column_count_;
+  size_t row = cell / column_count_;
+
+  // any particle this one can hit before changing cells is in a neighbor
+  size_t first_row = row > 0 ? row - 1 : 0;
+  size_t last_row = std::min(row + 1, row_count_ - 1);
+  size_t first_column = column > 0 ? column - 1 : 0;
+  size_t last_column = std::min(column + 1, column_count_ - 1);
+  for (size_t r = first_row; r <= last_row; r++) {
+    for (size_t c = first_column; c <= last_column; c++) {
+      for (size_t other : cell_particles_[r * column_count_ + c]) {
+        if (other == index) {
+          continue;
+        }
+        double time_to_collision =
+            GetTimeToCollision(particles, index, other);
+        if (time_to_collision >= 0) {
+          Event event = {time_ + time_to_collision, EventType::kParticle,
+                         index, other, event_counts_[index],
+                         event_counts_[other]};
+          events_.push(event);
+        }
+      }
+    }
+  }
+
+  dvec2 position = GetPositionAt(particles, index, time_);
+  PredictWallEvent(particles, index, position);
+  PredictCellCrossing(particles, index, position);
+}
+
+double EventDrivenStepper::GetTimeToCollision(const ParticleStore& particles,
+                                              size_t index_one,
+                                              size_t index_two) const {
+  dvec2 position_difference = GetPositionAt(particles, index_two, time_) -
+                              GetPositionAt(particles, index_one, time_);
+  dvec2 velocity_difference = dvec2(particles.GetVelocity(index_two)) -
+                              dvec2(particles.GetVelocity(index_one));
+
+  // moving apart or not moving relative to each other
+  double approach = glm::dot(position_difference, velocity_difference);
+  if (approach >= 0) {
+    return -1;
+  }
+
+  double contact_distance =
+      particles.GetRadius(index_one) + particles.GetRadius(index_two);
+  double distance_squared = glm::dot(position_difference, position_difference);
+  double gap = distance_squared - contact_distance * contact_distance;
+  if (gap <= 0) {
+    return 0;  // overlapping and approaching, collide right away
+  }
+
+  // solve |dp + dv * t| = contact_distance for the smaller t
+  double speed_squared = glm::dot(velocity_difference, velocity_difference);
+  double discriminant = approach * approach - speed_squared * gap;
+  if (discriminant < 0) {
+    return -1;  // they pass each other
+  }
+  return gap / (-approach + std::sqrt(discriminant));
+}
+
+void EventDrivenStepper::PredictWallEvent(const ParticleStore& particles,
+                                          size_t index,
+                                          const dvec2& position) {
+  vec2 velocity = particles.GetVelocity(index);
+  double radius = particles.GetRadius(index);
+  double best_time = std::numeric_limits<double>::infinity();
+  size_t best_axis = 0;
+
+  for (size_t axis = 0; axis < 2; axis++) {
+    double time_to_wall;
+    if (velocity[axis] < 0) {
+      time_to_wall = (top_left_[axis] + radius - position[axis]) /
+                     velocity[axis];
+    } else if (velocity[axis] > 0) {
+      time_to_wall = (bottom_right_[axis] - radius - position[axis]) /
+                     velocity[axis];
+    } else {
+      continue;
+    }
+
+    // already past the wall and still moving out: bounce right away
+    time_to_wall = std::max(time_to_wall, 0.0);
+    if (time_to_wall < best_time) {
+      best_time = time_to_wall;
+      best_axis = axis;
+    }
+  }
+
+  if (best_time < std::numeric_limits<double>::infinity()) {
+    Event event = {time_ + best_time, EventType::kWall, index, best_axis,
+                   event_counts_[index], 0};
+    events_.push(event);
+  }
+}
+
+void EventDrivenStepper::PredictCellCrossing(const ParticleStore& particles,
+                                             size_t index,
+                                             const dvec2& position) {
+  vec2 velocity = particles.GetVelocity(index);
+  size_t cell = particle_cells_[index];
+  size_t cell_coordinates[2] = {cell % column_count_, cell / column_count_};
+  size_t cell_counts[2] = {column_count_, row_count_};
+  size_t cell_strides[2] = {1, column_count_};
+  double best_time = std::numeric_limits<double>::infinity();
+  size_t new_cell = cell;
+
+  for (size_t axis = 0; axis < 2; axis++) {
+    double cell_start = top_left_[axis] + cell_coordinates[axis] * cell_size_;
+    double time_to_cross;
+    size_t next_cell;
+
+    // the edge cells extend past the container, so there is nothing to cross
+    if (velocity[axis] > 0 && cell_coordinates[axis] + 1 < cell_counts[axis]) {
+      time_to_cross =
+          (cell_start + cell_size_ - position[axis]) / velocity[axis];
+      next_cell = cell + cell_strides[axis];
+    } else if (velocity[axis] < 0 && cell_coordinates[axis] > 0) {
+      time_to_cross = (cell_start - position[axis]) / velocity[axis];
+      next_cell = cell - cell_strides[axis];
+    } else {
+      continue;
+    }
+
+    time_to_cross = std::max(time_to_cross, 0.0);
+    if (time_to_cross < best_time) {
+      best_time = time_to_cross;
+      new_cell = next_cell;
+    }
+  }
+
+  if (new_cell != cell) {
+    Event event = {time_ + best_time, EventType::kCellCrossing, index,
+                   new_cell, event_counts_[index], 0};
+    events_.push(event);
+  }
+}
+
+bool EventDrivenStepper::IsValid(const Event& event) const {
+  if (event.first_count != event_counts_[event.first]) {
+    return false;
+  }
+  return event.type != EventType::kParticle ||
+         event.second_count == event_counts_[event.second];
+}
+
+}  // namespace idealgas
@@ -0,0 +1,80 @@
+#include "fixed_time_stepper.h"
+
+namespace idealgas {
+
+template <int Dimension, typename Scalar>
+BasicFixedTimeStepper<Dimension, Scalar>::BasicFixedTimeStepper(
+    const Vector& top_left, const Vector& bottom_right)
+    : top_left_(top_left), bottom_right_(bottom_right), species_count_(0) {
+}
+
+template <int Dimension, typename Scalar>
+void BasicFixedTimeStepper<Dimension, Scalar>::AdvanceOneFrame(
+    Store& particles, Scalar dt) {
+  // the pairs are visited in increasing index order, so resolving each one
+  // as it is found picks the same pairs as finding them all first. A
+  // particle that collided is skipped, so no test sees a changed velocity
+  size_t size = particles.Size();
+  has_collided_.assign(size, 0);
+  resolved_pairs_.clear();
+  for (size_t i = 0; i < size; i++) {
+    for (size_t j = i + 1; j < size && !has_collided_[i]; j++) {
+      if (!has_collided_[j] && particles.IsTouching(i, j) &&
+          particles.IsApproaching(i, j)) {
+        ResolveCollision(particles, i, j);
+        resolved_pairs_.push_back(std::make_pair(i, j));
+        has_collided_[i] = 1;
+        has_collided_[j] = 1;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    if (!has_collided_[i]) {
+      particles.HandleIfWallCollision(i, top_left_, bottom_right_);
+    }
+  }
+  particles.Integrate(0, size, dt);
+}
+
+template <int Dimension, typename Scalar>
+void BasicFixedTimeStepper<Dimension, Scalar>::SetSpecies(
+    const SpeciesRegistry& species) {
+  species_count_ = species.Size();
+  mass_fractions_.resize(species_count_ * species_count_);
+  for (size_t one = 0; one < species_count_; one++) {
+    for (size_t two = 0; two < species_count_; two++) {
+      mass_fractions_[one * species_count_ + two] = species.GetMassFraction(
+          static_cast<uint8_t>(one), static_cast<uint8_t>(two));
+    }
+  }
+}
+
+template <int Dimension, typename Scalar>
+const std::vector<std::pair<size_t, size_t>>&
+BasicFixedTimeStepper<Dimension, Scalar>::GetResolvedPairs() const {
+  return resolved_pairs_;
+}
+
+template <int Dimension, typename Scalar>
+void BasicFixedTimeStepper<Dimension, Scalar>::ResolveCollision(
+    Store& particles, size_t index_one, size_t index_two) const {
+  if (mass_fractions_.empty()) {
+    particles.UpdateVelocitiesForParticleCollision(index_one, index_two);
+    return;
+  }
+
+  size_t species_one = particles.GetSpeciesId(index_one);
+  size_t species_two = particles.GetSpeciesId(index_two);
+  particles.UpdateVelocitiesForParticleCollision(
+      index_one, index_two,
+      mass_fractions_[species_one * species_count_ + species_two],
+      mass_fractions_[species_two * species_count_ + species_one]);
+}
+
+template class BasicFixedTimeStepper<2, float>;
+template class BasicFixedTimeStepper<3, float>;
+template class BasicFixedTimeStepper<2, double>;
+template class BasicFixedTimeStepper<3, double>;
+
+}  // namespace idealgas
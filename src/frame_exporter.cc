@@ -0,0 +1,251 @@
+#include "frame_exporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+#include "png_writer.h"
+
+namespace idealgas {
+
+using glm::vec2;
+
+namespace {
+
+const Color kBackgroundColor = "black";
+const Color kHistogramAxisColor = "white";
+
+/** Share of the frame width taken by the histogram column **/
+const float kHistogramColumnFraction = 1.0f / 3;
+
+/** Empty space around each histogram and the container, in pixels **/
+const float kPanelMargin = 20;
+
+/** Upper edge of the speed bins when every particle is at rest **/
+const float kMinHistogramMaxSpeed = 1;
+
+}  // namespace
+
+FrameExporter::FrameExporter(const std::string& path_prefix,
+                             const GasContainer& container,
+                             const FrameExportOptions& options)
+    : path_prefix_(path_prefix),
+      options_(options),
+      species_(container.GetSpecies()),
+      top_left_(container.GetTopLeftPosition()),
+      bottom_right_(container.GetBottomRightPosition()),
+      renderer_(options.thread_count),
+      framebuffer_(options.width, options.height) {
+  if (options.width == 0 || options.height == 0 || options.stride == 0 ||
+      options.buffer_count == 0) {
+    throw std::invalid_argument(
+        "Frame size, stride and buffer count must be positive");
+  }
+
+  float container_left = 0;
+  if (options.draw_histograms && species_.Size() > 0) {
+    container_left = options.width * kHistogramColumnFraction;
+    LayOutHistograms(container);
+  }
+
+  // scale the container to fit the rest of the frame, centered
+  vec2 area_top_left(container_left + kPanelMargin, kPanelMargin);
+  vec2 area_dimension(options.width - container_left - 2 * kPanelMargin,
+                      options.height - 2 * kPanelMargin);
+  vec2 container_dimension = bottom_right_ - top_left_;
+  float scale = std::max(std::min(area_dimension.x / container_dimension.x,
+                                  area_dimension.y / container_dimension.y),
+                         0.0f);
+  vec2 padding = (area_dimension - container_dimension * scale) * 0.5f;
+  container_viewport_.scale = scale;
+  container_viewport_.origin = top_left_ - (area_top_left + padding) / scale;
+
+  for (size_t i = 0; i < options.buffer_count; i++) {
+    std::unique_ptr<CapturedFrame> frame(new CapturedFrame());
+    free_frames_.push_back(frame.get());
+    frames_.push_back(std::move(frame));
+  }
+
+  if (options.format == FrameFormat::kRaw) {
+    raw_file_.open(path_prefix + ".rgba", std::ios::binary | std::ios::trunc);
+    if (!raw_file_) {
+      throw std::runtime_error("Can't write " + path_prefix + ".rgba");
+    }
+  }
+  export_thread_ = std::thread(&FrameExporter::ExportLoop, this);
+}
+
+FrameExporter::~FrameExporter() {
+  try {
+    Close();
+  } catch (const std::runtime_error&) {
+  }
+}
+
+void FrameExporter::AddFrame(const GasContainer& container) {
+  if (is_closed_) {
+    throw std::runtime_error("Frame exporter " + path_prefix_ +
+                             " is closed");
+  }
+  uint64_t frame_number = container.GetFrameCount();
+  if (frame_number % options_.stride != 0) {
+    return;
+  }
+
+  CapturedFrame* frame;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_frames_.empty()) {
+      stall_count_++;
+      frame_freed_.wait(lock, [this] { return !free_frames_.empty(); });
+    }
+    frame = free_frames_.back();
+    free_frames_.pop_back();
+  }
+
+  // the buffers keep their capacity, so copying doesn't allocate after the
+  // first few frames
+  frame->frame_number = frame_number;
+  frame->particles = container.GetParticleStore();
+  if (!histograms_.empty()) {
+    frame->species_speeds.resize(species_.Size());
+    for (size_t id = 0; id < species_.Size(); id++) {
+      frame->species_speeds[id] =
+          container.GetSpeciesSpeeds(static_cast<uint8_t>(id));
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_frames_.push_back(frame);
+    queued_frame_count_++;
+  }
+  frame_queued_.notify_one();
+}
+
+void FrameExporter::Close() {
+  if (is_closed_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_closing_ = true;
+  }
+  frame_queued_.notify_one();
+  export_thread_.join();
+  is_closed_ = true;
+  if (has_failed_) {
+    throw std::runtime_error("Failed writing frames to " + path_prefix_);
+  }
+}
+
+std::string FrameExporter::GetFramePath(uint64_t frame_number) const {
+  if (options_.format == FrameFormat::kRaw) {
+    return path_prefix_ + ".rgba";
+  }
+  char number[32];
+  std::snprintf(number, sizeof(number), "_%06llu.png",
+                static_cast<unsigned long long>(frame_number));
+  return path_prefix_ + number;
+}
+
+size_t FrameExporter::GetQueuedFrameCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queued_frame_count_;
+}
+
+size_t FrameExporter::GetStallCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stall_count_;
+}
+
+void FrameExporter::LayOutHistograms(const GasContainer& container) {
+  // fixed bin edges, so the bars don't jump around from frame to frame
+  const ParticleStore& particles = container.GetParticleStore();
+  float max_speed = kMinHistogramMaxSpeed;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    max_speed = std::max(max_speed, particles.GetSpeed(i));
+  }
+
+  float column_width = options_.width * kHistogramColumnFraction;
+  float slot_height = static_cast<float>(options_.height) / species_.Size();
+  vec2 dimension(std::max(column_width - 2 * kPanelMargin, 1.0f),
+                 std::max(slot_height - 2 * kPanelMargin, 1.0f));
+  for (size_t id = 0; id < species_.Size(); id++) {
+    const Species& species = species_.Get(static_cast<uint8_t>(id));
+    Histogram histogram(vec2(kPanelMargin, id * slot_height + kPanelMargin),
+                        dimension, species.color, kHistogramAxisColor,
+                        species.name + " Speed", "Frequency");
+    histogram.SetRange(0, max_speed);
+    histograms_.push_back(histogram);
+  }
+}
+
+void FrameExporter::ExportLoop() {
+  while (true) {
+    CapturedFrame* frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      frame_queued_.wait(
+          lock, [this] { return is_closing_ || !queued_frames_.empty(); });
+      if (queued_frames_.empty()) {
+        break;
+      }
+      frame = queued_frames_.front();
+      queued_frames_.pop_front();
+    }
+
+    uint64_t frame_number = frame->frame_number;
+    if (!has_failed_) {
+      DrawFrame(*frame);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_frames_.push_back(frame);
+    }
+    frame_freed_.notify_one();
+
+    // after a failure the frames are still taken, so AddFrame never waits
+    // forever, but they are dropped
+    if (!has_failed_) {
+      WriteFrame(frame_number);
+    }
+  }
+  if (raw_file_.is_open()) {
+    raw_file_.close();
+    if (!raw_file_) {
+      has_failed_ = true;
+    }
+  }
+}
+
+void FrameExporter::DrawFrame(const CapturedFrame& frame) {
+  framebuffer_.Clear(kBackgroundColor);
+
+  renderer_.SetViewport(Viewport());
+  for (size_t id = 0; id < histograms_.size(); id++) {
+    histograms_[id].UpdateData(frame.species_speeds[id],
+                               options_.histogram_bin_count);
+    renderer_.DrawHistogram(histograms_[id], framebuffer_);
+  }
+
+  renderer_.SetViewport(container_viewport_);
+  renderer_.DrawParticles(frame.particles, species_, top_left_, bottom_right_,
+                          framebuffer_);
+}
+
+void FrameExporter::WriteFrame(uint64_t frame_number) {
+  if (options_.format == FrameFormat::kRaw) {
+    raw_file_.write(reinterpret_cast<const char*>(framebuffer_.GetPixels()),
+                    4 * framebuffer_.GetWidth() * framebuffer_.GetHeight());
+    has_failed_ = !raw_file_;
+    return;
+  }
+  try {
+    WritePng(GetFramePath(frame_number), framebuffer_);
+  } catch (const std::runtime_error&) {
+    has_failed_ = true;
+  }
+}
+
+}  // namespace idealgas
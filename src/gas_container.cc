@@ -1,166 +1,786 @@
 #include "gas_container.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "profiler.h"
+#include "snapshot.h"
+#include "state_hash.h"
+
 namespace idealgas {
 
 using glm::vec2;
+using std::string;
 using std::vector;
 
+namespace {
+
+/**
+ * Finds when two particles moving at constant velocity first touch while
+ * approaching each other
+ *
+ * @param particles   particles the two are in
+ * @param one         index of the first particle
+ * @param two         index of the second particle
+ * @param periods     length of each periodic axis, 0 for each axis with walls
+ * @param dt          length of the interval to search
+ * @param time        set to the time the particles touch, 0 if they already
+ *                    overlap
+ * @return            whether they touch within [0, dt]
+ */
+bool FindContactTime(const ParticleStore &particles, size_t one, size_t two,
+                     const vec2 &periods, float dt, float &time) {
+  vec2 offset = particles.GetPosition(one) - particles.GetPosition(two);
+  offset.x = GetMinimumImage(offset.x, periods.x);
+  offset.y = GetMinimumImage(offset.y, periods.y);
+  vec2 relative_velocity =
+      particles.GetVelocity(one) - particles.GetVelocity(two);
+  float radius_sum = particles.GetRadius(one) + particles.GetRadius(two);
+
+  // solve |offset + relative_velocity * t| = radius_sum for the first root
+  float approach = offset.x * relative_velocity.x +
+                   offset.y * relative_velocity.y;
+  if (approach >= 0) {
+    return false;
+  }
+  float gap = offset.x * offset.x + offset.y * offset.y -
+              radius_sum * radius_sum;
+  if (gap <= 0) {
+    time = 0;
+    return true;
+  }
+  float speed_squared = relative_velocity.x * relative_velocity.x +
+                        relative_velocity.y * relative_velocity.y;
+  float discriminant = approach * approach - speed_squared * gap;
+  if (discriminant < 0) {
+    return false;
+  }
+  time = gap / (-approach + std::sqrt(discriminant));
+  return time <= dt;
+}
+
+}  // namespace
+
 GasContainer::GasContainer(size_t particle_count, vec2 top_left_position,
-                           vec2 container_dimension, int seed) {
-  srand(seed);
+                           vec2 container_dimension, int seed,
+                           Placement placement) {
+  seed_ = seed;
+  rng_ = CounterRng(static_cast<uint64_t>(seed));
   particle_count_ = particle_count;
   top_left_position_ = top_left_position;
   width_ = container_dimension[0];
   height_ = container_dimension[1];
   bottom_right_position =
       vec2(top_left_position_[0] + width_, top_left_position_[1] + height_);
-  container_box_ = ci::Rectf(top_left_position_, bottom_right_position);
-  InitializeParticlesCollection();
-  InitializeParticleSpeedsMap();
-  UpdateParticlesSpeedMap();
+  InitializeDefaultSpecies();
+  InitializeParticlesCollection(placement);
+  InitializeSpeciesSpeeds();
+  UpdateSpeciesSpeeds();
 }
 
 GasContainer::GasContainer(size_t particle_count, vec2 top_left_position,
                            vec2 container_dimension, int seed,
-                           vector<Particle> &particles) {
-  srand(seed);
+                           const SpeciesRegistry &species,
+                           Placement placement) {
+  if (species.IsEmpty() && particle_count > 0) {
+    throw std::invalid_argument("GasContainer needs at least one species");
+  }
+  seed_ = seed;
+  rng_ = CounterRng(static_cast<uint64_t>(seed));
   particle_count_ = particle_count;
   top_left_position_ = top_left_position;
   width_ = container_dimension[0];
   height_ = container_dimension[1];
   bottom_right_position =
       vec2(top_left_position_[0] + width_, top_left_position_[1] + height_);
-  container_box_ = ci::Rectf(top_left_position_, bottom_right_position);
-  particles_ = particles;
-  InitializeParticleSpeedsMap();
-  UpdateParticlesSpeedMap();
+  species_ = species;
+  InitializeParticlesCollection(placement);
+  InitializeSpeciesSpeeds();
+  UpdateSpeciesSpeeds();
 }
 
-void GasContainer::Display() const {
-  DrawContainer();
-  DrawParticles();
+GasContainer::GasContainer(size_t particle_count, vec2 top_left_position,
+                           vec2 container_dimension, int seed,
+                           vector<Particle> &particles) {
+  seed_ = seed;
+  rng_ = CounterRng(static_cast<uint64_t>(seed));
+  particle_count_ = particle_count;
+  top_left_position_ = top_left_position;
+  width_ = container_dimension[0];
+  height_ = container_dimension[1];
+  bottom_right_position =
+      vec2(top_left_position_[0] + width_, top_left_position_[1] + height_);
+  particles_.Reserve(particles.size());
+  for (const auto &particle : particles) {
+    AddParticle(particle);
+  }
+  InitializeSpeciesSpeeds();
+  UpdateSpeciesSpeeds();
 }
 
 void GasContainer::AdvanceOneFrame() {
-  ClearParticleSpeedsMapVectors();
-  for (size_t i = 0; i < particles_.size(); i++) {
-    int colliding_index = GetCollidingParticleIndex(i);
-
-    if (colliding_index == -1) {  // particle didn't collide with another particle
-      HandleIfWallCollision(particles_[i]);
-    } else {
-      particles_[i].UpdateVelocitiesForParticleCollision(
-          particles_[colliding_index]);
-    }
-    particle_speeds_.at(particles_[i].GetTypeName())
-        .push_back(particles_[i].GetSpeed());
-    particles_[i].Move();
+  AdvanceOneFrame(1);
+}
+
+void GasContainer::AdvanceOneFrame(float dt) {
+  if (!(dt > 0)) {
+    throw std::invalid_argument("The time step must be positive");
   }
+  IDEALGAS_PROFILE_SCOPE("frame");
+  substep_count_ = 1;
+  BeginFrameObservables();
+  if (stepper_ == Stepper::kEventDriven) {
+    AdvanceEventDriven(dt);
+  } else if (stepper_ == Stepper::kAdaptive) {
+    AdvanceAdaptive(dt);
+  } else {
+    FindCollidingPairs();
+    ResolveParticleCollisions();
+    HandleWallsAndMove(dt);
+  }
+  EndFrameObservables(dt);
+  frame_count_++;
+  is_snapshot_stale_ = true;
+  if (is_state_hashing_) {
+    state_hash_ =
+        CombineStateHashes(state_hash_, HashParticleState(particles_));
+    state_hashes_.push_back(state_hash_);
+  }
+}
+
+void GasContainer::SaveSnapshot(const string &path) const {
+  SnapshotHeader header;
+  header.top_left_position = top_left_position_;
+  header.container_dimension = vec2(width_, height_);
+  header.seed = seed_;
+  header.frame_count = frame_count_;
+  WriteSnapshot(path, header, species_, particles_);
+}
+
+GasContainer GasContainer::LoadSnapshot(const string &path) {
+  GasContainer container;
+  SnapshotHeader header;
+  ReadSnapshot(path, header, container.species_, container.particles_);
+
+  container.seed_ = static_cast<int>(header.seed);
+  container.rng_ = CounterRng(static_cast<uint64_t>(container.seed_));
+  container.frame_count_ = header.frame_count;
+  container.particle_count_ = container.particles_.Size();
+  container.top_left_position_ = header.top_left_position;
+  container.width_ = header.container_dimension[0];
+  container.height_ = header.container_dimension[1];
+  container.bottom_right_position =
+      header.top_left_position + header.container_dimension;
+  container.InitializeSpeciesSpeeds();
+  container.UpdateSpeciesSpeeds();
+  return container;
+}
+
+void GasContainer::SetThreadCount(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = ThreadPool::GetHardwareThreadCount();
+  }
+  if (thread_count != thread_pool_->GetThreadCount()) {
+    thread_pool_.reset(new ThreadPool(thread_count));
+  }
+}
+
+size_t GasContainer::GetThreadCount() const {
+  return thread_pool_->GetThreadCount();
+}
+
+void GasContainer::SetDeterministic(bool is_deterministic) {
+  is_deterministic_ = is_deterministic;
 }
 
-void GasContainer::InitializeParticlesCollection() {
-  particles_ = vector<Particle>();
-  for (size_t i = 0; i < particle_count_; i++) {
-    // generate a random particle
-    Particle particle = GenerateRandomParticle(i);
-    particles_.push_back(particle);
+bool GasContainer::IsDeterministic() const {
+  return is_deterministic_;
+}
+
+void GasContainer::SetStateHashing(bool is_enabled) {
+  if (is_enabled && !is_state_hashing_) {
+    state_hash_ = HashParticleState(particles_);
+    state_hashes_.clear();
+  }
+  is_state_hashing_ = is_enabled;
+}
+
+const vector<uint64_t> &GasContainer::GetStateHashes() const {
+  return state_hashes_;
+}
+
+void GasContainer::SetCollisionDetection(
+    CollisionDetection collision_detection) {
+  collision_detection_ = collision_detection;
+}
+
+CollisionDetection GasContainer::GetCollisionDetection() const {
+  return collision_detection_;
+}
+
+void GasContainer::SetNarrowphaseKernel(Narrowphase::Kernel kernel) {
+  narrowphase_ = Narrowphase(kernel);
+  spatial_grid_.SetNarrowphase(narrowphase_);
+}
+
+Narrowphase::Kernel GasContainer::GetNarrowphaseKernel() const {
+  return narrowphase_.GetKernel();
+}
+
+void GasContainer::SetStepper(Stepper stepper) {
+  if (stepper == Stepper::kEventDriven &&
+      (boundaries_[0] == Boundary::kPeriodic ||
+       boundaries_[1] == Boundary::kPeriodic)) {
+    throw std::invalid_argument(
+        "The event-driven stepper only supports walls");
+  }
+  if (stepper != stepper_) {
+    stepper_ = stepper;
+    // the fixed time step stepper moves particles behind its back
+    is_event_driven_stepper_stale_ = true;
+  }
+}
+
+Stepper GasContainer::GetStepper() const {
+  return stepper_;
+}
+
+void GasContainer::SetBoundary(size_t axis, Boundary boundary) {
+  if (axis > 1) {
+    throw std::invalid_argument("The container only has axes 0 and 1");
+  }
+  if (boundary == Boundary::kPeriodic && stepper_ == Stepper::kEventDriven) {
+    throw std::invalid_argument(
+        "The event-driven stepper only supports walls");
+  }
+  boundaries_[axis] = boundary;
+  spatial_grid_.SetBoundaries(boundaries_[0], boundaries_[1]);
+}
+
+Boundary GasContainer::GetBoundary(size_t axis) const {
+  if (axis > 1) {
+    throw std::invalid_argument("The container only has axes 0 and 1");
+  }
+  return boundaries_[axis];
+}
+
+size_t GasContainer::GetSubstepCount() const {
+  return substep_count_;
+}
+
+Observables GasContainer::GetObservables() const {
+  // the walls across x are as long as the height, and the other way around
+  double wall_length = 0;
+  if (boundaries_[0] == Boundary::kWall) {
+    wall_length += 2.0 * height_;
+  }
+  if (boundaries_[1] == Boundary::kWall) {
+    wall_length += 2.0 * width_;
+  }
+  return observables_window_.GetAverages(particles_.Size(), wall_length);
+}
+
+void GasContainer::SetObservablesWindow(size_t frame_count) {
+  observables_window_.SetFrameCount(frame_count);
+}
+
+void GasContainer::InitializeParticlesCollection(Placement placement) {
+  particles_.Clear();
+  particles_.Resize(particle_count_);
+  auto generate = [this](size_t begin, size_t end, size_t) {
+    for (size_t i = begin; i < end; i++) {
+      // generate a random particle
+      GenerateRandomParticle(i, particles_, i);
+    }
+  };
+
+  // the container's own pool is still single threaded while constructing
+  if (particle_count_ >= kParallelInitializationMinParticles) {
+    ThreadPool(ThreadPool::GetHardwareThreadCount())
+        .ParallelFor(particle_count_, generate);
+  } else {
+    generate(0, particle_count_, 0);
+  }
+
+  if (placement != Placement::kUniform) {
+    PlaceWithoutOverlaps(placement, top_left_position_, bottom_right_position,
+                         rng_, kParticlePlacementStream, particles_);
   }
 }
 
-Particle GasContainer::GenerateRandomParticle(int particle_number) {
+void GasContainer::GenerateRandomParticle(size_t particle_number,
+                                          ParticleStore &particles,
+                                          size_t index) const {
+  // one block of four random words per particle: x, y, vx and vy
+  CounterRng::Block random =
+      rng_.Generate(kParticleInitializationStream, particle_number);
+
   // generate a random position for the particle within the container
   vec2 position;
   vec2 velocity;
-  SetRandomPosition(position);
-  SetRandomVelocity(velocity);
-
-  if (particle_number % 3 == 0) {
-    return Particle(position, velocity, kBlueParticleColor, kBlueParticleRadius,
-                    kBlueParticleMass, kBlueParticleType);
-  } else if (particle_number % 3 == 1) {
-    return Particle(position, velocity, kRedParticleColor, kRedParticleRadius,
-                    kRedParticleMass, kRedParticleType);
-  } else {
-    return Particle(position, velocity, kGreenParticleColor,
-                    kGreenParticleRadius, kGreenParticleMass,
-                    kGreenParticleType);
-  }
+  SetRandomPosition(random, position);
+  SetRandomVelocity(random, velocity);
+
+  // species take turns in registration order
+  uint8_t species_id =
+      static_cast<uint8_t>(particle_number % species_.Size());
+  const Species &species = species_.Get(species_id);
+  particles.Set(index, position, velocity, species.radius, species.mass,
+                species_id);
+}
+
+void GasContainer::AddParticle(const Particle &particle) {
+  uint8_t species_id =
+      species_.Register(particle.GetTypeName(), particle.GetColor(),
+                        particle.GetMass(), particle.GetRadius());
+  particles_.Add(particle.GetPosition(), particle.GetVelocity(),
+                 particle.GetRadius(), particle.GetMass(), species_id);
+  is_snapshot_stale_ = true;
+  is_event_driven_stepper_stale_ = true;
 }
 
-void GasContainer::DrawContainer() const {
-  ci::gl::color(ci::Color("white"));
-  ci::gl::drawStrokedRect(container_box_);
+void GasContainer::InitializeDefaultSpecies() {
+  species_.Register(kBlueParticleType, kBlueParticleColor, kBlueParticleMass,
+                    kBlueParticleRadius);
+  species_.Register(kRedParticleType, kRedParticleColor, kRedParticleMass,
+                    kRedParticleRadius);
+  species_.Register(kGreenParticleType, kGreenParticleColor,
+                    kGreenParticleMass, kGreenParticleRadius);
 }
 
-float GasContainer::GenerateRandomFloat(float lower_bound, float upper_bound) {
-  // code derived from: https://stackoverflow.com/a/5289625/7359915
+float GasContainer::GenerateRandomFloat(uint32_t random_bits,
+                                        float lower_bound,
+                                        float upper_bound) const {
   // random = float between 0 and 1
-  float random = (static_cast<float>(rand())) / static_cast<float>(RAND_MAX);
+  float random = CounterRng::ToUnitFloat(random_bits);
   float range = upper_bound - lower_bound;
   return (random * range) + lower_bound;
 }
 
-void GasContainer::SetRandomPosition(vec2 &position) {
+void GasContainer::SetRandomPosition(const CounterRng::Block &random,
+                                     vec2 &position) const {
   // offset each bound by a margin to make sure particle doesn't spawn too
   // close to the bounds
   float left_bound = top_left_position_[0] + kMargin;
   float right_bound = top_left_position_[0] + width_ - kMargin;
-  float x_position = GenerateRandomFloat(left_bound, right_bound);
+  float x_position = GenerateRandomFloat(random[0], left_bound, right_bound);
 
   float top_bound = top_left_position_[1] + kMargin;
   float bottom_bound = top_left_position_[1] + height_ - kMargin;
-  float y_position = GenerateRandomFloat(top_bound, bottom_bound);
+  float y_position = GenerateRandomFloat(random[1], top_bound, bottom_bound);
 
   position = vec2(x_position, y_position);
 }
 
-void GasContainer::DrawParticles() const {
-  for (const auto &particle : particles_) {
-    ci::gl::color(particle.GetColor());
-    ci::gl::drawSolidCircle(particle.GetPosition(), particle.GetRadius());
+void GasContainer::SetRandomVelocity(const CounterRng::Block &random,
+                                     vec2 &velocity) const {
+  float x_velocity = GenerateRandomFloat(random[2], kMinVelocityComponent,
+                                         kMaxVelocityComponent);
+  float y_velocity = GenerateRandomFloat(random[3], kMinVelocityComponent,
+                                         kMaxVelocityComponent);
+  velocity = vec2(x_velocity, y_velocity);
+}
+
+void GasContainer::FindCollidingPairs() {
+  IDEALGAS_PROFILE_SCOPE("collision search");
+  size_t chunk_count = thread_pool_->GetThreadCount();
+  if (collision_detection_ == CollisionDetection::kBruteForce) {
+    // later rows of the triangle are shorter, so use more chunks than
+    // threads to balance the work
+    chunk_count *= kBruteForceChunksPerThread;
   }
+  chunk_pairs_.resize(chunk_count);
+
+  if (collision_detection_ == CollisionDetection::kBruteForce) {
+    thread_pool_->ParallelFor(
+        particles_.Size(), chunk_count,
+        [this](size_t begin, size_t end, size_t chunk) {
+          FindCollidingPairsBruteForce(begin, end, chunk_pairs_[chunk]);
+        });
+  } else {
+    spatial_grid_.Rebuild(particles_, top_left_position_,
+                          bottom_right_position);
+    thread_pool_->ParallelFor(
+        spatial_grid_.GetRowCount(), chunk_count,
+        [this](size_t begin, size_t end, size_t chunk) {
+          chunk_pairs_[chunk].clear();
+          spatial_grid_.FindCollidingPairsInRows(particles_, begin, end,
+                                                 chunk_pairs_[chunk]);
+        });
+  }
+
+  // merge in chunk order then sort, so the pairs don't depend on how the
+  // work was split
+  colliding_pairs_.clear();
+  for (const auto &pairs : chunk_pairs_) {
+    colliding_pairs_.insert(colliding_pairs_.end(), pairs.begin(),
+                            pairs.end());
+  }
+  std::sort(colliding_pairs_.begin(), colliding_pairs_.end());
 }
-void GasContainer::SetRandomVelocity(vec2 &velocity) {
-  float x_velocity =
-      GenerateRandomFloat(kMinVelocityComponent, kMaxVelocityComponent);
-  float y_velocity =
-      GenerateRandomFloat(kMinVelocityComponent, kMaxVelocityComponent);
-  velocity = vec2(x_velocity, y_velocity);
+
+void GasContainer::FindCollidingPairsBruteForce(
+    size_t begin, size_t end, vector<SpatialGrid::IndexPair> &pairs) const {
+  pairs.clear();
+  ParticleArrays arrays(particles_);
+  vec2 periods = GetPeriods();
+  arrays.period_x = periods.x;
+  arrays.period_y = periods.y;
+  size_t size = particles_.Size();
+  for (size_t i = begin; i < end; i++) {
+    for (size_t block = i + 1; block < size;
+         block += Narrowphase::kBlockSize) {
+      size_t count = std::min(Narrowphase::kBlockSize, size - block);
+      uint32_t contacts = narrowphase_.FindContacts(arrays, i, block, count);
+      for (size_t j = block; contacts != 0; j++, contacts >>= 1) {
+        if (contacts & 1) {
+          pairs.push_back(SpatialGrid::IndexPair(i, j));
+        }
+      }
+    }
+  }
 }
 
-int GasContainer::GetCollidingParticleIndex(size_t particle_index) const {
-  for (size_t i = 0; i < particles_.size(); i++) {
-    // checking if its colliding with a particle that's not itself
-    if (particle_index == i) {
+void GasContainer::ResolveParticleCollisions() {
+  IDEALGAS_PROFILE_SCOPE("collision resolution");
+  // choosing which pairs collide depends on the order of the pairs, so it is
+  // done serially. It's a single pass over the pairs
+  has_collided_.assign(particles_.Size(), 0);
+  resolved_pairs_.clear();
+  for (const auto &pair : colliding_pairs_) {
+    if (has_collided_[pair.first] || has_collided_[pair.second]) {
       continue;
-    } else if (particles_[i].IsTouching(particles_[particle_index]) &&
-               particles_[i].IsApproaching(particles_[particle_index])) {
-      return i;
     }
+    resolved_pairs_.push_back(pair);
+    has_collided_[pair.first] = 1;
+    has_collided_[pair.second] = 1;
+  }
+
+  // every particle is in at most one resolved pair, so the pairs don't
+  // conflict and can be resolved in any order
+  vec2 periods = GetPeriods();
+  thread_pool_->ParallelFor(
+      resolved_pairs_.size(), GetObservableChunkCount(),
+      [this, &periods](size_t begin, size_t end, size_t chunk) {
+        ObservableSums &sums = chunk_observables_[chunk];
+        for (size_t p = begin; p < end; p++) {
+          size_t first = resolved_pairs_[p].first;
+          size_t second = resolved_pairs_[p].second;
+          uint8_t species_one = particles_.GetSpeciesId(first);
+          uint8_t species_two = particles_.GetSpeciesId(second);
+          particles_.UpdateVelocitiesForParticleCollision(
+              first, second,
+              species_.GetMassFraction(species_one, species_two),
+              species_.GetMassFraction(species_two, species_one), periods);
+          sums.AddCollision(species_one, species_two);
+        }
+      });
+}
+
+void GasContainer::HandleWallsAndMove(float dt) {
+  size_t species_count = species_.Size();
+  size_t chunk_count = GetObservableChunkCount();
+  chunk_species_offsets_.assign(chunk_count * species_count, 0);
+
+  // bounce off the walls and count the particles of each species per chunk
+  {
+    IDEALGAS_PROFILE_SCOPE("wall handling");
+    vec2 top_left;
+    vec2 bottom_right;
+    GetWallBounds(top_left, bottom_right);
+    thread_pool_->ParallelFor(
+        particles_.Size(), chunk_count,
+        [this, species_count, &top_left, &bottom_right](size_t begin,
+                                                        size_t end,
+                                                        size_t chunk) {
+          size_t *counts = &chunk_species_offsets_[chunk * species_count];
+          double impulse = 0;
+          for (size_t i = begin; i < end; i++) {
+            if (!has_collided_[i]) {  // didn't collide with another particle
+              impulse +=
+                  particles_.HandleIfWallCollision(i, top_left, bottom_right);
+            }
+            counts[particles_.GetSpeciesId(i)]++;
+          }
+          chunk_observables_[chunk].wall_impulse += impulse;
+        });
+  }
+
+  // turn the counts into the offset each chunk starts writing speeds at, so
+  // speeds stay in particle order
+  for (size_t id = 0; id < species_count; id++) {
+    size_t total = 0;
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+      size_t count = chunk_species_offsets_[chunk * species_count + id];
+      chunk_species_offsets_[chunk * species_count + id] = total;
+      total += count;
+    }
+    species_speeds_[id].resize(total);
+  }
+
+  // speeds are recorded in the same pass as integration, so the two are
+  // timed together
+  IDEALGAS_PROFILE_SCOPE("speeds and integration");
+  thread_pool_->ParallelFor(
+      particles_.Size(), chunk_count,
+      [this, species_count, dt](size_t begin, size_t end, size_t chunk) {
+        size_t *offsets = &chunk_species_offsets_[chunk * species_count];
+        const float *inverse_masses = particles_.GetInverseMasses();
+        double energy = 0;
+        double distance = 0;
+        for (size_t i = begin; i < end; i++) {
+          uint8_t species_id = particles_.GetSpeciesId(i);
+          float speed = particles_.GetSpeed(i);
+          species_speeds_[species_id][offsets[species_id]++] = speed;
+          energy += speed * speed / inverse_masses[i];
+          distance += speed;
+        }
+        particles_.Integrate(begin, end, dt);
+        WrapPeriodicAxes(begin, end);
+
+        ObservableSums &sums = chunk_observables_[chunk];
+        sums.energy_time += 0.5 * energy * dt;
+        sums.distance += distance * dt;
+      });
+}
+
+void GasContainer::GetWallBounds(vec2 &top_left, vec2 &bottom_right) const {
+  top_left = top_left_position_;
+  bottom_right = bottom_right_position;
+  for (size_t axis = 0; axis < 2; axis++) {
+    if (boundaries_[axis] == Boundary::kPeriodic) {
+      top_left[axis] = -std::numeric_limits<float>::infinity();
+      bottom_right[axis] = std::numeric_limits<float>::infinity();
+    }
+  }
+}
+
+vec2 GasContainer::GetPeriods() const {
+  return vec2(boundaries_[0] == Boundary::kPeriodic ? width_ : 0,
+              boundaries_[1] == Boundary::kPeriodic ? height_ : 0);
+}
+
+void GasContainer::WrapPeriodicAxes(size_t begin, size_t end) {
+  for (size_t axis = 0; axis < 2; axis++) {
+    if (boundaries_[axis] == Boundary::kPeriodic) {
+      particles_.WrapPositions(begin, end, axis, top_left_position_[axis],
+                               bottom_right_position[axis]);
+    }
+  }
+}
+
+void GasContainer::AdvanceEventDriven(float dt) {
+  IDEALGAS_PROFILE_SCOPE("event-driven stepper");
+  if (is_event_driven_stepper_stale_) {
+    event_driven_stepper_.Initialize(particles_, top_left_position_,
+                                     bottom_right_position);
+    is_event_driven_stepper_stale_ = false;
   }
 
-  return -1;
+  // speeds are recorded before moving, like the fixed time step
+  RecordSpeeds(dt);
+  event_driven_stepper_.Advance(particles_, species_, dt,
+                                &chunk_observables_[0]);
 }
 
-void GasContainer::HandleIfWallCollision(Particle &particle) {
-  float position_x = particle.GetPosition()[0];
-  float position_y = particle.GetPosition()[1];
-  float radius = particle.GetRadius();
+void GasContainer::AdvanceAdaptive(float dt) {
+  // speeds are recorded before moving, like the fixed time step
+  RecordSpeeds(dt);
 
-  bool is_touching_vertical_wall =
-      position_x - radius <= top_left_position_[0] ||
-      position_x + radius >= bottom_right_position[0];
-  bool is_touching_horizontal_wall =
-      position_y - radius <= top_left_position_[1] ||
-      position_y + radius >= bottom_right_position[1];
+  // CFL-like bound: enough substeps that all but the fastest few particles
+  // move at most kMaxSubstepTravel smallest radii per substep. The speeds
+  // have a long tail, so bounding the fastest one would take many more
+  // substeps; the few particles above the bound are swept instead.
+  substep_speeds_.clear();
+  for (const vector<float> &speeds : species_speeds_) {
+    substep_speeds_.insert(substep_speeds_.end(), speeds.begin(),
+                           speeds.end());
+  }
+  float bound_speed = 0;
+  if (!substep_speeds_.empty()) {
+    size_t rank = static_cast<size_t>(kSubstepSpeedQuantile *
+                                      (substep_speeds_.size() - 1));
+    std::nth_element(substep_speeds_.begin(), substep_speeds_.begin() + rank,
+                     substep_speeds_.end());
+    bound_speed = substep_speeds_[rank];
+  }
+  float max_travel = kMaxSubstepTravel * particles_.GetMinRadius();
+  if (max_travel > 0) {
+    float substeps = std::ceil(bound_speed * dt / max_travel);
+    substep_count_ = static_cast<size_t>(std::min(
+        std::max(substeps, 1.0f), static_cast<float>(kMaxSubstepCount)));
+  }
 
-  if (is_touching_vertical_wall) {
-    particle.UpdateVelocityForVerticalWallCollision();
-  } else if (is_touching_horizontal_wall) {
-    particle.UpdateVelocityForHorizontalWallCollision();
+  float substep = dt / static_cast<float>(substep_count_);
+  for (size_t step = 0; step < substep_count_; step++) {
+    AdvanceSubstep(substep);
   }
 }
 
+void GasContainer::AdvanceSubstep(float dt) {
+  IDEALGAS_PROFILE_SCOPE("substep");
+  FindCollidingPairs();
+  FindSweptCollisions(dt);
+  ResolveTimedCollisions();
+
+  IDEALGAS_PROFILE_SCOPE("wall handling and integration");
+  vec2 top_left;
+  vec2 bottom_right;
+  GetWallBounds(top_left, bottom_right);
+  thread_pool_->ParallelFor(
+      particles_.Size(), GetObservableChunkCount(),
+      [this, &top_left, &bottom_right, dt](size_t begin, size_t end,
+                                           size_t chunk) {
+        double impulse = 0;
+        for (size_t i = begin; i < end; i++) {
+          impulse += particles_.ReflectOffWalls(i, top_left, bottom_right, dt);
+        }
+        particles_.Integrate(begin, end, dt);
+        WrapPeriodicAxes(begin, end);
+        chunk_observables_[chunk].wall_impulse += impulse;
+      });
+}
+
+void GasContainer::FindSweptCollisions(float dt) {
+  IDEALGAS_PROFILE_SCOPE("swept collision search");
+  // the touching pairs are already sorted and found once each
+  timed_pairs_.clear();
+  for (const auto &pair : colliding_pairs_) {
+    timed_pairs_.push_back(TimedPair(0, pair));
+  }
+
+  // squared speeds, to skip a square root per particle
+  float max_slow_speed = kMaxSubstepTravel * particles_.GetMinRadius() / dt;
+  float max_slow_speed_squared = max_slow_speed * max_slow_speed;
+  float max_speed_squared = 0;
+  const float *velocities_x = particles_.GetVelocitiesX();
+  const float *velocities_y = particles_.GetVelocitiesY();
+  // the buffers grow as needed and keep their capacity, so they stop
+  // allocating once they have held the most fast particles and candidates
+  // of a frame, without holding room for every particle per thread
+  size_t chunk_count = thread_pool_->GetThreadCount();
+  chunk_candidates_.resize(chunk_count);
+  fast_particles_.clear();
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    float speed_squared =
+        velocities_x[i] * velocities_x[i] + velocities_y[i] * velocities_y[i];
+    max_speed_squared = std::max(max_speed_squared, speed_squared);
+    if (speed_squared > max_slow_speed_squared) {
+      fast_particles_.push_back(i);
+    }
+  }
+  if (fast_particles_.empty()) {
+    return;
+  }
+  float max_distance = std::sqrt(max_speed_squared) * dt;
+
+  // a particle can reach a fast one if it starts within the fast one's swept
+  // box grown by both radii and the distance the other particle moves
+  float margin = particles_.GetMaxRadius() + max_distance;
+  chunk_timed_pairs_.resize(chunk_count);
+  vec2 periods = GetPeriods();
+  thread_pool_->ParallelFor(
+      fast_particles_.size(), chunk_count,
+      [this, dt, margin, &periods](size_t begin, size_t end, size_t chunk) {
+        vector<TimedPair> &pairs = chunk_timed_pairs_[chunk];
+        pairs.clear();
+        vector<size_t> &candidates = chunk_candidates_[chunk];
+        for (size_t f = begin; f < end; f++) {
+          size_t i = fast_particles_[f];
+          float time;
+          auto test_candidate = [&](size_t j) {
+            if (j != i &&
+                FindContactTime(particles_, i, j, periods, dt, time)) {
+              SpatialGrid::IndexPair pair(std::min(i, j), std::max(i, j));
+              pairs.push_back(TimedPair(time, pair));
+            }
+          };
+          if (collision_detection_ == CollisionDetection::kSpatialGrid) {
+            vec2 start = particles_.GetPosition(i);
+            vec2 finish = start + particles_.GetVelocity(i) * dt;
+            float reach = particles_.GetRadius(i) + margin;
+            candidates.clear();
+            spatial_grid_.FindParticlesInBox(
+                vec2(std::min(start.x, finish.x) - reach,
+                     std::min(start.y, finish.y) - reach),
+                vec2(std::max(start.x, finish.x) + reach,
+                     std::max(start.y, finish.y) + reach),
+                candidates);
+            for (size_t j : candidates) {
+              test_candidate(j);
+            }
+          } else {
+            // every particle is a candidate, so skip listing them
+            for (size_t j = 0; j < particles_.Size(); j++) {
+              test_candidate(j);
+            }
+          }
+        }
+      });
+
+  // pairs found by both particles or already touching are kept once
+  for (const auto &pairs : chunk_timed_pairs_) {
+    timed_pairs_.insert(timed_pairs_.end(), pairs.begin(), pairs.end());
+  }
+  std::sort(timed_pairs_.begin(), timed_pairs_.end());
+  timed_pairs_.erase(std::unique(timed_pairs_.begin(), timed_pairs_.end()),
+                     timed_pairs_.end());
+}
+
+void GasContainer::ResolveTimedCollisions() {
+  IDEALGAS_PROFILE_SCOPE("collision resolution");
+  // earliest contacts first, each particle at most once per substep
+  has_collided_.assign(particles_.Size(), 0);
+  resolved_timed_pairs_.clear();
+  for (const auto &timed_pair : timed_pairs_) {
+    const SpatialGrid::IndexPair &pair = timed_pair.second;
+    if (has_collided_[pair.first] || has_collided_[pair.second]) {
+      continue;
+    }
+    resolved_timed_pairs_.push_back(timed_pair);
+    has_collided_[pair.first] = 1;
+    has_collided_[pair.second] = 1;
+  }
+
+  vec2 periods = GetPeriods();
+  thread_pool_->ParallelFor(
+      resolved_timed_pairs_.size(), GetObservableChunkCount(),
+      [this, &periods](size_t begin, size_t end, size_t chunk) {
+        ObservableSums &sums = chunk_observables_[chunk];
+        for (size_t p = begin; p < end; p++) {
+          float time = resolved_timed_pairs_[p].first;
+          size_t first = resolved_timed_pairs_[p].second.first;
+          size_t second = resolved_timed_pairs_[p].second.second;
+          vec2 old_velocity_one = particles_.GetVelocity(first);
+          vec2 old_velocity_two = particles_.GetVelocity(second);
+
+          // collide where the particles touch, then shift them so moving
+          // with the new velocities for the whole substep ends where moving
+          // to the contact and bouncing would
+          particles_.SetPosition(
+              first, particles_.GetPosition(first) + old_velocity_one * time);
+          particles_.SetPosition(
+              second,
+              particles_.GetPosition(second) + old_velocity_two * time);
+          uint8_t species_one = particles_.GetSpeciesId(first);
+          uint8_t species_two = particles_.GetSpeciesId(second);
+          particles_.UpdateVelocitiesForParticleCollision(
+              first, second,
+              species_.GetMassFraction(species_one, species_two),
+              species_.GetMassFraction(species_two, species_one), periods);
+          particles_.SetPosition(first,
+                                 particles_.GetPosition(first) -
+                                     particles_.GetVelocity(first) * time);
+          particles_.SetPosition(second,
+                                 particles_.GetPosition(second) -
+                                     particles_.GetVelocity(second) * time);
+          sums.AddCollision(species_one, species_two);
+        }
+      });
+}
+
 float GasContainer::GetWidth() const {
   return width_;
 }
@@ -170,6 +790,12 @@ float GasContainer::GetHeight() const {
 size_t GasContainer::GetParticleCount() const {
   return particle_count_;
 }
+uint64_t GasContainer::GetFrameCount() const {
+  return frame_count_;
+}
+int GasContainer::GetSeed() const {
+  return seed_;
+}
 const vec2 &GasContainer::GetTopLeftPosition() const {
   return top_left_position_;
 }
@@ -177,25 +803,93 @@ const vec2 &GasContainer::GetBottomRightPosition() const {
   return bottom_right_position;
 }
 const vector<Particle> &GasContainer::GetParticles() const {
+  if (is_snapshot_stale_) {
+    particles_snapshot_.clear();
+    particles_snapshot_.reserve(particles_.Size());
+    for (size_t i = 0; i < particles_.Size(); i++) {
+      const Species &species = species_.Get(particles_.GetSpeciesId(i));
+      particles_snapshot_.push_back(Particle(
+          particles_.GetPosition(i), particles_.GetVelocity(i), species.color,
+          particles_.GetRadius(i), particles_.GetMass(i), species.name));
+    }
+    is_snapshot_stale_ = false;
+  }
+  return particles_snapshot_;
+}
+const ParticleStore &GasContainer::GetParticleStore() const {
   return particles_;
 }
-const std::map<std::string, vector<float>> &GasContainer::GetParticleSpeeds()
-    const {
-  return particle_speeds_;
+void GasContainer::GenerateParticles(size_t begin, size_t end,
+                                     ParticleStore &particles) const {
+  if (species_.IsEmpty() && begin < end) {
+    throw std::invalid_argument("GasContainer needs at least one species");
+  }
+  particles.Resize(end - begin);
+  for (size_t i = begin; i < end; i++) {
+    GenerateRandomParticle(i, particles, i - begin);
+  }
+}
+std::map<string, vector<float>> GasContainer::GetParticleSpeeds() const {
+  std::map<string, vector<float>> particle_speeds;
+  for (size_t id = 0; id < species_.Size(); id++) {
+    particle_speeds[species_.Get(static_cast<uint8_t>(id)).name] =
+        species_speeds_[id];
+  }
+  return particle_speeds;
+}
+const vector<float> &GasContainer::GetSpeciesSpeeds(uint8_t species_id) const {
+  return species_speeds_[species_id];
+}
+const SpeciesRegistry &GasContainer::GetSpecies() const {
+  return species_;
+}
+void GasContainer::InitializeSpeciesSpeeds() {
+  // clearing rather than replacing the vectors keeps their capacity, so
+  // recording the speeds every frame doesn't allocate
+  species_speeds_.resize(species_.Size());
+  for (vector<float> &speeds : species_speeds_) {
+    speeds.clear();
+  }
 }
-void GasContainer::InitializeParticleSpeedsMap() {
-  particle_speeds_ = {{kBlueParticleType, vector<float>()},
-                      {kRedParticleType, vector<float>()},
-                      {kGreenParticleType, vector<float>()}};
+void GasContainer::UpdateSpeciesSpeeds() {
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    species_speeds_[particles_.GetSpeciesId(i)].push_back(
+        particles_.GetSpeed(i));
+  }
 }
-void GasContainer::UpdateParticlesSpeedMap() {
-  for (const auto &particle : particles_) {
+void GasContainer::RecordSpeeds(float dt) {
+  IDEALGAS_PROFILE_SCOPE("speed bookkeeping");
+  InitializeSpeciesSpeeds();
+  const float *inverse_masses = particles_.GetInverseMasses();
+  double energy = 0;
+  double distance = 0;
+  for (size_t i = 0; i < particles_.Size(); i++) {
+    float speed = particles_.GetSpeed(i);
+    species_speeds_[particles_.GetSpeciesId(i)].push_back(speed);
+    energy += speed * speed / inverse_masses[i];
+    distance += speed;
   }
+  chunk_observables_[0].energy_time += 0.5 * energy * dt;
+  chunk_observables_[0].distance += distance * dt;
+}
+size_t GasContainer::GetObservableChunkCount() const {
+  return is_deterministic_ ? kDeterministicChunkCount
+                           : thread_pool_->GetThreadCount();
 }
-void GasContainer::ClearParticleSpeedsMapVectors() {
-  particle_speeds_.at(kBlueParticleType).clear();
-  particle_speeds_.at(kRedParticleType).clear();
-  particle_speeds_.at(kGreenParticleType).clear();
+void GasContainer::BeginFrameObservables() {
+  chunk_observables_.resize(GetObservableChunkCount());
+  for (ObservableSums &sums : chunk_observables_) {
+    sums.Clear(species_.Size());
+  }
+}
+void GasContainer::EndFrameObservables(float dt) {
+  IDEALGAS_PROFILE_SCOPE("observables");
+  frame_observables_.Clear(species_.Size());
+  for (const ObservableSums &sums : chunk_observables_) {
+    frame_observables_.Add(sums);
+  }
+  frame_observables_.time = dt;
+  observables_window_.Add(frame_observables_);
 }
 
 }  // namespace idealgas
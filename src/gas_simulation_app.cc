@@ -1,15 +1,26 @@
 #include "gas_simulation_app.h"
 
-using std::map;
-using std::string;
-using std::vector;
+#include "profiler.h"
+
 using glm::vec2;
 
 namespace idealgas {
 
+namespace {
+
+SimulationThreadOptions MakeSimulationOptions(double steps_per_second) {
+  SimulationThreadOptions options;
+  options.steps_per_second = steps_per_second;
+  return options;
+}
+
+}  // namespace
+
 IdealGasApp::IdealGasApp()
-    : container_(kParticleCount, vec2(kGasTopLeftX, kGasTopLeftY),
-                 vec2(kGasWidth, kGasHeight), kRandomSeed),
+    : simulation_(GasContainer(kParticleCount,
+                               vec2(kGasTopLeftX, kGasTopLeftY),
+                               vec2(kGasWidth, kGasHeight), kRandomSeed),
+                  MakeSimulationOptions(kStepsPerSecond)),
       blue_particle_histogram(vec2(kHistogramX, kBlueHistogramY),
                               kHistogramDimension, kBlueHistogramColor,
                               kHistogramAxisLabelColor, kBlueXAxisLabel,
@@ -21,29 +32,46 @@ IdealGasApp::IdealGasApp()
       green_particle_histogram(vec2(kHistogramX, kGreenHistogramY),
                                kHistogramDimension, kGreenHistogramColor,
                                kHistogramAxisLabelColor, kGreenXAxisLabel,
-                               kYAxisLabel) {
+                               kYAxisLabel),
+      blue_speed_distribution_(kHistogramMaxSpeed, histogram_num_bins_),
+      red_speed_distribution_(kHistogramMaxSpeed, histogram_num_bins_),
+      green_speed_distribution_(kHistogramMaxSpeed, histogram_num_bins_) {
   ci::app::setWindowSize(kWindowSize, kWindowSize);
+
+  // the type names are constants, so they can be read while the simulation
+  // thread runs
+  const GasContainer& container = simulation_.GetContainer();
+  const SpeciesRegistry& species = simulation_.GetSpecies();
+  blue_species_id_ = species.GetId(container.kBlueParticleType);
+  red_species_id_ = species.GetId(container.kRedParticleType);
+  green_species_id_ = species.GetId(container.kGreenParticleType);
 }
 
 void IdealGasApp::draw() {
   ci::Color background_color("black");
   ci::gl::clear(background_color);
 
-  container_.Display();
-  blue_particle_histogram.Draw();
-  red_particle_histogram.Draw();
-  green_particle_histogram.Draw();
+  DrawParticles(simulation_.GetSnapshot().particles, simulation_.GetSpecies(),
+                simulation_.GetTopLeftPosition(),
+                simulation_.GetBottomRightPosition());
+  DrawHistogram(blue_particle_histogram);
+  DrawHistogram(red_particle_histogram);
+  DrawHistogram(green_particle_histogram);
 }
 
 void IdealGasApp::update() {
-  container_.AdvanceOneFrame();
-  map<string, vector<float>> speeds = container_.GetParticleSpeeds();
-  blue_particle_histogram.UpdateData(speeds.at(container_.kBlueParticleType),
-                                     histogram_num_bins_);
-  red_particle_histogram.UpdateData(speeds.at(container_.kRedParticleType),
-                                    histogram_num_bins_);
-  green_particle_histogram.UpdateData(speeds.at(container_.kGreenParticleType),
-                                      histogram_num_bins_);
+  IDEALGAS_PROFILE_SCOPE("app update");
+  if (!simulation_.AcquireSnapshot()) {
+    return;
+  }
+  const SimulationSnapshot& snapshot = simulation_.GetSnapshot();
+  blue_speed_distribution_.AddFrame(snapshot.species_speeds[blue_species_id_]);
+  red_speed_distribution_.AddFrame(snapshot.species_speeds[red_species_id_]);
+  green_speed_distribution_.AddFrame(
+      snapshot.species_speeds[green_species_id_]);
+  blue_particle_histogram.UpdateData(blue_speed_distribution_);
+  red_particle_histogram.UpdateData(red_speed_distribution_);
+  green_particle_histogram.UpdateData(green_speed_distribution_);
 }
 
 }  // namespace idealgas
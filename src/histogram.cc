@@ -1,5 +1,11 @@
 #include <histogram.h>
-#include <math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "profiler.h"
 
 using glm::vec2;
 using std::string;
@@ -8,123 +14,164 @@ using std::vector;
 namespace idealgas {
 
 Histogram::Histogram(const glm::vec2& position, const glm::vec2& dimension,
-                     const ci::Color& bar_color,
-                     const ci::Color& axis_label_color,
+                     const Color& bar_color, const Color& axis_label_color,
                      std::string x_axis_label, std::string y_axis_label) {
   position_ = position;
   width_ = dimension[0];
   height_ = dimension[1];
   bar_color_ = bar_color;
   axis_label_color_ = axis_label_color;
-  bins_ = vector<int>();
+  bins_ = vector<float>();
   x_axis_label_ = x_axis_label;
   y_axis_label_ = y_axis_label;
 }
-const ci::Color& Histogram::GetBarColor() const {
+const Color& Histogram::GetBarColor() const {
   return bar_color_;
 }
 const glm::vec2& Histogram::GetPosition() const {
   return position_;
 }
-std::string Histogram::GetXLabel() const {
+const std::string& Histogram::GetXLabel() const {
   return x_axis_label_;
 }
-std::string Histogram::GetYLabel() const {
+const std::string& Histogram::GetYLabel() const {
   return y_axis_label_;
 }
-void Histogram::DrawAxis() {
-  ci::gl::color(axis_label_color_);
-  // draw y axis
-  ci::gl::drawLine(vec2(position_[0], position_[1]),
-                   vec2(position_[0], position_[1] + height_));
-
-  // draw x axis
-  ci::gl::drawLine(vec2(position_[0], position_[1] + height_),
-                   vec2(position_[0] + width_, position_[1] + height_));
-}
-void Histogram::DrawLabels() {
-  ci::gl::color(axis_label_color_);
-  vec2 x_label_position =
-      vec2(position_[0] + (width_ / 2), position_[1] + height_ + kXLabelMargin);
-  ci::gl::drawStringCentered(x_axis_label_, x_label_position, axis_label_color_,
-                             ci::Font("Arial", 20));
-
-  vec2 y_label_position =
-      vec2(position_[0] - kYLabelMargin, position_[1] + (height_ / 2));
-  ci::gl::drawString(y_axis_label_, y_label_position, axis_label_color_,
-                     ci::Font("Arial", 20));
+void Histogram::UpdateData(const std::vector<float>& data, int num_bins) {
+  UpdateData(data.data(), data.data() + data.size(), num_bins);
 }
-void Histogram::DrawBars() {
-  if (bins_.empty()) {
+void Histogram::UpdateData(const float* begin, const float* end,
+                           int num_bins) {
+  UpdateBins(begin, end, num_bins, 1, nullptr);
+}
+void Histogram::UpdateData(const float* begin, const float* end, int num_bins,
+                           ThreadPool& thread_pool) {
+  UpdateBins(begin, end, num_bins, thread_pool.GetThreadCount(),
+             &thread_pool);
+}
+void Histogram::UpdateData(const SpeedDistribution& distribution) {
+  const std::vector<uint64_t>& counts = distribution.GetBinCounts();
+  uint64_t frame_count = distribution.GetFrameCount();
+  bar_width_ = width_ / static_cast<float>(counts.size());
+  bins_.assign(counts.size(), 0);
+  if (frame_count == 0) {
     return;
   }
-
-  // find max frequency to find how much each y axis data point should go up by
-  int max_freq = 0;
-  for (const auto& frequency : bins_) {
-    max_freq = std::max(static_cast<int>(frequency), max_freq);
-  }
-
-  float y_step =
-      height_ / max_freq;  // number of pixels per one frequency value
-  float bottom_y = position_[1] + height_;  // bottom y coord of the bar
-  float left_x = position_[0];  // increments by bar width for each iteration
-
-  ci::gl::color(bar_color_);
-  for (const auto& value : bins_) {
-    float top_y = (position_[1] + height_) - (y_step * value);
-    ci::gl::drawSolidRect(
-        ci::Rectf(vec2(left_x, top_y), vec2(left_x + bar_width_, bottom_y)));
-    left_x += bar_width_;
+  for (size_t bin = 0; bin < counts.size(); bin++) {
+    bins_[bin] = static_cast<float>(static_cast<double>(counts[bin]) /
+                                    static_cast<double>(frame_count));
   }
 }
-void Histogram::UpdateData(std::vector<float> data, int num_bins) {
+void Histogram::UpdateBins(const float* begin, const float* end, int num_bins,
+                           size_t chunk_count, ThreadPool* thread_pool) {
+  IDEALGAS_PROFILE_SCOPE("histogram update");
+
   // clear out previous data entry
   bins_.clear();
 
-  if (data.empty()) {
+  if (begin == end || num_bins <= 0) {
     return;
   }
-
-  // sort in ascending order
-  std::sort(data.begin(), data.end());
-
-  float range = data[data.size() - 1] - data[0];  // max - min
-  float bin_size = range / static_cast<float>(num_bins);
   bar_width_ =
       width_ / static_cast<float>(num_bins);  // pixel width of each bar
 
-  float bin_min = data[0];             // (inclusive)
-  float bin_max = bin_min + bin_size;  // (exclusive)
+  size_t count = end - begin;
+  auto run = [thread_pool, count, chunk_count](
+                 const ThreadPool::RangeFunction& body) {
+    if (thread_pool != nullptr) {
+      thread_pool->ParallelFor(count, chunk_count, body);
+    } else {
+      body(0, count, 0);
+    }
+  };
+
+  // first pass: range of the data
+  chunk_minimums_.assign(chunk_count, std::numeric_limits<float>::max());
+  chunk_maximums_.assign(chunk_count, std::numeric_limits<float>::lowest());
+  run([this, begin](size_t first, size_t last, size_t chunk) {
+    float minimum = chunk_minimums_[chunk];
+    float maximum = chunk_maximums_[chunk];
+    for (size_t i = first; i < last; i++) {
+      minimum = std::min(minimum, begin[i]);
+      maximum = std::max(maximum, begin[i]);
+    }
+    chunk_minimums_[chunk] = minimum;
+    chunk_maximums_[chunk] = maximum;
+  });
+  float data_min =
+      *std::min_element(chunk_minimums_.begin(), chunk_minimums_.end());
+  float data_max =
+      *std::max_element(chunk_maximums_.begin(), chunk_maximums_.end());
+
+  float bin_min = data_min;
+  float bin_max = data_max;
+  if (has_fixed_range_) {
+    // widen until every value fits
+    while (data_max > range_max_ && std::isfinite(data_max)) {
+      range_max_ = range_min_ + 2 * (range_max_ - range_min_);
+    }
+    bin_min = range_min_;
+    bin_max = range_max_;
+  }
 
-  // count frequencies in data and add to bin collection
-  bins_.push_back(0);  // add 0 for first value
-  for (float value : data) {
-    if (value >= bin_max) {  // transition to new bin if necessary
-      bin_min = bin_max;
-      bin_max = bin_min + bin_size;
-      bins_.push_back(0);
+  // second pass: each value goes straight to its bin. Values on the upper
+  // edge go in the last bin
+  float bins_per_unit =
+      bin_max > bin_min ? num_bins / (bin_max - bin_min) : 0;
+  int last_bin = num_bins - 1;
+  chunk_bins_.assign(chunk_count * num_bins, 0);
+  run([this, begin, num_bins, bin_min, bins_per_unit, last_bin](
+          size_t first, size_t last, size_t chunk) {
+    int* bins = &chunk_bins_[chunk * num_bins];
+    for (size_t i = first; i < last; i++) {
+      float position = (begin[i] - bin_min) * bins_per_unit;
+      int bin = 0;
+      if (position >= last_bin) {
+        bin = last_bin;
+      } else if (position >= 1) {
+        bin = static_cast<int>(position);
+      }
+      bins[bin]++;
     }
-    if (value >= bin_min && value < bin_max) {  // increment freq in bin
-      bins_[bins_.size() - 1] = bins_[bins_.size() - 1] + 1;
+  });
+
+  bins_.assign(num_bins, 0);
+  for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+    for (int bin = 0; bin < num_bins; bin++) {
+      bins_[bin] += static_cast<float>(chunk_bins_[chunk * num_bins + bin]);
     }
   }
 }
-void Histogram::Draw() {
-  DrawBars();
-  DrawAxis();
-  DrawLabels();
+void Histogram::SetRange(float min, float max) {
+  if (!(max > min)) {
+    throw std::invalid_argument("Histogram range must have max > min");
+  }
+  has_fixed_range_ = true;
+  range_min_ = min;
+  range_max_ = max;
+}
+void Histogram::ClearRange() {
+  has_fixed_range_ = false;
+}
+bool Histogram::HasFixedRange() const {
+  return has_fixed_range_;
+}
+float Histogram::GetRangeMin() const {
+  return range_min_;
+}
+float Histogram::GetRangeMax() const {
+  return range_max_;
 }
 float Histogram::GetBarWidth() const {
   return bar_width_;
 }
-const std::vector<int>& Histogram::GetBins() const {
+const std::vector<float>& Histogram::GetBins() const {
   return bins_;
 }
 const glm::vec2 Histogram::GetDimensions() const {
   return vec2(width_, height_);
 }
-const ci::Color& Histogram::GetAxisLabelColor() const {
+const Color& Histogram::GetAxisLabelColor() const {
   return axis_label_color_;
 }
 
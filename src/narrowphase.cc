@@ -0,0 +1,291 @@
+#include "narrowphase.h"
+
+#include <stdexcept>
+#include <string>
+
+// the SIMD kernels need GCC or Clang, for the target attribute and the CPU
+// feature checks
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IDEALGAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace idealgas {
+
+const size_t Narrowphase::kBlockSize;
+
+ParticleArrays::ParticleArrays(const ParticleStore& particles)
+    : positions_x(particles.GetPositionsX()),
+      positions_y(particles.GetPositionsY()),
+      velocities_x(particles.GetVelocitiesX()),
+      velocities_y(particles.GetVelocitiesY()),
+      radii(particles.GetRadii()) {
+}
+
+namespace {
+
+template <bool kIsPeriodic>
+uint32_t FindContactsScalar(const ParticleArrays& particles, size_t index,
+                            size_t begin, size_t count) {
+  float x = particles.positions_x[index];
+  float y = particles.positions_y[index];
+  float vx = particles.velocities_x[index];
+  float vy = particles.velocities_y[index];
+  float radius = particles.radii[index];
+
+  uint32_t contacts = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t candidate = begin + i;
+    float dx = particles.positions_x[candidate] - x;
+    float dy = particles.positions_y[candidate] - y;
+    if (kIsPeriodic) {
+      dx = GetMinimumImage(dx, particles.period_x);
+      dy = GetMinimumImage(dy, particles.period_y);
+    }
+    float dvx = particles.velocities_x[candidate] - vx;
+    float dvy = particles.velocities_y[candidate] - vy;
+    float radius_sum = particles.radii[candidate] + radius;
+
+    bool is_touching = dx * dx + dy * dy <= radius_sum * radius_sum;
+    float approach = dx * dvx + dy * dvy;
+    float drift = dvx * dvx + dvy * dvy;
+    bool is_approaching = approach + approach + drift < 0;
+    if (is_touching && is_approaching) {
+      contacts |= uint32_t(1) << i;
+    }
+  }
+  return contacts;
+}
+
+#if defined(IDEALGAS_X86_KERNELS) && defined(__SSE2__)
+/**
+ * GetMinimumImage of each lane: subtracts the period where offset is above
+ * half of it and adds it where offset is below minus half of it
+ */
+inline __m128 GetMinimumImageSse2(__m128 offset, __m128 period,
+                                  __m128 half_period) {
+  __m128 above = _mm_and_ps(_mm_cmpgt_ps(offset, half_period), period);
+  __m128 below = _mm_and_ps(
+      _mm_cmplt_ps(offset, _mm_sub_ps(_mm_setzero_ps(), half_period)), period);
+  return _mm_sub_ps(offset, _mm_sub_ps(above, below));
+}
+
+template <bool kIsPeriodic>
+uint32_t FindContactsSse2(const ParticleArrays& particles, size_t index,
+                          size_t begin, size_t count) {
+  __m128 x = _mm_set1_ps(particles.positions_x[index]);
+  __m128 y = _mm_set1_ps(particles.positions_y[index]);
+  __m128 vx = _mm_set1_ps(particles.velocities_x[index]);
+  __m128 vy = _mm_set1_ps(particles.velocities_y[index]);
+  __m128 radius = _mm_set1_ps(particles.radii[index]);
+  __m128 zero = _mm_setzero_ps();
+  __m128 period_x = _mm_set1_ps(particles.period_x);
+  __m128 period_y = _mm_set1_ps(particles.period_y);
+  __m128 half_period_x = _mm_set1_ps(particles.period_x / 2);
+  __m128 half_period_y = _mm_set1_ps(particles.period_y / 2);
+
+  uint32_t contacts = 0;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    size_t candidate = begin + i;
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(particles.positions_x + candidate), x);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(particles.positions_y + candidate), y);
+    if (kIsPeriodic) {
+      dx = GetMinimumImageSse2(dx, period_x, half_period_x);
+      dy = GetMinimumImageSse2(dy, period_y, half_period_y);
+    }
+    __m128 dvx =
+        _mm_sub_ps(_mm_loadu_ps(particles.velocities_x + candidate), vx);
+    __m128 dvy =
+        _mm_sub_ps(_mm_loadu_ps(particles.velocities_y + candidate), vy);
+    __m128 radius_sum =
+        _mm_add_ps(_mm_loadu_ps(particles.radii + candidate), radius);
+
+    __m128 distance_squared =
+        _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    __m128 is_touching =
+        _mm_cmple_ps(distance_squared, _mm_mul_ps(radius_sum, radius_sum));
+    __m128 approach = _mm_add_ps(_mm_mul_ps(dx, dvx), _mm_mul_ps(dy, dvy));
+    __m128 drift = _mm_add_ps(_mm_mul_ps(dvx, dvx), _mm_mul_ps(dvy, dvy));
+    __m128 is_approaching = _mm_cmplt_ps(
+        _mm_add_ps(_mm_add_ps(approach, approach), drift), zero);
+
+    uint32_t lanes = static_cast<uint32_t>(
+        _mm_movemask_ps(_mm_and_ps(is_touching, is_approaching)));
+    contacts |= lanes << i;
+  }
+
+  if (i < count) {
+    contacts |= FindContactsScalar<kIsPeriodic>(particles, index, begin + i,
+                                                count - i)
+                << i;
+  }
+  return contacts;
+}
+#endif
+
+#if defined(IDEALGAS_X86_KERNELS)
+/** GetMinimumImageSse2 for 8 lanes **/
+__attribute__((target("avx2"))) inline __m256 GetMinimumImageAvx2(
+    __m256 offset, __m256 period, __m256 half_period) {
+  __m256 above = _mm256_and_ps(
+      _mm256_cmp_ps(offset, half_period, _CMP_GT_OQ), period);
+  __m256 below = _mm256_and_ps(
+      _mm256_cmp_ps(offset, _mm256_sub_ps(_mm256_setzero_ps(), half_period),
+                    _CMP_LT_OQ),
+      period);
+  return _mm256_sub_ps(offset, _mm256_sub_ps(above, below));
+}
+
+// no FMA, so the products are rounded exactly like the other kernels
+template <bool kIsPeriodic>
+__attribute__((target("avx2"))) uint32_t FindContactsAvx2(
+    const ParticleArrays& particles, size_t index, size_t begin,
+    size_t count) {
+  // grid cells hold only a few particles, and for runs shorter than one
+  // vector, setting up the 256-bit registers costs more than it saves
+  if (count < 8) {
+    return FindContactsScalar<kIsPeriodic>(particles, index, begin, count);
+  }
+  __m256 x = _mm256_set1_ps(particles.positions_x[index]);
+  __m256 y = _mm256_set1_ps(particles.positions_y[index]);
+  __m256 vx = _mm256_set1_ps(particles.velocities_x[index]);
+  __m256 vy = _mm256_set1_ps(particles.velocities_y[index]);
+  __m256 radius = _mm256_set1_ps(particles.radii[index]);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 period_x = _mm256_set1_ps(particles.period_x);
+  __m256 period_y = _mm256_set1_ps(particles.period_y);
+  __m256 half_period_x = _mm256_set1_ps(particles.period_x / 2);
+  __m256 half_period_y = _mm256_set1_ps(particles.period_y / 2);
+
+  uint32_t contacts = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    size_t candidate = begin + i;
+    __m256 dx =
+        _mm256_sub_ps(_mm256_loadu_ps(particles.positions_x + candidate), x);
+    __m256 dy =
+        _mm256_sub_ps(_mm256_loadu_ps(particles.positions_y + candidate), y);
+    if (kIsPeriodic) {
+      dx = GetMinimumImageAvx2(dx, period_x, half_period_x);
+      dy = GetMinimumImageAvx2(dy, period_y, half_period_y);
+    }
+    __m256 dvx =
+        _mm256_sub_ps(_mm256_loadu_ps(particles.velocities_x + candidate), vx);
+    __m256 dvy =
+        _mm256_sub_ps(_mm256_loadu_ps(particles.velocities_y + candidate), vy);
+    __m256 radius_sum =
+        _mm256_add_ps(_mm256_loadu_ps(particles.radii + candidate), radius);
+
+    __m256 distance_squared =
+        _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    __m256 is_touching =
+        _mm256_cmp_ps(distance_squared, _mm256_mul_ps(radius_sum, radius_sum),
+                      _CMP_LE_OQ);
+    __m256 approach =
+        _mm256_add_ps(_mm256_mul_ps(dx, dvx), _mm256_mul_ps(dy, dvy));
+    __m256 drift =
+        _mm256_add_ps(_mm256_mul_ps(dvx, dvx), _mm256_mul_ps(dvy, dvy));
+    __m256 is_approaching = _mm256_cmp_ps(
+        _mm256_add_ps(_mm256_add_ps(approach, approach), drift), zero,
+        _CMP_LT_OQ);
+
+    uint32_t lanes = static_cast<uint32_t>(
+        _mm256_movemask_ps(_mm256_and_ps(is_touching, is_approaching)));
+    contacts |= lanes << i;
+  }
+
+  if (i < count) {
+    contacts |= FindContactsScalar<kIsPeriodic>(particles, index, begin + i,
+                                                count - i)
+                << i;
+  }
+  return contacts;
+}
+#endif
+
+}  // namespace
+
+Narrowphase::Narrowphase() : Narrowphase(GetBestKernel()) {
+}
+
+Narrowphase::Narrowphase(Kernel kernel) {
+  if (!IsSupported(kernel)) {
+    throw std::invalid_argument(std::string("Narrowphase kernel ") +
+                                GetKernelName(kernel) +
+                                " is not supported on this CPU");
+  }
+  kernel_ = kernel;
+  find_contacts_ = FindContactsScalar<false>;
+  find_periodic_contacts_ = FindContactsScalar<true>;
+#if defined(IDEALGAS_X86_KERNELS) && defined(__SSE2__)
+  if (kernel == Kernel::kSse2) {
+    find_contacts_ = FindContactsSse2<false>;
+    find_periodic_contacts_ = FindContactsSse2<true>;
+  }
+#endif
+#if defined(IDEALGAS_X86_KERNELS)
+  if (kernel == Kernel::kAvx2) {
+    find_contacts_ = FindContactsAvx2<false>;
+    find_periodic_contacts_ = FindContactsAvx2<true>;
+  }
+#endif
+}
+
+uint32_t Narrowphase::FindContacts(const ParticleArrays& particles,
+                                   size_t index, size_t begin,
+                                   size_t count) const {
+  // the wrapping costs a few instructions per candidate, so it is only done
+  // when some axis is periodic
+  if (particles.period_x != 0 || particles.period_y != 0) {
+    return find_periodic_contacts_(particles, index, begin, count);
+  }
+  return find_contacts_(particles, index, begin, count);
+}
+
+Narrowphase::Kernel Narrowphase::GetKernel() const {
+  return kernel_;
+}
+
+bool Narrowphase::IsSupported(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kScalar:
+      return true;
+    case Kernel::kSse2:
+#if defined(IDEALGAS_X86_KERNELS) && defined(__SSE2__)
+      return true;
+#else
+      return false;
+#endif
+    case Kernel::kAvx2:
+#if defined(IDEALGAS_X86_KERNELS)
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+Narrowphase::Kernel Narrowphase::GetBestKernel() {
+  if (IsSupported(Kernel::kAvx2)) {
+    return Kernel::kAvx2;
+  } else if (IsSupported(Kernel::kSse2)) {
+    return Kernel::kSse2;
+  }
+  return Kernel::kScalar;
+}
+
+const char* Narrowphase::GetKernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kScalar:
+      return "scalar";
+    case Kernel::kSse2:
+      return "sse2";
+    case Kernel::kAvx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+}  // namespace idealgas
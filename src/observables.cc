@@ -0,0 +1,114 @@
+#include "observables.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace idealgas {
+
+const size_t ObservablesWindow::kDefaultFrameCount;
+
+void ObservableSums::Clear(size_t species) {
+  time = 0;
+  wall_impulse = 0;
+  energy_time = 0;
+  distance = 0;
+  species_count = species;
+  pair_collision_counts.assign(species * species, 0);
+}
+
+void ObservableSums::AddCollision(uint8_t species_one, uint8_t species_two) {
+  size_t low = std::min(species_one, species_two);
+  size_t high = std::max(species_one, species_two);
+  pair_collision_counts[low * species_count + high]++;
+}
+
+void ObservableSums::Add(const ObservableSums& other) {
+  time += other.time;
+  wall_impulse += other.wall_impulse;
+  energy_time += other.energy_time;
+  distance += other.distance;
+  if (species_count != other.species_count) {
+    throw std::invalid_argument("Observable sums of different species");
+  }
+  for (size_t i = 0; i < pair_collision_counts.size(); i++) {
+    pair_collision_counts[i] += other.pair_collision_counts[i];
+  }
+}
+
+ObservablesWindow::ObservablesWindow(size_t frame_count) {
+  SetFrameCount(frame_count);
+}
+
+void ObservablesWindow::SetFrameCount(size_t frame_count) {
+  if (frame_count == 0) {
+    throw std::invalid_argument("The window needs at least one frame");
+  }
+  frames_.resize(frame_count);
+  Clear();
+}
+
+size_t ObservablesWindow::GetFrameCount() const {
+  return frames_.size();
+}
+
+void ObservablesWindow::Add(const ObservableSums& frame) {
+  // assigning into the slot reuses its pair counts
+  frames_[next_frame_] = frame;
+  next_frame_ = (next_frame_ + 1) % frames_.size();
+  size_ = std::min(size_ + 1, frames_.size());
+}
+
+void ObservablesWindow::Clear() {
+  next_frame_ = 0;
+  size_ = 0;
+}
+
+Observables ObservablesWindow::GetAverages(size_t particle_count,
+                                           double wall_length) const {
+  Observables observables;
+  if (size_ == 0) {
+    return observables;
+  }
+
+  // the slots in use are the size_ before next_frame_, wrapping around
+  size_t first = (next_frame_ + frames_.size() - size_) % frames_.size();
+  ObservableSums total = frames_[first];
+  for (size_t i = 1; i < size_; i++) {
+    total.Add(frames_[(first + i) % frames_.size()]);
+  }
+  observables.frame_count = size_;
+  observables.time = total.time;
+  if (total.time <= 0) {
+    return observables;
+  }
+
+  size_t species_count = total.species_count;
+  uint64_t collision_count = 0;
+  observables.pair_collision_rates.assign(species_count * species_count, 0);
+  for (size_t a = 0; a < species_count; a++) {
+    for (size_t b = a; b < species_count; b++) {
+      uint64_t count = total.pair_collision_counts[a * species_count + b];
+      collision_count += count;
+      double rate = count / total.time;
+      observables.pair_collision_rates[a * species_count + b] = rate;
+      observables.pair_collision_rates[b * species_count + a] = rate;
+    }
+  }
+
+  if (wall_length > 0) {
+    observables.pressure = total.wall_impulse / (total.time * wall_length);
+  }
+  observables.kinetic_energy = total.energy_time / total.time;
+  if (particle_count > 0) {
+    // each collision ends a free path of both of its particles
+    observables.temperature = observables.kinetic_energy / particle_count;
+    observables.collision_frequency =
+        2.0 * collision_count / (particle_count * total.time);
+  }
+  if (collision_count > 0) {
+    observables.mean_free_path = total.distance / (2.0 * collision_count);
+  }
+  return observables;
+}
+
+}  // namespace idealgas
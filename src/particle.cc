@@ -3,13 +3,15 @@
 //
 #include <particle.h>
 
+#include <cmath>
+
 using glm::vec2;
 using std::string;
 
 namespace idealgas {
 
 Particle::Particle(glm::vec2 position, glm::vec2 velocity,
-                   ci::Color particle_color, float radius, float mass,
+                   Color particle_color, float radius, float mass,
                    string type_name) {
   position_ = position;
   velocity_ = velocity;
@@ -21,7 +23,7 @@ Particle::Particle(glm::vec2 position, glm::vec2 velocity,
 const glm::vec2& Particle::GetPosition() const {
   return position_;
 }
-ci::Color Particle::GetColor() const {
+Color Particle::GetColor() const {
   return color_;
 }
 const glm::vec2& Particle::GetVelocity() const {
@@ -34,33 +36,25 @@ void Particle::Move() {
   position_ += velocity_;
 }
 bool Particle::IsTouching(const Particle& other_particle) const {
-  // get distance between the 2 particles
-  float distance = fabs(glm::distance(position_, other_particle.position_));
-
-  // checks if particles are touching
-  return distance <= (radius_ + other_particle.radius_);
+  // compare squared distances to avoid the square root
+  vec2 position_difference = other_particle.position_ - position_;
+  float radius_sum = radius_ + other_particle.radius_;
+  return glm::dot(position_difference, position_difference) <=
+         radius_sum * radius_sum;
 }
 bool Particle::IsApproaching(const Particle& other_particle) const {
   // logic is derived from this explanation:
   // https://math.stackexchange.com/a/1438045/824233
 
   // make particle 1 the observer and all else relative to particle 1
-  vec2 particle_1_position = position_ - position_;
-  vec2 particle_2_position = other_particle.position_ - position_;
-
-  // do same thing for velocities: make them relative to particle 1
-  vec2 particle_1_velocity = velocity_ - velocity_;
-  vec2 particle_2_velocity = other_particle.velocity_ - velocity_;
-
-  // now evaluate if particle 2 velocity is in direction of particle 1 (origin)
-  float old_distance =
-      fabs(glm::distance(particle_2_position, particle_1_position));
-  float new_distance = fabs(glm::distance(
-      particle_2_position + particle_2_velocity, particle_1_position));
-
-  // if the new distance is shorter than the old distance,
-  // then particle 2 is getting closer to (i.e. approaching) particle 1
-  return new_distance < old_distance;
+  vec2 position_difference = other_particle.position_ - position_;
+  vec2 velocity_difference = other_particle.velocity_ - velocity_;
+
+  // particle 2 is approaching if it is closer after one more step:
+  // |d + v|^2 < |d|^2, which simplifies to 2 * d.v + v.v < 0
+  float approach = glm::dot(position_difference, velocity_difference);
+  float drift = glm::dot(velocity_difference, velocity_difference);
+  return 2 * approach + drift < 0;
 }
 void Particle::UpdateVelocitiesForParticleCollision(
     Particle& colliding_particle) {
@@ -75,23 +69,9 @@ void Particle::UpdateVelocitiesForParticleCollision(
 
 glm::vec2 Particle::ComputeVelocityForParticleCollision(Particle& particle1,
                                                         Particle& particle2) {
-  // calculate difference between velocities & distance between particle 1 & 2
-  vec2 velocity_difference = particle1.velocity_ - particle2.velocity_;
-  vec2 distance = particle1.position_ - particle2.position_;
-
-  // compute the squared length of the distance vector
-  float squared_length_of_distance = glm::length2(distance);
-
-  // compute mass fraction
-  float mass_fraction =
-      2 * particle2.mass_ / (particle1.mass_ + particle2.mass_);
-
-  // compute the fraction in the equation that multiplies the distance vector
-  float multiplier = mass_fraction * (glm::dot(velocity_difference, distance) /
-                                      squared_length_of_distance);
-
-  // return the final answer using the equation described in method docs
-  return particle1.velocity_ - (multiplier * distance);
+  return ComputeCollisionVelocity(particle1.position_, particle1.velocity_,
+                                  particle1.mass_, particle2.position_,
+                                  particle2.velocity_, particle2.mass_);
 }
 
 void Particle::UpdateVelocityForVerticalWallCollision() {
@@ -103,7 +83,7 @@ void Particle::UpdateVelocityForHorizontalWallCollision() {
 float Particle::GetSpeed() const {
   return glm::length(velocity_);
 }
-std::string Particle::GetTypeName() const {
+const std::string& Particle::GetTypeName() const {
   return type_name_;
 }
 float Particle::GetMass() const {
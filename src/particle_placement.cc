@@ -0,0 +1,212 @@
+#include "particle_placement.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+using glm::vec2;
+
+namespace {
+
+/** Positions each particle tries before kRandomSequential gives up **/
+const uint32_t kMaxPlacementAttempts = 1000;
+
+const size_t kNoParticle = std::numeric_limits<size_t>::max();
+
+const float kPi = 3.14159265f;
+
+float GetPackingFraction(const ParticleStore& particles, const vec2& extent) {
+  double covered_area = 0;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    float radius = particles.GetRadius(i);
+    covered_area += kPi * radius * radius;
+  }
+  return static_cast<float>(covered_area / (extent.x * extent.y));
+}
+
+std::string DescribePacking(const ParticleStore& particles,
+                            const vec2& extent) {
+  return std::to_string(particles.Size()) + " particles at packing fraction " +
+         std::to_string(GetPackingFraction(particles, extent));
+}
+
+/** Random 64-bit value from the first two words of a block **/
+uint64_t ToUint64(const CounterRng::Block& random) {
+  return static_cast<uint64_t>(random[0]) << 32 | random[1];
+}
+
+void PlaceOnJitteredLattice(const vec2& top_left, const vec2& extent,
+                            const CounterRng& rng, uint32_t stream,
+                            ParticleStore& particles) {
+  size_t particle_count = particles.Size();
+  float min_spacing = 2 * particles.GetMaxRadius();
+
+  // shrink the spacing one row or column at a time until there are enough
+  // cells, starting from the spacing that would fit exactly
+  double spacing = std::min<double>(
+      {std::sqrt(static_cast<double>(extent.x) * extent.y / particle_count),
+       extent.x, extent.y});
+  size_t column_count = static_cast<size_t>(extent.x / spacing);
+  size_t row_count = static_cast<size_t>(extent.y / spacing);
+  while (column_count * row_count < particle_count &&
+         spacing >= min_spacing) {
+    spacing = std::min(extent.x / static_cast<double>(column_count + 1),
+                       extent.y / static_cast<double>(row_count + 1));
+    column_count = static_cast<size_t>(extent.x / spacing);
+    row_count = static_cast<size_t>(extent.y / spacing);
+  }
+  if (column_count * row_count < particle_count || spacing < min_spacing) {
+    throw std::runtime_error("Can't place " +
+                             DescribePacking(particles, extent) +
+                             " on a lattice without overlaps");
+  }
+
+  // center the lattice in the bounds
+  vec2 origin =
+      top_left +
+      vec2(static_cast<float>((extent.x - column_count * spacing) / 2),
+           static_cast<float>((extent.y - row_count * spacing) / 2));
+
+  // partial Fisher-Yates shuffle, so particle i gets the i-th random cell
+  size_t cell_count = column_count * row_count;
+  std::vector<size_t> cells(cell_count);
+  for (size_t cell = 0; cell < cell_count; cell++) {
+    cells[cell] = cell;
+  }
+  for (size_t i = 0; i < particle_count; i++) {
+    CounterRng::Block random = rng.Generate(stream, i);
+    std::swap(cells[i], cells[i + ToUint64(random) % (cell_count - i)]);
+
+    // keep the particle inside its cell, so it can't reach its neighbors
+    size_t column = cells[i] % column_count;
+    size_t row = cells[i] / column_count;
+    float jitter = static_cast<float>(spacing) / 2 - particles.GetRadius(i);
+    vec2 offset((CounterRng::ToUnitFloat(random[2]) - 0.5f) * 2 * jitter,
+                (CounterRng::ToUnitFloat(random[3]) - 0.5f) * 2 * jitter);
+    vec2 center =
+        origin + vec2(static_cast<float>((column + 0.5) * spacing),
+                      static_cast<float>((row + 0.5) * spacing));
+    particles.SetPosition(i, center + offset);
+  }
+}
+
+void PlaceBySequentialAddition(const vec2& top_left, const vec2& extent,
+                               const CounterRng& rng, uint32_t stream,
+                               ParticleStore& particles) {
+  size_t particle_count = particles.Size();
+  if (GetPackingFraction(particles, extent) >
+      kMaxRandomSequentialPackingFraction) {
+    throw std::runtime_error(
+        "Can't place " + DescribePacking(particles, extent) +
+        " by random sequential addition, the limit is " +
+        std::to_string(kMaxRandomSequentialPackingFraction));
+  }
+
+  // cells at least as wide as the largest diameter, so overlapping particles
+  // are always in neighboring cells, and no more cells than particles. Each
+  // cell holds a linked list of the particles placed in it.
+  float cell_size = std::max(
+      2 * particles.GetMaxRadius(),
+      std::sqrt(extent.x * extent.y / static_cast<float>(particle_count)));
+  size_t column_count = static_cast<size_t>(extent.x / cell_size) + 1;
+  size_t row_count = static_cast<size_t>(extent.y / cell_size) + 1;
+  std::vector<size_t> cell_heads(column_count * row_count, kNoParticle);
+  std::vector<size_t> next_in_cell(particle_count, kNoParticle);
+
+  // small particles fit in the gaps between large ones but not the other way
+  // around, so the largest go first
+  std::vector<size_t> order(particle_count);
+  for (size_t i = 0; i < particle_count; i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&particles](size_t one, size_t two) {
+                     return particles.GetRadius(one) > particles.GetRadius(two);
+                   });
+
+  for (size_t i : order) {
+    float radius = particles.GetRadius(i);
+    vec2 free_extent = extent - vec2(2 * radius, 2 * radius);
+    if (free_extent.x < 0 || free_extent.y < 0) {
+      throw std::runtime_error("Particle " + std::to_string(i) +
+                               " is larger than the container");
+    }
+
+    bool is_placed = false;
+    for (uint32_t attempt = 0; attempt < kMaxPlacementAttempts; attempt++) {
+      CounterRng::Block random = rng.Generate(stream, i, attempt);
+      vec2 position =
+          top_left + vec2(radius, radius) +
+          vec2(CounterRng::ToUnitFloat(random[0]) * free_extent.x,
+               CounterRng::ToUnitFloat(random[1]) * free_extent.y);
+      size_t column = static_cast<size_t>((position.x - top_left.x) /
+                                          cell_size);
+      size_t row = static_cast<size_t>((position.y - top_left.y) / cell_size);
+
+      bool overlaps = false;
+      for (size_t neighbor_row = row > 0 ? row - 1 : 0;
+           neighbor_row <= std::min(row + 1, row_count - 1) && !overlaps;
+           neighbor_row++) {
+        for (size_t neighbor_column = column > 0 ? column - 1 : 0;
+             neighbor_column <= std::min(column + 1, column_count - 1) &&
+             !overlaps;
+             neighbor_column++) {
+          size_t other =
+              cell_heads[neighbor_row * column_count + neighbor_column];
+          for (; other != kNoParticle && !overlaps;
+               other = next_in_cell[other]) {
+            vec2 offset = particles.GetPosition(other) - position;
+            float radius_sum = radius + particles.GetRadius(other);
+            overlaps = offset.x * offset.x + offset.y * offset.y <
+                       radius_sum * radius_sum;
+          }
+        }
+      }
+      if (!overlaps) {
+        particles.SetPosition(i, position);
+        size_t cell = row * column_count + column;
+        next_in_cell[i] = cell_heads[cell];
+        cell_heads[cell] = i;
+        is_placed = true;
+        break;
+      }
+    }
+
+    if (!is_placed) {
+      throw std::runtime_error("Can't place " +
+                               DescribePacking(particles, extent) +
+                               " by random sequential addition, particle " +
+                               std::to_string(i) + " found no free space");
+    }
+  }
+}
+
+}  // namespace
+
+void PlaceWithoutOverlaps(Placement placement, const vec2& top_left,
+                          const vec2& bottom_right, const CounterRng& rng,
+                          uint32_t stream, ParticleStore& particles) {
+  if (particles.IsEmpty()) {
+    return;
+  }
+  vec2 extent = bottom_right - top_left;
+  switch (placement) {
+    case Placement::kJitteredLattice:
+      PlaceOnJitteredLattice(top_left, extent, rng, stream, particles);
+      return;
+    case Placement::kRandomSequential:
+      PlaceBySequentialAddition(top_left, extent, rng, stream, particles);
+      return;
+    case Placement::kUniform:
+      break;
+  }
+  throw std::invalid_argument(
+      "PlaceWithoutOverlaps needs a non-overlapping placement");
+}
+
+}  // namespace idealgas
@@ -0,0 +1,389 @@
+#include "particle_store.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace idealgas {
+
+template <int Dimension, typename Scalar>
+size_t BasicParticleStore<Dimension, Scalar>::Add(const Vector& position,
+                                                  const Vector& velocity,
+                                                  Scalar radius, Scalar mass,
+                                                  uint8_t species_id) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    positions_[axis].push_back(position[axis]);
+    velocities_[axis].push_back(velocity[axis]);
+  }
+  radii_.push_back(radius);
+  inverse_masses_.push_back(1 / mass);
+  species_ids_.push_back(species_id);
+  return species_ids_.size() - 1;
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Assign(
+    size_t particle_count, const Scalar* const* positions,
+    const Scalar* const* velocities, const Scalar* radii,
+    const Scalar* inverse_masses, const uint8_t* species_ids) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    positions_[axis].assign(positions[axis],
+                            positions[axis] + particle_count);
+    velocities_[axis].assign(velocities[axis],
+                             velocities[axis] + particle_count);
+  }
+  radii_.assign(radii, radii + particle_count);
+  inverse_masses_.assign(inverse_masses, inverse_masses + particle_count);
+  species_ids_.assign(species_ids, species_ids + particle_count);
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Set(size_t index,
+                                                const Vector& position,
+                                                const Vector& velocity,
+                                                Scalar radius, Scalar mass,
+                                                uint8_t species_id) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    positions_[axis][index] = position[axis];
+    velocities_[axis][index] = velocity[axis];
+  }
+  radii_[index] = radius;
+  inverse_masses_[index] = 1 / mass;
+  species_ids_[index] = species_id;
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Clear() {
+  Resize(0);
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Reserve(size_t particle_count) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    positions_[axis].reserve(particle_count);
+    velocities_[axis].reserve(particle_count);
+  }
+  radii_.reserve(particle_count);
+  inverse_masses_.reserve(particle_count);
+  species_ids_.reserve(particle_count);
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Resize(size_t particle_count) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    positions_[axis].resize(particle_count);
+    velocities_[axis].resize(particle_count);
+  }
+  radii_.resize(particle_count);
+  inverse_masses_.resize(particle_count);
+  species_ids_.resize(particle_count);
+}
+
+template <int Dimension, typename Scalar>
+size_t BasicParticleStore<Dimension, Scalar>::Size() const {
+  return species_ids_.size();
+}
+
+template <int Dimension, typename Scalar>
+bool BasicParticleStore<Dimension, Scalar>::IsEmpty() const {
+  return species_ids_.empty();
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Integrate() {
+  Integrate(0, Size());
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Integrate(size_t begin,
+                                                      size_t end, Scalar dt) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    Scalar* x = positions_[axis].data();
+    const Scalar* vx = velocities_[axis].data();
+    for (size_t i = begin; i < end; i++) {
+      x[i] += vx[i] * dt;
+    }
+  }
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::Integrate(size_t begin,
+                                                      size_t end) {
+  // plain indexed loops over separate arrays so the compiler can vectorize
+  for (int axis = 0; axis < Dimension; axis++) {
+    Scalar* x = positions_[axis].data();
+    const Scalar* vx = velocities_[axis].data();
+    for (size_t i = begin; i < end; i++) {
+      x[i] += vx[i];
+    }
+  }
+}
+
+template <int Dimension, typename Scalar>
+bool BasicParticleStore<Dimension, Scalar>::IsTouching(
+    size_t index_one, size_t index_two) const {
+  Scalar distance_squared = 0;
+  for (int axis = 0; axis < Dimension; axis++) {
+    Scalar dx = positions_[axis][index_two] - positions_[axis][index_one];
+    distance_squared += dx * dx;
+  }
+  Scalar radius_sum = radii_[index_one] + radii_[index_two];
+  return distance_squared <= radius_sum * radius_sum;
+}
+
+template <int Dimension, typename Scalar>
+bool BasicParticleStore<Dimension, Scalar>::IsApproaching(
+    size_t index_one, size_t index_two) const {
+  // same test as Particle::IsApproaching, with particle one as the observer
+  Scalar approach = 0;
+  Scalar drift = 0;
+  for (int axis = 0; axis < Dimension; axis++) {
+    Scalar dx = positions_[axis][index_two] - positions_[axis][index_one];
+    Scalar dvx = velocities_[axis][index_two] - velocities_[axis][index_one];
+    approach += dx * dvx;
+    drift += dvx * dvx;
+  }
+
+  // |d + v|^2 < |d|^2 simplifies to 2 * d.v + v.v < 0
+  return 2 * approach + drift < 0;
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::
+    UpdateVelocitiesForParticleCollision(size_t index_one, size_t index_two) {
+  // 2 * m2 / (m1 + m2) == 2 * w1 / (w1 + w2) where w = 1 / m
+  Scalar inverse_mass_sum =
+      inverse_masses_[index_one] + inverse_masses_[index_two];
+  UpdateVelocitiesForParticleCollision(
+      index_one, index_two, 2 * inverse_masses_[index_one] / inverse_mass_sum,
+      2 * inverse_masses_[index_two] / inverse_mass_sum);
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::
+    UpdateVelocitiesForParticleCollision(size_t index_one, size_t index_two,
+                                         Scalar mass_fraction_one,
+                                         Scalar mass_fraction_two) {
+  UpdateVelocitiesForParticleCollision(index_one, index_two, mass_fraction_one,
+                                       mass_fraction_two, Vector(Scalar(0)));
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::
+    UpdateVelocitiesForParticleCollision(size_t index_one, size_t index_two,
+                                         Scalar mass_fraction_one,
+                                         Scalar mass_fraction_two,
+                                         const Vector& periods) {
+  Scalar dx[Dimension];
+  Scalar velocity_dot = 0;
+  Scalar distance_squared = 0;
+  for (int axis = 0; axis < Dimension; axis++) {
+    dx[axis] = GetMinimumImage(
+        positions_[axis][index_one] - positions_[axis][index_two],
+        periods[axis]);
+    Scalar dvx = velocities_[axis][index_one] - velocities_[axis][index_two];
+    velocity_dot += dvx * dx[axis];
+    distance_squared += dx[axis] * dx[axis];
+  }
+
+  // both new velocities share the same projection of dv onto dx
+  Scalar projection = velocity_dot / distance_squared;
+  Scalar multiplier_one = mass_fraction_one * projection;
+  Scalar multiplier_two = mass_fraction_two * projection;
+  for (int axis = 0; axis < Dimension; axis++) {
+    velocities_[axis][index_one] -= multiplier_one * dx[axis];
+    velocities_[axis][index_two] += multiplier_two * dx[axis];
+  }
+}
+
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::HandleIfWallCollision(
+    size_t index, const Vector& top_left, const Vector& bottom_right) {
+  Scalar radius = radii_[index];
+  for (int axis = 0; axis < Dimension; axis++) {
+    Scalar position = positions_[axis][index];
+    bool is_touching_low_wall = position - radius <= top_left[axis];
+    if (!is_touching_low_wall && position + radius < bottom_right[axis]) {
+      continue;
+    }
+
+    // the momentum change is -2 * m * v, and the wall takes the opposite
+    Scalar& velocity = velocities_[axis][index];
+    Scalar impulse = 2 * velocity / inverse_masses_[index];
+    velocity *= -1;
+    return is_touching_low_wall ? -impulse : impulse;
+  }
+  return 0;
+}
+
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::ReflectOffWalls(
+    size_t index, const Vector& top_left, const Vector& bottom_right,
+    Scalar dt) {
+  Scalar radius = radii_[index];
+  Scalar impulse = 0;
+  for (int axis = 0; axis < Dimension; axis++) {
+    Scalar& position = positions_[axis][index];
+    Scalar& velocity = velocities_[axis][index];
+
+    // distance the particle can move towards the wall it's heading to
+    Scalar gap;
+    if (velocity < 0) {
+      gap = position - radius - top_left[axis];
+    } else if (velocity > 0) {
+      gap = bottom_right[axis] - position - radius;
+    } else {
+      continue;
+    }
+    Scalar speed = std::abs(velocity);
+    if (gap > speed * dt) {
+      continue;
+    }
+
+    // bounce at the contact time, or right away if already past the wall.
+    // The shift makes position + new velocity * dt equal the position after
+    // moving to the wall and back out for the rest of the step
+    Scalar contact_time = std::max(gap, Scalar(0)) / speed;
+    position += 2 * velocity * contact_time;
+    velocity = -velocity;
+    impulse += 2 * speed / inverse_masses_[index];
+  }
+  return impulse;
+}
+
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::ReflectVelocity(size_t index,
+                                                              size_t axis) {
+  Scalar& velocity = velocities_[axis][index];
+  velocity *= -1;
+  return 2 * std::abs(velocity) / inverse_masses_[index];
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::WrapPositions(size_t begin,
+                                                          size_t end,
+                                                          size_t axis,
+                                                          Scalar low,
+                                                          Scalar high) {
+  Scalar period = high - low;
+  Scalar* x = positions_[axis].data();
+  for (size_t i = begin; i < end; i++) {
+    if (x[i] >= low && x[i] < high) {
+      continue;
+    }
+    x[i] -= std::floor((x[i] - low) / period) * period;
+
+    // rounding can leave a value on the edge, e.g. -1e-9 + period == high
+    if (x[i] >= high || x[i] < low) {
+      x[i] = low;
+    }
+  }
+}
+
+template <int Dimension, typename Scalar>
+void BasicParticleStore<Dimension, Scalar>::SetPosition(
+    size_t index, const Vector& position) {
+  for (int axis = 0; axis < Dimension; axis++) {
+    positions_[axis][index] = position[axis];
+  }
+}
+
+template <int Dimension, typename Scalar>
+typename BasicParticleStore<Dimension, Scalar>::Vector
+BasicParticleStore<Dimension, Scalar>::GetPosition(size_t index) const {
+  Vector position(Scalar(0));
+  for (int axis = 0; axis < Dimension; axis++) {
+    position[axis] = positions_[axis][index];
+  }
+  return position;
+}
+template <int Dimension, typename Scalar>
+typename BasicParticleStore<Dimension, Scalar>::Vector
+BasicParticleStore<Dimension, Scalar>::GetVelocity(size_t index) const {
+  Vector velocity(Scalar(0));
+  for (int axis = 0; axis < Dimension; axis++) {
+    velocity[axis] = velocities_[axis][index];
+  }
+  return velocity;
+}
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::GetSpeed(size_t index) const {
+  Scalar speed_squared = 0;
+  for (int axis = 0; axis < Dimension; axis++) {
+    speed_squared += velocities_[axis][index] * velocities_[axis][index];
+  }
+  return std::sqrt(speed_squared);
+}
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::GetRadius(size_t index) const {
+  return radii_[index];
+}
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::GetMass(size_t index) const {
+  return 1 / inverse_masses_[index];
+}
+template <int Dimension, typename Scalar>
+uint8_t BasicParticleStore<Dimension, Scalar>::GetSpeciesId(
+    size_t index) const {
+  return species_ids_[index];
+}
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::GetMaxRadius() const {
+  Scalar max_radius = 0;
+  for (Scalar radius : radii_) {
+    max_radius = std::max(max_radius, radius);
+  }
+  return max_radius;
+}
+template <int Dimension, typename Scalar>
+Scalar BasicParticleStore<Dimension, Scalar>::GetMinRadius() const {
+  if (radii_.empty()) {
+    return 0;
+  }
+  return *std::min_element(radii_.begin(), radii_.end());
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetPositions(
+    size_t axis) const {
+  return positions_[axis].data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetVelocities(
+    size_t axis) const {
+  return velocities_[axis].data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetPositionsX() const {
+  return positions_[0].data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetPositionsY() const {
+  return positions_[1].data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetVelocitiesX() const {
+  return velocities_[0].data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetVelocitiesY() const {
+  return velocities_[1].data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetRadii() const {
+  return radii_.data();
+}
+template <int Dimension, typename Scalar>
+const Scalar* BasicParticleStore<Dimension, Scalar>::GetInverseMasses()
+    const {
+  return inverse_masses_.data();
+}
+template <int Dimension, typename Scalar>
+const uint8_t* BasicParticleStore<Dimension, Scalar>::GetSpeciesIds() const {
+  return species_ids_.data();
+}
+
+template class BasicParticleStore<2, float>;
+template class BasicParticleStore<3, float>;
+template class BasicParticleStore<2, double>;
+template class BasicParticleStore<3, double>;
+
+}  // namespace idealgas
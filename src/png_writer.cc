@@ -0,0 +1,215 @@
+#include "png_writer.h"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+/** Bytes per pixel, which is also the distance the Sub filter looks back **/
+const size_t kPixelSize = 4;
+
+const uint8_t kSubFilter = 1;
+
+/** Longest match deflate can encode **/
+const size_t kMaxMatchLength = 258;
+const size_t kMinMatchLength = 3;
+
+/** Deflate length codes 257 to 285: shortest length and extra bits **/
+const uint16_t kLengthBases[] = {3,  4,  5,  6,   7,   8,   9,   10,
+                                 11, 13, 15, 17,  19,  23,  27,  31,
+                                 35, 43, 51, 59,  67,  83,  99,  115,
+                                 131, 163, 195, 227, 258};
+const uint8_t kLengthExtraBits[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                    1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                    4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+std::array<uint32_t, 256> MakeCrcTable() {
+  std::array<uint32_t, 256> table;
+  for (uint32_t n = 0; n < 256; n++) {
+    uint32_t value = n;
+    for (int bit = 0; bit < 8; bit++) {
+      value = (value & 1) ? 0xedb88320 ^ (value >> 1) : value >> 1;
+    }
+    table[n] = value;
+  }
+  return table;
+}
+
+uint32_t UpdateCrc(uint32_t crc, const uint8_t* bytes, size_t size) {
+  static const std::array<uint32_t, 256> table = MakeCrcTable();
+  for (size_t i = 0; i < size; i++) {
+    crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+/** Writes bits least significant first, as deflate expects **/
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t>& bytes) : bytes_(bytes) {
+  }
+
+  void WriteBits(uint32_t value, int count) {
+    buffer_ |= static_cast<uint64_t>(value) << buffer_size_;
+    buffer_size_ += count;
+    while (buffer_size_ >= 8) {
+      bytes_.push_back(static_cast<uint8_t>(buffer_));
+      buffer_ >>= 8;
+      buffer_size_ -= 8;
+    }
+  }
+
+  /** Huffman codes are defined most significant bit first **/
+  void WriteCode(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int bit = 0; bit < length; bit++) {
+      reversed = (reversed << 1) | ((code >> bit) & 1);
+    }
+    WriteBits(reversed, length);
+  }
+
+  void Flush() {
+    if (buffer_size_ > 0) {
+      bytes_.push_back(static_cast<uint8_t>(buffer_));
+    }
+    buffer_ = 0;
+    buffer_size_ = 0;
+  }
+
+ private:
+  std::vector<uint8_t>& bytes_;
+  uint64_t buffer_ = 0;
+  int buffer_size_ = 0;
+};
+
+/** Writes a literal or length symbol with the fixed Huffman code **/
+void WriteFixedSymbol(BitWriter& writer, uint32_t symbol) {
+  if (symbol < 144) {
+    writer.WriteCode(0x30 + symbol, 8);
+  } else if (symbol < 256) {
+    writer.WriteCode(0x190 + symbol - 144, 9);
+  } else if (symbol < 280) {
+    writer.WriteCode(symbol - 256, 7);
+  } else {
+    writer.WriteCode(0xc0 + symbol - 280, 8);
+  }
+}
+
+/** Writes a match of length bytes repeating the byte before it **/
+void WriteRunMatch(BitWriter& writer, size_t length) {
+  size_t code = 0;
+  while (code + 1 < sizeof(kLengthBases) / sizeof(kLengthBases[0]) &&
+         kLengthBases[code + 1] <= length) {
+    code++;
+  }
+  WriteFixedSymbol(writer, static_cast<uint32_t>(257 + code));
+  writer.WriteBits(static_cast<uint32_t>(length - kLengthBases[code]),
+                   kLengthExtraBits[code]);
+  // distance 1 is distance code 0, with no extra bits
+  writer.WriteCode(0, 5);
+}
+
+/** zlib stream of one fixed Huffman block with run-length matches **/
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> stream = {0x78, 0x01};
+  BitWriter writer(stream);
+  writer.WriteBits(1, 1);  // last block
+  writer.WriteBits(1, 2);  // fixed Huffman codes
+
+  size_t i = 0;
+  while (i < data.size()) {
+    size_t run = 0;
+    if (i > 0) {
+      while (run < kMaxMatchLength && i + run < data.size() &&
+             data[i + run] == data[i - 1]) {
+        run++;
+      }
+    }
+    if (run >= kMinMatchLength) {
+      WriteRunMatch(writer, run);
+      i += run;
+    } else {
+      WriteFixedSymbol(writer, data[i]);
+      i++;
+    }
+  }
+  WriteFixedSymbol(writer, 256);  // end of block
+  writer.Flush();
+
+  uint32_t adler_low = 1;
+  uint32_t adler_high = 0;
+  for (uint8_t byte : data) {
+    adler_low = (adler_low + byte) % 65521;
+    adler_high = (adler_high + adler_low) % 65521;
+  }
+  uint32_t adler = (adler_high << 16) | adler_low;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    stream.push_back(static_cast<uint8_t>(adler >> shift));
+  }
+  return stream;
+}
+
+void AppendUint32(std::vector<uint8_t>& bytes, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    bytes.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+void AppendChunk(std::vector<uint8_t>& png, const char type[4],
+                 const std::vector<uint8_t>& data) {
+  AppendUint32(png, static_cast<uint32_t>(data.size()));
+  size_t type_start = png.size();
+  png.insert(png.end(), type, type + 4);
+  png.insert(png.end(), data.begin(), data.end());
+  uint32_t crc = UpdateCrc(0xffffffff, png.data() + type_start,
+                           png.size() - type_start);
+  AppendUint32(png, crc ^ 0xffffffff);
+}
+
+}  // namespace
+
+std::vector<uint8_t> EncodePng(const Framebuffer& framebuffer) {
+  size_t width = framebuffer.GetWidth();
+  size_t height = framebuffer.GetHeight();
+  size_t row_size = kPixelSize * width;
+
+  // each row starts with its filter type
+  std::vector<uint8_t> filtered;
+  filtered.reserve((row_size + 1) * height);
+  for (size_t y = 0; y < height; y++) {
+    const uint8_t* row = framebuffer.GetPixel(0, y);
+    filtered.push_back(kSubFilter);
+    for (size_t x = 0; x < row_size; x++) {
+      uint8_t left = x >= kPixelSize ? row[x - kPixelSize] : 0;
+      filtered.push_back(static_cast<uint8_t>(row[x] - left));
+    }
+  }
+
+  std::vector<uint8_t> header;
+  AppendUint32(header, static_cast<uint32_t>(width));
+  AppendUint32(header, static_cast<uint32_t>(height));
+  // 8 bits per channel, RGBA, deflate, adaptive filtering, no interlacing
+  header.insert(header.end(), {8, 6, 0, 0, 0});
+
+  std::vector<uint8_t> png(kSignature, kSignature + sizeof(kSignature));
+  AppendChunk(png, "IHDR", header);
+  AppendChunk(png, "IDAT", Compress(filtered));
+  AppendChunk(png, "IEND", std::vector<uint8_t>());
+  return png;
+}
+
+void WritePng(const std::string& path, const Framebuffer& framebuffer) {
+  std::vector<uint8_t> png = EncodePng(framebuffer);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(png.data()), png.size());
+  if (!file) {
+    throw std::runtime_error("Can't write " + path);
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,392 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#define IDEALGAS_HAS_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+const size_t Profiler::kMaxEventsPerThread;
+
+namespace {
+
+/** Cycles, instructions and cache misses **/
+const size_t kCounterCount = 3;
+
+struct TraceEvent {
+  const char* name;
+  uint64_t start_nanoseconds;
+  uint64_t duration_nanoseconds;
+  uint64_t counters[kCounterCount];
+};
+
+/**
+ * What one thread recorded. Only its thread writes to it, but the lock lets
+ * other threads read it while that thread is still running.
+ */
+struct ThreadBuffer {
+  std::mutex mutex;
+  uint32_t thread_id = 0;
+  std::vector<TraceEvent> events;
+
+  /** Totals per name, keyed by the name pointer to keep recording cheap **/
+  std::vector<std::pair<const char*, PhaseSummary>> totals;
+
+  /** perf_event_open descriptors, the first one leads the group **/
+  int counter_fds[kCounterCount] = {-1, -1, -1};
+  bool has_tried_counters = false;
+
+  ~ThreadBuffer() {
+    CloseCounters();
+  }
+
+  bool HasCounters() const {
+    return counter_fds[0] >= 0;
+  }
+
+  /** Opens the counters of the calling thread, once **/
+  void OpenCounters();
+  void CloseCounters();
+
+  /** Reads the counters into values, zeros if they aren't open **/
+  void ReadCounters(uint64_t* values) const;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  std::atomic<bool> is_enabled{false};
+  std::atomic<bool> are_counters_enabled{false};
+  std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+};
+
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+/** Buffer of the calling thread, registered on first use **/
+ThreadBuffer& GetThreadBuffer() {
+  thread_local ThreadBuffer* buffer = nullptr;
+  if (buffer == nullptr) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::unique_ptr<ThreadBuffer> new_buffer(new ThreadBuffer());
+    new_buffer->thread_id = static_cast<uint32_t>(registry.buffers.size());
+    buffer = new_buffer.get();
+    registry.buffers.push_back(std::move(new_buffer));
+  }
+  return *buffer;
+}
+
+uint64_t GetNanoseconds() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - GetRegistry().epoch)
+          .count());
+}
+
+void ThreadBuffer::OpenCounters() {
+  if (has_tried_counters) {
+    return;
+  }
+  has_tried_counters = true;
+#if defined(IDEALGAS_HAS_PERF_EVENTS)
+  const uint64_t configs[kCounterCount] = {PERF_COUNT_HW_CPU_CYCLES,
+                                           PERF_COUNT_HW_INSTRUCTIONS,
+                                           PERF_COUNT_HW_CACHE_MISSES};
+  for (size_t i = 0; i < kCounterCount; i++) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = configs[i];
+    attributes.read_format = PERF_FORMAT_GROUP;
+    attributes.disabled = i == 0 ? 1 : 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    // this thread, any cpu, grouped under the first counter so all three
+    // are read at once and count over the same time
+    counter_fds[i] = static_cast<int>(syscall(
+        SYS_perf_event_open, &attributes, 0, -1,
+        i == 0 ? -1 : counter_fds[0], 0));
+    if (counter_fds[i] < 0) {
+      CloseCounters();
+      return;
+    }
+  }
+  ioctl(counter_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void ThreadBuffer::CloseCounters() {
+#if defined(IDEALGAS_HAS_PERF_EVENTS)
+  for (int& fd : counter_fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    fd = -1;
+  }
+#endif
+}
+
+void ThreadBuffer::ReadCounters(uint64_t* values) const {
+  std::fill(values, values + kCounterCount, 0);
+#if defined(IDEALGAS_HAS_PERF_EVENTS)
+  // PERF_FORMAT_GROUP: the number of counters, then each value
+  uint64_t group[1 + kCounterCount];
+  if (read(counter_fds[0], group, sizeof(group)) ==
+          static_cast<ssize_t>(sizeof(group)) &&
+      group[0] == kCounterCount) {
+    std::copy(group + 1, group + 1 + kCounterCount, values);
+  }
+#endif
+}
+
+/** Writes s as a JSON string, with quotes **/
+void WriteJsonString(std::FILE* file, const char* s) {
+  std::fputc('"', file);
+  for (; *s != '\0'; s++) {
+    if (*s == '"' || *s == '\\') {
+      std::fputc('\\', file);
+    }
+    std::fputc(*s, file);
+  }
+  std::fputc('"', file);
+}
+
+}  // namespace
+
+bool Profiler::IsCompiledIn() {
+#if defined(IDEALGAS_PROFILING)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Profiler::SetEnabled(bool is_enabled) {
+  GetRegistry().is_enabled = is_enabled;
+}
+
+bool Profiler::IsEnabled() {
+  return GetRegistry().is_enabled.load(std::memory_order_relaxed);
+}
+
+bool Profiler::SetHardwareCountersEnabled(bool is_enabled) {
+  GetRegistry().are_counters_enabled = is_enabled;
+  if (!is_enabled) {
+    return false;
+  }
+  ThreadBuffer& buffer = GetThreadBuffer();
+  buffer.OpenCounters();
+  return buffer.HasCounters();
+}
+
+void Profiler::Clear() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->totals.clear();
+  }
+}
+
+std::vector<PhaseSummary> Profiler::GetSummary() {
+  std::vector<PhaseSummary> summaries;
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for (const auto& entry : buffer->totals) {
+      // equal literals from different files can have different addresses
+      const PhaseSummary& totals = entry.second;
+      auto summary =
+          std::find_if(summaries.begin(), summaries.end(),
+                       [&entry](const PhaseSummary& other) {
+                         return other.name == entry.first;
+                       });
+      if (summary == summaries.end()) {
+        summaries.push_back(totals);
+        summaries.back().name = entry.first;
+        continue;
+      }
+      summary->call_count += totals.call_count;
+      summary->total_nanoseconds += totals.total_nanoseconds;
+      summary->min_nanoseconds =
+          std::min(summary->min_nanoseconds, totals.min_nanoseconds);
+      summary->max_nanoseconds =
+          std::max(summary->max_nanoseconds, totals.max_nanoseconds);
+      summary->cycles += totals.cycles;
+      summary->instructions += totals.instructions;
+      summary->cache_misses += totals.cache_misses;
+    }
+  }
+  std::sort(summaries.begin(), summaries.end(),
+            [](const PhaseSummary& one, const PhaseSummary& two) {
+              return one.total_nanoseconds > two.total_nanoseconds;
+            });
+  return summaries;
+}
+
+void Profiler::PrintSummary(std::FILE* file) {
+  std::vector<PhaseSummary> summaries = GetSummary();
+  int name_width = 5;
+  for (const PhaseSummary& summary : summaries) {
+    name_width = std::max(name_width, static_cast<int>(summary.name.size()));
+  }
+
+  std::fprintf(file, "%-*s %9s %11s %10s %10s %10s %6s %12s\n", name_width,
+               "phase", "calls", "total ms", "mean us", "min us", "max us",
+               "IPC", "misses/call");
+  for (const PhaseSummary& summary : summaries) {
+    double calls = static_cast<double>(summary.call_count);
+    std::fprintf(file, "%-*s %9llu %11.3f %10.3f %10.3f %10.3f",
+                 name_width, summary.name.c_str(),
+                 static_cast<unsigned long long>(summary.call_count),
+                 summary.total_nanoseconds * 1e-6,
+                 summary.total_nanoseconds * 1e-3 / calls,
+                 summary.min_nanoseconds * 1e-3,
+                 summary.max_nanoseconds * 1e-3);
+    if (summary.cycles > 0) {
+      std::fprintf(file, " %6.2f %12.1f\n",
+                   static_cast<double>(summary.instructions) / summary.cycles,
+                   summary.cache_misses / calls);
+    } else {
+      std::fprintf(file, " %6s %12s\n", "-", "-");
+    }
+  }
+}
+
+void Profiler::WriteChromeTrace(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    throw std::runtime_error("Can't write " + path);
+  }
+
+  std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  bool is_first = true;
+  {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      std::fprintf(file,
+                   "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                   "\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                   is_first ? "" : ",\n", buffer->thread_id,
+                   buffer->thread_id);
+      is_first = false;
+
+      // microseconds with nanosecond digits
+      for (const TraceEvent& event : buffer->events) {
+        std::fprintf(file, ",\n{\"name\":");
+        WriteJsonString(file, event.name);
+        std::fprintf(file,
+                     ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                     "\"dur\":%.3f",
+                     buffer->thread_id, event.start_nanoseconds * 1e-3,
+                     event.duration_nanoseconds * 1e-3);
+        if (event.counters[0] > 0) {
+          std::fprintf(file,
+                       ",\"args\":{\"cycles\":%llu,\"instructions\":%llu,"
+                       "\"cache_misses\":%llu}",
+                       static_cast<unsigned long long>(event.counters[0]),
+                       static_cast<unsigned long long>(event.counters[1]),
+                       static_cast<unsigned long long>(event.counters[2]));
+        }
+        std::fputc('}', file);
+      }
+    }
+  }
+  std::fprintf(file, "\n]}\n");
+
+  bool has_failed = std::ferror(file) != 0;
+  if (std::fclose(file) != 0 || has_failed) {
+    throw std::runtime_error("Failed writing " + path);
+  }
+}
+
+ProfileScope::ProfileScope(const char* name) : name_(name) {
+  if (!Profiler::IsEnabled()) {
+    return;
+  }
+  is_recording_ = true;
+  Registry& registry = GetRegistry();
+  if (registry.are_counters_enabled.load(std::memory_order_relaxed)) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    buffer.OpenCounters();
+    if (buffer.HasCounters()) {
+      has_counters_ = true;
+      buffer.ReadCounters(start_counters_);
+    }
+  }
+  // last, so reading the counters isn't timed
+  start_nanoseconds_ = GetNanoseconds();
+}
+
+ProfileScope::~ProfileScope() {
+  if (!is_recording_) {
+    return;
+  }
+  uint64_t end_nanoseconds = GetNanoseconds();
+  ThreadBuffer& buffer = GetThreadBuffer();
+  TraceEvent event;
+  event.name = name_;
+  event.start_nanoseconds = start_nanoseconds_;
+  event.duration_nanoseconds = end_nanoseconds - start_nanoseconds_;
+  std::fill(event.counters, event.counters + kCounterCount, 0);
+  if (has_counters_) {
+    buffer.ReadCounters(event.counters);
+    for (size_t i = 0; i < kCounterCount; i++) {
+      // a failed read gives zeros
+      event.counters[i] = event.counters[i] >= start_counters_[i]
+                              ? event.counters[i] - start_counters_[i]
+                              : 0;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() < Profiler::kMaxEventsPerThread) {
+    buffer.events.push_back(event);
+  }
+
+  // a frame only has a handful of phases, so a linear search is enough
+  auto entry = std::find_if(
+      buffer.totals.begin(), buffer.totals.end(),
+      [this](const std::pair<const char*, PhaseSummary>& other) {
+        return other.first == name_;
+      });
+  if (entry == buffer.totals.end()) {
+    buffer.totals.push_back(std::make_pair(name_, PhaseSummary()));
+    entry = buffer.totals.end() - 1;
+    entry->second.min_nanoseconds = event.duration_nanoseconds;
+  }
+  PhaseSummary& totals = entry->second;
+  totals.call_count++;
+  totals.total_nanoseconds += event.duration_nanoseconds;
+  totals.min_nanoseconds =
+      std::min(totals.min_nanoseconds, event.duration_nanoseconds);
+  totals.max_nanoseconds =
+      std::max(totals.max_nanoseconds, event.duration_nanoseconds);
+  totals.cycles += event.counters[0];
+  totals.instructions += event.counters[1];
+  totals.cache_misses += event.counters[2];
+}
+
+}  // namespace idealgas
@@ -0,0 +1,215 @@
+#include "quantile_sketch.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace idealgas {
+
+const size_t QuantileSketch::kDefaultSize;
+
+namespace {
+
+const uint64_t kRandomSeed = 0x9e3779b97f4a7c15ULL;
+
+/** Every level holds at least this many values before it is compacted **/
+const size_t kMinLevelCapacity = 8;
+
+}  // namespace
+
+QuantileSketch::QuantileSketch(size_t size)
+    : size_(size), random_state_(kRandomSeed) {
+  if (size < kMinLevelCapacity) {
+    throw std::invalid_argument(
+        "A quantile sketch needs a size of at least 8");
+  }
+  AddLevel();
+}
+
+void QuantileSketch::Add(float value) {
+  if (count_ == 0) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  count_++;
+  levels_[0].push_back(value);
+  retained_count_++;
+  if (retained_count_ >= max_retained_count_) {
+    Compress();
+  }
+}
+
+void QuantileSketch::Add(const QuantileSketch& other) {
+  if (other.size_ != size_) {
+    throw std::invalid_argument("Quantile sketches have different sizes");
+  }
+  if (other.count_ == 0) {
+    return;
+  }
+  if (&other == this) {
+    QuantileSketch copy = other;
+    Add(copy);
+    return;
+  }
+  if (count_ == 0) {
+    min_ = other.min_;
+    max_ = other.max_;
+  } else {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  count_ += other.count_;
+
+  while (levels_.size() < other.levels_.size()) {
+    AddLevel();
+  }
+  for (size_t level = 0; level < other.levels_.size(); level++) {
+    const std::vector<float>& values = other.levels_[level];
+    MergeIntoLevel(level, values.data(), values.data() + values.size());
+  }
+  retained_count_ += other.retained_count_;
+  if (retained_count_ >= max_retained_count_) {
+    Compress();
+  }
+}
+
+float QuantileSketch::GetQuantile(double fraction) const {
+  if (!(fraction >= 0 && fraction <= 1)) {
+    throw std::invalid_argument("Quantile fraction must be in [0, 1]");
+  }
+  if (count_ == 0) {
+    return 0;
+  }
+  if (fraction == 0) {
+    return min_;
+  }
+  if (fraction == 1) {
+    return max_;
+  }
+
+  std::vector<std::pair<float, uint64_t>> weighted_values;
+  weighted_values.reserve(retained_count_);
+  for (size_t level = 0; level < levels_.size(); level++) {
+    for (float value : levels_[level]) {
+      weighted_values.push_back(std::make_pair(value, uint64_t(1) << level));
+    }
+  }
+  std::sort(weighted_values.begin(), weighted_values.end());
+
+  // the weights add up to count_, compaction keeps the total
+  double rank = fraction * static_cast<double>(count_);
+  uint64_t weight_below = 0;
+  for (const auto& weighted_value : weighted_values) {
+    weight_below += weighted_value.second;
+    if (static_cast<double>(weight_below) >= rank) {
+      return weighted_value.first;
+    }
+  }
+  return max_;
+}
+
+uint64_t QuantileSketch::GetCount() const {
+  return count_;
+}
+
+size_t QuantileSketch::GetRetainedCount() const {
+  return retained_count_;
+}
+
+size_t QuantileSketch::GetSize() const {
+  return size_;
+}
+
+float QuantileSketch::GetMin() const {
+  return min_;
+}
+
+float QuantileSketch::GetMax() const {
+  return max_;
+}
+
+void QuantileSketch::AddLevel() {
+  levels_.push_back(std::vector<float>());
+
+  // the new level gets size_, each one below 2/3 of the room of the level
+  // above it, rounded up
+  capacities_.resize(levels_.size());
+  max_retained_count_ = 0;
+  size_t capacity = size_;
+  for (size_t level = levels_.size(); level-- > 0;) {
+    capacities_[level] = std::max(capacity, kMinLevelCapacity);
+    max_retained_count_ += capacities_[level];
+    capacity = (2 * capacity + 2) / 3;
+  }
+}
+
+void QuantileSketch::Compress() {
+  // some level is always full while retained_count_ >= max_retained_count_
+  for (size_t level = 0; level < levels_.size(); level++) {
+    if (levels_[level].size() < capacities_[level]) {
+      continue;
+    }
+    if (level + 1 == levels_.size()) {
+      AddLevel();
+    }
+    CompactLevel(level);
+    if (retained_count_ < max_retained_count_) {
+      return;
+    }
+  }
+}
+
+void QuantileSketch::CompactLevel(size_t level) {
+  std::vector<float>& values = levels_[level];
+  if (level == 0) {
+    std::sort(values.begin(), values.end());
+  }
+
+  // an odd one out stays, the smallest so the rest pair up neighbours
+  size_t kept_count = values.size() % 2;
+  size_t moved_count = (values.size() - kept_count) / 2;
+  merge_buffer_.clear();
+  for (size_t i = kept_count + (FlipCoin() ? 1 : 0); i < values.size();
+       i += 2) {
+    merge_buffer_.push_back(values[i]);
+  }
+  values.resize(kept_count);
+  retained_count_ -= moved_count;
+  MergeIntoLevel(level + 1, merge_buffer_.data(),
+                 merge_buffer_.data() + merge_buffer_.size());
+}
+
+void QuantileSketch::MergeIntoLevel(size_t level, const float* begin,
+                                    const float* end) {
+  std::vector<float>& values = levels_[level];
+  if (level == 0) {
+    values.insert(values.end(), begin, end);
+    return;
+  }
+  // the levels above 0 stay sorted, so the new values are merged in from
+  // the back rather than sorting the level again
+  size_t old_size = values.size();
+  values.resize(old_size + (end - begin));
+  float* old_end = values.data() + old_size;
+  float* out = values.data() + values.size();
+  while (end != begin) {
+    if (old_end != values.data() && *(old_end - 1) > *(end - 1)) {
+      *--out = *--old_end;
+    } else {
+      *--out = *--end;
+    }
+  }
+}
+
+bool QuantileSketch::FlipCoin() {
+  // xorshift64
+  random_state_ ^= random_state_ << 13;
+  random_state_ ^= random_state_ >> 7;
+  random_state_ ^= random_state_ << 17;
+  return (random_state_ >> 32) & 1;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,277 @@
+#include "shared_memory_transport.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IDEALGAS_HAS_POSIX_IPC
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+const size_t SharedMemoryTransport::kDefaultMailboxCapacity;
+
+#if defined(IDEALGAS_HAS_POSIX_IPC)
+
+namespace {
+
+const uint64_t kMagic = 0x4d4853534147444bULL;
+
+/** Alignment of each mailbox in the segment, one cache line **/
+const size_t kMailboxAlignment = 64;
+
+struct SegmentHeader {
+  uint64_t magic;
+  uint64_t rank_count;
+  uint64_t mailbox_capacity;
+};
+
+/**
+ * Ring buffer for one direction between two ranks, followed in the segment
+ * by its capacity in bytes. The counts only grow, so the bytes in the
+ * buffer are write_count - read_count.
+ */
+struct Mailbox {
+  pthread_mutex_t mutex;
+
+  /** Signaled whenever bytes are written or read **/
+  pthread_cond_t changed;
+  uint64_t write_count;
+  uint64_t read_count;
+};
+
+size_t GetHeaderSize() {
+  return (sizeof(SegmentHeader) + kMailboxAlignment - 1) /
+         kMailboxAlignment * kMailboxAlignment;
+}
+
+size_t GetMailboxSize(size_t capacity) {
+  return (sizeof(Mailbox) + capacity + kMailboxAlignment - 1) /
+         kMailboxAlignment * kMailboxAlignment;
+}
+
+uint8_t* GetRing(Mailbox* mailbox) {
+  return reinterpret_cast<uint8_t*>(mailbox + 1);
+}
+
+/** Writes size bytes, waiting for the reader whenever the ring is full **/
+void WriteToMailbox(Mailbox* mailbox, size_t capacity, const uint8_t* data,
+                    size_t size) {
+  uint8_t* ring = GetRing(mailbox);
+  pthread_mutex_lock(&mailbox->mutex);
+  while (size > 0) {
+    while (mailbox->write_count - mailbox->read_count == capacity) {
+      pthread_cond_wait(&mailbox->changed, &mailbox->mutex);
+    }
+    size_t free = capacity - (mailbox->write_count - mailbox->read_count);
+    size_t start = mailbox->write_count % capacity;
+    size_t count = std::min(std::min(free, size), capacity - start);
+    std::copy(data, data + count, ring + start);
+    mailbox->write_count += count;
+    data += count;
+    size -= count;
+    pthread_cond_broadcast(&mailbox->changed);
+  }
+  pthread_mutex_unlock(&mailbox->mutex);
+}
+
+/** Reads size bytes, waiting for the writer whenever the ring is empty **/
+void ReadFromMailbox(Mailbox* mailbox, size_t capacity, uint8_t* data,
+                     size_t size) {
+  const uint8_t* ring = GetRing(mailbox);
+  pthread_mutex_lock(&mailbox->mutex);
+  while (size > 0) {
+    while (mailbox->write_count == mailbox->read_count) {
+      pthread_cond_wait(&mailbox->changed, &mailbox->mutex);
+    }
+    size_t available = mailbox->write_count - mailbox->read_count;
+    size_t start = mailbox->read_count % capacity;
+    size_t count = std::min(std::min(available, size), capacity - start);
+    std::copy(ring + start, ring + start + count, data);
+    mailbox->read_count += count;
+    data += count;
+    size -= count;
+    pthread_cond_broadcast(&mailbox->changed);
+  }
+  pthread_mutex_unlock(&mailbox->mutex);
+}
+
+}  // namespace
+
+void SharedMemoryTransport::Create(const std::string& name,
+                                   size_t rank_count,
+                                   size_t mailbox_capacity) {
+  if (rank_count == 0 || mailbox_capacity == 0) {
+    throw std::invalid_argument(
+        "Shared memory needs at least one rank and a mailbox capacity");
+  }
+  size_t mailbox_size = GetMailboxSize(mailbox_capacity);
+  size_t size = GetHeaderSize() + rank_count * rank_count * mailbox_size;
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    throw std::runtime_error("Can't create shared memory " + name);
+  }
+  void* mapping = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("Can't map shared memory " + name);
+  }
+
+  uint8_t* bytes = static_cast<uint8_t*>(mapping);
+  pthread_mutexattr_t mutex_attributes;
+  pthread_mutexattr_init(&mutex_attributes);
+  pthread_mutexattr_setpshared(&mutex_attributes, PTHREAD_PROCESS_SHARED);
+  pthread_condattr_t cond_attributes;
+  pthread_condattr_init(&cond_attributes);
+  pthread_condattr_setpshared(&cond_attributes, PTHREAD_PROCESS_SHARED);
+  for (size_t i = 0; i < rank_count * rank_count; i++) {
+    Mailbox* mailbox = reinterpret_cast<Mailbox*>(bytes + GetHeaderSize() +
+                                                  i * mailbox_size);
+    pthread_mutex_init(&mailbox->mutex, &mutex_attributes);
+    pthread_cond_init(&mailbox->changed, &cond_attributes);
+    mailbox->write_count = 0;
+    mailbox->read_count = 0;
+  }
+  pthread_condattr_destroy(&cond_attributes);
+  pthread_mutexattr_destroy(&mutex_attributes);
+
+  SegmentHeader* header = reinterpret_cast<SegmentHeader*>(bytes);
+  header->rank_count = rank_count;
+  header->mailbox_capacity = mailbox_capacity;
+  header->magic = kMagic;
+  munmap(mapping, size);
+}
+
+void SharedMemoryTransport::Unlink(const std::string& name) {
+  shm_unlink(name.c_str());
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string& name,
+                                             size_t rank)
+    : rank_(rank) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    throw std::runtime_error("Can't open shared memory " + name);
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      static_cast<size_t>(status.st_size) < GetHeaderSize()) {
+    close(fd);
+    throw std::runtime_error("Shared memory " + name + " is too small");
+  }
+  mapping_size_ = static_cast<size_t>(status.st_size);
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  fd, 0);
+  close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    throw std::runtime_error("Can't map shared memory " + name);
+  }
+
+  const SegmentHeader* header = static_cast<const SegmentHeader*>(mapping_);
+  rank_count_ = header->rank_count;
+  mailbox_capacity_ = header->mailbox_capacity;
+  if (header->magic != kMagic ||
+      GetHeaderSize() + rank_count_ * rank_count_ *
+                            GetMailboxSize(mailbox_capacity_) >
+          mapping_size_) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    throw std::runtime_error(name + " isn't a transport segment");
+  }
+  if (rank >= rank_count_) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    throw std::invalid_argument("Rank is out of range");
+  }
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+void SharedMemoryTransport::Send(size_t destination,
+                                 const std::vector<uint8_t>& message) {
+  CheckRank(destination);
+  Mailbox* mailbox = static_cast<Mailbox*>(GetMailbox(rank_, destination));
+  uint64_t size = message.size();
+  WriteToMailbox(mailbox, mailbox_capacity_,
+                 reinterpret_cast<const uint8_t*>(&size), sizeof(size));
+  WriteToMailbox(mailbox, mailbox_capacity_, message.data(), message.size());
+}
+
+void SharedMemoryTransport::Receive(size_t source,
+                                    std::vector<uint8_t>& message) {
+  CheckRank(source);
+  Mailbox* mailbox = static_cast<Mailbox*>(GetMailbox(source, rank_));
+  uint64_t size;
+  ReadFromMailbox(mailbox, mailbox_capacity_,
+                  reinterpret_cast<uint8_t*>(&size), sizeof(size));
+  message.resize(size);
+  ReadFromMailbox(mailbox, mailbox_capacity_, message.data(), size);
+}
+
+void* SharedMemoryTransport::GetMailbox(size_t source,
+                                        size_t destination) const {
+  size_t index = source * rank_count_ + destination;
+  return static_cast<uint8_t*>(mapping_) + GetHeaderSize() +
+         index * GetMailboxSize(mailbox_capacity_);
+}
+
+#else
+
+void SharedMemoryTransport::Create(const std::string&, size_t, size_t) {
+  throw std::runtime_error("Shared memory isn't supported on this platform");
+}
+
+void SharedMemoryTransport::Unlink(const std::string&) {
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string&, size_t rank)
+    : rank_(rank) {
+  throw std::runtime_error("Shared memory isn't supported on this platform");
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+}
+
+void SharedMemoryTransport::Send(size_t, const std::vector<uint8_t>&) {
+}
+
+void SharedMemoryTransport::Receive(size_t, std::vector<uint8_t>&) {
+}
+
+void* SharedMemoryTransport::GetMailbox(size_t, size_t) const {
+  return nullptr;
+}
+
+#endif
+
+size_t SharedMemoryTransport::GetRank() const {
+  return rank_;
+}
+
+size_t SharedMemoryTransport::GetRankCount() const {
+  return rank_count_;
+}
+
+void SharedMemoryTransport::CheckRank(size_t rank) const {
+  if (rank >= rank_count_ || rank == rank_) {
+    throw std::invalid_argument("Can't message rank " +
+                                std::to_string(rank));
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,144 @@
+#include "simulation_thread.h"
+
+#include <chrono>
+#include <utility>
+
+namespace idealgas {
+
+using glm::vec2;
+using std::chrono::steady_clock;
+
+namespace {
+
+typedef std::chrono::duration<double> Seconds;
+
+}  // namespace
+
+SimulationThread::SimulationThread(GasContainer container,
+                                   const SimulationThreadOptions& options)
+    : container_(std::move(container)),
+      options_(options),
+      species_(container_.GetSpecies()),
+      top_left_(container_.GetTopLeftPosition()),
+      bottom_right_(container_.GetBottomRightPosition()),
+      steps_per_second_(options.steps_per_second) {
+  // the reader gets the starting state even before the first step
+  PublishSnapshot();
+  AcquireSnapshot();
+  thread_ = std::thread(&SimulationThread::StepLoop, this);
+}
+
+SimulationThread::~SimulationThread() {
+  Stop();
+}
+
+void SimulationThread::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  stop_requested_.notify_one();
+  thread_.join();
+}
+
+void SimulationThread::SetStepsPerSecond(double steps_per_second) {
+  steps_per_second_ = steps_per_second;
+}
+
+bool SimulationThread::AcquireSnapshot() {
+  return snapshots_.Acquire();
+}
+
+const SimulationSnapshot& SimulationThread::GetSnapshot() const {
+  return snapshots_.GetFront();
+}
+
+uint64_t SimulationThread::GetStepCount() const {
+  return step_count_;
+}
+
+uint64_t SimulationThread::GetDroppedStepCount() const {
+  return dropped_step_count_;
+}
+
+const SpeciesRegistry& SimulationThread::GetSpecies() const {
+  return species_;
+}
+
+const vec2& SimulationThread::GetTopLeftPosition() const {
+  return top_left_;
+}
+
+const vec2& SimulationThread::GetBottomRightPosition() const {
+  return bottom_right_;
+}
+
+const GasContainer& SimulationThread::GetContainer() const {
+  return container_;
+}
+
+void SimulationThread::StepLoop() {
+  steady_clock::time_point next_step = steady_clock::now();
+  steady_clock::time_point last_publish = next_step;
+  double last_steps_per_second = 0;
+
+  while (true) {
+    double steps_per_second = steps_per_second_;
+    if (steps_per_second > 0) {
+      steady_clock::time_point now = steady_clock::now();
+      if (steps_per_second != last_steps_per_second) {
+        // start the new schedule from now
+        next_step = now;
+      }
+      Seconds period(1 / steps_per_second);
+      Seconds lag = now - next_step;
+      if (lag > period * static_cast<double>(options_.max_catch_up_steps)) {
+        dropped_step_count_ += static_cast<uint64_t>(lag / period);
+        next_step = now;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      stop_requested_.wait_until(
+          lock, next_step, [this] { return is_stopping_; });
+      if (is_stopping_) {
+        break;
+      }
+      next_step += std::chrono::duration_cast<steady_clock::duration>(period);
+    } else {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (is_stopping_) {
+        break;
+      }
+    }
+    last_steps_per_second = steps_per_second;
+
+    container_.AdvanceOneFrame();
+    step_count_++;
+
+    steady_clock::time_point now = steady_clock::now();
+    if (Seconds(now - last_publish).count() >= options_.min_publish_interval) {
+      PublishSnapshot();
+      last_publish = now;
+    }
+  }
+
+  // so the reader sees the state the container stopped at
+  PublishSnapshot();
+}
+
+void SimulationThread::PublishSnapshot() {
+  SimulationSnapshot& snapshot = snapshots_.GetBack();
+  snapshot.frame_count = container_.GetFrameCount();
+  snapshot.particles = container_.GetParticleStore();
+  snapshot.species_speeds.resize(species_.Size());
+  for (size_t id = 0; id < species_.Size(); id++) {
+    snapshot.species_speeds[id] =
+        container_.GetSpeciesSpeeds(static_cast<uint8_t>(id));
+  }
+  snapshots_.Publish();
+}
+
+}  // namespace idealgas
@@ -0,0 +1,301 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IDEALGAS_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+namespace {
+
+const char kMagic[8] = {'I', 'G', 'A', 'S', 'S', 'N', 'A', 'P'};
+
+/**
+ * Written as a number so a file from a machine of the other byte order is
+ * detected instead of misread
+ */
+const uint32_t kByteOrderMark = 0x01020304;
+
+/** Alignment of each particle array in the file **/
+const uint64_t kArrayAlignment = 64;
+
+/** Number of float arrays per particle, followed by the species ids **/
+const uint64_t kFloatArrayCount = 6;
+
+/**
+ * Fixed size start of the file. Every field is naturally aligned, so the
+ * struct has no padding and can be copied to and from the file as is.
+ */
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  float top_left_position[2];
+  float container_dimension[2];
+  int64_t seed;
+  uint64_t frame_count;
+  uint64_t particle_count;
+  uint64_t species_count;
+  uint64_t arrays_offset;
+  uint64_t file_size;
+};
+static_assert(sizeof(FileHeader) == 80, "FileHeader must not be padded");
+
+/** One entry of the species table, followed by name_length bytes of name **/
+struct SpeciesRecord {
+  uint32_t name_length;
+  float color[3];
+  float mass;
+  float radius;
+};
+static_assert(sizeof(SpeciesRecord) == 24,
+              "SpeciesRecord must not be padded");
+
+#if defined(IDEALGAS_HAS_MMAP) && defined(MAP_POPULATE)
+/** The whole file is copied right away, so fault every page in at once **/
+const int kMapFlags = MAP_PRIVATE | MAP_POPULATE;
+#elif defined(IDEALGAS_HAS_MMAP)
+const int kMapFlags = MAP_PRIVATE;
+#endif
+
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + kArrayAlignment - 1) / kArrayAlignment * kArrayAlignment;
+}
+
+uint64_t GetFloatArrayStride(uint64_t particle_count) {
+  return AlignUp(particle_count * sizeof(float));
+}
+
+/**
+ * Read-only view of a whole file. Uses mmap where it is available, so only
+ * the pages that are touched are read from disk, and reads the file into
+ * memory elsewhere.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+#if defined(IDEALGAS_HAS_MMAP)
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      throw std::runtime_error("Can't open " + path);
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+      close(file);
+      throw std::runtime_error("Can't read the size of " + path);
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    if (size_ > 0) {
+      mapping_ = mmap(nullptr, size_, PROT_READ, kMapFlags, file, 0);
+    }
+    close(file);  // the mapping stays valid
+    if (mapping_ == MAP_FAILED) {
+      throw std::runtime_error("Can't map " + path);
+    }
+    data_ = static_cast<const char*>(mapping_);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+      throw std::runtime_error("Can't open " + path);
+    }
+    buffer_.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer_.data(), buffer_.size());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+  }
+
+  ~MappedFile() {
+#if defined(IDEALGAS_HAS_MMAP)
+    if (mapping_ != nullptr && mapping_ != MAP_FAILED) {
+      munmap(mapping_, size_);
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* GetData() const {
+    return data_;
+  }
+  size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(IDEALGAS_HAS_MMAP)
+  void* mapping_ = nullptr;
+#else
+  std::vector<char> buffer_;
+#endif
+};
+
+void WritePadding(std::ofstream& file, uint64_t offset) {
+  static const char kZeros[kArrayAlignment] = {};
+  file.write(kZeros, AlignUp(offset) - offset);
+}
+
+}  // namespace
+
+void WriteSnapshot(const std::string& path, const SnapshotHeader& header,
+                   const SpeciesRegistry& species,
+                   const ParticleStore& particles) {
+  uint64_t particle_count = particles.Size();
+  uint64_t species_table_size = 0;
+  for (size_t id = 0; id < species.Size(); id++) {
+    species_table_size += sizeof(SpeciesRecord) +
+                          species.Get(static_cast<uint8_t>(id)).name.size();
+  }
+
+  FileHeader file_header;
+  std::memcpy(file_header.magic, kMagic, sizeof(kMagic));
+  file_header.version = kSnapshotVersion;
+  file_header.byte_order = kByteOrderMark;
+  for (int axis = 0; axis < 2; axis++) {
+    file_header.top_left_position[axis] = header.top_left_position[axis];
+    file_header.container_dimension[axis] = header.container_dimension[axis];
+  }
+  file_header.seed = header.seed;
+  file_header.frame_count = header.frame_count;
+  file_header.particle_count = particle_count;
+  file_header.species_count = species.Size();
+  file_header.arrays_offset =
+      AlignUp(sizeof(FileHeader) + species_table_size);
+  file_header.file_size =
+      file_header.arrays_offset +
+      kFloatArrayCount * GetFloatArrayStride(particle_count) + particle_count;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Can't write " + path);
+  }
+  file.write(reinterpret_cast<const char*>(&file_header),
+             sizeof(file_header));
+
+  for (size_t id = 0; id < species.Size(); id++) {
+    const Species& entry = species.Get(static_cast<uint8_t>(id));
+    SpeciesRecord record = {static_cast<uint32_t>(entry.name.size()),
+                            {entry.color.r, entry.color.g, entry.color.b},
+                            entry.mass,
+                            entry.radius};
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    file.write(entry.name.data(), entry.name.size());
+  }
+  WritePadding(file, sizeof(FileHeader) + species_table_size);
+
+  const float* float_arrays[kFloatArrayCount] = {
+      particles.GetPositionsX(),  particles.GetPositionsY(),
+      particles.GetVelocitiesX(), particles.GetVelocitiesY(),
+      particles.GetRadii(),       particles.GetInverseMasses()};
+  for (const float* array : float_arrays) {
+    file.write(reinterpret_cast<const char*>(array),
+               particle_count * sizeof(float));
+    WritePadding(file, particle_count * sizeof(float));
+  }
+  file.write(reinterpret_cast<const char*>(particles.GetSpeciesIds()),
+             particle_count);
+
+  if (!file) {
+    throw std::runtime_error("Failed writing " + path);
+  }
+}
+
+void ReadSnapshot(const std::string& path, SnapshotHeader& header,
+                  SpeciesRegistry& species, ParticleStore& particles) {
+  MappedFile file(path);
+  const char* data = file.GetData();
+
+  FileHeader file_header;
+  if (file.GetSize() < sizeof(FileHeader)) {
+    throw std::runtime_error(path + " is not a snapshot");
+  }
+  std::memcpy(&file_header, data, sizeof(file_header));
+  if (std::memcmp(file_header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error(path + " is not a snapshot");
+  } else if (file_header.byte_order != kByteOrderMark) {
+    throw std::runtime_error(path + " was written with another byte order");
+  } else if (file_header.version != kSnapshotVersion) {
+    throw std::runtime_error(path + " has unsupported snapshot version " +
+                             std::to_string(file_header.version));
+  } else if (file_header.file_size != file.GetSize() ||
+             file_header.species_count > SpeciesRegistry::kMaxSpeciesCount) {
+    throw std::runtime_error(path + " is truncated or corrupt");
+  }
+
+  // every particle takes more than a byte, which also rules out overflows
+  uint64_t particle_count = file_header.particle_count;
+  if (particle_count > file.GetSize() ||
+      file_header.arrays_offset % kArrayAlignment != 0 ||
+      file_header.arrays_offset +
+              kFloatArrayCount * GetFloatArrayStride(particle_count) +
+              particle_count !=
+          file_header.file_size) {
+    throw std::runtime_error(path + " is truncated or corrupt");
+  }
+  uint64_t float_array_stride = GetFloatArrayStride(particle_count);
+
+  species = SpeciesRegistry();
+  uint64_t offset = sizeof(FileHeader);
+  for (uint64_t id = 0; id < file_header.species_count; id++) {
+    SpeciesRecord record;
+    if (offset + sizeof(record) > file_header.arrays_offset) {
+      throw std::runtime_error(path + " is truncated or corrupt");
+    }
+    std::memcpy(&record, data + offset, sizeof(record));
+    offset += sizeof(record);
+    if (offset + record.name_length > file_header.arrays_offset) {
+      throw std::runtime_error(path + " is truncated or corrupt");
+    }
+    std::string name(data + offset, record.name_length);
+    offset += record.name_length;
+
+    uint8_t registered_id = species.Register(
+        name, Color(record.color[0], record.color[1], record.color[2]),
+        record.mass, record.radius);
+    if (registered_id != id) {
+      throw std::runtime_error(path + " has duplicate species " + name);
+    }
+  }
+
+  // the arrays are aligned in the file and the mapping is page aligned, so
+  // they can be read in place
+  const char* arrays = data + file_header.arrays_offset;
+  const float* float_arrays[kFloatArrayCount];
+  for (uint64_t i = 0; i < kFloatArrayCount; i++) {
+    float_arrays[i] =
+        reinterpret_cast<const float*>(arrays + i * float_array_stride);
+  }
+  const uint8_t* species_ids = reinterpret_cast<const uint8_t*>(
+      arrays + kFloatArrayCount * float_array_stride);
+  if (particle_count > 0 &&
+      *std::max_element(species_ids, species_ids + particle_count) >=
+          file_header.species_count) {
+    throw std::runtime_error(path + " has particles of unknown species");
+  }
+  // x and y positions, then x and y velocities
+  particles.Assign(particle_count, &float_arrays[0], &float_arrays[2],
+                   float_arrays[4], float_arrays[5], species_ids);
+
+  header.top_left_position = glm::vec2(file_header.top_left_position[0],
+                                       file_header.top_left_position[1]);
+  header.container_dimension = glm::vec2(file_header.container_dimension[0],
+                                         file_header.container_dimension[1]);
+  header.seed = file_header.seed;
+  header.frame_count = file_header.frame_count;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,284 @@
+#include "socket_transport.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IDEALGAS_HAS_SOCKETS
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace idealgas {
+
+constexpr double SocketTransport::kDefaultConnectTimeout;
+
+#if defined(IDEALGAS_HAS_SOCKETS)
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/** Pause between attempts to connect to a rank that isn't listening yet **/
+const std::chrono::milliseconds kConnectRetryInterval(20);
+
+#if defined(MSG_NOSIGNAL)
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+/**
+ * Resolves "host:port"
+ *
+ * @param passive whether the address is to listen on
+ * @return        the addresses, to be freed with freeaddrinfo
+ * @throws std::invalid_argument if the address can't be resolved
+ */
+addrinfo* Resolve(const std::string& address, bool passive) {
+  size_t colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    throw std::invalid_argument("Address " + address + " has no port");
+  }
+  std::string host = address.substr(0, colon);
+  std::string port = address.substr(colon + 1);
+
+  addrinfo hints = addrinfo();
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(),
+                  &hints, &result) != 0) {
+    throw std::invalid_argument("Can't resolve " + address);
+  }
+  return result;
+}
+
+void WriteAll(int socket, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    ssize_t count = send(socket, bytes, size, kSendFlags);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    } else if (count <= 0) {
+      throw std::runtime_error("Failed sending to a rank");
+    }
+    bytes += count;
+    size -= static_cast<size_t>(count);
+  }
+}
+
+void ReadAll(int socket, void* data, size_t size) {
+  uint8_t* bytes = static_cast<uint8_t*>(data);
+  while (size > 0) {
+    ssize_t count = recv(socket, bytes, size, 0);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    } else if (count <= 0) {
+      throw std::runtime_error("Connection to a rank was closed");
+    }
+    bytes += count;
+    size -= static_cast<size_t>(count);
+  }
+}
+
+int Listen(const std::string& address, size_t backlog) {
+  addrinfo* addresses = Resolve(address, true);
+  int listener = -1;
+  for (addrinfo* info = addresses; info != nullptr; info = info->ai_next) {
+    listener = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (listener < 0) {
+      continue;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listener, info->ai_addr, info->ai_addrlen) == 0 &&
+        listen(listener, static_cast<int>(backlog)) == 0) {
+      break;
+    }
+    close(listener);
+    listener = -1;
+  }
+  freeaddrinfo(addresses);
+  if (listener < 0) {
+    throw std::runtime_error("Can't listen on " + address);
+  }
+  return listener;
+}
+
+/** Connects to address, retrying until deadline **/
+int Connect(const std::string& address, Clock::time_point deadline) {
+  addrinfo* addresses = Resolve(address, false);
+  int connection = -1;
+  while (connection < 0 && Clock::now() < deadline) {
+    for (addrinfo* info = addresses; info != nullptr; info = info->ai_next) {
+      connection =
+          socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+      if (connection < 0) {
+        continue;
+      }
+      if (connect(connection, info->ai_addr, info->ai_addrlen) == 0) {
+        break;
+      }
+      close(connection);
+      connection = -1;
+    }
+    if (connection < 0) {
+      std::this_thread::sleep_for(kConnectRetryInterval);
+    }
+  }
+  freeaddrinfo(addresses);
+  if (connection < 0) {
+    throw std::runtime_error("Can't connect to " + address);
+  }
+  return connection;
+}
+
+/** Accepts a connection, waiting until deadline **/
+int Accept(int listener, Clock::time_point deadline) {
+  while (true) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - Clock::now());
+    if (remaining.count() <= 0) {
+      throw std::runtime_error("Timed out waiting for ranks to connect");
+    }
+    pollfd poll_fd = {listener, POLLIN, 0};
+    int ready = poll(&poll_fd, 1, static_cast<int>(remaining.count()));
+    if (ready > 0) {
+      int connection = accept(listener, nullptr, nullptr);
+      if (connection >= 0) {
+        return connection;
+      }
+    }
+    if (ready < 0 && errno != EINTR) {
+      throw std::runtime_error("Failed waiting for ranks to connect");
+    }
+  }
+}
+
+}  // namespace
+
+SocketTransport::SocketTransport(const std::vector<std::string>& addresses,
+                                 size_t rank, double connect_timeout)
+    : rank_(rank), sockets_(addresses.size(), -1) {
+  if (rank >= addresses.size()) {
+    throw std::invalid_argument("Rank is out of range");
+  }
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(connect_timeout));
+
+  int listener = Listen(addresses[rank], addresses.size());
+  try {
+    // the lower ranks accept once they're listening; until then the
+    // connection is refused and retried
+    for (size_t other = 0; other < rank; other++) {
+      sockets_[other] = Connect(addresses[other], deadline);
+      uint64_t own_rank = rank;
+      WriteAll(sockets_[other], &own_rank, sizeof(own_rank));
+    }
+    for (size_t i = rank + 1; i < addresses.size(); i++) {
+      int connection = Accept(listener, deadline);
+      uint64_t other;
+      ReadAll(connection, &other, sizeof(other));
+      if (other <= rank || other >= addresses.size() ||
+          sockets_[other] >= 0) {
+        close(connection);
+        throw std::runtime_error("Unexpected connection from rank " +
+                                 std::to_string(other));
+      }
+      sockets_[other] = connection;
+    }
+  } catch (...) {
+    close(listener);
+    CloseSockets();
+    throw;
+  }
+  close(listener);
+
+  // messages are sent whole, so don't delay the small ones
+  for (int connection : sockets_) {
+    if (connection >= 0) {
+      int no_delay = 1;
+      setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay,
+                 sizeof(no_delay));
+    }
+  }
+}
+
+SocketTransport::~SocketTransport() {
+  CloseSockets();
+}
+
+void SocketTransport::Send(size_t destination,
+                           const std::vector<uint8_t>& message) {
+  int connection = GetSocket(destination);
+  uint64_t size = message.size();
+  WriteAll(connection, &size, sizeof(size));
+  WriteAll(connection, message.data(), message.size());
+}
+
+void SocketTransport::Receive(size_t source, std::vector<uint8_t>& message) {
+  int connection = GetSocket(source);
+  uint64_t size;
+  ReadAll(connection, &size, sizeof(size));
+  message.resize(size);
+  ReadAll(connection, message.data(), size);
+}
+
+void SocketTransport::CloseSockets() {
+  for (int& connection : sockets_) {
+    if (connection >= 0) {
+      close(connection);
+    }
+    connection = -1;
+  }
+}
+
+#else
+
+SocketTransport::SocketTransport(const std::vector<std::string>&,
+                                 size_t rank, double)
+    : rank_(rank) {
+  throw std::runtime_error("Sockets aren't supported on this platform");
+}
+
+SocketTransport::~SocketTransport() {
+}
+
+void SocketTransport::Send(size_t, const std::vector<uint8_t>&) {
+}
+
+void SocketTransport::Receive(size_t, std::vector<uint8_t>&) {
+}
+
+void SocketTransport::CloseSockets() {
+}
+
+#endif
+
+size_t SocketTransport::GetRank() const {
+  return rank_;
+}
+
+size_t SocketTransport::GetRankCount() const {
+  return sockets_.size();
+}
+
+int SocketTransport::GetSocket(size_t rank) const {
+  if (rank >= sockets_.size() || rank == rank_) {
+    throw std::invalid_argument("Can't message rank " +
+                                std::to_string(rank));
+  }
+  return sockets_[rank];
+}
+
+}  // namespace idealgas
@@ -0,0 +1,316 @@
+#include "software_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace idealgas {
+
+using glm::vec2;
+
+namespace {
+
+/** Tiles per thread, since some tiles hold many more particles than others **/
+const size_t kTilesChunksPerThread = 4;
+
+/**
+ * Particles smaller than this many pixels are drawn as one pixel, so they
+ * don't vanish when a large container is scaled down
+ */
+const float kMinPixelRadius = 0.5f;
+
+const Color kWallColor = "white";
+
+uint8_t ToByte(float component) {
+  return static_cast<uint8_t>(
+      std::min(std::max(component, 0.0f), 1.0f) * 255 + 0.5f);
+}
+
+/** Color as 4 bytes in R, G, B, A order, held in a uint32_t **/
+uint32_t PackColor(const Color& color) {
+  uint8_t bytes[4] = {ToByte(color.r), ToByte(color.g), ToByte(color.b), 255};
+  uint32_t packed;
+  std::memcpy(&packed, bytes, sizeof(packed));
+  return packed;
+}
+
+/** Fills pixels [begin, end) of a row **/
+void FillSpan(uint8_t* row, long begin, long end, uint32_t color) {
+  for (long x = begin; x < end; x++) {
+    std::memcpy(row + 4 * x, &color, sizeof(color));
+  }
+}
+
+/** Pixel index range [begin, end) covered by [low, high), clipped to size **/
+void ClipRange(float low, float high, size_t size, long& begin, long& end) {
+  begin = std::max(0L, static_cast<long>(std::lround(low)));
+  end = std::min(static_cast<long>(size), static_cast<long>(std::lround(high)));
+}
+
+}  // namespace
+
+const size_t SoftwareRenderer::kTileSize;
+
+Framebuffer::Framebuffer(size_t width, size_t height)
+    : width_(width), height_(height), pixels_(4 * width * height) {
+  Clear(Color());
+}
+
+void Framebuffer::Clear(const Color& color) {
+  uint32_t packed = PackColor(color);
+  for (size_t y = 0; y < height_; y++) {
+    FillSpan(pixels_.data() + 4 * width_ * y, 0, static_cast<long>(width_),
+             packed);
+  }
+}
+
+const uint8_t* Framebuffer::GetPixel(size_t x, size_t y) const {
+  return pixels_.data() + 4 * (width_ * y + x);
+}
+
+size_t Framebuffer::GetWidth() const {
+  return width_;
+}
+
+size_t Framebuffer::GetHeight() const {
+  return height_;
+}
+
+const uint8_t* Framebuffer::GetPixels() const {
+  return pixels_.data();
+}
+
+uint8_t* Framebuffer::GetPixels() {
+  return pixels_.data();
+}
+
+SoftwareRenderer::SoftwareRenderer(size_t thread_count)
+    : thread_pool_(thread_count) {
+}
+
+void SoftwareRenderer::SetViewport(const Viewport& viewport) {
+  viewport_ = viewport;
+}
+
+const Viewport& SoftwareRenderer::GetViewport() const {
+  return viewport_;
+}
+
+void SoftwareRenderer::DrawGasContainer(const GasContainer& container,
+                                        Framebuffer& framebuffer) {
+  DrawParticles(container.GetParticleStore(), container.GetSpecies(),
+                container.GetTopLeftPosition(),
+                container.GetBottomRightPosition(), framebuffer);
+}
+
+void SoftwareRenderer::DrawParticles(const ParticleStore& particles,
+                                     const SpeciesRegistry& species,
+                                     const vec2& top_left,
+                                     const vec2& bottom_right,
+                                     Framebuffer& framebuffer) {
+  StrokeRect(top_left, bottom_right, kWallColor, framebuffer);
+
+  species_colors_.resize(species.Size());
+  for (size_t id = 0; id < species.Size(); id++) {
+    species_colors_[id] =
+        PackColor(species.Get(static_cast<uint8_t>(id)).color);
+  }
+
+  size_t width = framebuffer.GetWidth();
+  size_t height = framebuffer.GetHeight();
+  size_t tile_columns = (width + kTileSize - 1) / kTileSize;
+  size_t tile_rows = (height + kTileSize - 1) / kTileSize;
+  size_t tile_count = tile_columns * tile_rows;
+  if (tile_count == 0) {
+    return;
+  }
+
+  const float* positions_x = particles.GetPositionsX();
+  const float* positions_y = particles.GetPositionsY();
+  const float* radii = particles.GetRadii();
+  float scale = viewport_.scale;
+
+  // finds the range of tiles the bounding box of a particle overlaps
+  struct TileRange {
+    size_t first_column;
+    size_t first_row;
+    size_t last_column;
+    size_t last_row;
+  };
+  auto find_tiles = [&](size_t i, TileRange& range) -> bool {
+    float x = (positions_x[i] - viewport_.origin.x) * scale;
+    float y = (positions_y[i] - viewport_.origin.y) * scale;
+    float radius = std::max(radii[i] * scale, kMinPixelRadius);
+    float left = std::floor(x - radius);
+    float top = std::floor(y - radius);
+    float right = std::floor(x + radius);
+    float bottom = std::floor(y + radius);
+    if (right < 0 || bottom < 0 || left >= static_cast<float>(width) ||
+        top >= static_cast<float>(height)) {
+      return false;
+    }
+    range.first_column = static_cast<size_t>(std::max(left, 0.0f)) / kTileSize;
+    range.first_row = static_cast<size_t>(std::max(top, 0.0f)) / kTileSize;
+    range.last_column =
+        std::min(static_cast<size_t>(right) / kTileSize, tile_columns - 1);
+    range.last_row =
+        std::min(static_cast<size_t>(bottom) / kTileSize, tile_rows - 1);
+    return true;
+  };
+
+  // counting sort of the particles into tiles, in index order
+  tile_offsets_.assign(tile_count + 1, 0);
+  TileRange range;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    if (!find_tiles(i, range)) {
+      continue;
+    }
+    for (size_t row = range.first_row; row <= range.last_row; row++) {
+      for (size_t column = range.first_column; column <= range.last_column;
+           column++) {
+        tile_offsets_[row * tile_columns + column + 1]++;
+      }
+    }
+  }
+  for (size_t tile = 0; tile < tile_count; tile++) {
+    tile_offsets_[tile + 1] += tile_offsets_[tile];
+  }
+  tile_particles_.resize(tile_offsets_[tile_count]);
+  tile_cursors_.assign(tile_offsets_.begin(), tile_offsets_.end() - 1);
+  for (size_t i = 0; i < particles.Size(); i++) {
+    if (!find_tiles(i, range)) {
+      continue;
+    }
+    for (size_t row = range.first_row; row <= range.last_row; row++) {
+      for (size_t column = range.first_column; column <= range.last_column;
+           column++) {
+        size_t& cursor = tile_cursors_[row * tile_columns + column];
+        tile_particles_[cursor++] = static_cast<uint32_t>(i);
+      }
+    }
+  }
+
+  const uint8_t* species_ids = particles.GetSpeciesIds();
+  uint8_t* pixels = framebuffer.GetPixels();
+  thread_pool_.ParallelFor(
+      tile_count, thread_pool_.GetThreadCount() * kTilesChunksPerThread,
+      [&](size_t begin, size_t end, size_t) {
+        for (size_t tile = begin; tile < end; tile++) {
+          long tile_left = static_cast<long>(tile % tile_columns * kTileSize);
+          long tile_top = static_cast<long>(tile / tile_columns * kTileSize);
+          long tile_right =
+              std::min(tile_left + static_cast<long>(kTileSize),
+                       static_cast<long>(width));
+          long tile_bottom =
+              std::min(tile_top + static_cast<long>(kTileSize),
+                       static_cast<long>(height));
+
+          for (size_t k = tile_offsets_[tile]; k < tile_offsets_[tile + 1];
+               k++) {
+            uint32_t i = tile_particles_[k];
+            float x = (positions_x[i] - viewport_.origin.x) * scale;
+            float y = (positions_y[i] - viewport_.origin.y) * scale;
+            float radius = radii[i] * scale;
+            uint32_t color = species_colors_[species_ids[i]];
+
+            if (radius < kMinPixelRadius) {
+              long column = static_cast<long>(std::floor(x));
+              long row = static_cast<long>(std::floor(y));
+              if (column >= tile_left && column < tile_right &&
+                  row >= tile_top && row < tile_bottom) {
+                FillSpan(pixels + 4 * width * row, column, column + 1, color);
+              }
+              continue;
+            }
+
+            // fill the pixels whose centers are inside the circle, one row
+            // at a time
+            long first_row = std::max(
+                tile_top, static_cast<long>(std::ceil(y - radius - 0.5f)));
+            long last_row = std::min(
+                tile_bottom - 1,
+                static_cast<long>(std::floor(y + radius - 0.5f)));
+            for (long row = first_row; row <= last_row; row++) {
+              float dy = row + 0.5f - y;
+              float half_width_squared = radius * radius - dy * dy;
+              if (half_width_squared < 0) {
+                continue;
+              }
+              float half_width = std::sqrt(half_width_squared);
+              long first_column = std::max(
+                  tile_left,
+                  static_cast<long>(std::ceil(x - half_width - 0.5f)));
+              long last_column = std::min(
+                  tile_right - 1,
+                  static_cast<long>(std::floor(x + half_width - 0.5f)));
+              FillSpan(pixels + 4 * width * row, first_column,
+                       last_column + 1, color);
+            }
+          }
+        }
+      });
+}
+
+void SoftwareRenderer::DrawHistogram(const Histogram& histogram,
+                                     Framebuffer& framebuffer) {
+  vec2 position = ToPixel(histogram.GetPosition());
+  vec2 dimension = histogram.GetDimensions() * viewport_.scale;
+  float bottom_y = position[1] + dimension[1];
+
+  const std::vector<float>& bins = histogram.GetBins();
+  float max_freq = 0;
+  for (float frequency : bins) {
+    max_freq = std::max(frequency, max_freq);
+  }
+  if (max_freq > 0) {
+    float y_step = dimension[1] / max_freq;
+    float bar_width = histogram.GetBarWidth() * viewport_.scale;
+    float left_x = position[0];
+    for (float value : bins) {
+      FillRect(left_x, bottom_y - y_step * value, left_x + bar_width,
+               bottom_y, histogram.GetBarColor(), framebuffer);
+      left_x += bar_width;
+    }
+  }
+
+  // y axis, then x axis
+  const Color& axis_color = histogram.GetAxisLabelColor();
+  FillRect(position[0], position[1], position[0] + 1, bottom_y + 1,
+           axis_color, framebuffer);
+  FillRect(position[0], bottom_y, position[0] + dimension[0], bottom_y + 1,
+           axis_color, framebuffer);
+}
+
+vec2 SoftwareRenderer::ToPixel(const vec2& position) const {
+  return (position - viewport_.origin) * viewport_.scale;
+}
+
+void SoftwareRenderer::FillRect(float left, float top, float right,
+                                float bottom, const Color& color,
+                                Framebuffer& framebuffer) const {
+  long first_column;
+  long end_column;
+  long first_row;
+  long end_row;
+  ClipRange(left, right, framebuffer.GetWidth(), first_column, end_column);
+  ClipRange(top, bottom, framebuffer.GetHeight(), first_row, end_row);
+  uint32_t packed = PackColor(color);
+  for (long row = first_row; row < end_row; row++) {
+    FillSpan(framebuffer.GetPixels() + 4 * framebuffer.GetWidth() * row,
+             first_column, end_column, packed);
+  }
+}
+
+void SoftwareRenderer::StrokeRect(const vec2& top_left,
+                                  const vec2& bottom_right,
+                                  const Color& color,
+                                  Framebuffer& framebuffer) const {
+  vec2 start = ToPixel(top_left);
+  vec2 end = ToPixel(bottom_right);
+  FillRect(start.x, start.y, end.x, start.y + 1, color, framebuffer);
+  FillRect(start.x, end.y - 1, end.x, end.y, color, framebuffer);
+  FillRect(start.x, start.y, start.x + 1, end.y, color, framebuffer);
+  FillRect(end.x - 1, start.y, end.x, end.y, color, framebuffer);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,261 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace idealgas {
+
+using glm::vec2;
+using std::vector;
+
+void SpatialGrid::Rebuild(const ParticleStore& particles,
+                          const vec2& top_left, const vec2& bottom_right) {
+  float max_radius = particles.GetMaxRadius();
+
+  float width = bottom_right[0] - top_left[0];
+  float height = bottom_right[1] - top_left[1];
+
+  // a cell must be at least one diameter wide so that touching particles are
+  // always in the same or neighboring cells. Cells may be wider than that to
+  // keep the number of cells proportional to the number of particles
+  size_t max_cells =
+      std::max<size_t>(1, kMaxCellsPerParticle * particles.Size());
+  float min_cell_size =
+      std::sqrt(width * height / static_cast<float>(max_cells));
+  cell_size_ = std::max(2 * max_radius, min_cell_size);
+  if (cell_size_ <= 0) {
+    cell_size_ = 1;
+  }
+
+  origin_ = top_left;
+  column_count_ = GetCellCount(width, x_boundary_);
+  row_count_ = GetCellCount(height, y_boundary_);
+  cell_sides_ = vec2(cell_size_);
+  if (x_boundary_ == Boundary::kPeriodic) {
+    cell_sides_[0] = width / static_cast<float>(column_count_);
+  }
+  if (y_boundary_ == Boundary::kPeriodic) {
+    cell_sides_[1] = height / static_cast<float>(row_count_);
+  }
+
+  // counting sort of the particle indices by cell
+  size_t cell_count = column_count_ * row_count_;
+  cell_starts_.assign(cell_count + 1, 0);
+  particle_cells_.resize(particles.Size());
+  for (size_t i = 0; i < particles.Size(); i++) {
+    particle_cells_[i] = GetCellIndex(particles.GetPosition(i));
+    cell_starts_[particle_cells_[i] + 1]++;
+  }
+  for (size_t cell = 0; cell < cell_count; cell++) {
+    cell_starts_[cell + 1] += cell_starts_[cell];
+  }
+
+  cell_particles_.resize(particles.Size());
+  next_slots_.assign(cell_starts_.begin(), cell_starts_.end() - 1);
+  for (size_t i = 0; i < particles.Size(); i++) {
+    cell_particles_[next_slots_[particle_cells_[i]]++] = i;
+  }
+
+  // gather the fields in cell order so neighboring cells are contiguous
+  sorted_positions_x_.resize(particles.Size());
+  sorted_positions_y_.resize(particles.Size());
+  sorted_velocities_x_.resize(particles.Size());
+  sorted_velocities_y_.resize(particles.Size());
+  sorted_radii_.resize(particles.Size());
+  for (size_t slot = 0; slot < particles.Size(); slot++) {
+    size_t i = cell_particles_[slot];
+    sorted_positions_x_[slot] = particles.GetPositionsX()[i];
+    sorted_positions_y_[slot] = particles.GetPositionsY()[i];
+    sorted_velocities_x_[slot] = particles.GetVelocitiesX()[i];
+    sorted_velocities_y_[slot] = particles.GetVelocitiesY()[i];
+    sorted_radii_[slot] = particles.GetRadii()[i];
+  }
+  sorted_particles_.positions_x = sorted_positions_x_.data();
+  sorted_particles_.positions_y = sorted_positions_y_.data();
+  sorted_particles_.velocities_x = sorted_velocities_x_.data();
+  sorted_particles_.velocities_y = sorted_velocities_y_.data();
+  sorted_particles_.radii = sorted_radii_.data();
+  sorted_particles_.period_x = x_boundary_ == Boundary::kPeriodic ? width : 0;
+  sorted_particles_.period_y = y_boundary_ == Boundary::kPeriodic ? height : 0;
+}
+
+void SpatialGrid::FindCollidingPairs(const ParticleStore& particles,
+                                     vector<IndexPair>& pairs) const {
+  pairs.clear();
+  FindCollidingPairsInRows(particles, 0, row_count_, pairs);
+  std::sort(pairs.begin(), pairs.end());
+}
+
+void SpatialGrid::FindCollidingPairsInRows(const ParticleStore&,
+                                           size_t first_row, size_t end_row,
+                                           vector<IndexPair>& pairs) const {
+  // with a single cell along a periodic axis, the cell is its own neighbor
+  // and is already covered
+  bool wraps_x = x_boundary_ == Boundary::kPeriodic && column_count_ > 1;
+  bool wraps_y = y_boundary_ == Boundary::kPeriodic && row_count_ > 1;
+  for (size_t row = first_row; row < end_row && row < row_count_; row++) {
+    for (size_t column = 0; column < column_count_; column++) {
+      size_t cell = row * column_count_ + column;
+      bool has_right = column + 1 < column_count_;
+
+      // only visit the "forward" half of the neighbors so that each pair of
+      // adjacent cells is visited exactly once. The cell and the one to its
+      // right are contiguous, and so are the three cells below. Neighbors
+      // across a periodic edge are runs of their own
+      size_t same_row_end = cell_starts_[has_right ? cell + 2 : cell + 1];
+      size_t runs[3][2];
+      size_t run_count = 0;
+      if (!has_right && wraps_x) {
+        size_t right = row * column_count_;
+        runs[run_count][0] = cell_starts_[right];
+        runs[run_count++][1] = cell_starts_[right + 1];
+      }
+      if (row + 1 < row_count_ || wraps_y) {
+        size_t below_row_start = (row + 1) % row_count_ * column_count_;
+        size_t below = below_row_start + column;
+        runs[run_count][0] = cell_starts_[column > 0 ? below - 1 : below];
+        runs[run_count++][1] = cell_starts_[has_right ? below + 2 : below + 1];
+        if (column == 0 && wraps_x) {
+          size_t below_left = below_row_start + column_count_ - 1;
+          runs[run_count][0] = cell_starts_[below_left];
+          runs[run_count++][1] = cell_starts_[below_left + 1];
+        }
+        if (!has_right && wraps_x) {
+          runs[run_count][0] = cell_starts_[below_row_start];
+          runs[run_count++][1] = cell_starts_[below_row_start + 1];
+        }
+      }
+
+      for (size_t slot = cell_starts_[cell]; slot < cell_starts_[cell + 1];
+           slot++) {
+        // within the cell, only test each particle against the ones after it
+        CollectPairs(slot, slot + 1, same_row_end, pairs);
+        for (size_t run = 0; run < run_count; run++) {
+          CollectPairs(slot, runs[run][0], runs[run][1], pairs);
+        }
+      }
+    }
+  }
+}
+
+void SpatialGrid::CollectPairs(size_t slot, size_t begin, size_t end,
+                               vector<IndexPair>& pairs) const {
+  size_t first = cell_particles_[slot];
+  for (size_t block = begin; block < end; block += Narrowphase::kBlockSize) {
+    size_t count = std::min(Narrowphase::kBlockSize, end - block);
+    uint32_t contacts =
+        narrowphase_.FindContacts(sorted_particles_, slot, block, count);
+    for (size_t i = 0; contacts != 0; i++, contacts >>= 1) {
+      if (contacts & 1) {
+        size_t second = cell_particles_[block + i];
+        pairs.push_back(
+            IndexPair(std::min(first, second), std::max(first, second)));
+      }
+    }
+  }
+}
+
+size_t SpatialGrid::GetCellIndex(const vec2& position) const {
+  // positions outside of the container are clamped into the edge cells
+  float column = std::floor((position[0] - origin_[0]) / cell_sides_[0]);
+  float row = std::floor((position[1] - origin_[1]) / cell_sides_[1]);
+  column = std::min(std::max(column, 0.0f),
+                    static_cast<float>(column_count_ - 1));
+  row = std::min(std::max(row, 0.0f), static_cast<float>(row_count_ - 1));
+
+  return static_cast<size_t>(row) * column_count_ +
+         static_cast<size_t>(column);
+}
+
+size_t SpatialGrid::GetCellCount(float length, Boundary boundary) const {
+  if (boundary == Boundary::kWall) {
+    return std::max<size_t>(
+        1, static_cast<size_t>(std::ceil(length / cell_size_)));
+  }
+
+  // the cells must tile a periodic axis, so they are stretched to fit rather
+  // than overhanging the far edge. With 2 cells, each would be the neighbor
+  // of the other on both sides, so those axes get a single cell instead
+  size_t count = static_cast<size_t>(std::floor(length / cell_size_));
+  return count < 3 ? 1 : count;
+}
+
+void SpatialGrid::GetCellRange(float low, float high, size_t axis,
+                               size_t& first, size_t& count) const {
+  size_t cell_count = axis == 0 ? column_count_ : row_count_;
+  Boundary boundary = axis == 0 ? x_boundary_ : y_boundary_;
+  float first_cell = std::floor((low - origin_[axis]) / cell_sides_[axis]);
+  float last_cell = std::floor((high - origin_[axis]) / cell_sides_[axis]);
+  float max_cell = static_cast<float>(cell_count - 1);
+
+  if (boundary == Boundary::kPeriodic) {
+    // the range wraps around the axis, and covers all of it when it is as
+    // long as the axis
+    if (last_cell - first_cell >= max_cell) {
+      first = 0;
+      count = cell_count;
+      return;
+    }
+    float cells = static_cast<float>(cell_count);
+    first = static_cast<size_t>(first_cell -
+                                std::floor(first_cell / cells) * cells);
+    count = static_cast<size_t>(last_cell - first_cell) + 1;
+    return;
+  }
+
+  // like GetCellIndex, cells past the edges are clamped
+  first_cell = std::min(std::max(first_cell, 0.0f), max_cell);
+  last_cell = std::min(std::max(last_cell, 0.0f), max_cell);
+  first = static_cast<size_t>(first_cell);
+  count = last_cell >= first_cell
+              ? static_cast<size_t>(last_cell - first_cell) + 1
+              : 0;
+}
+
+void SpatialGrid::FindParticlesInBox(const vec2& low, const vec2& high,
+                                     std::vector<size_t>& indices) const {
+  size_t first_column = 0;
+  size_t column_span = 0;
+  size_t first_row = 0;
+  size_t row_span = 0;
+  GetCellRange(low[0], high[0], 0, first_column, column_span);
+  GetCellRange(low[1], high[1], 1, first_row, row_span);
+  for (size_t r = 0; r < row_span; r++) {
+    size_t row_start = (first_row + r) % row_count_ * column_count_;
+
+    // the cells of a row are contiguous in cell_particles_, in two runs when
+    // the columns wrap around a periodic edge
+    size_t end_column = first_column + column_span;
+    size_t begin = cell_starts_[row_start + first_column];
+    size_t end = cell_starts_[row_start + std::min(end_column, column_count_)];
+    indices.insert(indices.end(), cell_particles_.begin() + begin,
+                   cell_particles_.begin() + end);
+    if (end_column > column_count_) {
+      begin = cell_starts_[row_start];
+      end = cell_starts_[row_start + end_column - column_count_];
+      indices.insert(indices.end(), cell_particles_.begin() + begin,
+                     cell_particles_.begin() + end);
+    }
+  }
+}
+
+void SpatialGrid::SetBoundaries(Boundary x_boundary, Boundary y_boundary) {
+  x_boundary_ = x_boundary;
+  y_boundary_ = y_boundary;
+}
+
+void SpatialGrid::SetNarrowphase(const Narrowphase& narrowphase) {
+  narrowphase_ = narrowphase;
+}
+
+float SpatialGrid::GetCellSize() const {
+  return cell_size_;
+}
+size_t SpatialGrid::GetColumnCount() const {
+  return column_count_;
+}
+size_t SpatialGrid::GetRowCount() const {
+  return row_count_;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,99 @@
+#include "species_registry.h"
+
+#include <stdexcept>
+
+namespace idealgas {
+
+using std::string;
+
+const size_t SpeciesRegistry::kMaxSpeciesCount;
+
+uint8_t SpeciesRegistry::Register(const string& name, const Color& color,
+                                  float mass, float radius) {
+  if (!(mass > 0) || !(radius > 0)) {
+    throw std::invalid_argument("Species " + name +
+                                " needs a positive mass and radius");
+  }
+
+  if (Contains(name)) {
+    uint8_t id = GetId(name);
+    if (species_[id].mass != mass || species_[id].radius != radius) {
+      throw std::invalid_argument("Species " + name +
+                                  " is already registered with a different "
+                                  "mass or radius");
+    }
+    return id;
+  }
+
+  if (species_.size() >= kMaxSpeciesCount) {
+    throw std::length_error("Too many species registered");
+  }
+
+  Species species;
+  species.name = name;
+  species.color = color;
+  species.mass = mass;
+  species.radius = radius;
+  species_.push_back(species);
+  RebuildPairTables();
+  return static_cast<uint8_t>(species_.size() - 1);
+}
+
+bool SpeciesRegistry::Contains(const string& name) const {
+  for (const auto& species : species_) {
+    if (species.name == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t SpeciesRegistry::GetId(const string& name) const {
+  for (size_t id = 0; id < species_.size(); id++) {
+    if (species_[id].name == name) {
+      return static_cast<uint8_t>(id);
+    }
+  }
+  throw std::out_of_range("No species named " + name);
+}
+
+const Species& SpeciesRegistry::Get(uint8_t id) const {
+  return species_[id];
+}
+
+size_t SpeciesRegistry::Size() const {
+  return species_.size();
+}
+
+bool SpeciesRegistry::IsEmpty() const {
+  return species_.empty();
+}
+
+float SpeciesRegistry::GetMassFraction(uint8_t species_one,
+                                       uint8_t species_two) const {
+  return mass_fractions_[species_one * species_.size() + species_two];
+}
+
+float SpeciesRegistry::GetRadiusSum(uint8_t species_one,
+                                    uint8_t species_two) const {
+  return radius_sums_[species_one * species_.size() + species_two];
+}
+
+void SpeciesRegistry::RebuildPairTables() {
+  size_t count = species_.size();
+  mass_fractions_.resize(count * count);
+  radius_sums_.resize(count * count);
+
+  for (size_t one = 0; one < count; one++) {
+    for (size_t two = 0; two < count; two++) {
+      float mass_one = species_[one].mass;
+      float mass_two = species_[two].mass;
+      mass_fractions_[one * count + two] =
+          2 * mass_two / (mass_one + mass_two);
+      radius_sums_[one * count + two] =
+          species_[one].radius + species_[two].radius;
+    }
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,94 @@
+#include "speed_distribution.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace idealgas {
+
+constexpr float SpeedDistribution::kDefaultMaxSpeed;
+const size_t SpeedDistribution::kDefaultBinCount;
+
+SpeedDistribution::SpeedDistribution(float max_speed, size_t bin_count)
+    : max_speed_(max_speed), bin_counts_(bin_count, 0) {
+  if (!(max_speed > 0) || bin_count == 0) {
+    throw std::invalid_argument(
+        "A speed distribution needs a positive max speed and bins");
+  }
+}
+
+void SpeedDistribution::Add(float speed) {
+  float bin = speed / GetBinWidth();
+  size_t index = bin < static_cast<float>(bin_counts_.size())
+                     ? static_cast<size_t>(std::max(bin, 0.0f))
+                     : bin_counts_.size() - 1;
+  bin_counts_[index]++;
+  sample_count_++;
+  speed_sum_ += speed;
+  sketch_.Add(speed);
+}
+
+void SpeedDistribution::AddFrame(const std::vector<float>& speeds) {
+  for (float speed : speeds) {
+    Add(speed);
+  }
+  frame_count_++;
+}
+
+void SpeedDistribution::Add(const SpeedDistribution& other) {
+  if (other.max_speed_ != max_speed_ ||
+      other.bin_counts_.size() != bin_counts_.size()) {
+    throw std::invalid_argument("Speed distributions have different bins");
+  }
+  for (size_t i = 0; i < bin_counts_.size(); i++) {
+    bin_counts_[i] += other.bin_counts_[i];
+  }
+  sample_count_ += other.sample_count_;
+  frame_count_ += other.frame_count_;
+  speed_sum_ += other.speed_sum_;
+  sketch_.Add(other.sketch_);
+}
+
+uint64_t SpeedDistribution::GetSampleCount() const {
+  return sample_count_;
+}
+
+uint64_t SpeedDistribution::GetFrameCount() const {
+  return frame_count_;
+}
+
+double SpeedDistribution::GetMean() const {
+  return sample_count_ == 0 ? 0 : speed_sum_ / sample_count_;
+}
+
+float SpeedDistribution::GetQuantile(double fraction) const {
+  return sketch_.GetQuantile(fraction);
+}
+
+const std::vector<uint64_t>& SpeedDistribution::GetBinCounts() const {
+  return bin_counts_;
+}
+
+std::vector<double> SpeedDistribution::GetAverageBinCounts() const {
+  std::vector<double> averages(bin_counts_.size(), 0);
+  if (frame_count_ == 0) {
+    return averages;
+  }
+  for (size_t i = 0; i < bin_counts_.size(); i++) {
+    averages[i] = static_cast<double>(bin_counts_[i]) / frame_count_;
+  }
+  return averages;
+}
+
+const QuantileSketch& SpeedDistribution::GetSketch() const {
+  return sketch_;
+}
+
+float SpeedDistribution::GetMaxSpeed() const {
+  return max_speed_;
+}
+
+float SpeedDistribution::GetBinWidth() const {
+  return max_speed_ / static_cast<float>(bin_counts_.size());
+}
+
+}  // namespace idealgas
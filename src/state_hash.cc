@@ -0,0 +1,57 @@
+#include "state_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace idealgas {
+
+namespace {
+
+const uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+const uint64_t kFnvPrime = 0x100000001b3ULL;
+
+/** Folds the bits of count values into hash, FNV-1a style a word at a time **/
+template <typename Value>
+uint64_t HashArray(uint64_t hash, const Value* values, size_t count) {
+  static_assert(sizeof(Value) <= sizeof(uint32_t), "Values must fit a word");
+  for (size_t i = 0; i < count; i++) {
+    // copied out, so -0 and 0 or two NaNs with different payloads differ
+    uint32_t bits = 0;
+    std::memcpy(&bits, &values[i], sizeof(Value));
+    hash = (hash ^ bits) * kFnvPrime;
+  }
+  return hash;
+}
+
+/** Final mix of SplitMix64, spreads every input bit over the output **/
+uint64_t Mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+}  // namespace
+
+uint64_t HashParticleState(const ParticleStore& particles) {
+  size_t count = particles.Size();
+  uint64_t hash = (kFnvOffsetBasis ^ count) * kFnvPrime;
+  hash = HashArray(hash, particles.GetPositionsX(), count);
+  hash = HashArray(hash, particles.GetPositionsY(), count);
+  hash = HashArray(hash, particles.GetVelocitiesX(), count);
+  hash = HashArray(hash, particles.GetVelocitiesY(), count);
+  hash = HashArray(hash, particles.GetSpeciesIds(), count);
+  return Mix(hash);
+}
+
+uint64_t CombineStateHashes(uint64_t previous_hash, uint64_t state_hash) {
+  return Mix(previous_hash * kFnvPrime ^ state_hash);
+}
+
+size_t FindFirstDivergentFrame(const std::vector<uint64_t>& one,
+                               const std::vector<uint64_t>& two) {
+  size_t length = std::min(one.size(), two.size());
+  return std::mismatch(one.begin(), one.begin() + length, two.begin()).first -
+         one.begin();
+}
+
+}  // namespace idealgas
@@ -0,0 +1,99 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace idealgas {
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  thread_count = std::max<size_t>(1, thread_count);
+  for (size_t i = 1; i < thread_count; i++) {
+    workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, const RangeFunction& body) {
+  ParallelFor(count, GetThreadCount(), body);
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunk_count,
+                             const RangeFunction& body) {
+  chunk_count = std::max<size_t>(1, chunk_count);
+
+  // nothing to share, so skip the synchronization
+  if (workers_.empty() || chunk_count == 1) {
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+      body(count * chunk / chunk_count, count * (chunk + 1) / chunk_count,
+           chunk);
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  body_ = &body;
+  count_ = count;
+  chunk_count_ = chunk_count;
+  next_chunk_ = 0;
+  busy_workers_ = 1;  // the calling thread
+  generation_++;
+  work_ready_.notify_all();
+
+  RunChunks(lock);
+  busy_workers_--;
+  work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+  body_ = nullptr;
+}
+
+size_t ThreadPool::GetThreadCount() const {
+  return workers_.size() + 1;
+}
+
+size_t ThreadPool::GetHardwareThreadCount() {
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  size_t seen_generation = generation_;
+  while (true) {
+    work_ready_.wait(lock, [this, seen_generation] {
+      return is_stopping_ || generation_ != seen_generation;
+    });
+    if (is_stopping_) {
+      return;
+    }
+    seen_generation = generation_;
+
+    busy_workers_++;
+    RunChunks(lock);
+    busy_workers_--;
+    if (busy_workers_ == 0) {
+      work_done_.notify_all();
+    }
+  }
+}
+
+void ThreadPool::RunChunks(std::unique_lock<std::mutex>& lock) {
+  while (next_chunk_ < chunk_count_) {
+    size_t chunk = next_chunk_++;
+    const RangeFunction& body = *body_;
+    size_t begin = count_ * chunk / chunk_count_;
+    size_t end = count_ * (chunk + 1) / chunk_count_;
+
+    lock.unlock();
+    body(begin, end, chunk);
+    lock.lock();
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,532 @@
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace idealgas {
+
+namespace {
+
+const char kMagic[8] = {'I', 'G', 'A', 'S', 'T', 'R', 'A', 'J'};
+const uint32_t kTrajectoryVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+
+/** Largest quantized position, the bottom right edge of the container **/
+const float kPositionScale = 65535;
+
+/** Largest quantized velocity, the velocity limit **/
+const float kVelocityScale = 32767;
+
+/** Values per particle and frame: x, y, vx and vy **/
+const size_t kChannelCount = 4;
+
+/**
+ * Fixed size start of the file. Every field is naturally aligned, so the
+ * struct has no padding and can be copied to and from the file as is.
+ */
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  float top_left_position[2];
+  float container_dimension[2];
+  float velocity_limit;
+  uint32_t stride;
+  uint32_t species_count;
+  uint32_t frames_per_chunk;
+  uint64_t particle_count;
+};
+static_assert(sizeof(FileHeader) == 56, "FileHeader must not be padded");
+
+/** Start of each chunk, followed by byte_size bytes of encoded frames **/
+struct ChunkHeader {
+  uint64_t byte_size;
+  uint32_t frame_count;
+  uint32_t reserved;
+};
+static_assert(sizeof(ChunkHeader) == 16, "ChunkHeader must not be padded");
+
+/** Maps small negative and positive differences to small unsigned values **/
+uint32_t ZigZagEncode(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^
+         (value < 0 ? ~uint32_t(0) : uint32_t(0));
+}
+
+int32_t ZigZagDecode(uint32_t value) {
+  return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+/** Appends value in 7-bit groups, low group first **/
+void AppendVarint(std::vector<uint8_t>& bytes, uint64_t value) {
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+}
+
+/** Bytes AppendVarint takes at most, for 64 bits in 7-bit groups **/
+const size_t kMaxVarintBytes = 10;
+
+/**
+ * Reads a varint written by AppendVarint
+ *
+ * @throws std::runtime_error if it runs past the end or is too long
+ */
+uint64_t ReadVarint(const std::vector<uint8_t>& bytes, size_t& position) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (position >= bytes.size()) {
+      throw std::runtime_error("Trajectory chunk is truncated");
+    }
+    uint8_t byte = bytes[position++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return value;
+    }
+  }
+  throw std::runtime_error("Trajectory chunk is corrupt");
+}
+
+/**
+ * Bytes a value of a channel takes at most. The differences of 16-bit values
+ * need 17 bits after zigzag encoding, and a run of zeros takes at most as
+ * many bytes as values.
+ */
+const size_t kMaxBytesPerValue = 3;
+
+uint8_t* WriteVarint(uint8_t* bytes, uint32_t value) {
+  while (value >= 0x80) {
+    *bytes++ = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  *bytes++ = static_cast<uint8_t>(value);
+  return bytes;
+}
+
+/**
+ * Appends the zigzag varint of the difference of each value from the
+ * previous frame. Velocities only change on collisions, so a run of zero
+ * differences is written as a zero followed by the run length minus one.
+ */
+template <typename T>
+void EncodeChannel(const std::vector<T>& values, int32_t* previous_values,
+                   std::vector<uint8_t>& bytes) {
+  size_t start = bytes.size();
+  bytes.resize(start + kMaxBytesPerValue * values.size());
+  uint8_t* output = bytes.data() + start;
+
+  size_t i = 0;
+  while (i < values.size()) {
+    int32_t difference = values[i] - previous_values[i];
+    previous_values[i] = values[i];
+    i++;
+    if (difference != 0) {
+      output = WriteVarint(output, ZigZagEncode(difference));
+      continue;
+    }
+    size_t run_start = i;
+    while (i < values.size() && values[i] == previous_values[i]) {
+      i++;
+    }
+    *output++ = 0;
+    output = WriteVarint(output, static_cast<uint32_t>(i - run_start));
+  }
+  bytes.resize(output - bytes.data());
+}
+
+uint16_t QuantizePosition(float position, float origin, float extent) {
+  float scaled = (position - origin) / extent * kPositionScale;
+  scaled = std::min(std::max(scaled, 0.0f), kPositionScale);
+  return static_cast<uint16_t>(scaled + 0.5f);
+}
+
+int16_t QuantizeVelocity(float velocity, float limit) {
+  float scaled = velocity / limit * kVelocityScale;
+  scaled = std::min(std::max(scaled, -kVelocityScale), kVelocityScale);
+  return static_cast<int16_t>(std::lround(scaled));
+}
+
+template <typename T>
+void ReadValue(std::ifstream& file, T& value, const std::string& path) {
+  if (!file.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error(path + " is truncated");
+  }
+}
+
+}  // namespace
+
+TrajectoryWriter::TrajectoryWriter(const std::string& path,
+                                   const GasContainer& container,
+                                   const TrajectoryOptions& options)
+    : path_(path),
+      options_(options),
+      top_left_(container.GetTopLeftPosition()),
+      dimension_(container.GetBottomRightPosition() -
+                 container.GetTopLeftPosition()),
+      container_particle_count_(container.GetParticleStore().Size()) {
+  if (options.stride == 0 || options.frames_per_chunk == 0 ||
+      options.buffer_count == 0 || !(options.velocity_limit > 0)) {
+    throw std::invalid_argument(
+        "Trajectory stride, chunk size, buffer count and velocity limit must "
+        "be positive");
+  }
+
+  const ParticleStore& particles = container.GetParticleStore();
+  for (size_t i = 0; i < particles.Size(); i++) {
+    const std::vector<uint8_t>& species_ids = options.species_ids;
+    if (species_ids.empty() ||
+        std::find(species_ids.begin(), species_ids.end(),
+                  particles.GetSpeciesId(i)) != species_ids.end()) {
+      particle_indices_.push_back(i);
+    }
+  }
+
+  size_t particle_count = particle_indices_.size();
+  for (size_t i = 0; i < options.buffer_count; i++) {
+    std::unique_ptr<FrameBuffer> buffer(new FrameBuffer());
+    buffer->positions_x.resize(particle_count);
+    buffer->positions_y.resize(particle_count);
+    buffer->velocities_x.resize(particle_count);
+    buffer->velocities_y.resize(particle_count);
+    free_buffers_.push_back(buffer.get());
+    buffers_.push_back(std::move(buffer));
+  }
+  previous_values_.resize(kChannelCount * particle_count);
+
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_) {
+    throw std::runtime_error("Can't write " + path);
+  }
+  WriteHeader(container);
+  io_thread_ = std::thread(&TrajectoryWriter::IoLoop, this);
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+  try {
+    Close();
+  } catch (const std::runtime_error&) {
+  }
+}
+
+void TrajectoryWriter::AddFrame(const GasContainer& container) {
+  if (is_closed_) {
+    throw std::runtime_error("Trajectory " + path_ + " is closed");
+  } else if (container.GetParticleStore().Size() !=
+             container_particle_count_) {
+    throw std::invalid_argument(
+        "Trajectory frames must all have the same particles");
+  }
+  uint64_t frame_number = container.GetFrameCount();
+  if (frame_number % options_.stride != 0) {
+    return;
+  }
+
+  FrameBuffer* buffer;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_buffers_.empty()) {
+      stall_count_++;
+      buffer_freed_.wait(lock, [this] { return !free_buffers_.empty(); });
+    }
+    buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+  }
+
+  // quantizing is the only per-particle work on the calling thread
+  const ParticleStore& particles = container.GetParticleStore();
+  const float* positions_x = particles.GetPositionsX();
+  const float* positions_y = particles.GetPositionsY();
+  const float* velocities_x = particles.GetVelocitiesX();
+  const float* velocities_y = particles.GetVelocitiesY();
+  float limit = options_.velocity_limit;
+  buffer->frame_number = frame_number;
+  for (size_t i = 0; i < particle_indices_.size(); i++) {
+    size_t index = particle_indices_[i];
+    buffer->positions_x[i] =
+        QuantizePosition(positions_x[index], top_left_.x, dimension_.x);
+    buffer->positions_y[i] =
+        QuantizePosition(positions_y[index], top_left_.y, dimension_.y);
+    buffer->velocities_x[i] = QuantizeVelocity(velocities_x[index], limit);
+    buffer->velocities_y[i] = QuantizeVelocity(velocities_y[index], limit);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_buffers_.push_back(buffer);
+    queued_frame_count_++;
+  }
+  frame_queued_.notify_one();
+}
+
+void TrajectoryWriter::Close() {
+  if (is_closed_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_closing_ = true;
+  }
+  frame_queued_.notify_one();
+  io_thread_.join();
+  is_closed_ = true;
+  if (has_failed_) {
+    throw std::runtime_error("Failed writing " + path_);
+  }
+}
+
+size_t TrajectoryWriter::GetQueuedFrameCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queued_frame_count_;
+}
+
+size_t TrajectoryWriter::GetStallCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stall_count_;
+}
+
+void TrajectoryWriter::WriteHeader(const GasContainer& container) {
+  const SpeciesRegistry& species = container.GetSpecies();
+
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kTrajectoryVersion;
+  header.byte_order = kByteOrderMark;
+  for (int axis = 0; axis < 2; axis++) {
+    header.top_left_position[axis] = top_left_[axis];
+    header.container_dimension[axis] = dimension_[axis];
+  }
+  header.velocity_limit = options_.velocity_limit;
+  header.stride = static_cast<uint32_t>(options_.stride);
+  header.species_count = static_cast<uint32_t>(species.Size());
+  header.frames_per_chunk = static_cast<uint32_t>(options_.frames_per_chunk);
+  header.particle_count = particle_indices_.size();
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  for (size_t id = 0; id < species.Size(); id++) {
+    const std::string& name = species.Get(static_cast<uint8_t>(id)).name;
+    uint32_t name_length = static_cast<uint32_t>(name.size());
+    file_.write(reinterpret_cast<const char*>(&name_length),
+                sizeof(name_length));
+    file_.write(name.data(), name.size());
+  }
+
+  const ParticleStore& particles = container.GetParticleStore();
+  std::vector<uint64_t> indices(particle_indices_.begin(),
+                                particle_indices_.end());
+  std::vector<uint8_t> species_ids;
+  for (size_t index : particle_indices_) {
+    species_ids.push_back(particles.GetSpeciesId(index));
+  }
+  file_.write(reinterpret_cast<const char*>(indices.data()),
+              indices.size() * sizeof(uint64_t));
+  file_.write(reinterpret_cast<const char*>(species_ids.data()),
+              species_ids.size());
+  if (!file_) {
+    throw std::runtime_error("Failed writing " + path_);
+  }
+}
+
+void TrajectoryWriter::IoLoop() {
+  while (true) {
+    FrameBuffer* buffer;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      frame_queued_.wait(
+          lock, [this] { return is_closing_ || !queued_buffers_.empty(); });
+      if (queued_buffers_.empty()) {
+        break;
+      }
+      buffer = queued_buffers_.front();
+      queued_buffers_.pop_front();
+    }
+
+    // after a failure the frames are still taken, so AddFrame never waits
+    // forever, but they are dropped
+    if (!has_failed_) {
+      EncodeFrame(*buffer);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_buffers_.push_back(buffer);
+    }
+    buffer_freed_.notify_one();
+
+    if (chunk_frame_count_ == options_.frames_per_chunk) {
+      FlushChunk();
+    }
+  }
+  FlushChunk();
+  file_.close();
+  if (!file_) {
+    has_failed_ = true;
+  }
+}
+
+void TrajectoryWriter::EncodeFrame(const FrameBuffer& buffer) {
+  size_t particle_count = particle_indices_.size();
+  AppendVarint(chunk_, buffer.frame_number - previous_frame_number_);
+  previous_frame_number_ = buffer.frame_number;
+
+  int32_t* previous_values = previous_values_.data();
+  EncodeChannel(buffer.positions_x, previous_values, chunk_);
+  EncodeChannel(buffer.positions_y, previous_values + particle_count, chunk_);
+  EncodeChannel(buffer.velocities_x, previous_values + 2 * particle_count,
+                chunk_);
+  EncodeChannel(buffer.velocities_y, previous_values + 3 * particle_count,
+                chunk_);
+  chunk_frame_count_++;
+}
+
+void TrajectoryWriter::FlushChunk() {
+  if (chunk_frame_count_ > 0 && !has_failed_) {
+    ChunkHeader header = {chunk_.size(), chunk_frame_count_, 0};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.write(reinterpret_cast<const char*>(chunk_.data()), chunk_.size());
+    if (!file_) {
+      has_failed_ = true;
+    }
+  }
+
+  // the next chunk starts from absolute values
+  chunk_.clear();
+  chunk_frame_count_ = 0;
+  std::fill(previous_values_.begin(), previous_values_.end(), 0);
+  previous_frame_number_ = 0;
+}
+
+TrajectoryReader::TrajectoryReader(const std::string& path)
+    : file_(path, std::ios::binary) {
+  if (!file_) {
+    throw std::runtime_error("Can't open " + path);
+  }
+
+  FileHeader header;
+  if (!file_.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error(path + " is not a trajectory");
+  } else if (header.byte_order != kByteOrderMark) {
+    throw std::runtime_error(path + " was written with another byte order");
+  } else if (header.version != kTrajectoryVersion) {
+    throw std::runtime_error(path + " has unsupported trajectory version " +
+                             std::to_string(header.version));
+  }
+  top_left_ = glm::vec2(header.top_left_position[0],
+                        header.top_left_position[1]);
+  dimension_ = glm::vec2(header.container_dimension[0],
+                         header.container_dimension[1]);
+  velocity_limit_ = header.velocity_limit;
+  stride_ = header.stride;
+  frames_per_chunk_ = header.frames_per_chunk;
+
+  for (uint32_t id = 0; id < header.species_count; id++) {
+    uint32_t name_length;
+    ReadValue(file_, name_length, path);
+    std::string name(name_length, '\0');
+    if (!file_.read(&name[0], name_length)) {
+      throw std::runtime_error(path + " is truncated");
+    }
+    species_names_.push_back(name);
+  }
+
+  // read in pieces, so a corrupt count fails at the end of the file instead
+  // of allocating it all up front
+  for (uint64_t i = 0; i < header.particle_count; i++) {
+    uint64_t index;
+    ReadValue(file_, index, path);
+    particle_indices_.push_back(index);
+  }
+  species_ids_.resize(particle_indices_.size());
+  if (!file_.read(reinterpret_cast<char*>(species_ids_.data()),
+                  species_ids_.size())) {
+    throw std::runtime_error(path + " is truncated");
+  }
+  previous_values_.resize(kChannelCount * particle_indices_.size());
+}
+
+bool TrajectoryReader::ReadFrame(TrajectoryFrame& frame) {
+  if (chunk_frames_left_ == 0) {
+    ChunkHeader header;
+    file_.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file_.gcount() == 0 && file_.eof()) {
+      return false;
+    }
+    // each frame is its frame number and at most kMaxBytesPerValue per
+    // value, so a larger size is corrupt and mustn't be allocated
+    uint64_t max_frame_size =
+        kMaxVarintBytes + kMaxBytesPerValue * previous_values_.size();
+    if (!file_ || header.frame_count == 0 ||
+        header.frame_count > frames_per_chunk_ ||
+        header.byte_size / header.frame_count > max_frame_size) {
+      throw std::runtime_error("Trajectory chunk header is corrupt");
+    }
+    chunk_.resize(header.byte_size);
+    if (!file_.read(reinterpret_cast<char*>(chunk_.data()),
+                    header.byte_size)) {
+      throw std::runtime_error("Trajectory chunk is truncated");
+    }
+    chunk_position_ = 0;
+    chunk_frames_left_ = header.frame_count;
+    std::fill(previous_values_.begin(), previous_values_.end(), 0);
+    previous_frame_number_ = 0;
+  }
+
+  previous_frame_number_ += ReadVarint(chunk_, chunk_position_);
+  size_t value_count = previous_values_.size();
+  size_t i = 0;
+  while (i < value_count) {
+    uint64_t encoded = ReadVarint(chunk_, chunk_position_);
+    if (encoded != 0) {
+      previous_values_[i++] += ZigZagDecode(static_cast<uint32_t>(encoded));
+      continue;
+    }
+    // a run of unchanged values
+    uint64_t run_length = ReadVarint(chunk_, chunk_position_) + 1;
+    if (run_length > value_count - i) {
+      throw std::runtime_error("Trajectory chunk is corrupt");
+    }
+    i += static_cast<size_t>(run_length);
+  }
+  chunk_frames_left_--;
+
+  size_t particle_count = particle_indices_.size();
+  const int32_t* positions_x = previous_values_.data();
+  const int32_t* positions_y = positions_x + particle_count;
+  const int32_t* velocities_x = positions_y + particle_count;
+  const int32_t* velocities_y = velocities_x + particle_count;
+  float step_x = dimension_.x / kPositionScale;
+  float step_y = dimension_.y / kPositionScale;
+  float velocity_step = velocity_limit_ / kVelocityScale;
+
+  frame.frame_number = previous_frame_number_;
+  frame.positions.resize(particle_count);
+  frame.velocities.resize(particle_count);
+  for (size_t i = 0; i < particle_count; i++) {
+    frame.positions[i] = top_left_ + glm::vec2(positions_x[i] * step_x,
+                                               positions_y[i] * step_y);
+    frame.velocities[i] =
+        glm::vec2(velocities_x[i], velocities_y[i]) * velocity_step;
+  }
+  return true;
+}
+
+const std::vector<uint64_t>& TrajectoryReader::GetParticleIndices() const {
+  return particle_indices_;
+}
+
+const std::vector<uint8_t>& TrajectoryReader::GetSpeciesIds() const {
+  return species_ids_;
+}
+
+const std::vector<std::string>& TrajectoryReader::GetSpeciesNames() const {
+  return species_names_;
+}
+
+size_t TrajectoryReader::GetStride() const {
+  return stride_;
+}
+
+}  // namespace idealgas
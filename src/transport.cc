@@ -0,0 +1,23 @@
+#include "transport.h"
+
+namespace idealgas {
+
+void Transport::Exchange(const std::vector<size_t>& partners,
+                         const std::vector<std::vector<uint8_t>>& outgoing,
+                         std::vector<std::vector<uint8_t>>& incoming) {
+  incoming.resize(partners.size());
+  size_t rank = GetRank();
+  for (size_t i = 0; i < partners.size(); i++) {
+    // every rank handles its pairs in order of (lower rank, higher rank),
+    // so the pair every waiting rank is stuck on can always proceed
+    if (rank < partners[i]) {
+      Send(partners[i], outgoing[i]);
+      Receive(partners[i], incoming[i]);
+    } else {
+      Receive(partners[i], incoming[i]);
+      Send(partners[i], outgoing[i]);
+    }
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,128 @@
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+namespace idealgas {
+
+WorkStealingPool::WorkStealingPool(size_t thread_count) : steal_count_(0) {
+  thread_count = std::max<size_t>(1, thread_count);
+  for (size_t thread = 0; thread < thread_count; thread++) {
+    queues_.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+  }
+  for (size_t thread = 1; thread < thread_count; thread++) {
+    workers_.push_back(
+        std::thread(&WorkStealingPool::WorkerLoop, this, thread));
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkStealingPool::Run(size_t task_count, const TaskFunction& body) {
+  steal_count_ = 0;
+  for (size_t task = 0; task < task_count; task++) {
+    TaskQueue& queue = *queues_[task % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+  }
+
+  // nothing to share, so skip the synchronization
+  if (workers_.empty()) {
+    RunTasks(0, body);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    body_ = &body;
+    busy_workers_ = 1;  // the calling thread
+    generation_++;
+  }
+  work_ready_.notify_all();
+
+  RunTasks(0, body);
+  std::unique_lock<std::mutex> lock(mutex_);
+  busy_workers_--;
+  work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+  body_ = nullptr;
+}
+
+size_t WorkStealingPool::GetThreadCount() const {
+  return queues_.size();
+}
+
+size_t WorkStealingPool::GetStealCount() const {
+  return steal_count_;
+}
+
+void WorkStealingPool::WorkerLoop(size_t thread) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // threads are started before the first Run, at generation 0, but may
+  // only get here after it began
+  size_t seen_generation = 0;
+  while (true) {
+    work_ready_.wait(lock, [this, seen_generation] {
+      return is_stopping_ || generation_ != seen_generation;
+    });
+    if (is_stopping_) {
+      return;
+    }
+    seen_generation = generation_;
+    if (body_ == nullptr) {
+      continue;  // woke up after the Run had already finished
+    }
+
+    const TaskFunction& body = *body_;
+    busy_workers_++;
+    lock.unlock();
+    RunTasks(thread, body);
+    lock.lock();
+    busy_workers_--;
+    if (busy_workers_ == 0) {
+      work_done_.notify_all();
+    }
+  }
+}
+
+void WorkStealingPool::RunTasks(size_t thread, const TaskFunction& body) {
+  size_t task;
+  while (TakeTask(thread, task)) {
+    body(task, thread);
+  }
+}
+
+bool WorkStealingPool::TakeTask(size_t thread, size_t& task) {
+  {
+    TaskQueue& own = *queues_[thread];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = own.tasks.front();
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+
+  // tasks are never added during a Run, so once every queue was seen empty
+  // there is nothing left to do
+  for (size_t offset = 1; offset < queues_.size(); offset++) {
+    TaskQueue& victim = *queues_[(thread + offset) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.back();
+      victim.tasks.pop_back();
+      steal_count_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,166 @@
+#include <gas_container.h>
+#include <histogram.h>
+#include <thread_pool.h>
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using glm::vec2;
+using idealgas::GasContainer;
+using idealgas::Histogram;
+using idealgas::Stepper;
+using idealgas::ThreadPool;
+using std::vector;
+
+namespace {
+
+/** Whether operator new counts allocations, off outside of the checks **/
+std::atomic<bool> is_counting(false);
+std::atomic<size_t> allocation_count(0);
+
+/**
+ * Counts the allocations made by every thread while it is alive
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter() {
+    allocation_count = 0;
+    is_counting = true;
+  }
+  ~AllocationCounter() {
+    is_counting = false;
+  }
+
+  size_t GetCount() const {
+    return allocation_count;
+  }
+};
+
+const size_t kParticleCount = 600;
+
+/**
+ * Frames run before counting. The scratch vectors grow until they hold the
+ * most pairs a frame has had, which takes longer for the swept pairs and
+ * fast particles of the adaptive stepper.
+ */
+const size_t kWarmUpFrames = 100;
+const size_t kAdaptiveWarmUpFrames = 300;
+const size_t kCheckedFrames = 50;
+const int kHistogramBins = 10;
+
+Histogram MakeHistogram() {
+  return Histogram(vec2(0, 0), vec2(100, 100), "blue", "white", "Speed",
+                   "Frequency");
+}
+
+/**
+ * Runs the frame pipeline of the app: a step, then a histogram of the
+ * speeds of each species
+ *
+ * @return  allocations made by the last kCheckedFrames frames
+ */
+size_t CountFrameAllocations(GasContainer& container,
+                             size_t warm_up_frames = kWarmUpFrames) {
+  vector<Histogram> histograms(container.GetSpecies().Size(),
+                               MakeHistogram());
+  auto run_frame = [&container, &histograms]() {
+    container.AdvanceOneFrame();
+    for (size_t id = 0; id < histograms.size(); id++) {
+      histograms[id].UpdateData(
+          container.GetSpeciesSpeeds(static_cast<uint8_t>(id)),
+          kHistogramBins);
+    }
+  };
+
+  for (size_t frame = 0; frame < warm_up_frames; frame++) {
+    run_frame();
+  }
+  AllocationCounter counter;
+  for (size_t frame = 0; frame < kCheckedFrames; frame++) {
+    run_frame();
+  }
+  return counter.GetCount();
+}
+
+}  // namespace
+
+// GCC sees the frees below inlined into code that got the memory from
+// operator new, and doesn't know they are the replacements of each other
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// replaced for the whole test binary, but only counts inside the checks
+void* operator new(size_t size) {
+  if (is_counting) {
+    allocation_count++;
+  }
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+TEST_CASE("Counting catches allocations") {
+  size_t count = 0;
+  {
+    AllocationCounter counter;
+    vector<float> values(10);
+    count = counter.GetCount();
+  }
+  REQUIRE(count == 1);
+}
+
+TEST_CASE("Fixed time step frames don't allocate after warm-up") {
+  for (size_t thread_count : {1, 3}) {
+    GasContainer container(kParticleCount, vec2(0, 0), vec2(800, 800), 4);
+    container.SetThreadCount(thread_count);
+    REQUIRE(CountFrameAllocations(container) == 0);
+  }
+}
+
+TEST_CASE("Brute force frames don't allocate after warm-up") {
+  GasContainer container(kParticleCount, vec2(0, 0), vec2(800, 800), 4);
+  container.SetCollisionDetection(idealgas::CollisionDetection::kBruteForce);
+  REQUIRE(CountFrameAllocations(container) == 0);
+}
+
+TEST_CASE("Adaptive frames don't allocate after warm-up") {
+  GasContainer container(kParticleCount, vec2(0, 0), vec2(800, 800), 4);
+  container.SetStepper(Stepper::kAdaptive);
+  container.SetThreadCount(2);
+  REQUIRE(CountFrameAllocations(container, kAdaptiveWarmUpFrames) == 0);
+}
+
+TEST_CASE("Threaded histogram updates don't allocate after the first") {
+  vector<float> values(1000);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = static_cast<float>(i % 37);
+  }
+  Histogram serial_histogram = MakeHistogram();
+  serial_histogram.UpdateData(values, kHistogramBins);
+  ThreadPool pool(3);
+  Histogram histogram = MakeHistogram();
+  histogram.UpdateData(values.data(), values.data() + values.size(),
+                       kHistogramBins, pool);
+
+  size_t count = 0;
+  {
+    AllocationCounter counter;
+    for (int update = 0; update < 10; update++) {
+      histogram.UpdateData(values.data(), values.data() + values.size(),
+                           kHistogramBins, pool);
+    }
+    count = counter.GetCount();
+  }
+  REQUIRE(count == 0);
+  REQUIRE(histogram.GetBins() == serial_histogram.GetBins());
+}
@@ -0,0 +1,24 @@
+#include <color.h>
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+using idealgas::Color;
+
+TEST_CASE("Color constructors") {
+  SECTION("Default color is black") {
+    REQUIRE(Color() == Color(0, 0, 0));
+  }
+
+  SECTION("Named colors use the SVG values") {
+    REQUIRE(Color("red") == Color(1, 0, 0));
+    REQUIRE(Color("blue") == Color(0, 0, 1));
+    REQUIRE(Color("white") == Color(1, 1, 1));
+    REQUIRE(Color("green") == Color(0, 128.0f / 255, 0));
+    REQUIRE(Color("green") != Color(0, 1, 0));
+  }
+
+  SECTION("Unknown names are rejected") {
+    REQUIRE_THROWS_AS(Color("chartreuse-ish"), std::invalid_argument);
+  }
+}
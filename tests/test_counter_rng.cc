@@ -0,0 +1,72 @@
+#include <counter_rng.h>
+
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cmath>
+
+using idealgas::CounterRng;
+
+TEST_CASE("Philox4x32-10 known answers") {
+  SECTION("Zero key and counter") {
+    CounterRng rng(0);
+    CounterRng::Block expected = {
+        {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}};
+    REQUIRE(rng.Generate(0, 0, 0) == expected);
+  }
+
+  SECTION("All bits set") {
+    CounterRng rng(0xffffffffffffffff);
+    CounterRng::Block expected = {
+        {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}};
+    REQUIRE(rng.Generate(0xffffffff, 0xffffffffffffffff, 0xffffffff) ==
+            expected);
+  }
+
+  SECTION("Digits of pi") {
+    CounterRng rng(0x299f31d0a4093822);
+    CounterRng::Block expected = {
+        {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+    REQUIRE(rng.Generate(0x85a308d3, 0x0370734413198a2e, 0x243f6a88) ==
+            expected);
+  }
+}
+
+TEST_CASE("Counter-based generation") {
+  CounterRng rng(42);
+
+  SECTION("Same position gives the same block") {
+    REQUIRE(rng.Generate(3, 1000, 2) == CounterRng(42).Generate(3, 1000, 2));
+    REQUIRE(rng.GetSeed() == 42);
+  }
+
+  SECTION("Seeds, streams, indices and counters are all independent") {
+    CounterRng::Block block = rng.Generate(0, 0, 0);
+    REQUIRE(CounterRng(43).Generate(0, 0, 0) != block);
+    REQUIRE(rng.Generate(1, 0, 0) != block);
+    REQUIRE(rng.Generate(0, 1, 0) != block);
+    REQUIRE(rng.Generate(0, 0, 1) != block);
+  }
+
+  SECTION("Unit floats are uniform in [0, 1)") {
+    const int kSampleCount = 100000;
+    double sum = 0;
+    float min = 1;
+    float max = 0;
+    for (int i = 0; i < kSampleCount; i++) {
+      for (uint32_t word : rng.Generate(0, i)) {
+        float value = CounterRng::ToUnitFloat(word);
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+      }
+    }
+    REQUIRE(min >= 0);
+    REQUIRE(max < 1);
+    REQUIRE(std::abs(sum / (4 * kSampleCount) - 0.5) < 0.005);
+  }
+
+  SECTION("Unit float bounds") {
+    REQUIRE(CounterRng::ToUnitFloat(0) == 0);
+    REQUIRE(CounterRng::ToUnitFloat(0xffffffff) < 1);
+  }
+}
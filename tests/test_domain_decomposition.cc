@@ -0,0 +1,340 @@
+#include <domain_decomposition.h>
+#include <gas_container.h>
+#include <shared_memory_transport.h>
+#include <socket_transport.h>
+
+#include <catch2/catch.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using glm::vec2;
+using idealgas::DomainCoordinator;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::SharedMemoryTransport;
+using idealgas::SocketTransport;
+using idealgas::Transport;
+using std::vector;
+
+namespace {
+
+const size_t kParticleCount = 300;
+const vec2 kContainerSize(1200, 900);
+const int kSeed = 11;
+
+GasContainer MakeContainer() {
+  return GasContainer(kParticleCount, vec2(0, 0), kContainerSize, kSeed);
+}
+
+/**
+ * Advances a serial container and a decomposed run of the same particles
+ * by the same frames
+ *
+ * @param coordinator   run started from MakeContainer
+ * @return              whether the particles match bit for bit after every
+ *                      frame
+ */
+bool MatchesSerialRun(DomainCoordinator& coordinator,
+                      const vector<float>& time_steps) {
+  GasContainer container = MakeContainer();
+  for (float dt : time_steps) {
+    container.AdvanceOneFrame(dt);
+    coordinator.AdvanceOneFrame(dt);
+
+    ParticleStore gathered = coordinator.GatherParticles();
+    const ParticleStore& expected = container.GetParticleStore();
+    if (gathered.Size() != expected.Size()) {
+      return false;
+    }
+    for (size_t i = 0; i < expected.Size(); i++) {
+      if (gathered.GetPosition(i) != expected.GetPosition(i) ||
+          gathered.GetVelocity(i) != expected.GetVelocity(i) ||
+          gathered.GetSpeciesId(i) != expected.GetSpeciesId(i)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/** Frames of unit length, then a few long ones that cross slabs **/
+vector<float> GetTimeSteps() {
+  vector<float> time_steps(40, 1);
+  time_steps.insert(time_steps.end(), 5, 60);
+  return time_steps;
+}
+
+/**
+ * Runs RunDomainWorker for ranks 1 up to rank_count on their own threads,
+ * each with the transport made by make_transport
+ */
+template <typename MakeTransport>
+vector<std::thread> StartWorkers(size_t rank_count,
+                                 MakeTransport make_transport,
+                                 vector<std::string>& errors) {
+  errors.assign(rank_count, std::string());
+  vector<std::thread> workers;
+  for (size_t rank = 1; rank < rank_count; rank++) {
+    workers.emplace_back([make_transport, rank, &errors]() {
+      try {
+        std::unique_ptr<Transport> transport = make_transport(rank);
+        idealgas::RunDomainWorker(*transport);
+      } catch (const std::exception& error) {
+        errors[rank] = error.what();
+      }
+    });
+  }
+  return workers;
+}
+
+std::string GetSegmentName(const std::string& test) {
+  return "/idealgas-domains-" + test + "-" + std::to_string(getpid());
+}
+
+}  // namespace
+
+TEST_CASE("Decomposed run matches the single process run") {
+  for (size_t rank_count : {2, 4}) {
+    std::string name = GetSegmentName("threads");
+    SharedMemoryTransport::Create(name, rank_count);
+    SharedMemoryTransport transport(name, 0);
+    vector<std::string> errors;
+    vector<std::thread> workers = StartWorkers(
+        rank_count,
+        [&name](size_t rank) {
+          return std::unique_ptr<Transport>(
+              new SharedMemoryTransport(name, rank));
+        },
+        errors);
+
+    bool matches = false;
+    uint64_t frame_count = 0;
+    {
+      DomainCoordinator coordinator(MakeContainer(), transport);
+      matches = MatchesSerialRun(coordinator, GetTimeSteps());
+      frame_count = coordinator.GetFrameCount();
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+    SharedMemoryTransport::Unlink(name);
+
+    REQUIRE(errors == vector<std::string>(rank_count));
+    REQUIRE(matches);
+    REQUIRE(frame_count == GetTimeSteps().size());
+  }
+}
+
+TEST_CASE("Workers generate their own slabs from a DomainSetup") {
+  const size_t kRankCount = 3;
+  std::string name = GetSegmentName("setup");
+  SharedMemoryTransport::Create(name, kRankCount);
+  SharedMemoryTransport transport(name, 0);
+  vector<std::string> errors;
+  vector<std::thread> workers = StartWorkers(
+      kRankCount,
+      [&name](size_t rank) {
+        return std::unique_ptr<Transport>(
+            new SharedMemoryTransport(name, rank));
+      },
+      errors);
+
+  bool matches = false;
+  size_t slab_count = 0;
+  vector<size_t> times_gathered(kParticleCount);
+  {
+    idealgas::DomainSetup setup;
+    setup.particle_count = kParticleCount;
+    setup.container_dimension = kContainerSize;
+    setup.seed = kSeed;
+    DomainCoordinator coordinator(setup, transport);
+    matches = MatchesSerialRun(coordinator, GetTimeSteps());
+    coordinator.GatherParticles(
+        [&](const vector<uint64_t>& ids, const ParticleStore& particles) {
+          slab_count++;
+          REQUIRE(ids.size() == particles.Size());
+          for (uint64_t id : ids) {
+            times_gathered[id]++;
+          }
+        });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  SharedMemoryTransport::Unlink(name);
+
+  REQUIRE(errors == vector<std::string>(kRankCount));
+  REQUIRE(matches);
+  REQUIRE(slab_count == kRankCount - 1);
+  REQUIRE(times_gathered == vector<size_t>(kParticleCount, 1));
+}
+
+TEST_CASE("Decomposed run over sockets matches the single process run") {
+  const size_t kRankCount = 3;
+  vector<std::string> addresses;
+  for (size_t rank = 0; rank < kRankCount; rank++) {
+    // bind to port 0 to find a free port
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+    close(listener);
+    addresses.push_back("127.0.0.1:" +
+                        std::to_string(ntohs(address.sin_port)));
+  }
+
+  vector<std::string> errors;
+  vector<std::thread> workers = StartWorkers(
+      kRankCount,
+      [&addresses](size_t rank) {
+        return std::unique_ptr<Transport>(
+            new SocketTransport(addresses, rank));
+      },
+      errors);
+
+  bool matches = false;
+  {
+    SocketTransport transport(addresses, 0);
+    DomainCoordinator coordinator(MakeContainer(), transport);
+    matches = MatchesSerialRun(coordinator, GetTimeSteps());
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  REQUIRE(errors == vector<std::string>(kRankCount));
+  REQUIRE(matches);
+}
+
+TEST_CASE("Decomposed run across processes matches the single process run") {
+  const size_t kRankCount = 3;
+  std::string name = GetSegmentName("processes");
+  SharedMemoryTransport::Create(name, kRankCount);
+
+  vector<pid_t> children;
+  for (size_t rank = 1; rank < kRankCount; rank++) {
+    pid_t child = fork();
+    if (child == 0) {
+      int status = 0;
+      try {
+        SharedMemoryTransport transport(name, rank);
+        idealgas::RunDomainWorker(transport);
+      } catch (const std::exception&) {
+        status = 1;
+      }
+      _exit(status);
+    }
+    children.push_back(child);
+  }
+
+  bool matches = false;
+  {
+    SharedMemoryTransport transport(name, 0);
+    DomainCoordinator coordinator(MakeContainer(), transport);
+    matches = MatchesSerialRun(coordinator, GetTimeSteps());
+  }
+  size_t failed_children = 0;
+  for (pid_t child : children) {
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failed_children++;
+    }
+  }
+  SharedMemoryTransport::Unlink(name);
+
+  REQUIRE(failed_children == 0);
+  REQUIRE(matches);
+}
+
+TEST_CASE("Decomposed run counts the particles the container holds") {
+  // the particle count passed to this constructor isn't the number of
+  // particles it holds
+  vector<idealgas::Particle> particles;
+  for (size_t i = 0; i < 40; i++) {
+    float offset = static_cast<float>(i);
+    particles.push_back(idealgas::Particle(
+        vec2(30 + 28 * offset, 100 + 15 * offset), vec2(3, -2 + offset / 10),
+        idealgas::Color("red"), 10, 5, "RED"));
+  }
+  GasContainer container(3, vec2(0, 0), kContainerSize, kSeed, particles);
+
+  std::string name = GetSegmentName("count");
+  SharedMemoryTransport::Create(name, 3);
+  SharedMemoryTransport transport(name, 0);
+  vector<std::string> errors;
+  vector<std::thread> workers = StartWorkers(
+      3,
+      [&name](size_t rank) {
+        return std::unique_ptr<Transport>(
+            new SharedMemoryTransport(name, rank));
+      },
+      errors);
+
+  ParticleStore gathered;
+  {
+    DomainCoordinator coordinator(container, transport);
+    for (size_t frame = 0; frame < 30; frame++) {
+      container.AdvanceOneFrame();
+      coordinator.AdvanceOneFrame();
+    }
+    gathered = coordinator.GatherParticles();
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  SharedMemoryTransport::Unlink(name);
+
+  REQUIRE(errors == vector<std::string>(3));
+  const ParticleStore& expected = container.GetParticleStore();
+  REQUIRE(gathered.Size() == expected.Size());
+  for (size_t i = 0; i < expected.Size(); i++) {
+    REQUIRE(gathered.GetPosition(i) == expected.GetPosition(i));
+    REQUIRE(gathered.GetVelocity(i) == expected.GetVelocity(i));
+  }
+}
+
+TEST_CASE("DomainCoordinator rejects invalid setups") {
+  std::string name = GetSegmentName("invalid");
+  SharedMemoryTransport::Create(name, 8);
+
+  SECTION("Coordinator isn't rank 0") {
+    SharedMemoryTransport transport(name, 1);
+    REQUIRE_THROWS_AS(DomainCoordinator(MakeContainer(), transport),
+                      std::invalid_argument);
+  }
+
+  SECTION("Slabs narrower than the halos") {
+    // 7 slabs of 50 are narrower than two of the largest radius, 30
+    SharedMemoryTransport transport(name, 0);
+    GasContainer container(10, vec2(0, 0), vec2(350, 900), kSeed);
+    REQUIRE_THROWS_AS(DomainCoordinator(container, transport),
+                      std::invalid_argument);
+  }
+
+  SECTION("Container with a periodic axis") {
+    SharedMemoryTransport transport(name, 0);
+    GasContainer container = MakeContainer();
+    container.SetBoundary(1, idealgas::Boundary::kPeriodic);
+    REQUIRE_THROWS_AS(DomainCoordinator(container, transport),
+                      std::invalid_argument);
+  }
+
+  SECTION("Worker can't be rank 0") {
+    SharedMemoryTransport transport(name, 0);
+    REQUIRE_THROWS_AS(idealgas::RunDomainWorker(transport),
+                      std::invalid_argument);
+  }
+
+  SharedMemoryTransport::Unlink(name);
+}
@@ -0,0 +1,202 @@
+#include <ensemble.h>
+#include <gas_container.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using glm::vec2;
+using idealgas::CsvEnsembleSink;
+using idealgas::EnsembleOptions;
+using idealgas::EnsembleRunner;
+using idealgas::EnsembleSink;
+using idealgas::GasContainer;
+using idealgas::Placement;
+using idealgas::SpeedDistribution;
+using idealgas::Stepper;
+using idealgas::WorldResult;
+using idealgas::WorldSpec;
+using std::vector;
+
+namespace {
+
+class CollectingSink : public EnsembleSink {
+ public:
+  vector<WorldResult> results;
+
+  void AddResult(const WorldResult& result) override {
+    results.push_back(result);
+  }
+
+  /** Result of the world at world_index, nullptr if there is none **/
+  const WorldResult* Find(size_t world_index) const {
+    for (const WorldResult& result : results) {
+      if (result.world_index == world_index) {
+        return &result;
+      }
+    }
+    return nullptr;
+  }
+};
+
+/** Worlds of different sizes, seeds and steppers **/
+vector<WorldSpec> MakeWorlds() {
+  vector<WorldSpec> worlds;
+  for (int i = 0; i < 12; i++) {
+    WorldSpec spec;
+    spec.particle_count = 20 + 15 * static_cast<size_t>(i % 4);
+    spec.container_dimension = vec2(800, 600 + 50 * i);
+    spec.seed = 100 + i;
+    spec.frame_count = 50;
+    spec.stepper =
+        i % 3 == 0 ? Stepper::kEventDriven : Stepper::kFixedTimeStep;
+    worlds.push_back(spec);
+  }
+  return worlds;
+}
+
+}  // namespace
+
+TEST_CASE("Ensemble worlds match containers run on their own") {
+  vector<WorldSpec> worlds = MakeWorlds();
+  EnsembleOptions options;
+  options.thread_count = 4;
+  EnsembleRunner runner(options);
+  CollectingSink sink;
+  runner.Run(worlds, sink);
+  REQUIRE(sink.results.size() == worlds.size());
+
+  for (size_t i = 0; i < worlds.size(); i++) {
+    const WorldSpec& spec = worlds[i];
+    GasContainer container(spec.particle_count, vec2(0, 0),
+                           spec.container_dimension, spec.seed);
+    container.SetStepper(spec.stepper);
+    for (size_t frame = 0; frame < spec.frame_count; frame++) {
+      container.AdvanceOneFrame(spec.dt);
+    }
+
+    const WorldResult* result = sink.Find(i);
+    REQUIRE(result != nullptr);
+    REQUIRE(result->error.empty());
+    REQUIRE(result->seed == spec.seed);
+    REQUIRE(result->frame_count == spec.frame_count);
+    REQUIRE(result->observables.pressure ==
+            container.GetObservables().pressure);
+    REQUIRE(result->observables.temperature ==
+            container.GetObservables().temperature);
+  }
+}
+
+TEST_CASE("Ensemble speed distributions don't depend on the thread count") {
+  vector<WorldSpec> worlds = MakeWorlds();
+  EnsembleOptions options;
+  options.thread_count = 1;
+  EnsembleRunner single_thread(options);
+  options.thread_count = 3;
+  EnsembleRunner multi_thread(options);
+
+  CollectingSink sink;
+  single_thread.Run(worlds, sink);
+  multi_thread.Run(worlds, sink);
+
+  const auto& expected = single_thread.GetSpeedDistributions();
+  const auto& actual = multi_thread.GetSpeedDistributions();
+  REQUIRE(expected.size() == 3);
+  REQUIRE(actual.size() == expected.size());
+  for (const auto& entry : expected) {
+    REQUIRE(actual.count(entry.first) == 1);
+    const SpeedDistribution& distribution = actual.at(entry.first);
+    REQUIRE(distribution.GetBinCounts() == entry.second.GetBinCounts());
+    REQUIRE(distribution.GetMean() == entry.second.GetMean());
+    REQUIRE(distribution.GetFrameCount() == entry.second.GetFrameCount());
+    REQUIRE(distribution.GetQuantile(0.5) == entry.second.GetQuantile(0.5));
+    REQUIRE(distribution.GetQuantile(0.99) ==
+            entry.second.GetQuantile(0.99));
+  }
+
+  // every particle is sampled every speed_sample_stride frames
+  uint64_t sample_count = 0;
+  for (const auto& entry : actual) {
+    sample_count += entry.second.GetSampleCount();
+  }
+  uint64_t expected_count = 0;
+  for (const WorldSpec& spec : worlds) {
+    expected_count +=
+        spec.particle_count * (spec.frame_count / options.speed_sample_stride);
+  }
+  REQUIRE(sample_count == expected_count);
+}
+
+TEST_CASE("Ensemble packs small worlds into shared tasks") {
+  vector<WorldSpec> worlds = MakeWorlds();
+  EnsembleOptions options;
+  options.thread_count = 2;
+
+  SECTION("Every world is small") {
+    options.min_task_particle_frames = 10000;
+    EnsembleRunner runner(options);
+    CollectingSink sink;
+    runner.Run(worlds, sink);
+    REQUIRE(runner.GetTaskCount() < worlds.size());
+    REQUIRE(sink.results.size() == worlds.size());
+  }
+
+  SECTION("Every world is large") {
+    options.min_task_particle_frames = 1;
+    EnsembleRunner runner(options);
+    CollectingSink sink;
+    runner.Run(worlds, sink);
+    REQUIRE(runner.GetTaskCount() == worlds.size());
+  }
+}
+
+TEST_CASE("Ensemble reports worlds that can't be set up") {
+  vector<WorldSpec> worlds = MakeWorlds();
+  WorldSpec crowded;
+  crowded.particle_count = 500;
+  crowded.container_dimension = vec2(200, 200);
+  crowded.placement = Placement::kJitteredLattice;
+  worlds.push_back(crowded);
+
+  EnsembleRunner runner;
+  CollectingSink sink;
+  runner.Run(worlds, sink);
+  REQUIRE(sink.results.size() == worlds.size());
+  REQUIRE_FALSE(sink.Find(worlds.size() - 1)->error.empty());
+  REQUIRE(sink.Find(0)->error.empty());
+}
+
+TEST_CASE("Ensemble rejects invalid options") {
+  EnsembleOptions options;
+  options.speed_sample_stride = 0;
+  REQUIRE_THROWS_AS(EnsembleRunner{options}, std::invalid_argument);
+
+  options = EnsembleOptions();
+  options.bin_count = 0;
+  REQUIRE_THROWS_AS(EnsembleRunner{options}, std::invalid_argument);
+}
+
+TEST_CASE("CSV sink writes a line per world") {
+  const std::string path = "test_ensemble.csv";
+  {
+    CsvEnsembleSink sink(path);
+    WorldResult result;
+    result.world_index = 3;
+    result.error = "said \"no\"";
+    sink.AddResult(result);
+  }
+
+  std::ifstream file(path);
+  std::string header;
+  std::string line;
+  std::getline(file, header);
+  std::getline(file, line);
+  REQUIRE(header.find("world,seed,particles") == 0);
+  REQUIRE(line.find("3,0,0,0,") == 0);
+  REQUIRE(line.find("\"said \"\"no\"\"\"") != std::string::npos);
+  file.close();
+  std::remove(path.c_str());
+}
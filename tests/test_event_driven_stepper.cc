@@ -0,0 +1,110 @@
+#include <event_driven_stepper.h>
+#include <gas_container.h>
+
+#include <catch2/catch.hpp>
+
+using glm::vec2;
+using idealgas::Color;
+using idealgas::EventDrivenStepper;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::SpeciesRegistry;
+using idealgas::Stepper;
+
+namespace {
+
+double GetKineticEnergy(const ParticleStore& particles) {
+  double kinetic_energy = 0;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    float speed = particles.GetSpeed(i);
+    kinetic_energy += 0.5 * particles.GetMass(i) * speed * speed;
+  }
+  return kinetic_energy;
+}
+
+}  // namespace
+
+TEST_CASE("Head-on collision happens at the exact time of contact") {
+  SpeciesRegistry species;
+  species.Register("A", Color("red"), 1, 10);
+  ParticleStore particles;
+  particles.Add(vec2(100, 200), vec2(4, 0), 10, 1, 0);
+  particles.Add(vec2(150, 200), vec2(-4, 0), 10, 1, 0);
+  EventDrivenStepper stepper;
+  stepper.Initialize(particles, vec2(0, 0), vec2(400, 400));
+
+  SECTION("Equal masses swap velocities") {
+    // the gap of 30 closes at 8 per unit of time
+    stepper.Advance(particles, species, 4);
+
+    REQUIRE(stepper.GetParticleCollisionCount() == 1);
+    REQUIRE(particles.GetVelocity(0).x == Approx(-4));
+    REQUIRE(particles.GetVelocity(1).x == Approx(4));
+    // touched at 3.75 then moved apart for 0.25
+    REQUIRE(particles.GetPosition(0).x == Approx(114));
+    REQUIRE(particles.GetPosition(1).x == Approx(136));
+  }
+
+  SECTION("Nothing happens before the time of contact") {
+    stepper.Advance(particles, species, 3.5);
+
+    REQUIRE(stepper.GetParticleCollisionCount() == 0);
+    REQUIRE(particles.GetPosition(0).x == Approx(114));
+    REQUIRE(particles.GetVelocity(0).x == Approx(4));
+  }
+}
+
+TEST_CASE("Fast particles don't tunnel through each other") {
+  SpeciesRegistry species;
+  species.Register("A", Color("red"), 1, 2);
+  ParticleStore particles;
+  // a fixed step of 50 would jump straight past the other particle
+  particles.Add(vec2(100, 200), vec2(50, 0), 2, 1, 0);
+  particles.Add(vec2(130, 200), vec2(0, 0), 2, 1, 0);
+  EventDrivenStepper stepper;
+  stepper.Initialize(particles, vec2(0, 0), vec2(1000, 400));
+  stepper.Advance(particles, species, 1);
+
+  REQUIRE(stepper.GetParticleCollisionCount() == 1);
+  REQUIRE(particles.GetVelocity(0).x == Approx(0));
+  REQUIRE(particles.GetVelocity(1).x == Approx(50));
+  REQUIRE(particles.GetPosition(0).x < particles.GetPosition(1).x);
+}
+
+TEST_CASE("Particles bounce off the walls at the exact time of contact") {
+  SpeciesRegistry species;
+  species.Register("A", Color("red"), 1, 10);
+  ParticleStore particles;
+  particles.Add(vec2(80, 50), vec2(5, 0), 10, 1, 0);
+  particles.Add(vec2(50, 25), vec2(0, -10), 10, 1, 0);
+  EventDrivenStepper stepper;
+  stepper.Initialize(particles, vec2(0, 0), vec2(100, 100));
+  stepper.Advance(particles, species, 3);
+
+  REQUIRE(stepper.GetWallCollisionCount() == 2);
+  REQUIRE(particles.GetVelocity(0).x == Approx(-5));
+  REQUIRE(particles.GetPosition(0).x == Approx(85));
+  REQUIRE(particles.GetVelocity(1).y == Approx(10));
+  REQUIRE(particles.GetPosition(1).y == Approx(25));
+}
+
+TEST_CASE("Event-driven stepper conserves kinetic energy") {
+  GasContainer container(200, vec2(0, 0), vec2(2000, 2000), 225);
+  double initial_energy = GetKineticEnergy(container.GetParticleStore());
+  container.SetStepper(Stepper::kEventDriven);
+  for (size_t frame = 0; frame < 200; frame++) {
+    container.AdvanceOneFrame();
+  }
+  const ParticleStore& particles = container.GetParticleStore();
+
+  REQUIRE(GetKineticEnergy(particles) ==
+          Approx(initial_energy).epsilon(1e-3));
+  for (size_t i = 0; i < particles.Size(); i++) {
+    vec2 position = particles.GetPosition(i);
+    float radius = particles.GetRadius(i);
+    REQUIRE(position.x >= radius - 1e-2f);
+    REQUIRE(position.x <= 2000 - radius + 1e-2f);
+    REQUIRE(position.y >= radius - 1e-2f);
+    REQUIRE(position.y <= 2000 - radius + 1e-2f);
+  }
+}
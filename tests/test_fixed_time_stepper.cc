@@ -0,0 +1,122 @@
+#include <fixed_time_stepper.h>
+#include <gas_container.h>
+
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using glm::dvec3;
+using glm::vec2;
+using idealgas::BasicFixedTimeStepper;
+using idealgas::BasicParticleStore;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+
+namespace {
+
+double GetKineticEnergy(const BasicParticleStore<3, double>& particles) {
+  double energy = 0;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    dvec3 velocity = particles.GetVelocity(i);
+    energy += particles.GetMass(i) * glm::dot(velocity, velocity) / 2;
+  }
+  return energy;
+}
+
+/**
+ * Finds every touching and approaching pair first, then keeps the pairs in
+ * sorted order whose particles haven't collided yet, like GasContainer
+ */
+std::vector<std::pair<size_t, size_t>> FindResolvedPairs(
+    const ParticleStore& particles) {
+  std::vector<std::pair<size_t, size_t>> pairs;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    for (size_t j = i + 1; j < particles.Size(); j++) {
+      if (particles.IsTouching(i, j) && particles.IsApproaching(i, j)) {
+        pairs.push_back(std::make_pair(i, j));
+      }
+    }
+  }
+
+  std::vector<uint8_t> has_collided(particles.Size(), 0);
+  std::vector<std::pair<size_t, size_t>> resolved_pairs;
+  for (const std::pair<size_t, size_t>& pair : pairs) {
+    if (!has_collided[pair.first] && !has_collided[pair.second]) {
+      resolved_pairs.push_back(pair);
+      has_collided[pair.first] = 1;
+      has_collided[pair.second] = 1;
+    }
+  }
+  return resolved_pairs;
+}
+
+}  // namespace
+
+TEST_CASE("2D float stepper follows GasContainer") {
+  GasContainer container(200, vec2(0, 0), vec2(600, 600), 5);
+  container.SetCollisionDetection(idealgas::CollisionDetection::kBruteForce);
+  ParticleStore particles = container.GetParticleStore();
+  BasicFixedTimeStepper<2, float> stepper(container.GetTopLeftPosition(),
+                                          container.GetBottomRightPosition());
+  stepper.SetSpecies(container.GetSpecies());
+
+  size_t resolved_count = 0;
+  for (int frame = 0; frame < 20; frame++) {
+    std::vector<std::pair<size_t, size_t>> expected_pairs =
+        FindResolvedPairs(container.GetParticleStore());
+    container.AdvanceOneFrame();
+    stepper.AdvanceOneFrame(particles);
+    REQUIRE(stepper.GetResolvedPairs() == expected_pairs);
+    resolved_count += expected_pairs.size();
+
+    const ParticleStore& expected = container.GetParticleStore();
+    for (size_t i = 0; i < expected.Size(); i++) {
+      REQUIRE(particles.GetPosition(i) == expected.GetPosition(i));
+      REQUIRE(particles.GetVelocity(i) == expected.GetVelocity(i));
+    }
+  }
+  REQUIRE(resolved_count > 0);
+}
+
+TEST_CASE("3D double stepper bounces off the walls of every axis") {
+  BasicParticleStore<3, double> particles;
+  particles.Add(dvec3(50, 50, 88), dvec3(0, 0, 2), 10, 1, 0);
+  particles.Add(dvec3(12, 50, 50), dvec3(-2, 0, 0), 10, 1, 0);
+  BasicFixedTimeStepper<3, double> stepper(dvec3(0, 0, 0),
+                                           dvec3(100, 100, 100));
+
+  stepper.AdvanceOneFrame(particles);
+  stepper.AdvanceOneFrame(particles);
+  REQUIRE(particles.GetVelocity(0) == dvec3(0, 0, -2));
+  REQUIRE(particles.GetPosition(0) == dvec3(50, 50, 88));
+  REQUIRE(particles.GetVelocity(1) == dvec3(2, 0, 0));
+  REQUIRE(particles.GetPosition(1) == dvec3(12, 50, 50));
+}
+
+TEST_CASE("3D double stepper conserves energy") {
+  BasicParticleStore<3, double> particles;
+  for (int x = 0; x < 4; x++) {
+    for (int y = 0; y < 4; y++) {
+      for (int z = 0; z < 4; z++) {
+        dvec3 position(12.5 + 25 * x, 12.5 + 25 * y, 12.5 + 25 * z);
+        dvec3 velocity(std::sin(x + 2 * y + 3 * z), std::cos(3 * x + y),
+                       std::sin(x - z));
+        particles.Add(position, 3.0 * velocity, 6, 1 + (x + y + z) % 3, 0);
+      }
+    }
+  }
+  double energy = GetKineticEnergy(particles);
+  BasicFixedTimeStepper<3, double> stepper(dvec3(0, 0, 0),
+                                           dvec3(100, 100, 100));
+
+  size_t resolved_count = 0;
+  for (int frame = 0; frame < 500; frame++) {
+    stepper.AdvanceOneFrame(particles, 0.5);
+    resolved_count += stepper.GetResolvedPairs().size();
+  }
+
+  REQUIRE(resolved_count > 0);
+  REQUIRE(GetKineticEnergy(particles) == Approx(energy).epsilon(1e-12));
+}
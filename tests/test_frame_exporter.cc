@@ -0,0 +1,85 @@
+#include <frame_exporter.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+using glm::vec2;
+using idealgas::FrameExporter;
+using idealgas::FrameExportOptions;
+using idealgas::FrameFormat;
+using idealgas::GasContainer;
+
+namespace {
+
+const char* kFramePathPrefix = "test_frame_exporter";
+
+bool FileExists(const std::string& path) {
+  return std::ifstream(path).good();
+}
+
+}  // namespace
+
+TEST_CASE("Frame export") {
+  GasContainer container(100, vec2(0, 0), vec2(400, 300), 5);
+  FrameExportOptions options;
+  options.width = 160;
+  options.height = 90;
+  options.stride = 2;
+  options.thread_count = 2;
+
+  SECTION("PNG frames are written at the stride") {
+    FrameExporter exporter(kFramePathPrefix, container, options);
+    REQUIRE(exporter.GetFramePath(12) == "test_frame_exporter_000012.png");
+    for (size_t frame = 0; frame < 5; frame++) {
+      exporter.AddFrame(container);
+      container.AdvanceOneFrame();
+    }
+    exporter.Close();
+    REQUIRE(exporter.GetQueuedFrameCount() == 3);
+
+    for (uint64_t frame = 0; frame < 5; frame++) {
+      std::string path = exporter.GetFramePath(frame);
+      REQUIRE(FileExists(path) == (frame % 2 == 0));
+      std::remove(path.c_str());
+    }
+  }
+
+  SECTION("Raw frames are appended to one file") {
+    options.format = FrameFormat::kRaw;
+    options.draw_histograms = false;
+    FrameExporter exporter(kFramePathPrefix, container, options);
+    for (size_t frame = 0; frame < 4; frame++) {
+      exporter.AddFrame(container);
+      container.AdvanceOneFrame();
+    }
+    exporter.Close();
+
+    std::string path = exporter.GetFramePath(0);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    REQUIRE(static_cast<size_t>(file.tellg()) == 2 * 160 * 90 * 4);
+    file.close();
+    std::remove(path.c_str());
+  }
+
+  SECTION("Adding frames after closing throws") {
+    options.format = FrameFormat::kRaw;
+    FrameExporter exporter(kFramePathPrefix, container, options);
+    exporter.Close();
+    REQUIRE_THROWS_AS(exporter.AddFrame(container), std::runtime_error);
+    std::remove(exporter.GetFramePath(0).c_str());
+  }
+
+  SECTION("Failed writes are reported by Close") {
+    FrameExporter exporter("missing_directory/frame", container, options);
+    exporter.AddFrame(container);
+    REQUIRE_THROWS_AS(exporter.Close(), std::runtime_error);
+  }
+
+  SECTION("Zero stride throws") {
+    options.stride = 0;
+    REQUIRE_THROWS_AS(FrameExporter(kFramePathPrefix, container, options),
+                      std::invalid_argument);
+  }
+}
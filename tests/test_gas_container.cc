@@ -1,10 +1,16 @@
 #include <gas_container.h>
 
 #include <catch2/catch.hpp>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
 #include "particle.h"
+#include "state_hash.h"
 
 using glm::vec2;
+using idealgas::Color;
 using idealgas::GasContainer;
 using idealgas::Particle;
 using std::vector;
@@ -22,38 +28,40 @@ TEST_CASE("Test Constructor: Important values initialized correctly") {
 }
 
 TEST_CASE("AdvanceOneFrame Method") {
-  // particle1 & 2 are colliding. Particle 3 collide w/ wall. Particle 4 is far away
-  Particle particle1(vec2(111, 111), vec2(3, -3), ci::Color("red"), 10, 10,
+  // particle1 & 2 touch but move past each other. Particle 2 & 3 collide w/
+  // walls. Particle 4 is far away
+  Particle particle1(vec2(111, 111), vec2(3, -3), Color("red"), 10, 10,
                      "RED");
-  Particle particle2(vec2(110, 110), vec2(-3, 3), ci::Color("blue"), 10, 15,
+  Particle particle2(vec2(110, 110), vec2(-3, 3), Color("blue"), 10, 15,
                      "BLUE");
-  Particle particle3(vec2(395, 200), vec2(2, -2), ci::Color("red"), 10, 10,
+  Particle particle3(vec2(395, 200), vec2(2, -2), Color("red"), 10, 10,
                      "RED");
-  Particle particle4(vec2(220, 220), vec2(1, -1), ci::Color("blue"), 10, 15,
+  Particle particle4(vec2(220, 220), vec2(1, -1), Color("blue"), 10, 15,
                      "BLUE");
   vector<Particle> particles = {particle1, particle2, particle3, particle4};
   GasContainer container(3, vec2(100, 100), vec2(300, 300), 5, particles);
   container.AdvanceOneFrame();
   SECTION(
       "Check that particles update velocities and move to correct position") {
-    REQUIRE(particle1.GetPosition() == vec2(108.2f, 113.5f));
-    REQUIRE(particle2.GetPosition() == vec2(113.7f, 107.6f));
-    REQUIRE(particle3.GetPosition() == vec2(393, 198));
-    REQUIRE(particle4.GetPosition() == vec2(221, 219));
+    const vector<Particle>& moved = container.GetParticles();
+    REQUIRE(moved[0].GetPosition() == vec2(114, 108));
+    REQUIRE(moved[1].GetPosition() == vec2(113, 113));
+    REQUIRE(moved[2].GetPosition() == vec2(393, 198));
+    REQUIRE(moved[3].GetPosition() == vec2(221, 219));
   }
 
   SECTION("Check that Speeds Map is also updated") {
     std::map<std::string, vector<float>> speeds = container.GetParticleSpeeds();
-    REQUIRE(speeds.at("RED")[0] == 4.19f);
-    REQUIRE(speeds.at("BLUE")[0] == 3.68f);
-    REQUIRE(speeds.at("RED")[1] == 2.83f);
-    REQUIRE(speeds.at("BLUE")[1] == 1);
+    REQUIRE(speeds.at("RED")[0] == Approx(std::sqrt(18.0f)));
+    REQUIRE(speeds.at("BLUE")[0] == Approx(std::sqrt(18.0f)));
+    REQUIRE(speeds.at("RED")[1] == Approx(std::sqrt(8.0f)));
+    REQUIRE(speeds.at("BLUE")[1] == Approx(std::sqrt(2.0f)));
   }
 
   SECTION("Check if particle touching but not approaching each other it doesn't call to change velocity") {
-    Particle particle5(vec2(110, 110), vec2(3, -3), ci::Color("red"), 10, 10,
+    Particle particle5(vec2(110, 110), vec2(3, -3), Color("red"), 10, 10,
                        "RED");
-    Particle particle6(vec2(115, 115), vec2(-6, 6), ci::Color("blue"), 10, 15,
+    Particle particle6(vec2(115, 115), vec2(-6, 6), Color("blue"), 10, 15,
                        "BLUE");
     vector<Particle> particles2 = {particle5, particle6};
     GasContainer container2(3, vec2(100, 100), vec2(300, 300), 5, particles);
@@ -62,4 +70,547 @@ TEST_CASE("AdvanceOneFrame Method") {
     REQUIRE(particle5.GetPosition() == vec2(110, 110));
     REQUIRE(particle6.GetPosition() == vec2(115, 115));
   }
-}
\ No newline at end of file
+}
+TEST_CASE("Spatial grid collision detection matches brute force") {
+  SECTION("Hand-placed scenario from AdvanceOneFrame test") {
+    Particle particle1(vec2(111, 111), vec2(3, -3), Color("red"), 10, 10,
+                       "RED");
+    Particle particle2(vec2(110, 110), vec2(-3, 3), Color("blue"), 10, 15,
+                       "BLUE");
+    Particle particle3(vec2(395, 200), vec2(2, -2), Color("red"), 10, 10,
+                       "RED");
+    Particle particle4(vec2(220, 220), vec2(1, -1), Color("blue"), 10, 15,
+                       "BLUE");
+    vector<Particle> particles = {particle1, particle2, particle3, particle4};
+    GasContainer brute_force(4, vec2(100, 100), vec2(300, 300), 5, particles);
+    GasContainer spatial_grid(4, vec2(100, 100), vec2(300, 300), 5, particles);
+    brute_force.SetCollisionDetection(
+        idealgas::CollisionDetection::kBruteForce);
+    spatial_grid.SetCollisionDetection(
+        idealgas::CollisionDetection::kSpatialGrid);
+
+    for (size_t frame = 0; frame < 100; frame++) {
+      brute_force.AdvanceOneFrame();
+      spatial_grid.AdvanceOneFrame();
+    }
+
+    for (size_t i = 0; i < particles.size(); i++) {
+      REQUIRE(brute_force.GetParticles()[i].GetPosition() ==
+              spatial_grid.GetParticles()[i].GetPosition());
+      REQUIRE(brute_force.GetParticles()[i].GetVelocity() ==
+              spatial_grid.GetParticles()[i].GetVelocity());
+    }
+  }
+
+  SECTION("Randomly generated crowded container") {
+    GasContainer brute_force(300, vec2(0, 0), vec2(700, 1200), 225);
+    GasContainer spatial_grid(300, vec2(0, 0), vec2(700, 1200), 225);
+    brute_force.SetCollisionDetection(
+        idealgas::CollisionDetection::kBruteForce);
+    spatial_grid.SetCollisionDetection(
+        idealgas::CollisionDetection::kSpatialGrid);
+
+    for (size_t frame = 0; frame < 200; frame++) {
+      brute_force.AdvanceOneFrame();
+      spatial_grid.AdvanceOneFrame();
+    }
+
+    for (size_t i = 0; i < brute_force.GetParticles().size(); i++) {
+      REQUIRE(brute_force.GetParticles()[i].GetPosition() ==
+              spatial_grid.GetParticles()[i].GetPosition());
+      REQUIRE(brute_force.GetParticles()[i].GetVelocity() ==
+              spatial_grid.GetParticles()[i].GetVelocity());
+    }
+  }
+}
+
+TEST_CASE("Species registry drives particle generation") {
+  idealgas::SpeciesRegistry species;
+  species.Register("HELIUM", Color("white"), 4, 10);
+  species.Register("NEON", Color("red"), 20, 15);
+  species.Register("ARGON", Color("blue"), 40, 18);
+  species.Register("XENON", Color("green"), 131, 22);
+  GasContainer container(10, vec2(0, 0), vec2(500, 500), 5, species);
+
+  SECTION("Species take turns in registration order") {
+    const vector<Particle>& particles = container.GetParticles();
+    REQUIRE(particles.size() == 10);
+    REQUIRE(particles[0].GetTypeName() == "HELIUM");
+    REQUIRE(particles[3].GetTypeName() == "XENON");
+    REQUIRE(particles[4].GetTypeName() == "HELIUM");
+    REQUIRE(particles[3].GetMass() == 131);
+    REQUIRE(particles[3].GetRadius() == 22);
+  }
+
+  SECTION("Speeds are grouped by species id") {
+    container.AdvanceOneFrame();
+    REQUIRE(container.GetSpeciesSpeeds(0).size() == 3);
+    REQUIRE(container.GetSpeciesSpeeds(1).size() == 3);
+    REQUIRE(container.GetSpeciesSpeeds(2).size() == 2);
+    REQUIRE(container.GetSpeciesSpeeds(3).size() == 2);
+    REQUIRE(container.GetParticleSpeeds().at("ARGON") ==
+            container.GetSpeciesSpeeds(2));
+  }
+}
+
+TEST_CASE("AdvanceOneFrame gives the same result for any thread count") {
+  GasContainer container(10, vec2(0, 0), vec2(500, 500), 7);
+  REQUIRE(container.GetThreadCount() == 1);
+  container.SetThreadCount(3);
+  REQUIRE(container.GetThreadCount() == 3);
+
+  for (idealgas::CollisionDetection detection :
+       {idealgas::CollisionDetection::kSpatialGrid,
+        idealgas::CollisionDetection::kBruteForce}) {
+    GasContainer reference(500, vec2(0, 0), vec2(1500, 1500), 7);
+    reference.SetCollisionDetection(detection);
+    for (size_t frame = 0; frame < 100; frame++) {
+      reference.AdvanceOneFrame();
+    }
+
+    for (size_t thread_count : {2, 3, 8}) {
+      GasContainer parallel(500, vec2(0, 0), vec2(1500, 1500), 7);
+      parallel.SetCollisionDetection(detection);
+      parallel.SetThreadCount(thread_count);
+      for (size_t frame = 0; frame < 100; frame++) {
+        parallel.AdvanceOneFrame();
+      }
+
+      for (size_t i = 0; i < reference.GetParticles().size(); i++) {
+        REQUIRE(reference.GetParticles()[i].GetPosition() ==
+                parallel.GetParticles()[i].GetPosition());
+        REQUIRE(reference.GetParticles()[i].GetVelocity() ==
+                parallel.GetParticles()[i].GetVelocity());
+      }
+      for (uint8_t id = 0; id < reference.GetSpecies().Size(); id++) {
+        REQUIRE(reference.GetSpeciesSpeeds(id) ==
+                parallel.GetSpeciesSpeeds(id));
+      }
+    }
+  }
+}
+
+TEST_CASE("Generated particles only depend on the seed and their index") {
+  SECTION("Parallel generation of a large container matches a small one") {
+    GasContainer small(10, vec2(0, 0), vec2(20000, 20000), 11);
+    GasContainer large(70000, vec2(0, 0), vec2(20000, 20000), 11);
+    for (size_t i = 0; i < small.GetParticleCount(); i++) {
+      REQUIRE(small.GetParticleStore().GetPosition(i) ==
+              large.GetParticleStore().GetPosition(i));
+      REQUIRE(small.GetParticleStore().GetVelocity(i) ==
+              large.GetParticleStore().GetVelocity(i));
+    }
+  }
+
+  SECTION("Containers built concurrently match containers built alone") {
+    GasContainer reference_one(200, vec2(0, 0), vec2(1500, 1500), 1);
+    GasContainer reference_two(200, vec2(0, 0), vec2(1500, 1500), 2);
+    std::unique_ptr<GasContainer> container_one;
+    std::unique_ptr<GasContainer> container_two;
+    std::thread thread_one([&container_one] {
+      container_one.reset(
+          new GasContainer(200, vec2(0, 0), vec2(1500, 1500), 1));
+    });
+    std::thread thread_two([&container_two] {
+      container_two.reset(
+          new GasContainer(200, vec2(0, 0), vec2(1500, 1500), 2));
+    });
+    thread_one.join();
+    thread_two.join();
+
+    for (size_t i = 0; i < reference_one.GetParticleCount(); i++) {
+      REQUIRE(reference_one.GetParticleStore().GetPosition(i) ==
+              container_one->GetParticleStore().GetPosition(i));
+      REQUIRE(reference_two.GetParticleStore().GetVelocity(i) ==
+              container_two->GetParticleStore().GetVelocity(i));
+    }
+    REQUIRE(reference_one.GetParticleStore().GetPosition(0) !=
+            reference_two.GetParticleStore().GetPosition(0));
+  }
+}
+
+TEST_CASE("Non-overlapping placement leaves no colliding pairs") {
+  for (idealgas::Placement placement :
+       {idealgas::Placement::kJitteredLattice,
+        idealgas::Placement::kRandomSequential}) {
+    GasContainer container(300, vec2(0, 0), vec2(1500, 1500), 9, placement);
+    const idealgas::ParticleStore& particles = container.GetParticleStore();
+    for (size_t i = 0; i < particles.Size(); i++) {
+      for (size_t j = i + 1; j < particles.Size(); j++) {
+        REQUIRE_FALSE(particles.IsTouching(i, j));
+      }
+    }
+  }
+
+  REQUIRE_THROWS_AS(GasContainer(3000, vec2(0, 0), vec2(1500, 1500), 9,
+                                 idealgas::Placement::kRandomSequential),
+                    std::runtime_error);
+}
+
+TEST_CASE("AdvanceOneFrame with a time step") {
+  Particle particle(vec2(150, 150), vec2(2, -4), Color("red"), 10, 10, "RED");
+  vector<Particle> particles = {particle};
+
+  SECTION("The fixed time step moves particles by velocity * dt") {
+    GasContainer container(1, vec2(100, 100), vec2(300, 300), 5, particles);
+    container.AdvanceOneFrame(0.5f);
+    REQUIRE(container.GetParticleStore().GetPosition(0) == vec2(151, 148));
+    REQUIRE(container.GetFrameCount() == 1);
+    REQUIRE(container.GetSubstepCount() == 1);
+  }
+
+  SECTION("Time steps must be positive") {
+    GasContainer container(1, vec2(100, 100), vec2(300, 300), 5, particles);
+    REQUIRE_THROWS_AS(container.AdvanceOneFrame(0), std::invalid_argument);
+    REQUIRE_THROWS_AS(container.AdvanceOneFrame(-1), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Adaptive stepper") {
+  SECTION("Slow particles take one substep per frame") {
+    GasContainer container(100, vec2(0, 0), vec2(1500, 1500), 3);
+    container.SetStepper(idealgas::Stepper::kAdaptive);
+    container.AdvanceOneFrame();
+    REQUIRE(container.GetSubstepCount() == 1);
+    container.AdvanceOneFrame(10);
+    REQUIRE(container.GetSubstepCount() > 1);
+  }
+
+  SECTION("Fast particles don't tunnel through each other") {
+    Particle particle1(vec2(1000, 500), vec2(500, 0), Color("red"), 5, 1,
+                       "RED");
+    Particle particle2(vec2(1040, 500), vec2(-500, 0), Color("red"), 5, 1,
+                       "RED");
+    vector<Particle> particles = {particle1, particle2};
+
+    GasContainer fixed(2, vec2(0, 0), vec2(2000, 1000), 5, particles);
+    fixed.AdvanceOneFrame();
+    REQUIRE(fixed.GetParticleStore().GetPosition(0).x >
+            fixed.GetParticleStore().GetPosition(1).x);
+
+    GasContainer adaptive(2, vec2(0, 0), vec2(2000, 1000), 5, particles);
+    adaptive.SetStepper(idealgas::Stepper::kAdaptive);
+    adaptive.AdvanceOneFrame();
+    REQUIRE(adaptive.GetSubstepCount() > 1);
+    const idealgas::ParticleStore& store = adaptive.GetParticleStore();
+    REQUIRE(store.GetVelocity(0) == vec2(-500, 0));
+    REQUIRE(store.GetVelocity(1) == vec2(500, 0));
+    REQUIRE(store.GetPosition(0).x == Approx(530));
+    REQUIRE(store.GetPosition(1).x == Approx(1510));
+  }
+
+  SECTION("Fast particles don't tunnel through the walls") {
+    Particle particle(vec2(50, 500), vec2(-1000, 300), Color("red"), 5, 1,
+                      "RED");
+    vector<Particle> particles = {particle};
+    GasContainer container(1, vec2(0, 0), vec2(1000, 1000), 5, particles);
+    container.SetStepper(idealgas::Stepper::kAdaptive);
+    for (size_t frame = 0; frame < 20; frame++) {
+      container.AdvanceOneFrame();
+      vec2 position = container.GetParticleStore().GetPosition(0);
+      REQUIRE(position.x >= 5 - 1e-3f);
+      REQUIRE(position.x <= 995 + 1e-3f);
+      REQUIRE(position.y >= 5 - 1e-3f);
+      REQUIRE(position.y <= 995 + 1e-3f);
+    }
+  }
+
+  SECTION("A hot gas stays inside the container and keeps its energy") {
+    vector<Particle> particles;
+    for (size_t i = 0; i < 100; i++) {
+      float angle = static_cast<float>(i) * 2.4f;
+      particles.push_back(
+          Particle(vec2(100 + (i % 10) * 200.0f, 100 + (i / 10) * 200.0f),
+                   vec2(300 * std::cos(angle), 300 * std::sin(angle)),
+                   Color("red"), 10, i % 2 == 0 ? 1.0f : 3.0f,
+                   i % 2 == 0 ? "LIGHT" : "HEAVY"));
+    }
+    GasContainer container(100, vec2(0, 0), vec2(2000, 2000), 5, particles);
+    container.SetStepper(idealgas::Stepper::kAdaptive);
+
+    auto kinetic_energy = [&container] {
+      const idealgas::ParticleStore& store = container.GetParticleStore();
+      double energy = 0;
+      for (size_t i = 0; i < store.Size(); i++) {
+        energy += 0.5 * store.GetMass(i) * store.GetSpeed(i) *
+                  store.GetSpeed(i);
+      }
+      return energy;
+    };
+    double initial_energy = kinetic_energy();
+    for (size_t frame = 0; frame < 50; frame++) {
+      container.AdvanceOneFrame();
+    }
+    REQUIRE(kinetic_energy() == Approx(initial_energy).epsilon(1e-3));
+
+    const idealgas::ParticleStore& store = container.GetParticleStore();
+    for (size_t i = 0; i < store.Size(); i++) {
+      REQUIRE(store.GetPosition(i).x >= 10 - 1e-2f);
+      REQUIRE(store.GetPosition(i).x <= 1990 + 1e-2f);
+      REQUIRE(store.GetPosition(i).y >= 10 - 1e-2f);
+      REQUIRE(store.GetPosition(i).y <= 1990 + 1e-2f);
+    }
+  }
+
+  SECTION("Results don't depend on the thread count") {
+    GasContainer reference(500, vec2(0, 0), vec2(1500, 1500), 7);
+    GasContainer parallel(500, vec2(0, 0), vec2(1500, 1500), 7);
+    reference.SetStepper(idealgas::Stepper::kAdaptive);
+    parallel.SetStepper(idealgas::Stepper::kAdaptive);
+    parallel.SetThreadCount(3);
+    for (size_t frame = 0; frame < 20; frame++) {
+      reference.AdvanceOneFrame(40);
+      parallel.AdvanceOneFrame(40);
+    }
+    for (size_t i = 0; i < reference.GetParticleCount(); i++) {
+      REQUIRE(reference.GetParticleStore().GetPosition(i) ==
+              parallel.GetParticleStore().GetPosition(i));
+    }
+  }
+}
+
+TEST_CASE("Observables follow the ideal gas law") {
+  idealgas::Stepper steppers[] = {idealgas::Stepper::kFixedTimeStep,
+                                  idealgas::Stepper::kEventDriven,
+                                  idealgas::Stepper::kAdaptive};
+  for (idealgas::Stepper stepper : steppers) {
+    GasContainer container(40, vec2(0, 0), vec2(1500, 1500), 3);
+    container.SetStepper(stepper);
+    container.SetObservablesWindow(2000);
+    REQUIRE(container.GetObservables().frame_count == 0);
+    for (size_t frame = 0; frame < 2000; frame++) {
+      container.AdvanceOneFrame();
+    }
+    idealgas::Observables observables = container.GetObservables();
+    REQUIRE(observables.frame_count == 2000);
+    REQUIRE(observables.time == Approx(2000));
+
+    // P A = N k T in 2D, with the area the centers can reach. The dilute
+    // gas is close enough to ideal
+    float mean_radius = 25;
+    double area = (1500 - 2 * mean_radius) * (1500 - 2 * mean_radius);
+    REQUIRE(observables.pressure * area ==
+            Approx(observables.kinetic_energy).epsilon(0.1));
+    REQUIRE(observables.temperature * 40 ==
+            Approx(observables.kinetic_energy));
+
+    // every collision is counted once in the upper triangle of the rates
+    double collision_rate = 0;
+    for (size_t a = 0; a < 3; a++) {
+      for (size_t b = a; b < 3; b++) {
+        collision_rate += observables.pair_collision_rates[a * 3 + b];
+        REQUIRE(observables.pair_collision_rates[a * 3 + b] ==
+                observables.pair_collision_rates[b * 3 + a]);
+      }
+    }
+    REQUIRE(collision_rate > 0);
+    REQUIRE(observables.collision_frequency ==
+            Approx(2 * collision_rate / 40));
+    REQUIRE(observables.mean_free_path > 0);
+  }
+}
+
+TEST_CASE("Deterministic mode gives the same observables for any thread "
+          "count") {
+  // masses far apart make the energy sums round, so adding them up in
+  // different groups gives different results
+  idealgas::SpeciesRegistry species;
+  species.Register("HEAVY", Color("red"), 1e9f, 10);
+  species.Register("LIGHT", Color("blue"), 1e-6f, 10);
+  species.Register("MEDIUM", Color("green"), 1.3f, 10);
+
+  vector<idealgas::Observables> observables;
+  vector<vector<uint64_t>> state_hashes;
+  for (size_t thread_count : {1, 2, 3, 8}) {
+    GasContainer container(3000, vec2(0, 0), vec2(5000, 5000), 3, species);
+    container.SetThreadCount(thread_count);
+    container.SetDeterministic(true);
+    container.SetStateHashing(true);
+    REQUIRE(container.IsDeterministic());
+    for (size_t frame = 0; frame < 20; frame++) {
+      container.AdvanceOneFrame();
+    }
+    observables.push_back(container.GetObservables());
+    state_hashes.push_back(container.GetStateHashes());
+  }
+
+  for (size_t i = 1; i < observables.size(); i++) {
+    REQUIRE(observables[i].kinetic_energy == observables[0].kinetic_energy);
+    REQUIRE(observables[i].pressure == observables[0].pressure);
+    REQUIRE(observables[i].temperature == observables[0].temperature);
+    REQUIRE(observables[i].mean_free_path == observables[0].mean_free_path);
+    REQUIRE(state_hashes[i] == state_hashes[0]);
+  }
+}
+
+TEST_CASE("State hashes find the frame two runs diverge at") {
+  GasContainer reference(300, vec2(0, 0), vec2(1500, 1500), 5);
+  GasContainer changed(300, vec2(0, 0), vec2(1500, 1500), 5);
+  reference.SetStateHashing(true);
+  changed.SetStateHashing(true);
+  changed.SetThreadCount(3);
+  for (size_t frame = 0; frame < 30; frame++) {
+    reference.AdvanceOneFrame();
+    changed.AdvanceOneFrame(frame == 17 ? 1.5f : 1.0f);
+  }
+
+  REQUIRE(reference.GetStateHashes().size() == 30);
+  REQUIRE(idealgas::FindFirstDivergentFrame(reference.GetStateHashes(),
+                                            changed.GetStateHashes()) == 17);
+
+  SECTION("Restarting hashing clears the hashes") {
+    reference.SetStateHashing(false);
+    reference.AdvanceOneFrame();
+    REQUIRE(reference.GetStateHashes().size() == 30);
+    reference.SetStateHashing(true);
+    REQUIRE(reference.GetStateHashes().empty());
+  }
+}
+
+TEST_CASE("Periodic boundaries") {
+  using idealgas::Boundary;
+
+  SECTION("Particles leaving through one face come back through the other") {
+    Particle particle(vec2(395, 200), vec2(10, 0), Color("red"), 10, 10,
+                      "RED");
+    vector<Particle> particles = {particle};
+    GasContainer container(1, vec2(100, 100), vec2(300, 300), 5, particles);
+    container.SetBoundary(0, Boundary::kPeriodic);
+    REQUIRE(container.GetBoundary(0) == Boundary::kPeriodic);
+    REQUIRE(container.GetBoundary(1) == Boundary::kWall);
+    container.AdvanceOneFrame();
+
+    REQUIRE(container.GetParticleStore().GetPosition(0) == vec2(105, 200));
+    REQUIRE(container.GetParticleStore().GetVelocity(0) == vec2(10, 0));
+  }
+
+  SECTION("Axes with walls still reflect") {
+    Particle particle(vec2(395, 200), vec2(10, 0), Color("red"), 10, 10,
+                      "RED");
+    vector<Particle> particles = {particle};
+    GasContainer container(1, vec2(100, 100), vec2(300, 300), 5, particles);
+    container.SetBoundary(1, Boundary::kPeriodic);
+    container.AdvanceOneFrame();
+
+    REQUIRE(container.GetParticleStore().GetVelocity(0) == vec2(-10, 0));
+  }
+
+  SECTION("Particles collide across a periodic face") {
+    Particle particle1(vec2(105, 250), vec2(-3, 0), Color("red"), 10, 10,
+                       "RED");
+    Particle particle2(vec2(395, 252), vec2(3, 0), Color("red"), 10, 10,
+                       "RED");
+    vector<Particle> particles = {particle1, particle2};
+    GasContainer walls(2, vec2(100, 100), vec2(300, 300), 5, particles);
+    walls.AdvanceOneFrame();
+    REQUIRE(walls.GetParticleStore().GetVelocity(0).x > 0);
+    REQUIRE(walls.GetParticleStore().GetVelocity(0).y == 0);
+
+    GasContainer periodic(2, vec2(100, 100), vec2(300, 300), 5, particles);
+    periodic.SetBoundary(0, Boundary::kPeriodic);
+    periodic.AdvanceOneFrame();
+    vec2 velocity = periodic.GetParticleStore().GetVelocity(0);
+    REQUIRE(velocity.x > 0);
+    REQUIRE(velocity.y < 0);
+    REQUIRE((velocity + periodic.GetParticleStore().GetVelocity(1)).x ==
+            Approx(0).margin(1e-5));
+  }
+
+  SECTION("Spatial grid matches brute force for every combination of axes") {
+    const Boundary boundaries[][2] = {
+        {Boundary::kPeriodic, Boundary::kWall},
+        {Boundary::kWall, Boundary::kPeriodic},
+        {Boundary::kPeriodic, Boundary::kPeriodic}};
+    for (const auto& boundary : boundaries) {
+      GasContainer brute_force(300, vec2(0, 0), vec2(700, 1200), 225);
+      GasContainer spatial_grid(300, vec2(0, 0), vec2(700, 1200), 225);
+      brute_force.SetCollisionDetection(
+          idealgas::CollisionDetection::kBruteForce);
+      for (size_t axis = 0; axis < 2; axis++) {
+        brute_force.SetBoundary(axis, boundary[axis]);
+        spatial_grid.SetBoundary(axis, boundary[axis]);
+      }
+
+      for (size_t frame = 0; frame < 200; frame++) {
+        brute_force.AdvanceOneFrame();
+        spatial_grid.AdvanceOneFrame();
+      }
+
+      const idealgas::ParticleStore& expected =
+          brute_force.GetParticleStore();
+      const idealgas::ParticleStore& actual = spatial_grid.GetParticleStore();
+      for (size_t i = 0; i < expected.Size(); i++) {
+        REQUIRE(actual.GetPosition(i) == expected.GetPosition(i));
+        REQUIRE(actual.GetVelocity(i) == expected.GetVelocity(i));
+      }
+    }
+  }
+
+  SECTION("Without walls, momentum and energy are conserved") {
+    idealgas::Stepper steppers[] = {idealgas::Stepper::kFixedTimeStep,
+                                    idealgas::Stepper::kAdaptive};
+    for (idealgas::Stepper stepper : steppers) {
+      GasContainer container(400, vec2(0, 0), vec2(900, 900), 7);
+      container.SetStepper(stepper);
+      container.SetBoundary(0, Boundary::kPeriodic);
+      container.SetBoundary(1, Boundary::kPeriodic);
+
+      auto get_totals = [&container](vec2& momentum, float& energy) {
+        const idealgas::ParticleStore& particles =
+            container.GetParticleStore();
+        momentum = vec2(0, 0);
+        energy = 0;
+        for (size_t i = 0; i < particles.Size(); i++) {
+          float speed = particles.GetSpeed(i);
+          momentum += particles.GetMass(i) * particles.GetVelocity(i);
+          energy += 0.5f * particles.GetMass(i) * speed * speed;
+        }
+      };
+      vec2 start_momentum;
+      float start_energy;
+      get_totals(start_momentum, start_energy);
+      for (size_t frame = 0; frame < 300; frame++) {
+        container.AdvanceOneFrame(stepper == idealgas::Stepper::kAdaptive
+                                      ? 5.0f
+                                      : 1.0f);
+      }
+      vec2 momentum;
+      float energy;
+      get_totals(momentum, energy);
+
+      REQUIRE(energy == Approx(start_energy).epsilon(1e-3));
+      REQUIRE(momentum.x == Approx(start_momentum.x).margin(1));
+      REQUIRE(momentum.y == Approx(start_momentum.y).margin(1));
+      REQUIRE(container.GetObservables().pressure == 0);
+      for (size_t i = 0; i < container.GetParticleCount(); i++) {
+        vec2 position = container.GetParticleStore().GetPosition(i);
+        REQUIRE((position.x >= 0 && position.x < 900));
+        REQUIRE((position.y >= 0 && position.y < 900));
+      }
+    }
+  }
+
+  SECTION("Pressure only counts the axes with walls") {
+    GasContainer container(100, vec2(0, 0), vec2(900, 900), 7);
+    container.SetBoundary(0, Boundary::kPeriodic);
+    for (size_t frame = 0; frame < 300; frame++) {
+      container.AdvanceOneFrame();
+    }
+    REQUIRE(container.GetObservables().pressure > 0);
+  }
+
+  SECTION("The event-driven stepper only supports walls") {
+    GasContainer container(10, vec2(0, 0), vec2(900, 900), 7);
+    REQUIRE_THROWS_AS(container.SetBoundary(2, Boundary::kPeriodic),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(container.GetBoundary(2), std::invalid_argument);
+
+    container.SetStepper(idealgas::Stepper::kEventDriven);
+    REQUIRE_THROWS_AS(container.SetBoundary(0, Boundary::kPeriodic),
+                      std::invalid_argument);
+    container.SetStepper(idealgas::Stepper::kFixedTimeStep);
+    container.SetBoundary(0, Boundary::kPeriodic);
+    REQUIRE_THROWS_AS(container.SetStepper(idealgas::Stepper::kEventDriven),
+                      std::invalid_argument);
+  }
+}
@@ -4,6 +4,7 @@
 #include <catch2/catch.hpp>
 
 using glm::vec2;
+using idealgas::Color;
 using idealgas::Histogram;
 using idealgas::Particle;
 using std::vector;
@@ -13,8 +14,8 @@ TEST_CASE("Test Histogram Constructor") {
   vec2 dimension = vec2(100, 100);
   std::string x_label = "Speed";
   std::string y_label = "Frequency";
-  ci::ColorT<float> axis_label_color = "white";
-  ci::ColorT<float> bar_color = "blue";
+  Color axis_label_color = "white";
+  Color bar_color = "blue";
 
   Histogram histogram(position, dimension, bar_color, axis_label_color, x_label,
                       y_label);
@@ -32,8 +33,8 @@ TEST_CASE("UpdateData Function") {
   vec2 dimension = vec2(99, 99);
   std::string x_label = "Speed";
   std::string y_label = "Frequency";
-  ci::ColorT<float> axis_label_color = "white";
-  ci::ColorT<float> bar_color = "blue";
+  Color axis_label_color = "white";
+  Color bar_color = "blue";
 
   Histogram histogram(position, dimension, bar_color, axis_label_color, x_label,
                       y_label);
@@ -48,10 +49,11 @@ TEST_CASE("UpdateData Function") {
     vector<float> speeds = {4.5, 6.7, 10, 1, 2, 5, 10, 20};
     histogram.UpdateData(speeds, 3);
 
-    vector<int> actual_frequencies = histogram.GetBins();
-    vector<int> expected_frequencies = {2, 3, 2, 0, 0, 0, 1};
+    vector<float> actual_frequencies = histogram.GetBins();
+    // [1, 7.33), [7.33, 13.67), [13.67, 20]
+    vector<float> expected_frequencies = {5, 2, 1};
     REQUIRE(histogram.GetBarWidth() == 33);
-    REQUIRE(actual_frequencies.size() == 7);
+    REQUIRE(actual_frequencies.size() == 3);
     REQUIRE(actual_frequencies == expected_frequencies);
   }
 
@@ -59,10 +61,106 @@ TEST_CASE("UpdateData Function") {
     vector<float> speeds = {4.5, 6.7, 10, 1, 2, 5, 10, 20};
     histogram.UpdateData(speeds, 1);
 
-    vector<int> actual_frequencies = histogram.GetBins();
-    vector<int> expected_frequencies = {8};
-    REQUIRE(histogram.GetBarWidth() == 33);
+    vector<float> actual_frequencies = histogram.GetBins();
+    vector<float> expected_frequencies = {8};
+    REQUIRE(histogram.GetBarWidth() == 99);
     REQUIRE(actual_frequencies.size() == 1);
     REQUIRE(actual_frequencies == expected_frequencies);
   }
 }
+
+TEST_CASE("UpdateData bins directly into num_bins bins") {
+  Histogram histogram(vec2(10, 10), vec2(100, 100), Color("blue"),
+                      Color("white"), "Speed", "Frequency");
+
+  SECTION("Bins split the range of the data") {
+    vector<float> speeds = {4.5, 6.7, 10, 1, 2, 5, 10, 20};
+    histogram.UpdateData(speeds, 3);
+
+    // [1, 7.33), [7.33, 13.67), [13.67, 20]
+    vector<float> expected_frequencies = {5, 2, 1};
+    REQUIRE(histogram.GetBins() == expected_frequencies);
+    REQUIRE(histogram.GetBarWidth() == Approx(100.0f / 3));
+  }
+
+  SECTION("Data with a single value goes in the first bin") {
+    vector<float> speeds = {3, 3, 3};
+    histogram.UpdateData(speeds, 2);
+
+    vector<float> expected_frequencies = {3, 0};
+    REQUIRE(histogram.GetBins() == expected_frequencies);
+  }
+}
+
+TEST_CASE("Fixed histogram range") {
+  Histogram histogram(vec2(10, 10), vec2(100, 100), Color("blue"),
+                      Color("white"), "Speed", "Frequency");
+  histogram.SetRange(0, 10);
+
+  SECTION("Bin edges don't depend on the data") {
+    vector<float> speeds = {1, 2, 3, 9.5};
+    histogram.UpdateData(speeds, 5);
+
+    vector<float> expected_frequencies = {1, 2, 0, 0, 1};
+    REQUIRE(histogram.GetBins() == expected_frequencies);
+    REQUIRE(histogram.GetRangeMax() == 10);
+  }
+
+  SECTION("Range widens to fit larger values") {
+    vector<float> speeds = {1, 35};
+    histogram.UpdateData(speeds, 4);
+
+    // 0 to 40 in steps of 10
+    vector<float> expected_frequencies = {1, 0, 0, 1};
+    REQUIRE(histogram.GetRangeMax() == 40);
+    REQUIRE(histogram.GetBins() == expected_frequencies);
+
+    // the range doesn't shrink back
+    speeds = {1, 2};
+    histogram.UpdateData(speeds, 4);
+    REQUIRE(histogram.GetRangeMax() == 40);
+  }
+
+  SECTION("Invalid range throws") {
+    REQUIRE_THROWS_AS(histogram.SetRange(5, 5), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Parallel UpdateData matches the single threaded one") {
+  vector<float> speeds;
+  for (int i = 0; i < 1000; i++) {
+    speeds.push_back(static_cast<float>((i * 37) % 101) / 7);
+  }
+  Histogram serial(vec2(0, 0), vec2(100, 100), Color("blue"), Color("white"),
+                   "Speed", "Frequency");
+  Histogram parallel = serial;
+  idealgas::ThreadPool thread_pool(3);
+
+  serial.UpdateData(speeds, 12);
+  parallel.UpdateData(speeds.data(), speeds.data() + speeds.size(), 12,
+                      thread_pool);
+
+  REQUIRE(parallel.GetBins() == serial.GetBins());
+  float total = 0;
+  for (float frequency : parallel.GetBins()) {
+    total += frequency;
+  }
+  REQUIRE(total == 1000);
+}
+
+TEST_CASE("Time averaged histograms keep fractional averages") {
+  Histogram histogram(vec2(0, 0), vec2(100, 100), Color("blue"),
+                      Color("white"), "Speed", "Frequency");
+  idealgas::SpeedDistribution distribution(10, 5);
+
+  // two particles over four frames: the fast one only shows up in one
+  distribution.AddFrame({1, 3});
+  distribution.AddFrame({1, 3});
+  distribution.AddFrame({1, 3});
+  distribution.AddFrame({1, 9});
+  histogram.UpdateData(distribution);
+
+  vector<float> expected_frequencies = {1, 0.75f, 0, 0, 0.25f};
+  REQUIRE(histogram.GetBins() == expected_frequencies);
+  REQUIRE(histogram.GetBarWidth() == 20);
+}
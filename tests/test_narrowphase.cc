@@ -0,0 +1,163 @@
+#include <narrowphase.h>
+
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <vector>
+
+using glm::vec2;
+using idealgas::Narrowphase;
+using idealgas::ParticleArrays;
+using idealgas::ParticleStore;
+using std::vector;
+
+namespace {
+
+float RandomFloat(float lower_bound, float upper_bound) {
+  float random = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+  return random * (upper_bound - lower_bound) + lower_bound;
+}
+
+/**
+ * Expected result of FindContacts with periodic axes, from the same tests as
+ * FindContactsReference with the offsets wrapped
+ */
+uint32_t FindPeriodicContactsReference(const ParticleArrays& particles,
+                                       size_t index, size_t begin,
+                                       size_t count) {
+  uint32_t contacts = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t j = begin + i;
+    float dx = idealgas::GetMinimumImage(
+        particles.positions_x[j] - particles.positions_x[index],
+        particles.period_x);
+    float dy = idealgas::GetMinimumImage(
+        particles.positions_y[j] - particles.positions_y[index],
+        particles.period_y);
+    float dvx = particles.velocities_x[j] - particles.velocities_x[index];
+    float dvy = particles.velocities_y[j] - particles.velocities_y[index];
+    float radius_sum = particles.radii[j] + particles.radii[index];
+    bool is_touching = dx * dx + dy * dy <= radius_sum * radius_sum;
+    float approach = dx * dvx + dy * dvy;
+    if (is_touching && 2 * approach + dvx * dvx + dvy * dvy < 0) {
+      contacts |= uint32_t(1) << i;
+    }
+  }
+  return contacts;
+}
+
+/** Expected result of FindContacts, from the ParticleStore tests **/
+uint32_t FindContactsReference(const ParticleStore& particles, size_t index,
+                               size_t begin, size_t count) {
+  uint32_t contacts = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (particles.IsTouching(index, begin + i) &&
+        particles.IsApproaching(index, begin + i)) {
+      contacts |= uint32_t(1) << i;
+    }
+  }
+  return contacts;
+}
+
+vector<Narrowphase::Kernel> GetSupportedKernels() {
+  vector<Narrowphase::Kernel> kernels;
+  const Narrowphase::Kernel all_kernels[] = {Narrowphase::Kernel::kScalar,
+                                             Narrowphase::Kernel::kSse2,
+                                             Narrowphase::Kernel::kAvx2};
+  for (Narrowphase::Kernel kernel : all_kernels) {
+    if (Narrowphase::IsSupported(kernel)) {
+      kernels.push_back(kernel);
+    }
+  }
+  return kernels;
+}
+
+}  // namespace
+
+TEST_CASE("Scalar kernel is always supported") {
+  REQUIRE(Narrowphase::IsSupported(Narrowphase::Kernel::kScalar));
+  REQUIRE(Narrowphase::IsSupported(Narrowphase().GetKernel()));
+}
+
+TEST_CASE("FindContacts sets one bit per colliding candidate") {
+  ParticleStore particles;
+  particles.Add(vec2(50, 50), vec2(2, 2), 10, 15, 0);
+  particles.Add(vec2(55, 56), vec2(-3, -3), 10, 20, 0);  // colliding
+  particles.Add(vec2(48, 48), vec2(-3, -3), 10, 20, 0);  // moving apart
+  particles.Add(vec2(400, 400), vec2(-9, -9), 10, 20, 0);  // too far
+  particles.Add(vec2(45, 60), vec2(0, -5), 10, 20, 0);  // colliding
+
+  for (Narrowphase::Kernel kernel : GetSupportedKernels()) {
+    Narrowphase narrowphase(kernel);
+    ParticleArrays arrays(particles);
+
+    REQUIRE(narrowphase.FindContacts(arrays, 0, 1, 4) == 0x9);
+    REQUIRE(narrowphase.FindContacts(arrays, 0, 2, 2) == 0);
+    REQUIRE(narrowphase.FindContacts(arrays, 0, 1, 0) == 0);
+  }
+}
+
+TEST_CASE("Every kernel matches the ParticleStore tests") {
+  srand(225);
+  ParticleStore particles;
+  for (size_t i = 0; i < 400; i++) {
+    particles.Add(vec2(RandomFloat(0, 200), RandomFloat(0, 200)),
+                  vec2(RandomFloat(-7, 7), RandomFloat(-7, 7)),
+                  RandomFloat(5, 30), 1, 0);
+  }
+  ParticleArrays arrays(particles);
+
+  for (Narrowphase::Kernel kernel : GetSupportedKernels()) {
+    Narrowphase narrowphase(kernel);
+    for (size_t index = 0; index < 40; index++) {
+      // every block length, so the SIMD tails are covered
+      for (size_t count = 0; count <= Narrowphase::kBlockSize; count++) {
+        size_t begin = 40 + index * 7;
+        REQUIRE(narrowphase.FindContacts(arrays, index, begin, count) ==
+                FindContactsReference(particles, index, begin, count));
+      }
+    }
+  }
+}
+
+TEST_CASE("Every kernel wraps offsets across periodic axes") {
+  srand(325);
+  ParticleStore particles;
+  for (size_t i = 0; i < 400; i++) {
+    particles.Add(vec2(RandomFloat(0, 200), RandomFloat(0, 100)),
+                  vec2(RandomFloat(-7, 7), RandomFloat(-7, 7)),
+                  RandomFloat(5, 30), 1, 0);
+  }
+
+  SECTION("A pair across the edge only touches when the axis is periodic") {
+    ParticleStore pair;
+    pair.Add(vec2(195, 50), vec2(1, 0), 10, 1, 0);
+    pair.Add(vec2(5, 50), vec2(-1, 0), 10, 1, 0);
+    for (Narrowphase::Kernel kernel : GetSupportedKernels()) {
+      Narrowphase narrowphase(kernel);
+      ParticleArrays arrays(pair);
+      REQUIRE(narrowphase.FindContacts(arrays, 0, 1, 1) == 0);
+      arrays.period_x = 200;
+      REQUIRE(narrowphase.FindContacts(arrays, 0, 1, 1) == 1);
+    }
+  }
+
+  SECTION("Kernels match the reference for each periodic axis") {
+    const vec2 all_periods[] = {vec2(200, 0), vec2(0, 100), vec2(200, 100)};
+    for (const vec2& periods : all_periods) {
+      ParticleArrays arrays(particles);
+      arrays.period_x = periods.x;
+      arrays.period_y = periods.y;
+      for (Narrowphase::Kernel kernel : GetSupportedKernels()) {
+        Narrowphase narrowphase(kernel);
+        for (size_t index = 0; index < 40; index++) {
+          for (size_t count = 0; count <= Narrowphase::kBlockSize; count++) {
+            size_t begin = 40 + index * 7;
+            REQUIRE(narrowphase.FindContacts(arrays, index, begin, count) ==
+                    FindPeriodicContactsReference(arrays, index, begin,
+                                                  count));
+          }
+        }
+      }
+    }
+  }
+}
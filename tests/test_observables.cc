@@ -0,0 +1,100 @@
+#include <observables.h>
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+using idealgas::Observables;
+using idealgas::ObservableSums;
+using idealgas::ObservablesWindow;
+
+namespace {
+
+/** Sums of a frame of one time unit with the given totals **/
+ObservableSums MakeFrame(double wall_impulse, double energy,
+                         uint64_t collision_count) {
+  ObservableSums frame;
+  frame.Clear(2);
+  frame.time = 1;
+  frame.wall_impulse = wall_impulse;
+  frame.energy_time = energy;
+  frame.distance = 10;
+  for (uint64_t i = 0; i < collision_count; i++) {
+    frame.AddCollision(1, 0);
+  }
+  return frame;
+}
+
+}  // namespace
+
+TEST_CASE("Observable sums count each species pair once") {
+  ObservableSums sums;
+  sums.Clear(3);
+  sums.AddCollision(2, 0);
+  sums.AddCollision(0, 2);
+  sums.AddCollision(1, 1);
+  REQUIRE(sums.pair_collision_counts.size() == 9);
+  REQUIRE(sums.pair_collision_counts[0 * 3 + 2] == 2);
+  REQUIRE(sums.pair_collision_counts[2 * 3 + 0] == 0);
+  REQUIRE(sums.pair_collision_counts[1 * 3 + 1] == 1);
+
+  ObservableSums other;
+  other.Clear(3);
+  other.AddCollision(1, 1);
+  other.wall_impulse = 4;
+  sums.Add(other);
+  REQUIRE(sums.pair_collision_counts[1 * 3 + 1] == 2);
+  REQUIRE(sums.wall_impulse == 4);
+
+  ObservableSums fewer_species;
+  fewer_species.Clear(2);
+  REQUIRE_THROWS_AS(sums.Add(fewer_species), std::invalid_argument);
+}
+
+TEST_CASE("Observables window averages the most recent frames") {
+  ObservablesWindow window(2);
+
+  SECTION("Nothing recorded") {
+    Observables observables = window.GetAverages(10, 4);
+    REQUIRE(observables.frame_count == 0);
+    REQUIRE(observables.pressure == 0);
+    REQUIRE(observables.pair_collision_rates.empty());
+  }
+
+  SECTION("Averages of every quantity") {
+    window.Add(MakeFrame(8, 20, 5));
+    Observables observables = window.GetAverages(10, 4);
+    REQUIRE(observables.frame_count == 1);
+    REQUIRE(observables.time == 1);
+    REQUIRE(observables.pressure == Approx(2));
+    REQUIRE(observables.kinetic_energy == Approx(20));
+    REQUIRE(observables.temperature == Approx(2));
+    REQUIRE(observables.collision_frequency == Approx(1));
+    REQUIRE(observables.mean_free_path == Approx(1));
+    REQUIRE(observables.pair_collision_rates.size() == 4);
+    REQUIRE(observables.pair_collision_rates[0 * 2 + 1] == Approx(5));
+    REQUIRE(observables.pair_collision_rates[1 * 2 + 0] == Approx(5));
+    REQUIRE(observables.pair_collision_rates[0] == 0);
+  }
+
+  SECTION("Old frames drop out") {
+    window.Add(MakeFrame(100, 100, 0));
+    window.Add(MakeFrame(8, 20, 5));
+    window.Add(MakeFrame(16, 40, 5));
+    Observables observables = window.GetAverages(10, 4);
+    REQUIRE(observables.frame_count == 2);
+    REQUIRE(observables.time == 2);
+    REQUIRE(observables.pressure == Approx(3));
+    REQUIRE(observables.kinetic_energy == Approx(30));
+  }
+
+  SECTION("Changing the size forgets the frames") {
+    window.Add(MakeFrame(8, 20, 5));
+    window.SetFrameCount(5);
+    REQUIRE(window.GetFrameCount() == 5);
+    REQUIRE(window.GetAverages(10, 4).frame_count == 0);
+  }
+
+  SECTION("The window can't be empty") {
+    REQUIRE_THROWS_AS(window.SetFrameCount(0), std::invalid_argument);
+  }
+}
@@ -0,0 +1,100 @@
+#include <particle_placement.h>
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+using glm::vec2;
+using idealgas::CounterRng;
+using idealgas::ParticleStore;
+using idealgas::Placement;
+using idealgas::PlaceWithoutOverlaps;
+
+namespace {
+
+/** Particles of three sizes, all at the origin **/
+ParticleStore MakeParticles(size_t particle_count) {
+  const float kRadii[] = {20, 25, 30};
+  ParticleStore particles;
+  for (size_t i = 0; i < particle_count; i++) {
+    particles.Add(vec2(0, 0), vec2(1, 1), kRadii[i % 3], 5,
+                  static_cast<uint8_t>(i % 3));
+  }
+  return particles;
+}
+
+bool IsInside(const ParticleStore& particles, const vec2& top_left,
+              const vec2& bottom_right) {
+  for (size_t i = 0; i < particles.Size(); i++) {
+    vec2 position = particles.GetPosition(i);
+    float radius = particles.GetRadius(i);
+    if (position.x - radius < top_left.x - 1e-3f ||
+        position.y - radius < top_left.y - 1e-3f ||
+        position.x + radius > bottom_right.x + 1e-3f ||
+        position.y + radius > bottom_right.y + 1e-3f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HasOverlaps(const ParticleStore& particles) {
+  for (size_t i = 0; i < particles.Size(); i++) {
+    for (size_t j = i + 1; j < particles.Size(); j++) {
+      vec2 offset = particles.GetPosition(i) - particles.GetPosition(j);
+      float radius_sum = particles.GetRadius(i) + particles.GetRadius(j);
+      if (offset.x * offset.x + offset.y * offset.y <
+          radius_sum * radius_sum * 0.9999f) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST_CASE("Placements without overlaps") {
+  vec2 top_left(10, 20);
+  vec2 bottom_right(3010, 2020);
+  CounterRng rng(5);
+
+  for (Placement placement :
+       {Placement::kJitteredLattice, Placement::kRandomSequential}) {
+    SECTION("Particles are inside the bounds and apart") {
+      // packing fraction of about 0.33
+      ParticleStore particles = MakeParticles(1000);
+      PlaceWithoutOverlaps(placement, top_left, bottom_right, rng, 0,
+                           particles);
+      REQUIRE(IsInside(particles, top_left, bottom_right));
+      REQUIRE_FALSE(HasOverlaps(particles));
+      REQUIRE(particles.GetVelocity(0) == vec2(1, 1));
+    }
+
+    SECTION("Same random numbers give the same positions") {
+      ParticleStore particles_one = MakeParticles(100);
+      ParticleStore particles_two = MakeParticles(100);
+      PlaceWithoutOverlaps(placement, top_left, bottom_right, rng, 0,
+                           particles_one);
+      PlaceWithoutOverlaps(placement, top_left, bottom_right, rng, 0,
+                           particles_two);
+      for (size_t i = 0; i < particles_one.Size(); i++) {
+        REQUIRE(particles_one.GetPosition(i) == particles_two.GetPosition(i));
+      }
+    }
+
+    SECTION("Unreachable packing fraction fails") {
+      // packing fraction of about 0.75
+      ParticleStore particles = MakeParticles(2300);
+      REQUIRE_THROWS_AS(PlaceWithoutOverlaps(placement, top_left,
+                                             bottom_right, rng, 0, particles),
+                        std::runtime_error);
+    }
+  }
+
+  SECTION("Uniform placement is rejected") {
+    ParticleStore particles = MakeParticles(10);
+    REQUIRE_THROWS_AS(PlaceWithoutOverlaps(Placement::kUniform, top_left,
+                                           bottom_right, rng, 0, particles),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,272 @@
+#include <particle.h>
+#include <particle_store.h>
+
+#include <catch2/catch.hpp>
+
+using glm::dvec2;
+using glm::dvec3;
+using glm::vec2;
+using glm::vec3;
+using idealgas::BasicParticleStore;
+using idealgas::Color;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+
+TEST_CASE("Add stores every field") {
+  ParticleStore particles;
+  size_t index = particles.Add(vec2(2, 3), vec2(4, 5), 10, 4, 7);
+
+  REQUIRE(index == 0);
+  REQUIRE(particles.Size() == 1);
+  REQUIRE(particles.GetPosition(0) == vec2(2, 3));
+  REQUIRE(particles.GetVelocity(0) == vec2(4, 5));
+  REQUIRE(particles.GetRadius(0) == 10);
+  REQUIRE(particles.GetMass(0) == 4);
+  REQUIRE(particles.GetInverseMasses()[0] == 0.25f);
+  REQUIRE(particles.GetSpeciesId(0) == 7);
+}
+
+TEST_CASE("Resize then Set stores every field") {
+  ParticleStore particles;
+  particles.Add(vec2(1, 1), vec2(1, 1), 10, 1, 0);
+  particles.Resize(3);
+  particles.Set(2, vec2(2, 3), vec2(4, 5), 10, 4, 7);
+
+  REQUIRE(particles.Size() == 3);
+  REQUIRE(particles.GetPosition(0) == vec2(1, 1));
+  REQUIRE(particles.GetPosition(2) == vec2(2, 3));
+  REQUIRE(particles.GetVelocity(2) == vec2(4, 5));
+  REQUIRE(particles.GetRadius(2) == 10);
+  REQUIRE(particles.GetMass(2) == 4);
+  REQUIRE(particles.GetSpeciesId(2) == 7);
+
+  particles.Resize(1);
+  REQUIRE(particles.Size() == 1);
+  REQUIRE(particles.GetPosition(0) == vec2(1, 1));
+}
+
+TEST_CASE("Integrate moves every particle one time step") {
+  ParticleStore particles;
+  particles.Add(vec2(2, 3), vec2(4, 5), 10, 15, 0);
+  particles.Add(vec2(-1, 0), vec2(1, -1), 10, 15, 0);
+  particles.Integrate();
+
+  REQUIRE(particles.GetPosition(0) == vec2(6, 8));
+  REQUIRE(particles.GetPosition(1) == vec2(0, -1));
+}
+
+TEST_CASE("Store matches Particle collision methods") {
+  Particle particle1(vec2(50, 50), vec2(2, -2), Color("red"), 10, 15,
+                     "RedParticle");
+  Particle particle2(vec2(55, 56), vec2(-3, 3), Color("blue"), 10, 20,
+                     "BlueParticle");
+  ParticleStore particles;
+  particles.Add(particle1.GetPosition(), particle1.GetVelocity(), 10, 15, 0);
+  particles.Add(particle2.GetPosition(), particle2.GetVelocity(), 10, 20, 1);
+
+  REQUIRE(particles.IsTouching(0, 1) == particle1.IsTouching(particle2));
+  REQUIRE(particles.IsApproaching(0, 1) == particle1.IsApproaching(particle2));
+
+  particle1.UpdateVelocitiesForParticleCollision(particle2);
+  particles.UpdateVelocitiesForParticleCollision(0, 1);
+  REQUIRE(particles.GetVelocity(0)[0] == Approx(particle1.GetVelocity()[0]));
+  REQUIRE(particles.GetVelocity(0)[1] == Approx(particle1.GetVelocity()[1]));
+  REQUIRE(particles.GetVelocity(1)[0] == Approx(particle2.GetVelocity()[0]));
+  REQUIRE(particles.GetVelocity(1)[1] == Approx(particle2.GetVelocity()[1]));
+}
+
+TEST_CASE("Store wall collisions") {
+  ParticleStore particles;
+  particles.Add(vec2(5, 50), vec2(-1, 1), 10, 15, 0);
+  particles.Add(vec2(50, 95), vec2(1, 1), 10, 15, 0);
+  particles.Add(vec2(50, 50), vec2(1, 1), 10, 15, 0);
+
+  for (size_t i = 0; i < particles.Size(); i++) {
+    particles.HandleIfWallCollision(i, vec2(0, 0), vec2(100, 100));
+  }
+  REQUIRE(particles.GetVelocity(0) == vec2(1, 1));
+  REQUIRE(particles.GetVelocity(1) == vec2(1, -1));
+  REQUIRE(particles.GetVelocity(2) == vec2(1, 1));
+}
+
+TEST_CASE("Minimum image offsets") {
+  REQUIRE(idealgas::GetMinimumImage(30.0f, 100.0f) == 30);
+  REQUIRE(idealgas::GetMinimumImage(80.0f, 100.0f) == -20);
+  REQUIRE(idealgas::GetMinimumImage(-80.0f, 100.0f) == 20);
+  REQUIRE(idealgas::GetMinimumImage(80.0f, 0.0f) == 80);
+  REQUIRE(idealgas::GetMinimumImage(-80.0f, 0.0f) == -80);
+}
+
+TEST_CASE("WrapPositions moves particles back in from the other side") {
+  ParticleStore particles;
+  particles.Add(vec2(-5, 50), vec2(0, 0), 1, 1, 0);
+  particles.Add(vec2(103, 50), vec2(0, 0), 1, 1, 0);
+  particles.Add(vec2(250, 50), vec2(0, 0), 1, 1, 0);
+  particles.Add(vec2(100, 150), vec2(0, 0), 1, 1, 0);
+  particles.Add(vec2(50, 50), vec2(0, 0), 1, 1, 0);
+
+  particles.WrapPositions(0, particles.Size(), 0, 0, 100);
+  REQUIRE(particles.GetPosition(0) == vec2(95, 50));
+  REQUIRE(particles.GetPosition(1) == vec2(3, 50));
+  REQUIRE(particles.GetPosition(2) == vec2(50, 50));
+  REQUIRE(particles.GetPosition(3) == vec2(0, 150));
+  REQUIRE(particles.GetPosition(4) == vec2(50, 50));
+
+  SECTION("Values that round onto the far edge end up on the near one") {
+    particles.SetPosition(0, vec2(-1e-9f, 0));
+    particles.WrapPositions(0, 1, 0, 0, 100);
+    REQUIRE(particles.GetPosition(0).x >= 0);
+    REQUIRE(particles.GetPosition(0).x < 100);
+  }
+}
+
+TEST_CASE("Collisions across a periodic axis use the minimum image") {
+  // 10 apart across the edge at x = 100, moving towards each other
+  ParticleStore wrapped;
+  wrapped.Add(vec2(95, 50), vec2(2, 0), 10, 1, 0);
+  wrapped.Add(vec2(5, 50), vec2(-2, 0), 10, 1, 0);
+  wrapped.UpdateVelocitiesForParticleCollision(0, 1, 1, 1, vec2(100, 0));
+
+  ParticleStore unwrapped;
+  unwrapped.Add(vec2(95, 50), vec2(2, 0), 10, 1, 0);
+  unwrapped.Add(vec2(105, 50), vec2(-2, 0), 10, 1, 0);
+  unwrapped.UpdateVelocitiesForParticleCollision(0, 1, 1, 1);
+
+  REQUIRE(wrapped.GetVelocity(0) == vec2(-2, 0));
+  REQUIRE(wrapped.GetVelocity(0) == unwrapped.GetVelocity(0));
+  REQUIRE(wrapped.GetVelocity(1) == unwrapped.GetVelocity(1));
+}
+
+TEST_CASE("Wall collisions return the momentum given to the wall") {
+  ParticleStore particles;
+  particles.Add(vec2(5, 50), vec2(-3, 1), 10, 2, 0);
+  particles.Add(vec2(50, 95), vec2(1, 4), 10, 2, 0);
+  particles.Add(vec2(50, 50), vec2(1, 1), 10, 2, 0);
+  // touching the right wall while moving away from it
+  particles.Add(vec2(95, 50), vec2(-1, 0), 10, 2, 0);
+
+  vec2 top_left(0, 0);
+  vec2 bottom_right(100, 100);
+  REQUIRE(particles.HandleIfWallCollision(0, top_left, bottom_right) ==
+          Approx(12));
+  REQUIRE(particles.HandleIfWallCollision(1, top_left, bottom_right) ==
+          Approx(16));
+  REQUIRE(particles.HandleIfWallCollision(2, top_left, bottom_right) == 0);
+  REQUIRE(particles.HandleIfWallCollision(3, top_left, bottom_right) ==
+          Approx(-4));
+
+  REQUIRE(particles.ReflectVelocity(2, 1) == Approx(4));
+  REQUIRE(particles.GetVelocity(2) == vec2(1, -1));
+}
+
+TEST_CASE("Integrate scales the step by dt") {
+  ParticleStore particles;
+  particles.Add(vec2(5, 5), vec2(2, -4), 10, 15, 0);
+  particles.Integrate(0, 1, 0.25f);
+  REQUIRE(particles.GetPosition(0) == vec2(5.5f, 4));
+}
+
+TEST_CASE("Store swept wall reflections") {
+  ParticleStore particles;
+  // reaches the left wall after 0.5 of a step of 1
+  particles.Add(vec2(15, 50), vec2(-10, 0), 10, 15, 0);
+  // far from the walls
+  particles.Add(vec2(50, 50), vec2(10, 10), 10, 15, 0);
+  // reaches the bottom right corner within the step
+  particles.Add(vec2(85, 88), vec2(20, 20), 10, 15, 0);
+  // already past the top wall, moving out
+  particles.Add(vec2(50, 5), vec2(0, -1), 10, 15, 0);
+  particles.Add(vec2(50, 50), vec2(0, 0), 10, 15, 0);
+  REQUIRE(particles.GetMinRadius() == 10);
+
+  float impulse = 0;
+  for (size_t i = 0; i < particles.Size(); i++) {
+    impulse += particles.ReflectOffWalls(i, vec2(0, 0), vec2(100, 100), 1);
+  }
+  particles.Integrate(0, particles.Size(), 1);
+
+  // 2 * m * |v| per reflected component
+  REQUIRE(impulse == Approx(2 * 15 * (10 + 20 + 20 + 1)));
+
+  REQUIRE(particles.GetVelocity(0) == vec2(10, 0));
+  REQUIRE(particles.GetPosition(0).x == Approx(15));
+  REQUIRE(particles.GetVelocity(1) == vec2(10, 10));
+  REQUIRE(particles.GetVelocity(2) == vec2(-20, -20));
+  REQUIRE(particles.GetPosition(2).x == Approx(75));
+  REQUIRE(particles.GetPosition(2).y == Approx(72));
+  REQUIRE(particles.GetVelocity(3) == vec2(0, 1));
+  REQUIRE(particles.GetVelocity(4) == vec2(0, 0));
+}
+
+TEST_CASE("3D store reflects off the walls of every axis") {
+  BasicParticleStore<3, double> particles;
+  dvec3 top_left(0, 0, 0);
+  dvec3 bottom_right(100, 100, 100);
+
+  // touching the far wall of z only
+  particles.Add(dvec3(50, 50, 95), dvec3(1, 2, 3), 10, 2, 0);
+  REQUIRE(particles.HandleIfWallCollision(0, top_left, bottom_right) == 12);
+  REQUIRE(particles.GetVelocity(0) == dvec3(1, 2, -3));
+
+  // a step of 2 reaches the near wall of y and the far wall of z
+  particles.Add(dvec3(50, 11, 89), dvec3(0, -1, 1), 10, 2, 0);
+  REQUIRE(particles.ReflectOffWalls(1, top_left, bottom_right, 2) == 8);
+  REQUIRE(particles.GetVelocity(1) == dvec3(0, 1, -1));
+  particles.Integrate(1, 2, 2);
+  REQUIRE(particles.GetPosition(1) == dvec3(50, 11, 89));
+}
+
+TEST_CASE("3D collisions conserve momentum and energy") {
+  BasicParticleStore<3, double> particles;
+  particles.Add(dvec3(0, 0, 0), dvec3(1, 0.5, 0), 1, 2, 0);
+  particles.Add(dvec3(1.5, 0.5, 0.5), dvec3(-1, 0, 0.5), 1, 3, 0);
+  REQUIRE(particles.IsTouching(0, 1));
+  REQUIRE(particles.IsApproaching(0, 1));
+
+  dvec3 momentum = 2.0 * particles.GetVelocity(0) +
+                   3.0 * particles.GetVelocity(1);
+  double energy = 2 * glm::dot(particles.GetVelocity(0),
+                               particles.GetVelocity(0)) +
+                  3 * glm::dot(particles.GetVelocity(1),
+                               particles.GetVelocity(1));
+  dvec3 expected = idealgas::ComputeCollisionVelocity(
+      particles.GetPosition(0), particles.GetVelocity(0), 2.0,
+      particles.GetPosition(1), particles.GetVelocity(1), 3.0);
+  particles.UpdateVelocitiesForParticleCollision(0, 1);
+
+  dvec3 new_momentum = 2.0 * particles.GetVelocity(0) +
+                       3.0 * particles.GetVelocity(1);
+  double new_energy = 2 * glm::dot(particles.GetVelocity(0),
+                                   particles.GetVelocity(0)) +
+                      3 * glm::dot(particles.GetVelocity(1),
+                                   particles.GetVelocity(1));
+  for (int axis = 0; axis < 3; axis++) {
+    REQUIRE(new_momentum[axis] == Approx(momentum[axis]));
+    REQUIRE(particles.GetVelocity(0)[axis] == Approx(expected[axis]));
+  }
+  REQUIRE(new_energy == Approx(energy));
+  REQUIRE_FALSE(particles.IsApproaching(0, 1));
+}
+
+TEST_CASE("Stores of every dimension and precision share the 2D results") {
+  // particles in the xy plane behave the same in 3D, and in double
+  ParticleStore flat;
+  BasicParticleStore<3, float> deep;
+  BasicParticleStore<2, double> precise;
+  flat.Add(vec2(50, 50), vec2(2, -2), 10, 15, 0);
+  flat.Add(vec2(55, 56), vec2(-3, 3), 10, 20, 0);
+  deep.Add(vec3(50, 50, 0), vec3(2, -2, 0), 10, 15, 0);
+  deep.Add(vec3(55, 56, 0), vec3(-3, 3, 0), 10, 20, 0);
+  precise.Add(dvec2(50, 50), dvec2(2, -2), 10, 15, 0);
+  precise.Add(dvec2(55, 56), dvec2(-3, 3), 10, 20, 0);
+
+  flat.UpdateVelocitiesForParticleCollision(0, 1);
+  deep.UpdateVelocitiesForParticleCollision(0, 1);
+  precise.UpdateVelocitiesForParticleCollision(0, 1);
+  for (size_t i = 0; i < 2; i++) {
+    REQUIRE(deep.GetVelocity(i) ==
+            vec3(flat.GetVelocity(i).x, flat.GetVelocity(i).y, 0));
+    REQUIRE(precise.GetVelocity(i).x == Approx(flat.GetVelocity(i).x));
+    REQUIRE(precise.GetVelocity(i).y == Approx(flat.GetVelocity(i).y));
+  }
+}
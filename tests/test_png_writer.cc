@@ -0,0 +1,76 @@
+#include <png_writer.h>
+
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+using idealgas::Color;
+using idealgas::EncodePng;
+using idealgas::Framebuffer;
+using idealgas::WritePng;
+
+namespace {
+
+uint32_t ReadBigEndian(const std::vector<uint8_t>& bytes, size_t offset) {
+  return static_cast<uint32_t>(bytes[offset]) << 24 |
+         static_cast<uint32_t>(bytes[offset + 1]) << 16 |
+         static_cast<uint32_t>(bytes[offset + 2]) << 8 | bytes[offset + 3];
+}
+
+bool HasChunk(const std::vector<uint8_t>& bytes, size_t offset,
+              const char* type) {
+  return bytes.size() >= offset + 8 &&
+         std::equal(type, type + 4, bytes.begin() + offset + 4);
+}
+
+}  // namespace
+
+TEST_CASE("PNG encoding") {
+  Framebuffer framebuffer(300, 200);
+  framebuffer.Clear(Color(0, 0, 1));
+  std::vector<uint8_t> png = EncodePng(framebuffer);
+
+  SECTION("Starts with the signature and header") {
+    const uint8_t kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    REQUIRE(png.size() > 8 + 25);
+    REQUIRE(std::equal(kSignature, kSignature + 8, png.begin()));
+    REQUIRE(ReadBigEndian(png, 8) == 13);
+    REQUIRE(HasChunk(png, 8, "IHDR"));
+    REQUIRE(ReadBigEndian(png, 16) == 300);
+    REQUIRE(ReadBigEndian(png, 20) == 200);
+    REQUIRE(png[24] == 8);
+    REQUIRE(png[25] == 6);
+  }
+
+  SECTION("Chunks are IHDR, IDAT and IEND") {
+    size_t idat_offset = 8 + 12 + 13;
+    REQUIRE(HasChunk(png, idat_offset, "IDAT"));
+    size_t iend_offset = idat_offset + 12 + ReadBigEndian(png, idat_offset);
+    REQUIRE(HasChunk(png, iend_offset, "IEND"));
+    REQUIRE(iend_offset + 12 == png.size());
+  }
+
+  SECTION("Flat images compress well") {
+    REQUIRE(png.size() < 300 * 200 * 4 / 20);
+  }
+
+  SECTION("Writes the encoded bytes to a file") {
+    const char* path = "test_png_writer.png";
+    WritePng(path, framebuffer);
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> written((std::istreambuf_iterator<char>(file)),
+                                 std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path);
+    REQUIRE(written == png);
+  }
+
+  SECTION("Unwritable paths throw") {
+    REQUIRE_THROWS_AS(WritePng("missing_directory/frame.png", framebuffer),
+                      std::runtime_error);
+  }
+}
@@ -0,0 +1,137 @@
+#include <profiler.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using idealgas::PhaseSummary;
+using idealgas::Profiler;
+using idealgas::ProfileScope;
+using std::vector;
+
+namespace {
+
+const PhaseSummary* FindPhase(const vector<PhaseSummary>& summaries,
+                              const std::string& name) {
+  for (const PhaseSummary& summary : summaries) {
+    if (summary.name == name) {
+      return &summary;
+    }
+  }
+  return nullptr;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+}  // namespace
+
+TEST_CASE("Profiler records nothing while disabled") {
+  Profiler::Clear();
+  Profiler::SetEnabled(false);
+  { ProfileScope scope("disabled phase"); }
+  REQUIRE(FindPhase(Profiler::GetSummary(), "disabled phase") == nullptr);
+}
+
+TEST_CASE("Profiler sums scopes per name") {
+  Profiler::Clear();
+  Profiler::SetEnabled(true);
+  for (int i = 0; i < 3; i++) {
+    ProfileScope outer("outer phase");
+    ProfileScope inner("inner phase");
+  }
+  Profiler::SetEnabled(false);
+
+  vector<PhaseSummary> summaries = Profiler::GetSummary();
+  const PhaseSummary* outer = FindPhase(summaries, "outer phase");
+  const PhaseSummary* inner = FindPhase(summaries, "inner phase");
+  REQUIRE(outer != nullptr);
+  REQUIRE(inner != nullptr);
+  REQUIRE(outer->call_count == 3);
+  REQUIRE(inner->call_count == 3);
+  REQUIRE(outer->min_nanoseconds <= outer->max_nanoseconds);
+  REQUIRE(outer->total_nanoseconds >= inner->total_nanoseconds);
+
+  Profiler::Clear();
+  REQUIRE(Profiler::GetSummary().empty());
+}
+
+TEST_CASE("Profiler merges the scopes of every thread") {
+  Profiler::Clear();
+  Profiler::SetEnabled(true);
+  std::thread worker([] { ProfileScope scope("threaded phase"); });
+  worker.join();
+  { ProfileScope scope("threaded phase"); }
+  Profiler::SetEnabled(false);
+
+  vector<PhaseSummary> summaries = Profiler::GetSummary();
+  const PhaseSummary* phase = FindPhase(summaries, "threaded phase");
+  REQUIRE(phase != nullptr);
+  REQUIRE(phase->call_count == 2);
+  Profiler::Clear();
+}
+
+TEST_CASE("Profiler writes a Chrome trace") {
+  Profiler::Clear();
+  Profiler::SetEnabled(true);
+  { ProfileScope scope("traced \"phase\""); }
+  Profiler::SetEnabled(false);
+
+  std::string path = "test_profiler_trace.json";
+  Profiler::WriteChromeTrace(path);
+  std::string trace = ReadFile(path);
+  std::remove(path.c_str());
+  REQUIRE(trace.find("\"traceEvents\":[") != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"traced \\\"phase\\\"\",\"ph\":\"X\"") !=
+          std::string::npos);
+  REQUIRE(trace.find("\"ph\":\"M\"") != std::string::npos);
+  Profiler::Clear();
+
+  REQUIRE_THROWS_AS(Profiler::WriteChromeTrace("missing_dir/trace.json"),
+                    std::runtime_error);
+}
+
+TEST_CASE("Profiler hardware counters are optional") {
+  Profiler::Clear();
+  bool has_counters = Profiler::SetHardwareCountersEnabled(true);
+  Profiler::SetEnabled(true);
+  {
+    ProfileScope scope("counted phase");
+    volatile double sum = 0;
+    for (int i = 0; i < 10000; i++) {
+      sum = sum + i;
+    }
+  }
+  Profiler::SetEnabled(false);
+  Profiler::SetHardwareCountersEnabled(false);
+
+  vector<PhaseSummary> summaries = Profiler::GetSummary();
+  const PhaseSummary* phase = FindPhase(summaries, "counted phase");
+  REQUIRE(phase != nullptr);
+  if (has_counters) {
+    REQUIRE(phase->cycles > 0);
+    REQUIRE(phase->instructions > 0);
+  } else {
+    REQUIRE(phase->cycles == 0);
+  }
+  Profiler::Clear();
+}
+
+TEST_CASE("Profile scope macro follows the build setting") {
+  Profiler::Clear();
+  Profiler::SetEnabled(true);
+  { IDEALGAS_PROFILE_SCOPE("macro phase"); }
+  Profiler::SetEnabled(false);
+
+  bool was_recorded =
+      FindPhase(Profiler::GetSummary(), "macro phase") != nullptr;
+  REQUIRE(was_recorded == Profiler::IsCompiledIn());
+  Profiler::Clear();
+}
@@ -0,0 +1,144 @@
+#include <quantile_sketch.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using idealgas::QuantileSketch;
+using std::vector;
+
+namespace {
+
+vector<float> MakeValues(size_t count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> distribution(5, 2);
+  vector<float> values(count);
+  for (float& value : values) {
+    value = distribution(rng);
+  }
+  return values;
+}
+
+/**
+ * Largest difference between a fraction and the fraction of sorted_values
+ * at or below the sketch's estimate of it, over the percentiles
+ */
+double GetWorstRankError(const QuantileSketch& sketch,
+                         const vector<float>& sorted_values) {
+  double worst_error = 0;
+  for (int percent = 1; percent < 100; percent++) {
+    double fraction = percent / 100.0;
+    float estimate = sketch.GetQuantile(fraction);
+    size_t rank = std::upper_bound(sorted_values.begin(), sorted_values.end(),
+                                   estimate) -
+                  sorted_values.begin();
+    double error = std::fabs(static_cast<double>(rank) / sorted_values.size() -
+                             fraction);
+    worst_error = std::max(worst_error, error);
+  }
+  return worst_error;
+}
+
+}  // namespace
+
+TEST_CASE("Empty sketch") {
+  QuantileSketch sketch;
+  REQUIRE(sketch.GetCount() == 0);
+  REQUIRE(sketch.GetRetainedCount() == 0);
+  REQUIRE(sketch.GetQuantile(0.5) == 0);
+}
+
+TEST_CASE("Few values are kept exactly") {
+  QuantileSketch sketch;
+  for (int value = 100; value >= 1; value--) {
+    sketch.Add(static_cast<float>(value));
+  }
+  REQUIRE(sketch.GetCount() == 100);
+  REQUIRE(sketch.GetRetainedCount() == 100);
+  REQUIRE(sketch.GetQuantile(0) == 1);
+  REQUIRE(sketch.GetQuantile(0.25) == 25);
+  REQUIRE(sketch.GetQuantile(0.5) == 50);
+  REQUIRE(sketch.GetQuantile(1) == 100);
+}
+
+TEST_CASE("Quantiles of many values are close in rank") {
+  vector<float> values = MakeValues(1000000, 1);
+  QuantileSketch sketch;
+  size_t retained_at_tenth = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    sketch.Add(values[i]);
+    if (i + 1 == values.size() / 10) {
+      retained_at_tenth = sketch.GetRetainedCount();
+    }
+  }
+  std::sort(values.begin(), values.end());
+
+  REQUIRE(sketch.GetCount() == values.size());
+  REQUIRE(GetWorstRankError(sketch, values) < 0.02);
+  REQUIRE(sketch.GetQuantile(0) == values.front());
+  REQUIRE(sketch.GetQuantile(1) == values.back());
+
+  // ten times the values only adds a level or so
+  REQUIRE(sketch.GetRetainedCount() < 5 * QuantileSketch::kDefaultSize);
+  REQUIRE(sketch.GetRetainedCount() < retained_at_tenth + 100);
+}
+
+TEST_CASE("Merged sketches estimate the quantiles of all their values") {
+  vector<float> values = MakeValues(300000, 2);
+  vector<QuantileSketch> sketches(4);
+  for (size_t i = 0; i < values.size(); i++) {
+    sketches[i % sketches.size()].Add(values[i]);
+  }
+  QuantileSketch merged;
+  for (const QuantileSketch& sketch : sketches) {
+    merged.Add(sketch);
+  }
+  std::sort(values.begin(), values.end());
+
+  REQUIRE(merged.GetCount() == values.size());
+  REQUIRE(merged.GetMin() == values.front());
+  REQUIRE(merged.GetMax() == values.back());
+  REQUIRE(GetWorstRankError(merged, values) < 0.02);
+  REQUIRE(merged.GetRetainedCount() < 5 * QuantileSketch::kDefaultSize);
+
+  SECTION("Merging a sketch into itself doubles it") {
+    float median = merged.GetQuantile(0.5);
+    merged.Add(merged);
+    REQUIRE(merged.GetCount() == 2 * values.size());
+    REQUIRE(merged.GetQuantile(0.5) == Approx(median).epsilon(0.01));
+  }
+
+  SECTION("Merging an empty sketch changes nothing") {
+    float median = merged.GetQuantile(0.5);
+    merged.Add(QuantileSketch());
+    REQUIRE(merged.GetCount() == values.size());
+    REQUIRE(merged.GetQuantile(0.5) == median);
+  }
+}
+
+TEST_CASE("The same values in the same order give the same sketch") {
+  vector<float> values = MakeValues(50000, 3);
+  QuantileSketch one;
+  QuantileSketch two;
+  for (float value : values) {
+    one.Add(value);
+    two.Add(value);
+  }
+  REQUIRE(one.GetRetainedCount() == two.GetRetainedCount());
+  for (int percent = 0; percent <= 100; percent += 5) {
+    REQUIRE(one.GetQuantile(percent / 100.0) ==
+            two.GetQuantile(percent / 100.0));
+  }
+}
+
+TEST_CASE("Invalid quantile sketch arguments throw") {
+  REQUIRE_THROWS_AS(QuantileSketch(4), std::invalid_argument);
+
+  QuantileSketch sketch;
+  REQUIRE_THROWS_AS(sketch.GetQuantile(-0.1), std::invalid_argument);
+  REQUIRE_THROWS_AS(sketch.GetQuantile(1.5), std::invalid_argument);
+  REQUIRE_THROWS_AS(sketch.Add(QuantileSketch(100)), std::invalid_argument);
+}
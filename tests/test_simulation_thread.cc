@@ -0,0 +1,104 @@
+#include <simulation_thread.h>
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <thread>
+
+using glm::vec2;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::SimulationSnapshot;
+using idealgas::SimulationThread;
+using idealgas::SimulationThreadOptions;
+
+namespace {
+
+GasContainer MakeContainer() {
+  return GasContainer(300, vec2(0, 0), vec2(800, 600), 11);
+}
+
+void WaitForSteps(const SimulationThread& simulation, uint64_t step_count) {
+  while (simulation.GetStepCount() < step_count) {
+    std::this_thread::yield();
+  }
+}
+
+bool HaveSamePositions(const ParticleStore& one, const ParticleStore& two) {
+  if (one.Size() != two.Size()) {
+    return false;
+  }
+  for (size_t i = 0; i < one.Size(); i++) {
+    if (one.GetPosition(i) != two.GetPosition(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("Simulation thread publishes snapshots") {
+  GasContainer reference = MakeContainer();
+
+  SECTION("The starting state is available right away") {
+    SimulationThreadOptions options;
+    options.steps_per_second = 1;
+    SimulationThread simulation(MakeContainer(), options);
+    const SimulationSnapshot& snapshot = simulation.GetSnapshot();
+    REQUIRE(snapshot.frame_count == 0);
+    REQUIRE(HaveSamePositions(snapshot.particles,
+                              reference.GetParticleStore()));
+    REQUIRE(snapshot.species_speeds.size() == reference.GetSpecies().Size());
+  }
+
+  SECTION("The last snapshot matches the stopped container") {
+    SimulationThread simulation(MakeContainer());
+    WaitForSteps(simulation, 50);
+    simulation.Stop();
+    uint64_t step_count = simulation.GetStepCount();
+    REQUIRE(simulation.GetContainer().GetFrameCount() == step_count);
+
+    REQUIRE(simulation.AcquireSnapshot());
+    const SimulationSnapshot& snapshot = simulation.GetSnapshot();
+    REQUIRE(snapshot.frame_count == step_count);
+
+    // same result as stepping on the calling thread
+    for (uint64_t step = 0; step < step_count; step++) {
+      reference.AdvanceOneFrame();
+    }
+    REQUIRE(HaveSamePositions(snapshot.particles,
+                              reference.GetParticleStore()));
+  }
+
+  SECTION("Snapshots arrive while the simulation runs") {
+    SimulationThreadOptions options;
+    options.min_publish_interval = 0;
+    SimulationThread simulation(MakeContainer(), options);
+    uint64_t last_frame_count = 0;
+    for (size_t i = 0; i < 20; i++) {
+      while (!simulation.AcquireSnapshot()) {
+        std::this_thread::yield();
+      }
+      REQUIRE(simulation.GetSnapshot().frame_count > last_frame_count);
+      last_frame_count = simulation.GetSnapshot().frame_count;
+    }
+  }
+
+  SECTION("A fixed rate limits the steps per second") {
+    SimulationThreadOptions options;
+    options.steps_per_second = 100;
+    SimulationThread simulation(MakeContainer(), options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    simulation.Stop();
+    REQUIRE(simulation.GetStepCount() >= 5);
+    REQUIRE(simulation.GetStepCount() <= 40);
+  }
+
+  SECTION("Stopping twice is harmless") {
+    SimulationThread simulation(MakeContainer());
+    simulation.Stop();
+    simulation.Stop();
+    REQUIRE(simulation.GetContainer().GetFrameCount() ==
+            simulation.GetStepCount());
+  }
+}
@@ -0,0 +1,115 @@
+#include <gas_container.h>
+#include <snapshot.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using glm::vec2;
+using idealgas::GasContainer;
+using idealgas::ParticleStore;
+using idealgas::SnapshotHeader;
+using idealgas::SpeciesRegistry;
+
+namespace {
+
+const char* kSnapshotPath = "test_snapshot.bin";
+
+bool HaveSameParticles(const ParticleStore& particles_one,
+                       const ParticleStore& particles_two) {
+  if (particles_one.Size() != particles_two.Size()) {
+    return false;
+  }
+  for (size_t i = 0; i < particles_one.Size(); i++) {
+    if (particles_one.GetPosition(i) != particles_two.GetPosition(i) ||
+        particles_one.GetVelocity(i) != particles_two.GetVelocity(i) ||
+        particles_one.GetRadius(i) != particles_two.GetRadius(i) ||
+        particles_one.GetInverseMasses()[i] !=
+            particles_two.GetInverseMasses()[i] ||
+        particles_one.GetSpeciesId(i) != particles_two.GetSpeciesId(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("Snapshot restores the full container state") {
+  GasContainer container(300, vec2(10, 20), vec2(1500, 1000), 42);
+  for (int frame = 0; frame < 20; frame++) {
+    container.AdvanceOneFrame();
+  }
+  container.SaveSnapshot(kSnapshotPath);
+  GasContainer restored = GasContainer::LoadSnapshot(kSnapshotPath);
+  std::remove(kSnapshotPath);
+
+  SECTION("State matches") {
+    REQUIRE(restored.GetParticleCount() == 300);
+    REQUIRE(restored.GetFrameCount() == 20);
+    REQUIRE(restored.GetSeed() == 42);
+    REQUIRE(restored.GetTopLeftPosition() == vec2(10, 20));
+    REQUIRE(restored.GetBottomRightPosition() == vec2(1510, 1020));
+    REQUIRE(HaveSameParticles(restored.GetParticleStore(),
+                              container.GetParticleStore()));
+
+    const SpeciesRegistry& species = restored.GetSpecies();
+    REQUIRE(species.Size() == 3);
+    REQUIRE(species.Get(1).name == container.kRedParticleType);
+    REQUIRE(species.Get(1).color == container.GetSpecies().Get(1).color);
+    REQUIRE(species.Get(1).mass == container.GetSpecies().Get(1).mass);
+    REQUIRE(species.Get(1).radius == container.GetSpecies().Get(1).radius);
+  }
+
+  SECTION("Restored container continues the same run") {
+    for (int frame = 0; frame < 30; frame++) {
+      container.AdvanceOneFrame();
+      restored.AdvanceOneFrame();
+    }
+    REQUIRE(restored.GetFrameCount() == 50);
+    REQUIRE(HaveSameParticles(restored.GetParticleStore(),
+                              container.GetParticleStore()));
+  }
+}
+
+TEST_CASE("Invalid snapshots are rejected") {
+  SnapshotHeader header;
+  SpeciesRegistry species;
+  ParticleStore particles;
+
+  SECTION("Missing file") {
+    REQUIRE_THROWS_AS(idealgas::ReadSnapshot("no_such_snapshot.bin", header,
+                                             species, particles),
+                      std::runtime_error);
+  }
+
+  SECTION("Not a snapshot") {
+    std::ofstream(kSnapshotPath) << "definitely not a snapshot of a gas, but "
+                                    "long enough to hold a header............";
+    REQUIRE_THROWS_AS(
+        idealgas::ReadSnapshot(kSnapshotPath, header, species, particles),
+        std::runtime_error);
+    std::remove(kSnapshotPath);
+  }
+
+  SECTION("Truncated snapshot") {
+    GasContainer container(50, vec2(0, 0), vec2(500, 500), 1);
+    container.SaveSnapshot(kSnapshotPath);
+    std::string contents;
+    {
+      std::ifstream file(kSnapshotPath, std::ios::binary);
+      contents.assign(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+    }
+    std::ofstream(kSnapshotPath, std::ios::binary)
+        .write(contents.data(), contents.size() - 10);
+
+    REQUIRE_THROWS_AS(
+        idealgas::ReadSnapshot(kSnapshotPath, header, species, particles),
+        std::runtime_error);
+    std::remove(kSnapshotPath);
+  }
+}
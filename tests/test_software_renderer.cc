@@ -0,0 +1,164 @@
+#include <software_renderer.h>
+
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <cstring>
+
+using glm::vec2;
+using idealgas::Color;
+using idealgas::Framebuffer;
+using idealgas::GasContainer;
+using idealgas::Histogram;
+using idealgas::ParticleStore;
+using idealgas::SoftwareRenderer;
+using idealgas::SpeciesRegistry;
+using idealgas::Viewport;
+
+namespace {
+
+bool HasColor(const Framebuffer& framebuffer, size_t x, size_t y,
+              uint8_t red, uint8_t green, uint8_t blue) {
+  const uint8_t* pixel = framebuffer.GetPixel(x, y);
+  return pixel[0] == red && pixel[1] == green && pixel[2] == blue &&
+         pixel[3] == 255;
+}
+
+bool HaveSamePixels(const Framebuffer& one, const Framebuffer& two) {
+  return one.GetWidth() == two.GetWidth() &&
+         one.GetHeight() == two.GetHeight() &&
+         std::memcmp(one.GetPixels(), two.GetPixels(),
+                     4 * one.GetWidth() * one.GetHeight()) == 0;
+}
+
+}  // namespace
+
+TEST_CASE("Framebuffer") {
+  Framebuffer framebuffer(3, 2);
+  REQUIRE(framebuffer.GetWidth() == 3);
+  REQUIRE(framebuffer.GetHeight() == 2);
+
+  SECTION("Starts black and opaque") {
+    REQUIRE(HasColor(framebuffer, 0, 0, 0, 0, 0));
+    REQUIRE(HasColor(framebuffer, 2, 1, 0, 0, 0));
+  }
+
+  SECTION("Clear fills every pixel") {
+    framebuffer.Clear(Color(1, 0, 0));
+    REQUIRE(HasColor(framebuffer, 0, 0, 255, 0, 0));
+    REQUIRE(HasColor(framebuffer, 2, 1, 255, 0, 0));
+  }
+}
+
+TEST_CASE("Software renderer draws particles") {
+  SpeciesRegistry species;
+  uint8_t red = species.Register("red", Color(1, 0, 0), 1, 10);
+  uint8_t blue = species.Register("blue", Color(0, 0, 1), 1, 10);
+  ParticleStore particles;
+  particles.Resize(2);
+  particles.Set(0, vec2(30, 30), vec2(0, 0), 10, 1, red);
+  particles.Set(1, vec2(150, 100), vec2(0, 0), 10, 1, blue);
+
+  Framebuffer framebuffer(200, 150);
+  SoftwareRenderer renderer;
+  renderer.DrawParticles(particles, species, vec2(0, 0), vec2(200, 150),
+                         framebuffer);
+
+  SECTION("Particles are filled circles of their species' color") {
+    REQUIRE(HasColor(framebuffer, 30, 30, 255, 0, 0));
+    REQUIRE(HasColor(framebuffer, 36, 36, 255, 0, 0));
+    REQUIRE(HasColor(framebuffer, 38, 38, 0, 0, 0));
+    REQUIRE(HasColor(framebuffer, 150, 100, 0, 0, 255));
+    REQUIRE(HasColor(framebuffer, 159, 100, 0, 0, 255));
+    REQUIRE(HasColor(framebuffer, 161, 100, 0, 0, 0));
+  }
+
+  SECTION("Walls are white") {
+    REQUIRE(HasColor(framebuffer, 0, 75, 255, 255, 255));
+    REQUIRE(HasColor(framebuffer, 199, 75, 255, 255, 255));
+    REQUIRE(HasColor(framebuffer, 100, 0, 255, 255, 255));
+    REQUIRE(HasColor(framebuffer, 100, 149, 255, 255, 255));
+    REQUIRE(HasColor(framebuffer, 100, 75, 0, 0, 0));
+  }
+
+  SECTION("Particles crossing the edge of the framebuffer are clipped") {
+    particles.Set(0, vec2(-5, 70), vec2(0, 0), 10, 1, red);
+    particles.Set(1, vec2(195, 145), vec2(0, 0), 10, 1, blue);
+    framebuffer.Clear(Color());
+    renderer.DrawParticles(particles, species, vec2(-100, -100),
+                           vec2(400, 400), framebuffer);
+    REQUIRE(HasColor(framebuffer, 0, 70, 255, 0, 0));
+    REQUIRE(HasColor(framebuffer, 199, 149, 0, 0, 255));
+  }
+}
+
+TEST_CASE("Software renderer viewport") {
+  SpeciesRegistry species;
+  uint8_t red = species.Register("red", Color(1, 0, 0), 1, 1);
+  ParticleStore particles;
+  particles.Resize(2);
+  particles.Set(0, vec2(1010, 1020), vec2(0, 0), 1, 1, red);
+  particles.Set(1, vec2(1000.01f, 1000.01f), vec2(0, 0), 0.01f, 1, red);
+
+  Framebuffer framebuffer(100, 100);
+  SoftwareRenderer renderer;
+  Viewport viewport;
+  viewport.origin = vec2(1000, 1000);
+  viewport.scale = 4;
+  renderer.SetViewport(viewport);
+  REQUIRE(renderer.GetViewport().scale == 4);
+  renderer.DrawParticles(particles, species, vec2(1000, 1000),
+                         vec2(1025, 1025), framebuffer);
+
+  SECTION("Positions are mapped and radii are scaled") {
+    REQUIRE(HasColor(framebuffer, 40, 80, 255, 0, 0));
+    REQUIRE(HasColor(framebuffer, 43, 80, 255, 0, 0));
+    REQUIRE(HasColor(framebuffer, 45, 80, 0, 0, 0));
+  }
+
+  SECTION("Particles smaller than a pixel are still drawn") {
+    REQUIRE(HasColor(framebuffer, 0, 0, 255, 0, 0));
+  }
+
+  SECTION("Walls are scaled") {
+    REQUIRE(HasColor(framebuffer, 99, 50, 255, 255, 255));
+    REQUIRE(HasColor(framebuffer, 50, 99, 255, 255, 255));
+  }
+}
+
+TEST_CASE("Software renderer output doesn't depend on the thread count") {
+  GasContainer container(2000, vec2(0, 0), vec2(700, 500), 3);
+  Framebuffer one_thread(700, 500);
+  Framebuffer four_threads(700, 500);
+
+  SoftwareRenderer serial_renderer(1);
+  SoftwareRenderer parallel_renderer(4);
+  for (size_t frame = 0; frame < 3; frame++) {
+    container.AdvanceOneFrame();
+  }
+  serial_renderer.DrawGasContainer(container, one_thread);
+  parallel_renderer.DrawGasContainer(container, four_threads);
+  REQUIRE(HaveSamePixels(one_thread, four_threads));
+}
+
+TEST_CASE("Software renderer draws histograms") {
+  Histogram histogram(vec2(10, 10), vec2(40, 40), Color(0, 1, 0),
+                      Color(1, 1, 1), "Speed", "Frequency");
+  histogram.SetRange(0, 2);
+  histogram.UpdateData(std::vector<float>{0.5f, 1.5f, 1.5f}, 2);
+
+  Framebuffer framebuffer(60, 60);
+  SoftwareRenderer renderer;
+  renderer.DrawHistogram(histogram, framebuffer);
+
+  SECTION("Bars are as tall as their frequency") {
+    REQUIRE(HasColor(framebuffer, 20, 40, 0, 255, 0));
+    REQUIRE(HasColor(framebuffer, 20, 20, 0, 0, 0));
+    REQUIRE(HasColor(framebuffer, 40, 20, 0, 255, 0));
+    REQUIRE(HasColor(framebuffer, 40, 5, 0, 0, 0));
+  }
+
+  SECTION("Axes use the axis color") {
+    REQUIRE(HasColor(framebuffer, 10, 30, 255, 255, 255));
+    REQUIRE(HasColor(framebuffer, 30, 50, 255, 255, 255));
+  }
+}
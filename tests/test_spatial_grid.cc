@@ -0,0 +1,193 @@
+#include <spatial_grid.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstdlib>
+
+using glm::vec2;
+using idealgas::Boundary;
+using idealgas::Narrowphase;
+using idealgas::ParticleArrays;
+using idealgas::ParticleStore;
+using idealgas::SpatialGrid;
+using std::vector;
+
+TEST_CASE("Rebuild sizes cells from the largest radius") {
+  ParticleStore particles;
+  particles.Add(vec2(10, 10), vec2(0, 0), 5, 1, 0);
+  particles.Add(vec2(90, 90), vec2(0, 0), 10, 1, 1);
+  SpatialGrid grid;
+  grid.Rebuild(particles, vec2(0, 0), vec2(100, 100));
+
+  REQUIRE(grid.GetCellSize() >= 20);
+  REQUIRE(grid.GetColumnCount() * grid.GetCellSize() >= 100);
+  REQUIRE(grid.GetRowCount() * grid.GetCellSize() >= 100);
+}
+
+TEST_CASE("FindCollidingPairs") {
+  ParticleStore particles;
+  SpatialGrid grid;
+  vector<SpatialGrid::IndexPair> pairs;
+
+  SECTION("Touching and approaching pair is found once") {
+    particles.Add(vec2(55, 56), vec2(-3, -3), 10, 20, 0);
+    particles.Add(vec2(50, 50), vec2(2, 2), 10, 15, 1);
+    particles.Add(vec2(400, 400), vec2(1, 1), 10, 15, 1);
+    grid.Rebuild(particles, vec2(0, 0), vec2(500, 500));
+    grid.FindCollidingPairs(particles, pairs);
+
+    REQUIRE(pairs.size() == 1);
+    REQUIRE(pairs[0] == SpatialGrid::IndexPair(0, 1));
+  }
+
+  SECTION("Touching pair that is moving apart is not found") {
+    particles.Add(vec2(50, 50), vec2(2, -2), 10, 15, 1);
+    particles.Add(vec2(48, 48), vec2(-3, 3), 10, 20, 0);
+    grid.Rebuild(particles, vec2(0, 0), vec2(500, 500));
+    grid.FindCollidingPairs(particles, pairs);
+
+    REQUIRE(pairs.empty());
+  }
+
+  SECTION("Pair across a cell boundary is found") {
+    particles.Add(vec2(19, 19), vec2(1, 1), 10, 15, 1);
+    particles.Add(vec2(21, 21), vec2(-1, -1), 10, 20, 0);
+    grid.Rebuild(particles, vec2(0, 0), vec2(40, 40));
+    grid.FindCollidingPairs(particles, pairs);
+
+    REQUIRE(pairs.size() == 1);
+    REQUIRE(pairs[0] == SpatialGrid::IndexPair(0, 1));
+  }
+
+  SECTION("Particles outside of the container are still found") {
+    particles.Add(vec2(-5, 50), vec2(1, 0), 10, 15, 1);
+    particles.Add(vec2(8, 50), vec2(-1, 0), 10, 20, 0);
+    grid.Rebuild(particles, vec2(0, 0), vec2(500, 500));
+    grid.FindCollidingPairs(particles, pairs);
+
+    REQUIRE(pairs.size() == 1);
+  }
+}
+
+TEST_CASE("FindParticlesInBox") {
+  ParticleStore particles;
+  particles.Add(vec2(10, 10), vec2(0, 0), 5, 1, 0);
+  particles.Add(vec2(90, 10), vec2(0, 0), 5, 1, 0);
+  particles.Add(vec2(10, 90), vec2(0, 0), 5, 1, 0);
+  particles.Add(vec2(-20, 50), vec2(0, 0), 5, 1, 0);
+  SpatialGrid grid;
+  grid.Rebuild(particles, vec2(0, 0), vec2(100, 100));
+
+  SECTION("Only particles in overlapping cells are found") {
+    vector<size_t> indices;
+    grid.FindParticlesInBox(vec2(0, 0), vec2(20, 20), indices);
+    REQUIRE(indices == vector<size_t>{0});
+  }
+
+  SECTION("Boxes beyond the container reach the edge cells") {
+    vector<size_t> indices;
+    grid.FindParticlesInBox(vec2(-100, -100), vec2(200, 200), indices);
+    std::sort(indices.begin(), indices.end());
+    vector<size_t> expected = {0, 1, 2, 3};
+    REQUIRE(indices == expected);
+  }
+
+  SECTION("Results are appended") {
+    vector<size_t> indices = {7};
+    grid.FindParticlesInBox(vec2(80, 0), vec2(100, 20), indices);
+    vector<size_t> expected = {7, 1};
+    REQUIRE(indices == expected);
+  }
+}
+
+TEST_CASE("Periodic axes") {
+  ParticleStore particles;
+  SpatialGrid grid;
+  vector<SpatialGrid::IndexPair> pairs;
+
+  SECTION("Cells tile a periodic axis exactly") {
+    particles.Add(vec2(10, 10), vec2(0, 0), 5, 1, 0);
+    grid.SetBoundaries(Boundary::kPeriodic, Boundary::kWall);
+    grid.Rebuild(particles, vec2(0, 0), vec2(100, 100));
+
+    REQUIRE(grid.GetColumnCount() * grid.GetCellSize() <= 100);
+    REQUIRE(grid.GetRowCount() * grid.GetCellSize() >= 100);
+  }
+
+  SECTION("Pairs across each edge and corner are found once") {
+    particles.Add(vec2(2, 50), vec2(-1, 0), 5, 1, 0);
+    particles.Add(vec2(98, 52), vec2(1, 0), 5, 1, 0);  // across x
+    particles.Add(vec2(50, 1), vec2(0, -1), 5, 1, 0);
+    particles.Add(vec2(51, 99), vec2(0, 1), 5, 1, 0);  // across y
+    particles.Add(vec2(1, 1), vec2(-1, -1), 5, 1, 0);
+    particles.Add(vec2(99, 99), vec2(1, 1), 5, 1, 0);  // across the corner
+    grid.SetBoundaries(Boundary::kPeriodic, Boundary::kPeriodic);
+    grid.Rebuild(particles, vec2(0, 0), vec2(100, 100));
+    grid.FindCollidingPairs(particles, pairs);
+
+    vector<SpatialGrid::IndexPair> expected = {
+        SpatialGrid::IndexPair(0, 1), SpatialGrid::IndexPair(2, 3),
+        SpatialGrid::IndexPair(4, 5)};
+    REQUIRE(pairs == expected);
+  }
+
+  SECTION("Pairs across an edge with walls are not found") {
+    particles.Add(vec2(2, 50), vec2(-1, 0), 5, 1, 0);
+    particles.Add(vec2(98, 52), vec2(1, 0), 5, 1, 0);
+    grid.SetBoundaries(Boundary::kWall, Boundary::kPeriodic);
+    grid.Rebuild(particles, vec2(0, 0), vec2(100, 100));
+    grid.FindCollidingPairs(particles, pairs);
+
+    REQUIRE(pairs.empty());
+  }
+
+  SECTION("Random particles match testing every pair") {
+    srand(425);
+    for (size_t i = 0; i < 500; i++) {
+      float x = static_cast<float>(rand() % 30000) / 100;
+      float y = static_cast<float>(rand() % 20000) / 100;
+      float vx = static_cast<float>(rand() % 1000) / 100 - 5;
+      float vy = static_cast<float>(rand() % 1000) / 100 - 5;
+      particles.Add(vec2(x, y), vec2(vx, vy), 4, 1, 0);
+    }
+    const Boundary boundaries[][2] = {
+        {Boundary::kPeriodic, Boundary::kWall},
+        {Boundary::kWall, Boundary::kPeriodic},
+        {Boundary::kPeriodic, Boundary::kPeriodic}};
+    for (const auto& boundary : boundaries) {
+      grid.SetBoundaries(boundary[0], boundary[1]);
+      grid.Rebuild(particles, vec2(0, 0), vec2(300, 200));
+      grid.FindCollidingPairs(particles, pairs);
+
+      ParticleArrays arrays(particles);
+      arrays.period_x = boundary[0] == Boundary::kPeriodic ? 300 : 0;
+      arrays.period_y = boundary[1] == Boundary::kPeriodic ? 200 : 0;
+      Narrowphase narrowphase;
+      vector<SpatialGrid::IndexPair> expected;
+      for (size_t i = 0; i < particles.Size(); i++) {
+        for (size_t j = i + 1; j < particles.Size(); j++) {
+          if (narrowphase.FindContacts(arrays, i, j, 1) != 0) {
+            expected.push_back(SpatialGrid::IndexPair(i, j));
+          }
+        }
+      }
+      REQUIRE(!expected.empty());
+      REQUIRE(pairs == expected);
+    }
+  }
+
+  SECTION("Boxes wrap around the periodic edges") {
+    particles.Add(vec2(5, 5), vec2(0, 0), 5, 1, 0);
+    particles.Add(vec2(95, 5), vec2(0, 0), 5, 1, 0);
+    particles.Add(vec2(5, 95), vec2(0, 0), 5, 1, 0);
+    particles.Add(vec2(50, 50), vec2(0, 0), 5, 1, 0);
+    grid.SetBoundaries(Boundary::kPeriodic, Boundary::kPeriodic);
+    grid.Rebuild(particles, vec2(0, 0), vec2(100, 100));
+
+    vector<size_t> indices;
+    grid.FindParticlesInBox(vec2(-10, -10), vec2(10, 10), indices);
+    std::sort(indices.begin(), indices.end());
+    vector<size_t> expected = {0, 1, 2};
+    REQUIRE(indices == expected);
+  }
+}
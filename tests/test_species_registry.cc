@@ -0,0 +1,58 @@
+#include <species_registry.h>
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+using idealgas::Color;
+using idealgas::SpeciesRegistry;
+
+TEST_CASE("Register assigns dense ids") {
+  SpeciesRegistry species;
+  REQUIRE(species.IsEmpty());
+  REQUIRE(species.Register("BLUE", Color("blue"), 5, 20) == 0);
+  REQUIRE(species.Register("RED", Color("red"), 7, 25) == 1);
+  REQUIRE(species.Size() == 2);
+
+  SECTION("Registering the same species again returns its id") {
+    REQUIRE(species.Register("BLUE", Color("blue"), 5, 20) == 0);
+    REQUIRE(species.Size() == 2);
+  }
+
+  SECTION("Looking up by name") {
+    REQUIRE(species.Contains("RED"));
+    REQUIRE_FALSE(species.Contains("GREEN"));
+    REQUIRE(species.GetId("RED") == 1);
+    REQUIRE(species.Get(1).name == "RED");
+    REQUIRE(species.Get(1).mass == 7);
+    REQUIRE(species.Get(1).radius == 25);
+    REQUIRE_THROWS_AS(species.GetId("GREEN"), std::out_of_range);
+  }
+
+  SECTION("Conflicting or invalid species are rejected") {
+    REQUIRE_THROWS_AS(species.Register("BLUE", Color("blue"), 6, 20),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(species.Register("GREEN", Color("green"), 0, 20),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(species.Register("GREEN", Color("green"), 10, -1),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Pair tables are precomputed for every pair of species") {
+  SpeciesRegistry species;
+  species.Register("BLUE", Color("blue"), 5, 20);
+  species.Register("RED", Color("red"), 15, 25);
+
+  REQUIRE(species.GetMassFraction(0, 0) == 1);
+  REQUIRE(species.GetMassFraction(0, 1) == Approx(1.5));
+  REQUIRE(species.GetMassFraction(1, 0) == Approx(0.5));
+  REQUIRE(species.GetRadiusSum(0, 1) == 45);
+  REQUIRE(species.GetRadiusSum(1, 1) == 50);
+
+  SECTION("Tables grow when a species is added") {
+    species.Register("GREEN", Color("green"), 10, 30);
+    REQUIRE(species.GetMassFraction(0, 1) == Approx(1.5));
+    REQUIRE(species.GetMassFraction(2, 0) == Approx(2.0 * 5 / 15));
+    REQUIRE(species.GetRadiusSum(2, 0) == 50);
+  }
+}
@@ -0,0 +1,91 @@
+#include <histogram.h>
+#include <speed_distribution.h>
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+#include <vector>
+
+using glm::vec2;
+using idealgas::Color;
+using idealgas::Histogram;
+using idealgas::SpeedDistribution;
+using std::vector;
+
+TEST_CASE("Speed distributions bin speeds and add up") {
+  SpeedDistribution distribution(10, 5);
+  REQUIRE(distribution.GetBinWidth() == 2);
+  distribution.Add(0);
+  distribution.Add(3.5f);
+  distribution.Add(9.9f);
+  distribution.Add(25);
+  REQUIRE(distribution.GetBinCounts() ==
+          (vector<uint64_t>{1, 1, 0, 0, 2}));
+  REQUIRE(distribution.GetSampleCount() == 4);
+  REQUIRE(distribution.GetMean() == Approx((3.5 + 9.9 + 25) / 4));
+
+  SpeedDistribution other(10, 5);
+  other.Add(5);
+  distribution.Add(other);
+  REQUIRE(distribution.GetBinCounts() ==
+          (vector<uint64_t>{1, 1, 1, 0, 2}));
+
+  REQUIRE_THROWS_AS(distribution.Add(SpeedDistribution(10, 4)),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(SpeedDistribution(0, 5), std::invalid_argument);
+}
+
+TEST_CASE("Speed distributions average the bins over frames") {
+  SpeedDistribution distribution(10, 5);
+  REQUIRE(distribution.GetAverageBinCounts() ==
+          (vector<double>{0, 0, 0, 0, 0}));
+
+  distribution.AddFrame({1, 1, 5});
+  distribution.AddFrame({1, 9, 9, 9});
+  REQUIRE(distribution.GetFrameCount() == 2);
+  REQUIRE(distribution.GetSampleCount() == 7);
+  REQUIRE(distribution.GetAverageBinCounts() ==
+          (vector<double>{1.5, 0, 0.5, 0, 1.5}));
+
+  SECTION("Added distributions add their frames") {
+    SpeedDistribution other(10, 5);
+    other.AddFrame({3, 3});
+    distribution.Add(other);
+    REQUIRE(distribution.GetFrameCount() == 3);
+    REQUIRE(distribution.GetAverageBinCounts() ==
+            (vector<double>{1, 2.0 / 3, 1.0 / 3, 0, 1}));
+  }
+}
+
+TEST_CASE("Speed distributions estimate percentiles of every speed") {
+  SpeedDistribution distribution(10, 5);
+  SpeedDistribution other(10, 5);
+  for (int frame = 0; frame < 1000; frame++) {
+    vector<float> speeds;
+    for (int i = 0; i < 100; i++) {
+      speeds.push_back(static_cast<float>((frame * 100 + i) % 1000) / 100);
+    }
+    (frame % 2 == 0 ? distribution : other).AddFrame(speeds);
+  }
+  distribution.Add(other);
+
+  REQUIRE(distribution.GetSampleCount() == 100000);
+  REQUIRE(distribution.GetSketch().GetCount() == 100000);
+  REQUIRE(distribution.GetQuantile(0) == 0);
+  REQUIRE(distribution.GetQuantile(0.5) == Approx(5).margin(0.2));
+  REQUIRE(distribution.GetQuantile(0.9) == Approx(9).margin(0.2));
+  REQUIRE(distribution.GetQuantile(1) == Approx(9.99f));
+}
+
+TEST_CASE("Histograms show the time average of a distribution") {
+  Histogram histogram(vec2(0, 0), vec2(100, 100), Color("blue"),
+                      Color("white"), "Speed", "Frequency");
+  SpeedDistribution distribution(10, 4);
+  histogram.UpdateData(distribution);
+  REQUIRE(histogram.GetBins() == (vector<float>{0, 0, 0, 0}));
+  REQUIRE(histogram.GetBarWidth() == 25);
+
+  distribution.AddFrame({1, 1, 1, 6});
+  distribution.AddFrame({1, 1, 9});
+  histogram.UpdateData(distribution);
+  REQUIRE(histogram.GetBins() == (vector<float>{2.5f, 0, 0.5f, 0.5f}));
+}
@@ -0,0 +1,84 @@
+#include <particle_store.h>
+#include <state_hash.h>
+
+#include <catch2/catch.hpp>
+#include <vector>
+
+using glm::vec2;
+using idealgas::CombineStateHashes;
+using idealgas::FindFirstDivergentFrame;
+using idealgas::HashParticleState;
+using idealgas::ParticleStore;
+using std::vector;
+
+namespace {
+
+ParticleStore MakeParticles() {
+  ParticleStore particles;
+  particles.Add(vec2(10, 20), vec2(1, -1), 5, 2, 0);
+  particles.Add(vec2(30, 40), vec2(0, 2), 5, 2, 1);
+  return particles;
+}
+
+}  // namespace
+
+TEST_CASE("Equal states hash the same") {
+  REQUIRE(HashParticleState(MakeParticles()) ==
+          HashParticleState(MakeParticles()));
+}
+
+TEST_CASE("Any change to the state changes the hash") {
+  uint64_t hash = HashParticleState(MakeParticles());
+
+  SECTION("Position") {
+    ParticleStore particles = MakeParticles();
+    particles.SetPosition(1, vec2(30, 40.00001f));
+    REQUIRE(HashParticleState(particles) != hash);
+  }
+
+  SECTION("Sign of a zero velocity") {
+    ParticleStore particles = MakeParticles();
+    particles.Set(1, vec2(30, 40), vec2(-0.0f, 2), 5, 2, 1);
+    REQUIRE(HashParticleState(particles) != hash);
+  }
+
+  SECTION("Species") {
+    ParticleStore particles = MakeParticles();
+    particles.Set(1, vec2(30, 40), vec2(0, 2), 5, 2, 0);
+    REQUIRE(HashParticleState(particles) != hash);
+  }
+
+  SECTION("Particle count") {
+    ParticleStore particles = MakeParticles();
+    particles.Resize(1);
+    REQUIRE(HashParticleState(particles) != hash);
+    REQUIRE(HashParticleState(ParticleStore()) != hash);
+  }
+}
+
+TEST_CASE("Combined hashes depend on the order of the frames") {
+  uint64_t one = HashParticleState(MakeParticles());
+  uint64_t two = HashParticleState(ParticleStore());
+  REQUIRE(CombineStateHashes(CombineStateHashes(0, one), two) !=
+          CombineStateHashes(CombineStateHashes(0, two), one));
+}
+
+TEST_CASE("FindFirstDivergentFrame") {
+  vector<uint64_t> hashes = {1, 2, 3, 4};
+
+  SECTION("Equal logs agree on every frame") {
+    REQUIRE(FindFirstDivergentFrame(hashes, hashes) == 4);
+  }
+
+  SECTION("Logs that differ") {
+    vector<uint64_t> other = {1, 2, 7, 4};
+    REQUIRE(FindFirstDivergentFrame(hashes, other) == 2);
+    REQUIRE(FindFirstDivergentFrame(other, hashes) == 2);
+  }
+
+  SECTION("A log and its prefix") {
+    vector<uint64_t> prefix = {1, 2};
+    REQUIRE(FindFirstDivergentFrame(hashes, prefix) == 2);
+    REQUIRE(FindFirstDivergentFrame(vector<uint64_t>(), hashes) == 0);
+  }
+}
@@ -0,0 +1,53 @@
+#include <thread_pool.h>
+
+#include <catch2/catch.hpp>
+#include <vector>
+
+using idealgas::ThreadPool;
+using std::vector;
+
+TEST_CASE("ParallelFor visits every index exactly once") {
+  for (size_t thread_count : {1, 2, 4, 7}) {
+    ThreadPool pool(thread_count);
+    REQUIRE(pool.GetThreadCount() == thread_count);
+
+    vector<int> visits(1000, 0);
+    pool.ParallelFor(visits.size(), 13,
+                     [&visits](size_t begin, size_t end, size_t) {
+                       for (size_t i = begin; i < end; i++) {
+                         visits[i]++;
+                       }
+                     });
+    REQUIRE(visits == vector<int>(1000, 1));
+  }
+}
+
+TEST_CASE("ParallelFor chunks don't depend on the thread count") {
+  vector<size_t> single_thread_begins(5);
+  vector<size_t> multi_thread_begins(5);
+  ThreadPool single_thread(1);
+  ThreadPool multi_thread(4);
+
+  single_thread.ParallelFor(
+      103, 5, [&](size_t begin, size_t, size_t chunk) {
+        single_thread_begins[chunk] = begin;
+      });
+  multi_thread.ParallelFor(
+      103, 5, [&](size_t begin, size_t, size_t chunk) {
+        multi_thread_begins[chunk] = begin;
+      });
+
+  REQUIRE(single_thread_begins == multi_thread_begins);
+  REQUIRE(single_thread_begins[0] == 0);
+}
+
+TEST_CASE("ParallelFor can be called repeatedly") {
+  ThreadPool pool(4);
+  vector<size_t> sums(4, 0);
+  for (size_t round = 0; round < 200; round++) {
+    pool.ParallelFor(400, [&sums](size_t begin, size_t end, size_t chunk) {
+      sums[chunk] += end - begin;
+    });
+  }
+  REQUIRE(sums == vector<size_t>(4, 200 * 100));
+}
@@ -0,0 +1,246 @@
+#include <gas_container.h>
+#include <trajectory.h>
+
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using glm::vec2;
+using idealgas::Color;
+using idealgas::GasContainer;
+using idealgas::Particle;
+using idealgas::ParticleStore;
+using idealgas::TrajectoryFrame;
+using idealgas::TrajectoryOptions;
+using idealgas::TrajectoryReader;
+using idealgas::TrajectoryWriter;
+
+namespace {
+
+const char* kTrajectoryPath = "test_trajectory.bin";
+
+/** Frames as the container had them, before quantizing **/
+struct RecordedFrame {
+  uint64_t frame_number;
+  std::vector<vec2> positions;
+  std::vector<vec2> velocities;
+};
+
+RecordedFrame Record(const GasContainer& container,
+                     const std::vector<uint64_t>& indices) {
+  const ParticleStore& particles = container.GetParticleStore();
+  RecordedFrame frame;
+  frame.frame_number = container.GetFrameCount();
+  for (uint64_t index : indices) {
+    frame.positions.push_back(particles.GetPosition(index));
+    frame.velocities.push_back(particles.GetVelocity(index));
+  }
+  return frame;
+}
+
+bool IsClose(const vec2& one, const vec2& two, float tolerance) {
+  return std::abs(one.x - two.x) <= tolerance &&
+         std::abs(one.y - two.y) <= tolerance;
+}
+
+}  // namespace
+
+TEST_CASE("Trajectory round trip") {
+  GasContainer container(200, vec2(10, 20), vec2(1500, 1000), 7);
+  TrajectoryOptions options;
+  options.stride = 3;
+  options.frames_per_chunk = 4;
+  options.buffer_count = 2;
+
+  SECTION("Every particle, every stride-th frame") {
+    std::vector<uint64_t> all_indices;
+    for (uint64_t i = 0; i < container.GetParticleCount(); i++) {
+      all_indices.push_back(i);
+    }
+    std::vector<RecordedFrame> recorded;
+    {
+      TrajectoryWriter writer(kTrajectoryPath, container, options);
+      for (int frame = 0; frame < 30; frame++) {
+        container.AdvanceOneFrame();
+        writer.AddFrame(container);
+        if (container.GetFrameCount() % options.stride == 0) {
+          recorded.push_back(Record(container, all_indices));
+        }
+      }
+      writer.Close();
+      REQUIRE(writer.GetQueuedFrameCount() == 10);
+    }
+
+    TrajectoryReader reader(kTrajectoryPath);
+    REQUIRE(reader.GetParticleIndices() == all_indices);
+    REQUIRE(reader.GetStride() == 3);
+    REQUIRE(reader.GetSpeciesNames().size() == 3);
+
+    // half a quantization step on each axis
+    float position_tolerance = 1500.0f / 65535 / 2 + 1e-3f;
+    float velocity_tolerance = options.velocity_limit / 32767 / 2 + 1e-5f;
+    TrajectoryFrame frame;
+    for (const RecordedFrame& expected : recorded) {
+      REQUIRE(reader.ReadFrame(frame));
+      REQUIRE(frame.frame_number == expected.frame_number);
+      REQUIRE(frame.positions.size() == expected.positions.size());
+      for (size_t i = 0; i < frame.positions.size(); i++) {
+        REQUIRE(IsClose(frame.positions[i], expected.positions[i],
+                        position_tolerance));
+        REQUIRE(IsClose(frame.velocities[i], expected.velocities[i],
+                        velocity_tolerance));
+      }
+    }
+    REQUIRE_FALSE(reader.ReadFrame(frame));
+  }
+
+  SECTION("Only the chosen species") {
+    options.species_ids.push_back(1);
+    {
+      TrajectoryWriter writer(kTrajectoryPath, container, options);
+      for (int frame = 0; frame < 6; frame++) {
+        container.AdvanceOneFrame();
+        writer.AddFrame(container);
+      }
+    }
+
+    TrajectoryReader reader(kTrajectoryPath);
+    const ParticleStore& particles = container.GetParticleStore();
+    size_t species_count = 0;
+    for (size_t i = 0; i < particles.Size(); i++) {
+      species_count += particles.GetSpeciesId(i) == 1;
+    }
+    REQUIRE(species_count > 0);
+    REQUIRE(reader.GetParticleIndices().size() == species_count);
+    for (uint8_t species_id : reader.GetSpeciesIds()) {
+      REQUIRE(species_id == 1);
+    }
+
+    TrajectoryFrame frame;
+    REQUIRE(reader.ReadFrame(frame));
+    REQUIRE(frame.frame_number == 3);
+    REQUIRE(frame.positions.size() == species_count);
+    REQUIRE(reader.ReadFrame(frame));
+    REQUIRE(frame.frame_number == 6);
+    REQUIRE_FALSE(reader.ReadFrame(frame));
+  }
+
+  std::remove(kTrajectoryPath);
+}
+
+TEST_CASE("Trajectory is smaller than raw floats") {
+  GasContainer container(500, vec2(0, 0), vec2(2000, 2000), 3);
+  {
+    TrajectoryWriter writer(kTrajectoryPath, container);
+    for (int frame = 0; frame < 64; frame++) {
+      container.AdvanceOneFrame();
+      writer.AddFrame(container);
+    }
+  }
+  std::ifstream file(kTrajectoryPath, std::ios::binary | std::ios::ate);
+  size_t file_size = static_cast<size_t>(file.tellg());
+  file.close();
+  std::remove(kTrajectoryPath);
+
+  size_t raw_size = 64 * 500 * 4 * sizeof(float);
+  REQUIRE(file_size < raw_size / 2);
+}
+
+TEST_CASE("Trajectory counts the particles the container holds") {
+  // the count passed to the constructor differs from the particles given
+  std::vector<Particle> particles;
+  for (int i = 0; i < 12; i++) {
+    particles.push_back(Particle(
+        vec2(40 + 35 * i, 100), vec2(1, 0.5f), Color("red"), 10, 5, "RED"));
+  }
+  GasContainer container(3, vec2(0, 0), vec2(500, 500), 1, particles);
+  {
+    TrajectoryWriter writer(kTrajectoryPath, container);
+    for (int frame = 0; frame < 3; frame++) {
+      container.AdvanceOneFrame();
+      writer.AddFrame(container);
+    }
+  }
+
+  TrajectoryReader reader(kTrajectoryPath);
+  TrajectoryFrame frame;
+  size_t frame_count = 0;
+  while (reader.ReadFrame(frame)) {
+    frame_count++;
+  }
+  REQUIRE(reader.GetParticleIndices().size() == particles.size());
+  REQUIRE(frame_count == 3);
+
+  // same count passed to the constructor, but fewer particles
+  GasContainer smaller(3, vec2(0, 0), vec2(500, 500), 1);
+  {
+    TrajectoryWriter writer(kTrajectoryPath, container);
+    REQUIRE_THROWS_AS(writer.AddFrame(smaller), std::invalid_argument);
+  }
+  std::remove(kTrajectoryPath);
+}
+
+TEST_CASE("Trajectory writer rejects invalid use") {
+  GasContainer container(10, vec2(0, 0), vec2(500, 500), 1);
+
+  SECTION("Zero stride") {
+    TrajectoryOptions options;
+    options.stride = 0;
+    REQUIRE_THROWS_AS(TrajectoryWriter(kTrajectoryPath, container, options),
+                      std::invalid_argument);
+  }
+
+  SECTION("Adding after closing") {
+    TrajectoryWriter writer(kTrajectoryPath, container);
+    writer.Close();
+    REQUIRE_THROWS_AS(writer.AddFrame(container), std::runtime_error);
+  }
+
+  SECTION("Unwritable file") {
+    REQUIRE_THROWS_AS(
+        TrajectoryWriter("missing_directory/trajectory.bin", container),
+        std::runtime_error);
+  }
+
+  SECTION("Reading a file that isn't a trajectory") {
+    std::ofstream(kTrajectoryPath) << "not a trajectory";
+    REQUIRE_THROWS_AS(TrajectoryReader{kTrajectoryPath}, std::runtime_error);
+  }
+
+  SECTION("Reading a chunk whose size is corrupt") {
+    {
+      TrajectoryWriter writer(kTrajectoryPath, container);
+      container.AdvanceOneFrame();
+      writer.AddFrame(container);
+    }
+    // the first chunk header follows the file header, the species names
+    // and the index and species id of each particle
+    size_t offset = 56;
+    size_t particle_count = 0;
+    {
+      TrajectoryReader reader(kTrajectoryPath);
+      for (const std::string& name : reader.GetSpeciesNames()) {
+        offset += sizeof(uint32_t) + name.size();
+      }
+      particle_count = reader.GetParticleIndices().size();
+    }
+    offset += particle_count * (sizeof(uint64_t) + sizeof(uint8_t));
+    uint64_t byte_size = uint64_t(1) << 62;
+    {
+      std::fstream file(kTrajectoryPath,
+                        std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(static_cast<std::streamoff>(offset));
+      file.write(reinterpret_cast<const char*>(&byte_size),
+                 sizeof(byte_size));
+    }
+
+    TrajectoryReader reader(kTrajectoryPath);
+    TrajectoryFrame frame;
+    REQUIRE_THROWS_AS(reader.ReadFrame(frame), std::runtime_error);
+  }
+
+  std::remove(kTrajectoryPath);
+}
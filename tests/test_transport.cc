@@ -0,0 +1,242 @@
+#include <shared_memory_transport.h>
+#include <socket_transport.h>
+#include <transport.h>
+
+#include <catch2/catch.hpp>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using idealgas::MessageReader;
+using idealgas::MessageWriter;
+using idealgas::SharedMemoryTransport;
+using idealgas::SocketTransport;
+using idealgas::Transport;
+using std::vector;
+
+namespace {
+
+/**
+ * Runs body(rank) for every rank on its own thread and returns the
+ * message of any exception each one threw, empty if it didn't
+ */
+vector<std::string> RunRanks(size_t rank_count,
+                             const std::function<void(size_t)>& body) {
+  vector<std::string> errors(rank_count);
+  vector<std::thread> threads;
+  for (size_t rank = 0; rank < rank_count; rank++) {
+    threads.emplace_back([&body, &errors, rank]() {
+      try {
+        body(rank);
+      } catch (const std::exception& error) {
+        errors[rank] = error.what();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return errors;
+}
+
+std::string GetSegmentName(const std::string& test) {
+  return "/idealgas-test-" + test + "-" + std::to_string(getpid());
+}
+
+/** Finds a port nothing is listening on **/
+int FindFreePort() {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = sockaddr_in();
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  socklen_t length = sizeof(address);
+  getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+  close(listener);
+  return ntohs(address.sin_port);
+}
+
+vector<std::string> GetLoopbackAddresses(size_t rank_count) {
+  vector<std::string> addresses;
+  for (size_t rank = 0; rank < rank_count; rank++) {
+    addresses.push_back("127.0.0.1:" + std::to_string(FindFreePort()));
+  }
+  return addresses;
+}
+
+/** Message from source to destination, long enough to wrap a mailbox **/
+vector<uint8_t> MakeMessage(size_t source, size_t destination, size_t size) {
+  vector<uint8_t> message(size);
+  for (size_t i = 0; i < size; i++) {
+    message[i] = static_cast<uint8_t>(i * 7 + source * 31 + destination);
+  }
+  return message;
+}
+
+/**
+ * Every rank exchanges a message with every other rank, twice, and checks
+ * what it got
+ *
+ * @return    number of messages that didn't arrive intact
+ */
+size_t ExchangeWithEveryRank(Transport& transport, size_t message_size) {
+  size_t rank = transport.GetRank();
+  vector<size_t> partners;
+  vector<vector<uint8_t>> outgoing;
+  for (size_t other = 0; other < transport.GetRankCount(); other++) {
+    if (other != rank) {
+      partners.push_back(other);
+      outgoing.push_back(MakeMessage(rank, other, message_size));
+    }
+  }
+  size_t failures = 0;
+  vector<vector<uint8_t>> incoming;
+  for (size_t round = 0; round < 2; round++) {
+    transport.Exchange(partners, outgoing, incoming);
+    for (size_t i = 0; i < partners.size(); i++) {
+      if (incoming[i] != MakeMessage(partners[i], rank, message_size)) {
+        failures++;
+      }
+    }
+  }
+  return failures;
+}
+
+}  // namespace
+
+TEST_CASE("MessageReader reads back what MessageWriter wrote") {
+  vector<uint8_t> message;
+  MessageWriter writer(message);
+  writer.Write<float>(1.5f);
+  writer.WriteArray(vector<uint64_t>{3, 1, 4});
+  writer.Write<uint8_t>(9);
+
+  MessageReader reader(message);
+  REQUIRE(reader.Read<float>() == 1.5f);
+  vector<uint64_t> values;
+  reader.ReadArray(values);
+  REQUIRE(values == (vector<uint64_t>{3, 1, 4}));
+  REQUIRE(reader.Read<uint8_t>() == 9);
+  REQUIRE(reader.IsAtEnd());
+}
+
+TEST_CASE("MessageReader rejects truncated messages") {
+  vector<uint8_t> message;
+  MessageWriter writer(message);
+  writer.WriteArray(vector<float>{1, 2, 3});
+  message.pop_back();
+
+  MessageReader reader(message);
+  vector<float> values;
+  REQUIRE_THROWS_AS(reader.ReadArray(values), std::runtime_error);
+
+  vector<uint8_t> empty_message;
+  MessageReader empty_reader(empty_message);
+  REQUIRE_THROWS_AS(empty_reader.Read<uint32_t>(), std::runtime_error);
+}
+
+TEST_CASE("MessageWriter clears the message") {
+  vector<uint8_t> message(5, 1);
+  MessageWriter writer(message);
+  REQUIRE(message.empty());
+}
+
+TEST_CASE("SharedMemoryTransport exchanges messages between ranks") {
+  std::string name = GetSegmentName("exchange");
+  const size_t kRankCount = 4;
+
+  SECTION("Messages fit in the mailboxes") {
+    SharedMemoryTransport::Create(name, kRankCount);
+  }
+
+  SECTION("Messages are streamed through small mailboxes") {
+    SharedMemoryTransport::Create(name, kRankCount, 64);
+  }
+
+  vector<size_t> failures(kRankCount);
+  vector<std::string> errors =
+      RunRanks(kRankCount, [&name, &failures](size_t rank) {
+        SharedMemoryTransport transport(name, rank);
+        failures[rank] = ExchangeWithEveryRank(transport, 1000);
+      });
+  SharedMemoryTransport::Unlink(name);
+
+  REQUIRE(errors == vector<std::string>(kRankCount));
+  REQUIRE(failures == vector<size_t>(kRankCount, 0));
+}
+
+TEST_CASE("SharedMemoryTransport sends empty messages") {
+  std::string name = GetSegmentName("empty");
+  SharedMemoryTransport::Create(name, 2);
+  SharedMemoryTransport sender(name, 0);
+  SharedMemoryTransport receiver(name, 1);
+  SharedMemoryTransport::Unlink(name);
+
+  sender.Send(1, vector<uint8_t>());
+  sender.Send(1, vector<uint8_t>{7});
+  vector<uint8_t> message(3, 1);
+  receiver.Receive(0, message);
+  REQUIRE(message.empty());
+  receiver.Receive(0, message);
+  REQUIRE(message == vector<uint8_t>{7});
+}
+
+TEST_CASE("SharedMemoryTransport rejects invalid ranks") {
+  std::string name = GetSegmentName("ranks");
+  SharedMemoryTransport::Create(name, 2);
+
+  SECTION("Creating the segment twice") {
+    REQUIRE_THROWS_AS(SharedMemoryTransport::Create(name, 2),
+                      std::runtime_error);
+  }
+
+  SECTION("Opening a rank out of range") {
+    REQUIRE_THROWS_AS(SharedMemoryTransport(name, 2), std::invalid_argument);
+  }
+
+  SECTION("Messaging itself or a rank out of range") {
+    SharedMemoryTransport transport(name, 0);
+    REQUIRE(transport.GetRank() == 0);
+    REQUIRE(transport.GetRankCount() == 2);
+    REQUIRE_THROWS_AS(transport.Send(0, vector<uint8_t>()),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(transport.Send(2, vector<uint8_t>()),
+                      std::invalid_argument);
+  }
+
+  SharedMemoryTransport::Unlink(name);
+  REQUIRE_THROWS_AS(SharedMemoryTransport(name, 0), std::runtime_error);
+}
+
+TEST_CASE("SocketTransport exchanges messages between ranks") {
+  const size_t kRankCount = 3;
+  vector<std::string> addresses = GetLoopbackAddresses(kRankCount);
+
+  vector<size_t> failures(kRankCount);
+  vector<std::string> errors =
+      RunRanks(kRankCount, [&addresses, &failures](size_t rank) {
+        SocketTransport transport(addresses, rank);
+        failures[rank] = ExchangeWithEveryRank(transport, 100000);
+      });
+
+  REQUIRE(errors == vector<std::string>(kRankCount));
+  REQUIRE(failures == vector<size_t>(kRankCount, 0));
+}
+
+TEST_CASE("SocketTransport rejects invalid addresses and ranks") {
+  REQUIRE_THROWS_AS(SocketTransport({"127.0.0.1:1"}, 1),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(SocketTransport({"no port"}, 0), std::invalid_argument);
+}
+
+TEST_CASE("SocketTransport times out when a rank never connects") {
+  vector<std::string> addresses = GetLoopbackAddresses(2);
+  REQUIRE_THROWS_AS(SocketTransport(addresses, 1, 0.2),
+                    std::runtime_error);
+}
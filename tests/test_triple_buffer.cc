@@ -0,0 +1,68 @@
+#include <triple_buffer.h>
+
+#include <catch2/catch.hpp>
+#include <thread>
+
+using idealgas::TripleBuffer;
+
+TEST_CASE("Triple buffer hands over the latest value") {
+  TripleBuffer<int> buffer;
+
+  SECTION("Nothing to acquire before the first publish") {
+    REQUIRE_FALSE(buffer.Acquire());
+    REQUIRE(buffer.GetFront() == 0);
+  }
+
+  SECTION("Acquire gets the published value once") {
+    buffer.GetBack() = 1;
+    buffer.Publish();
+    REQUIRE(buffer.Acquire());
+    REQUIRE(buffer.GetFront() == 1);
+    REQUIRE_FALSE(buffer.Acquire());
+    REQUIRE(buffer.GetFront() == 1);
+  }
+
+  SECTION("Values the reader missed are overwritten") {
+    for (int value = 1; value <= 5; value++) {
+      buffer.GetBack() = value;
+      buffer.Publish();
+    }
+    REQUIRE(buffer.Acquire());
+    REQUIRE(buffer.GetFront() == 5);
+  }
+
+  SECTION("Writer never gets the slot the reader holds") {
+    buffer.GetBack() = 1;
+    buffer.Publish();
+    REQUIRE(buffer.Acquire());
+    for (int value = 2; value <= 5; value++) {
+      buffer.GetBack() = value;
+      buffer.Publish();
+      REQUIRE(buffer.GetFront() == 1);
+    }
+  }
+}
+
+TEST_CASE("Triple buffer across threads") {
+  const int kValueCount = 100000;
+  TripleBuffer<int> buffer;
+  std::thread writer([&buffer] {
+    for (int value = 1; value <= kValueCount; value++) {
+      buffer.GetBack() = value;
+      buffer.Publish();
+    }
+  });
+
+  // values only ever increase, and the last one always arrives
+  bool is_increasing = true;
+  int last_value = 0;
+  while (last_value < kValueCount) {
+    if (buffer.Acquire()) {
+      is_increasing = is_increasing && buffer.GetFront() > last_value;
+      last_value = buffer.GetFront();
+    }
+  }
+  writer.join();
+  REQUIRE(is_increasing);
+  REQUIRE_FALSE(buffer.Acquire());
+}
@@ -0,0 +1,60 @@
+#include <work_stealing_pool.h>
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using idealgas::WorkStealingPool;
+using std::vector;
+
+TEST_CASE("WorkStealingPool runs every task exactly once") {
+  for (size_t thread_count : {1, 2, 4, 7}) {
+    WorkStealingPool pool(thread_count);
+    REQUIRE(pool.GetThreadCount() == thread_count);
+
+    for (size_t task_count : {0, 1, 5, 1000}) {
+      vector<int> runs(task_count, 0);
+      pool.Run(task_count,
+               [&runs](size_t task, size_t) { runs[task]++; });
+      REQUIRE(runs == vector<int>(task_count, 1));
+    }
+  }
+}
+
+TEST_CASE("WorkStealingPool passes the thread running each task") {
+  const size_t kThreadCount = 3;
+  WorkStealingPool pool(kThreadCount);
+  vector<size_t> threads(300, kThreadCount);
+  pool.Run(threads.size(), [&threads](size_t task, size_t thread) {
+    threads[task] = thread;
+  });
+  for (size_t thread : threads) {
+    REQUIRE(thread < kThreadCount);
+  }
+}
+
+TEST_CASE("Idle threads take tasks queued behind a long one") {
+  const size_t kThreadCount = 4;
+  const size_t kTaskCount = 40;
+  WorkStealingPool pool(kThreadCount);
+
+  // task 0 and every 4th task after it are dealt to thread 0, which is
+  // stuck in task 0 while the others run out of work
+  vector<size_t> threads(kTaskCount, kThreadCount);
+  pool.Run(kTaskCount, [&threads](size_t task, size_t thread) {
+    if (task == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    threads[task] = thread;
+  });
+
+  size_t stolen_from_first = 0;
+  for (size_t task = kThreadCount; task < kTaskCount; task += kThreadCount) {
+    if (threads[task] != 0) {
+      stolen_from_first++;
+    }
+  }
+  REQUIRE(stolen_from_first > 0);
+  REQUIRE(pool.GetStealCount() >= stolen_from_first);
+}